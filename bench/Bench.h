@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+// Headless benchmarks and checks of the CPU-side engine code, for what can
+// run without a GPU. Each one prints its timings as it goes and returns
+// false if a check failed.
+namespace Bench {
+	typedef bool (*BenchFunction)();
+
+	inline double GetSeconds() {
+		return std::chrono::duration<double>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// prints what went wrong and returns false, so checks can return it
+	bool Fail(std::string const& message);
+
+	bool RunOcclusionBufferBench();
+	bool RunPlaneBench();
+	bool RunPerlinNoiseBench();
+	bool RunSimplexNoiseBench();
+	bool RunNoiseOctavesBench();
+	bool RunNoiseDerivativesBench();
+	bool RunIcosahedronBench();
+	bool RunSpatialHashGridBench();
+	bool RunDynamicAabbTreeBench();
+}
@@ -0,0 +1,332 @@
+#include "Bench.h"
+#include "Math/DynamicAabbTree.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+static const size_t numBoxes = 10000;
+// boxes in a line, inserted in order, which is what degrades a tree that
+// doesn't rebalance
+static const size_t numLinedUpBoxes = 4096;
+static const float fatMargin = 1.0f;
+// enough over the frames that most boxes leave their fat ones at least once
+static const float maxStep = 0.5f;
+static const int numMoveFrames = 60;
+static const size_t numQueries = 1000;
+static const float queryRadius = 20.0f;
+static const float maxRayDistance = 1000.0f;
+
+// objects spread over a wide, flat battlefield
+static const glm::vec3 fieldExtents(500.0f, 50.0f, 500.0f);
+
+struct TreeBox {
+	AABB bounds;
+	uint32_t categoryBits;
+	int32_t proxy;
+};
+
+// balanced trees have about log2(n) levels; rotations keep it within twice
+// that
+static int32_t GetMaxHeight(size_t numProxies) {
+	int32_t log2 = 0;
+	while (((size_t)1 << log2) < numProxies) {
+		log2++;
+	}
+	return 2 * log2;
+}
+
+static bool CheckTree(DynamicAabbTree const& tree,
+	std::vector<TreeBox> const& boxes, const char* description) {
+	size_t numProxies = 0;
+	for (uint32_t item = 0; item < boxes.size(); item++) {
+		TreeBox const& box = boxes[item];
+		if (box.proxy == DynamicAabbTree::nullNode) {
+			continue;
+		}
+		numProxies++;
+		if (tree.GetItem(box.proxy) != item ||
+			!tree.GetFatBounds(box.proxy).Contains(box.bounds)) {
+			std::stringstream message;
+			message << description << ": proxy of box " << item
+				<< " has another item or doesn't contain the box";
+			return Bench::Fail(message.str());
+		}
+	}
+	if (tree.GetNumProxies() != numProxies) {
+		std::stringstream message;
+		message << description << ": " << tree.GetNumProxies()
+			<< " proxies, expected " << numProxies;
+		return Bench::Fail(message.str());
+	}
+	if (tree.GetHeight() > GetMaxHeight(numProxies)) {
+		std::stringstream message;
+		message << description << ": height " << tree.GetHeight()
+			<< " with " << numProxies << " proxies";
+		return Bench::Fail(message.str());
+	}
+	return true;
+}
+
+static glm::vec3 GetRandomPoint(std::mt19937& randomEngine) {
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	return fieldExtents * glm::vec3(unit(randomEngine), unit(randomEngine),
+		unit(randomEngine));
+}
+
+static glm::vec3 GetRandomDirection(std::mt19937& randomEngine) {
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	// mostly level, like shots across the field
+	return glm::normalize(glm::vec3(unit(randomEngine),
+		unit(randomEngine) * 0.1f, unit(randomEngine)));
+}
+
+// all three queries around a point, against testing every box. nearest
+// boxes and hits can tie, so those are compared by distance
+struct QueryResults {
+	std::vector<uint32_t> overlappingItems;
+	bool foundNearest = false;
+	float nearestDistance = 0.0f;
+	float hitDistance = -1.0f;
+};
+
+static void QueryTree(DynamicAabbTree const& tree,
+	std::vector<TreeBox> const& boxes, glm::vec3 const& point,
+	glm::vec3 const& direction, uint32_t categoryMask,
+	QueryResults& results) {
+	results.overlappingItems.clear();
+	tree.QuerySphere(point, queryRadius, categoryMask,
+		[&](uint32_t item) {
+			if (boxes[item].bounds.GetDistanceSquared(point) <=
+				queryRadius * queryRadius) {
+				results.overlappingItems.push_back(item);
+			}
+			return true;
+		});
+	std::sort(results.overlappingItems.begin(),
+		results.overlappingItems.end());
+
+	uint32_t nearestItem;
+	results.foundNearest = tree.FindNearest(point, queryRadius,
+		categoryMask, [&](uint32_t item) {
+			return std::sqrt(boxes[item].bounds.GetDistanceSquared(point));
+		}, nearestItem, results.nearestDistance);
+
+	glm::vec3 inverseDirection = 1.0f / direction;
+	results.hitDistance = -1.0f;
+	tree.Raycast(point, direction, maxRayDistance, categoryMask,
+		[&](uint32_t item) {
+			float distance = boxes[item].bounds.IntersectRay(point,
+				inverseDirection, maxRayDistance);
+			if (distance >= 0.0f && (results.hitDistance < 0.0f ||
+				distance < results.hitDistance)) {
+				results.hitDistance = distance;
+			}
+			return distance;
+		});
+}
+
+static void QueryBruteForce(std::vector<TreeBox> const& boxes,
+	glm::vec3 const& point, glm::vec3 const& direction,
+	uint32_t categoryMask, QueryResults& results) {
+	results.overlappingItems.clear();
+	results.foundNearest = false;
+	results.hitDistance = -1.0f;
+	float nearestDistanceSquared = queryRadius * queryRadius;
+	glm::vec3 inverseDirection = 1.0f / direction;
+	for (uint32_t item = 0; item < boxes.size(); item++) {
+		TreeBox const& box = boxes[item];
+		if (box.proxy == DynamicAabbTree::nullNode ||
+			(box.categoryBits & categoryMask) == 0) {
+			continue;
+		}
+		float distanceSquared = box.bounds.GetDistanceSquared(point);
+		if (distanceSquared <= queryRadius * queryRadius) {
+			results.overlappingItems.push_back(item);
+		}
+		// squared the way the tree compares them
+		float distance = std::sqrt(distanceSquared);
+		if (distance * distance <= nearestDistanceSquared) {
+			nearestDistanceSquared = distance * distance;
+			results.nearestDistance = distance;
+			results.foundNearest = true;
+		}
+		float hitDistance = box.bounds.IntersectRay(point, inverseDirection,
+			maxRayDistance);
+		if (hitDistance >= 0.0f && (results.hitDistance < 0.0f ||
+			hitDistance < results.hitDistance)) {
+			results.hitDistance = hitDistance;
+		}
+	}
+}
+
+static bool CheckQueries(DynamicAabbTree const& tree,
+	std::vector<TreeBox> const& boxes, std::mt19937& randomEngine,
+	const char* description) {
+	QueryResults treeResults, expectedResults;
+	for (size_t query = 0; query < numQueries; query++) {
+		glm::vec3 point = GetRandomPoint(randomEngine);
+		glm::vec3 direction = GetRandomDirection(randomEngine);
+		uint32_t categoryMask = query % 2 == 0 ? 0xffffffffu : 0x9u;
+		QueryTree(tree, boxes, point, direction, categoryMask, treeResults);
+		QueryBruteForce(boxes, point, direction, categoryMask,
+			expectedResults);
+
+		const char* queryName = nullptr;
+		if (treeResults.overlappingItems !=
+			expectedResults.overlappingItems) {
+			queryName = "QuerySphere";
+		}
+		else if (treeResults.foundNearest != expectedResults.foundNearest ||
+			(treeResults.foundNearest && treeResults.nearestDistance !=
+			expectedResults.nearestDistance)) {
+			queryName = "FindNearest";
+		}
+		else if (treeResults.hitDistance != expectedResults.hitDistance) {
+			queryName = "Raycast";
+		}
+		if (queryName != nullptr) {
+			std::stringstream message;
+			message << description << ": " << queryName << " from (" << point.x
+				<< ", " << point.y << ", " << point.z
+				<< ") differs from testing every box";
+			return Bench::Fail(message.str());
+		}
+	}
+	return true;
+}
+
+static void CreateProxies(DynamicAabbTree& tree, std::vector<TreeBox>& boxes) {
+	for (uint32_t item = 0; item < boxes.size(); item++) {
+		boxes[item].proxy = tree.CreateProxy(boxes[item].bounds, item,
+			boxes[item].categoryBits);
+	}
+}
+
+bool Bench::RunDynamicAabbTreeBench() {
+	std::mt19937 randomEngine(2016);
+	std::uniform_real_distribution<float> halfSize(0.2f, 2.0f);
+	std::uniform_real_distribution<float> step(-maxStep, maxStep);
+
+	// same box sizes everywhere; the sorted run is what a tree without
+	// rotations turns into a list
+	std::vector<TreeBox> linedUpBoxes(numLinedUpBoxes);
+	for (size_t i = 0; i < numLinedUpBoxes; i++) {
+		glm::vec3 center((float)i * 3.0f, 0.0f, 0.0f);
+		linedUpBoxes[i].bounds = AABB(center - glm::vec3(1.0f),
+			center + glm::vec3(1.0f));
+		linedUpBoxes[i].categoryBits = 1;
+	}
+	DynamicAabbTree linedUpTree(fatMargin);
+	CreateProxies(linedUpTree, linedUpBoxes);
+	if (!CheckTree(linedUpTree, linedUpBoxes, "boxes inserted in a line")) {
+		return false;
+	}
+
+	std::vector<TreeBox> boxes(numBoxes);
+	for (size_t i = 0; i < numBoxes; i++) {
+		glm::vec3 center = GetRandomPoint(randomEngine);
+		glm::vec3 extents(halfSize(randomEngine));
+		boxes[i].bounds = AABB(center - extents, center + extents);
+		boxes[i].categoryBits = 1u << (i % 4);
+	}
+	DynamicAabbTree tree(fatMargin);
+	double startTime = GetSeconds();
+	CreateProxies(tree, boxes);
+	double insertSeconds = GetSeconds() - startTime;
+	if (!CheckTree(tree, boxes, "inserted") ||
+		!CheckQueries(tree, boxes, randomEngine, "inserted")) {
+		return false;
+	}
+
+	// small steps every frame, so only some boxes leave their fat ones
+	size_t numMoved = 0;
+	startTime = GetSeconds();
+	for (int frame = 0; frame < numMoveFrames; frame++) {
+		for (TreeBox& box : boxes) {
+			glm::vec3 offset(step(randomEngine), 0.0f, step(randomEngine));
+			box.bounds.min += offset;
+			box.bounds.max += offset;
+			if (tree.MoveProxy(box.proxy, box.bounds)) {
+				numMoved++;
+			}
+		}
+	}
+	double moveSeconds = GetSeconds() - startTime;
+	if (!CheckTree(tree, boxes, "moved") ||
+		!CheckQueries(tree, boxes, randomEngine, "moved")) {
+		return false;
+	}
+
+	// a third go away, some change category, then half of those come back
+	for (size_t i = 0; i < numBoxes; i += 3) {
+		tree.DestroyProxy(boxes[i].proxy);
+		boxes[i].proxy = DynamicAabbTree::nullNode;
+	}
+	for (size_t i = 1; i < numBoxes; i += 7) {
+		if (boxes[i].proxy == DynamicAabbTree::nullNode) {
+			continue;
+		}
+		boxes[i].categoryBits = 8;
+		tree.SetCategoryBits(boxes[i].proxy, boxes[i].categoryBits);
+	}
+	if (!CheckTree(tree, boxes, "removed") ||
+		!CheckQueries(tree, boxes, randomEngine, "removed")) {
+		return false;
+	}
+	for (size_t i = 0; i < numBoxes; i += 6) {
+		boxes[i].proxy = tree.CreateProxy(boxes[i].bounds, (uint32_t)i,
+			boxes[i].categoryBits);
+	}
+	if (!CheckTree(tree, boxes, "reinserted") ||
+		!CheckQueries(tree, boxes, randomEngine, "reinserted")) {
+		return false;
+	}
+
+	// timed after all of that, the way the scene's tree looks after a
+	// while of play
+	std::vector<glm::vec3> points(numQueries), directions(numQueries);
+	for (size_t query = 0; query < numQueries; query++) {
+		points[query] = GetRandomPoint(randomEngine);
+		directions[query] = GetRandomDirection(randomEngine);
+	}
+	QueryResults results;
+	startTime = GetSeconds();
+	for (size_t query = 0; query < numQueries; query++) {
+		QueryTree(tree, boxes, points[query], directions[query],
+			0xffffffffu, results);
+	}
+	double treeQuerySeconds = GetSeconds() - startTime;
+	startTime = GetSeconds();
+	for (size_t query = 0; query < numQueries; query++) {
+		QueryBruteForce(boxes, points[query], directions[query], 0xffffffffu,
+			results);
+	}
+	double bruteForceSeconds = GetSeconds() - startTime;
+
+	std::cout << "  " << numLinedUpBoxes << " boxes inserted in a line: height "
+		<< linedUpTree.GetHeight() << "\n"
+		<< "  " << numBoxes << " boxes: inserted in "
+		<< insertSeconds * 1e3 << " ms, height " << tree.GetHeight() << "\n"
+		<< "  moving all of them: " << moveSeconds * 1e3 / numMoveFrames
+		<< " ms per frame, " << 100.0 * numMoved /
+		(numMoveFrames * (double)numBoxes) << "% reinserted\n"
+		<< "  " << tree.GetNumProxies() << " boxes after removals, "
+		<< "sphere, nearest and ray query: "
+		<< treeQuerySeconds * 1e6 / numQueries << " us, testing every box "
+		<< bruteForceSeconds * 1e6 / numQueries << " us\n";
+
+	tree.Clear();
+	std::fill(boxes.begin(), boxes.end(), TreeBox{ AABB(), 0,
+		DynamicAabbTree::nullNode });
+	QueryTree(tree, boxes, glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f),
+		0xffffffffu, results);
+	if (tree.GetNumProxies() != 0 || tree.GetHeight() != 0 ||
+		!results.overlappingItems.empty() || results.foundNearest ||
+		results.hitDistance >= 0.0f) {
+		return Fail("cleared tree still has boxes");
+	}
+	return true;
+}
@@ -0,0 +1,142 @@
+#include "Bench.h"
+#include "Resources/Model.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+static const float radius = 100.0f;
+static const uint32_t maxCheckedSubdivisions = 6;
+static const uint32_t minTimedSubdivisions = 3;
+static const uint32_t maxTimedSubdivisions = 7;
+static const int numTimedRepeats = 5;
+static const float minNormalDot = 0.999f;
+
+// every subdivision splits each triangle in four. every edge gets one
+// midpoint, shared by the triangles on both sides, except along the
+// texture seam, whose 22 edges are split on each side and double with
+// every level
+static size_t GetExpectedNumIndices(uint32_t numSubdivisions) {
+	return (size_t)60 << (2 * numSubdivisions);
+}
+
+static size_t GetExpectedNumVertices(uint32_t numSubdivisions) {
+	return ((size_t)10 << (2 * numSubdivisions)) +
+		((size_t)11 << numSubdivisions) + 1;
+}
+
+// vertices that share a position have to be on either side of the seam or
+// at a pole, and have different texture coordinates. a midpoint that was
+// added twice would match one already there in both
+static size_t CountDuplicatedVertices(
+	std::vector<Model::ModelVert> const& vertices) {
+	typedef std::tuple<float, float, float, float, float> VertexKey;
+	std::vector<VertexKey> keys;
+	keys.reserve(vertices.size());
+	for (auto const& vertex : vertices) {
+		keys.push_back(VertexKey(vertex.position.x, vertex.position.y,
+			vertex.position.z, vertex.texCoord.x, vertex.texCoord.y));
+	}
+	std::sort(keys.begin(), keys.end());
+	return keys.end() - std::unique(keys.begin(), keys.end());
+}
+
+static bool CheckLevel(Model& model, uint32_t numSubdivisions) {
+	std::vector<Model::ModelVert> const& vertices = model.GetVertices();
+	std::vector<uint32_t> const& indices = model.GetIndices();
+	std::stringstream message;
+	message << "level " << numSubdivisions << ": ";
+	if (indices.size() != GetExpectedNumIndices(numSubdivisions) ||
+		vertices.size() != GetExpectedNumVertices(numSubdivisions)) {
+		message << vertices.size() << " vertices and " << indices.size()
+			<< " indices, expected " << GetExpectedNumVertices(numSubdivisions)
+			<< " and " << GetExpectedNumIndices(numSubdivisions);
+		return Bench::Fail(message.str());
+	}
+	size_t numDuplicated = CountDuplicatedVertices(vertices);
+	if (numDuplicated > 0) {
+		message << numDuplicated << " duplicated vertices";
+		return Bench::Fail(message.str());
+	}
+
+	std::vector<bool> used(vertices.size(), false);
+	for (uint32_t index : indices) {
+		if (index >= vertices.size()) {
+			message << "index " << index << " is out of range";
+			return Bench::Fail(message.str());
+		}
+		used[index] = true;
+	}
+	if (std::find(used.begin(), used.end(), false) != used.end()) {
+		message << "some vertices are never used";
+		return Bench::Fail(message.str());
+	}
+
+	// on the sphere, with normals pointing straight out of it. vertices
+	// split at the poles and the seam get the same normal, so there's no
+	// crease there even on the base icosahedron
+	for (auto const& vertex : vertices) {
+		float distance = glm::length(vertex.position);
+		if (std::abs(distance - radius) > radius * 1e-5f) {
+			message << "vertex is " << distance << " from the center";
+			return Bench::Fail(message.str());
+		}
+		if (std::abs(glm::length(vertex.normal) - 1.0f) > 1e-4f ||
+			glm::dot(vertex.normal, vertex.position / distance) <
+			minNormalDot) {
+			message << "normal isn't unit length or isn't pointing out";
+			return Bench::Fail(message.str());
+		}
+	}
+	return true;
+}
+
+bool Bench::RunIcosahedronBench() {
+	for (uint32_t numSubdivisions = 0;
+		numSubdivisions <= maxCheckedSubdivisions; numSubdivisions++) {
+		std::shared_ptr<Model> icosahedron = Model::CreateIcosahedron(radius,
+			numSubdivisions);
+		if (!CheckLevel(*icosahedron, numSubdivisions)) {
+			return false;
+		}
+		// the levels of detail are the coarser subdivision levels
+		auto const& lods = icosahedron->GetLods();
+		size_t expectedNumLods = std::min(numSubdivisions,
+			Model::maxLodLevels - 1);
+		if (lods.size() != expectedNumLods) {
+			std::stringstream message;
+			message << "level " << numSubdivisions << " has " << lods.size()
+				<< " levels of detail, expected " << expectedNumLods;
+			return Fail(message.str());
+		}
+		for (uint32_t lodLevel = 1; lodLevel <= lods.size(); lodLevel++) {
+			if (!CheckLevel(*lods[lodLevel - 1].model,
+				numSubdivisions - lodLevel)) {
+				return false;
+			}
+		}
+	}
+
+	std::cout << "  radius " << radius
+		<< ", best of " << numTimedRepeats << ", with levels of detail:\n";
+	for (uint32_t numSubdivisions = minTimedSubdivisions;
+		numSubdivisions <= maxTimedSubdivisions; numSubdivisions++) {
+		double bestSeconds = 0.0;
+		for (int repeat = 0; repeat < numTimedRepeats; repeat++) {
+			double startTime = GetSeconds();
+			std::shared_ptr<Model> icosahedron = Model::CreateIcosahedron(
+				radius, numSubdivisions);
+			double seconds = GetSeconds() - startTime;
+			if (repeat == 0 || seconds < bestSeconds) {
+				bestSeconds = seconds;
+			}
+		}
+		std::cout << "    level " << numSubdivisions << ": "
+			<< GetExpectedNumVertices(numSubdivisions) << " vertices, "
+			<< GetExpectedNumIndices(numSubdivisions) / 3 << " triangles, "
+			<< bestSeconds * 1e3 << " ms\n";
+	}
+	return true;
+}
@@ -0,0 +1,313 @@
+#include "Bench.h"
+#include "Math/PerlinNoise.h"
+#include "Math/SimplexNoise.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+// not a multiple of eight, so the scalar tail after the SIMD groups runs
+static const size_t numPoints = (1 << 20) + 5;
+static const int numTimedRepeats = 5;
+
+static const size_t numOctavePoints = 1 << 18;
+static const uint32_t octaveCounts[] = { 1, 2, 4, 8 };
+
+static const size_t numDerivativePoints = 100000;
+// small enough that truncation error stays below float rounding, which
+// is why the points stay near the origin too
+static const float derivativeStep = 1e-3f;
+static const float derivativeTolerance = 2e-2f;
+
+struct NoiseResults {
+	std::vector<float> values;
+	std::vector<float> derivX;
+	std::vector<float> derivY;
+	std::vector<float> derivZ;
+
+	explicit NoiseResults(size_t count) : values(count), derivX(count),
+		derivY(count), derivZ(count) {
+	}
+};
+
+static const char* GetSimdLevelName(NoiseGenerator::SimdLevel simdLevel) {
+	switch (simdLevel) {
+		case NoiseGenerator::SimdLevel::Avx2:
+			return "AVX2";
+		case NoiseGenerator::SimdLevel::Sse41:
+			return "SSE4.1";
+		default:
+			return "none";
+	}
+}
+
+// terrain samples land anywhere, including on negative and whole numbers.
+// some have equal coordinates too, where simplex picks its tetrahedron
+static void CreateRandomPoints(std::vector<float>& x, std::vector<float>& y,
+	std::vector<float>& z) {
+	std::mt19937 randomEngine(2016);
+	std::uniform_real_distribution<float> coordinate(-300.0f, 300.0f);
+	std::uniform_int_distribution<int> wholeCoordinate(-300, 300);
+	x.resize(numPoints);
+	y.resize(numPoints);
+	z.resize(numPoints);
+	for (size_t i = 0; i < numPoints; i++) {
+		x[i] = coordinate(randomEngine);
+		y[i] = coordinate(randomEngine);
+		z[i] = coordinate(randomEngine);
+		if (i % 16 == 0) {
+			x[i] = (float)wholeCoordinate(randomEngine);
+		}
+		if (i % 32 == 0) {
+			y[i] = (float)wholeCoordinate(randomEngine);
+		}
+		if (i % 64 == 1) {
+			y[i] = x[i];
+		}
+		if (i % 64 == 2) {
+			z[i] = x[i];
+		}
+	}
+}
+
+static bool IsBitIdentical(float first, float second) {
+	uint32_t firstBits, secondBits;
+	memcpy(&firstBits, &first, sizeof(float));
+	memcpy(&secondBits, &second, sizeof(float));
+	return firstBits == secondBits;
+}
+
+// times Eval and EvalBatch at every SIMD level the CPU has, and checks that
+// the batches match Eval bit for bit
+template <typename Noise>
+static bool CheckSimdLevels(Noise const& noise) {
+	std::vector<float> x, y, z;
+	CreateRandomPoints(x, y, z);
+
+	NoiseResults scalarResults(numPoints);
+	double scalarSeconds = 0.0;
+	for (int repeat = 0; repeat < numTimedRepeats; repeat++) {
+		double startTime = Bench::GetSeconds();
+		for (size_t i = 0; i < numPoints; i++) {
+			glm::vec3 derivs;
+			scalarResults.values[i] = noise.Eval(glm::vec3(x[i], y[i], z[i]),
+				derivs);
+			scalarResults.derivX[i] = derivs.x;
+			scalarResults.derivY[i] = derivs.y;
+			scalarResults.derivZ[i] = derivs.z;
+		}
+		scalarSeconds += Bench::GetSeconds() - startTime;
+	}
+	std::cout << "  " << numPoints << " points, best SIMD level on this CPU: "
+		<< GetSimdLevelName(NoiseGenerator::GetSimdLevel()) << "\n"
+		<< "  Eval: " << numPoints * numTimedRepeats / scalarSeconds / 1e6
+		<< " million samples per second\n";
+
+	bool passed = true;
+	NoiseGenerator::SimdLevel simdLevels[] = {
+		NoiseGenerator::SimdLevel::None, NoiseGenerator::SimdLevel::Sse41,
+		NoiseGenerator::SimdLevel::Avx2 };
+	for (NoiseGenerator::SimdLevel simdLevel : simdLevels) {
+		if (simdLevel > NoiseGenerator::GetSimdLevel()) {
+			std::cout << "  EvalBatch, " << GetSimdLevelName(simdLevel)
+				<< ": not supported, skipped\n";
+			continue;
+		}
+
+		NoiseResults batchResults(numPoints);
+		NoiseBatch batch = { x.data(), y.data(), z.data(),
+			batchResults.values.data(), batchResults.derivX.data(),
+			batchResults.derivY.data(), batchResults.derivZ.data(),
+			numPoints };
+		double batchSeconds = 0.0;
+		for (int repeat = 0; repeat < numTimedRepeats; repeat++) {
+			double startTime = Bench::GetSeconds();
+			noise.EvalBatch(batch, simdLevel);
+			batchSeconds += Bench::GetSeconds() - startTime;
+		}
+
+		size_t numMismatches = 0;
+		size_t firstMismatch = 0;
+		for (size_t i = 0; i < numPoints; i++) {
+			if (!IsBitIdentical(batchResults.values[i],
+					scalarResults.values[i]) ||
+				!IsBitIdentical(batchResults.derivX[i],
+					scalarResults.derivX[i]) ||
+				!IsBitIdentical(batchResults.derivY[i],
+					scalarResults.derivY[i]) ||
+				!IsBitIdentical(batchResults.derivZ[i],
+					scalarResults.derivZ[i])) {
+				if (numMismatches == 0) {
+					firstMismatch = i;
+				}
+				numMismatches++;
+			}
+		}
+
+		std::cout << "  EvalBatch, " << GetSimdLevelName(simdLevel) << ": "
+			<< numPoints * numTimedRepeats / batchSeconds / 1e6
+			<< " million samples per second, "
+			<< scalarSeconds / batchSeconds << "x Eval\n";
+		if (numMismatches > 0) {
+			std::stringstream message;
+			message << "EvalBatch with " << GetSimdLevelName(simdLevel)
+				<< " differs from Eval at " << numMismatches
+				<< " points, first at (" << x[firstMismatch] << ", "
+				<< y[firstMismatch] << ", " << z[firstMismatch] << ")";
+			passed = Bench::Fail(message.str());
+		}
+	}
+	return passed;
+}
+
+bool Bench::RunPerlinNoiseBench() {
+	return CheckSimdLevels(PerlinNoise());
+}
+
+bool Bench::RunSimplexNoiseBench() {
+	return CheckSimdLevels(SimplexNoise());
+}
+
+// sums octaves the way planes do, every octave at twice the frequency and
+// half the amplitude of the one before. returns seconds per sample
+static double TimeOctaves(NoiseGenerator const& noiseGenerator,
+	uint32_t numOctaves, bool batched, std::vector<float> const& x,
+	std::vector<float> const& y, std::vector<float> const& z,
+	std::vector<float>& fractals) {
+	size_t count = x.size();
+	std::vector<float> octaveX(count), octaveY(count), octaveZ(count);
+	NoiseResults results(count);
+	NoiseBatch batch = { octaveX.data(), octaveY.data(), octaveZ.data(),
+		results.values.data(), results.derivX.data(), results.derivY.data(),
+		results.derivZ.data(), count };
+
+	double seconds = 0.0;
+	for (int repeat = 0; repeat < numTimedRepeats; repeat++) {
+		double startTime = Bench::GetSeconds();
+		octaveX = x;
+		octaveY = y;
+		octaveZ = z;
+		std::fill(fractals.begin(), fractals.end(), 0.0f);
+		float amplitude = 1.0f;
+		for (uint32_t octave = 0; octave < numOctaves; octave++) {
+			if (batched) {
+				noiseGenerator.EvalBatch(batch);
+			}
+			else {
+				for (size_t i = 0; i < count; i++) {
+					glm::vec3 derivs;
+					results.values[i] = noiseGenerator.Eval(glm::vec3(
+						octaveX[i], octaveY[i], octaveZ[i]), derivs);
+				}
+			}
+			for (size_t i = 0; i < count; i++) {
+				fractals[i] += (1.0f + results.values[i]) * 0.5f * amplitude;
+				octaveX[i] *= 2.0f;
+				octaveY[i] *= 2.0f;
+				octaveZ[i] *= 2.0f;
+			}
+			amplitude *= 0.5f;
+		}
+		seconds += Bench::GetSeconds() - startTime;
+	}
+	return seconds / (numTimedRepeats * (double)count);
+}
+
+bool Bench::RunNoiseOctavesBench() {
+	std::mt19937 randomEngine(2016);
+	std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+	std::vector<float> x(numOctavePoints), y(numOctavePoints),
+		z(numOctavePoints);
+	for (size_t i = 0; i < numOctavePoints; i++) {
+		x[i] = coordinate(randomEngine);
+		y[i] = coordinate(randomEngine);
+		z[i] = coordinate(randomEngine);
+	}
+
+	PerlinNoise perlinNoise;
+	SimplexNoise simplexNoise;
+	std::vector<float> fractals(numOctavePoints);
+	std::cout << "  " << numOctavePoints << " points, ns per sample:\n";
+	bool passed = true;
+	for (uint32_t numOctaves : octaveCounts) {
+		double perlinScalar = TimeOctaves(perlinNoise, numOctaves, false,
+			x, y, z, fractals);
+		double perlinBatch = TimeOctaves(perlinNoise, numOctaves, true,
+			x, y, z, fractals);
+		double simplexScalar = TimeOctaves(simplexNoise, numOctaves, false,
+			x, y, z, fractals);
+		double simplexBatch = TimeOctaves(simplexNoise, numOctaves, true,
+			x, y, z, fractals);
+		// fractal sums of noise in about [-1, 1] stay in about [0, 2]
+		float minFractal = *std::min_element(fractals.begin(),
+			fractals.end());
+		float maxFractal = *std::max_element(fractals.begin(),
+			fractals.end());
+		if (minFractal < -0.5f || maxFractal > 2.5f) {
+			std::stringstream message;
+			message << "simplex fractal with " << numOctaves
+				<< " octaves goes from " << minFractal << " to "
+				<< maxFractal;
+			passed = Fail(message.str());
+		}
+		std::cout << "  " << numOctaves << " octaves: perlin Eval "
+			<< perlinScalar * 1e9 << ", perlin EvalBatch "
+			<< perlinBatch * 1e9 << ", simplex Eval " << simplexScalar * 1e9
+			<< ", simplex EvalBatch " << simplexBatch * 1e9 << "\n";
+	}
+	return passed;
+}
+
+// central differences along each axis against the analytic derivatives.
+// the step is measured after rounding, since that's what was taken
+static bool CheckDerivatives(NoiseGenerator const& noiseGenerator,
+	const char* name) {
+	std::mt19937 randomEngine(2016);
+	std::uniform_real_distribution<float> coordinate(-20.0f, 20.0f);
+	float maxError = 0.0f;
+	glm::vec3 worstPoint(0.0f);
+	for (size_t i = 0; i < numDerivativePoints; i++) {
+		glm::vec3 point(coordinate(randomEngine), coordinate(randomEngine),
+			coordinate(randomEngine));
+		glm::vec3 derivs;
+		noiseGenerator.Eval(point, derivs);
+		for (int axis = 0; axis < 3; axis++) {
+			glm::vec3 after = point;
+			glm::vec3 before = point;
+			after[axis] += derivativeStep;
+			before[axis] -= derivativeStep;
+			glm::vec3 unused;
+			float difference = (noiseGenerator.Eval(after, unused) -
+				noiseGenerator.Eval(before, unused)) /
+				(after[axis] - before[axis]);
+			float error = std::abs(difference - derivs[axis]) /
+				std::max(1.0f, std::abs(derivs[axis]));
+			if (error > maxError) {
+				maxError = error;
+				worstPoint = point;
+			}
+		}
+	}
+
+	std::cout << "  " << name << ": largest derivative error "
+		<< maxError << " over " << numDerivativePoints << " points\n";
+	if (maxError > derivativeTolerance) {
+		std::stringstream message;
+		message << name << " derivatives are off by " << maxError << " at ("
+			<< worstPoint.x << ", " << worstPoint.y << ", " << worstPoint.z
+			<< ")";
+		return Bench::Fail(message.str());
+	}
+	return true;
+}
+
+bool Bench::RunNoiseDerivativesBench() {
+	PerlinNoise perlinNoise;
+	SimplexNoise simplexNoise;
+	bool perlinPassed = CheckDerivatives(perlinNoise, "perlin");
+	bool simplexPassed = CheckDerivatives(simplexNoise, "simplex");
+	return perlinPassed && simplexPassed;
+}
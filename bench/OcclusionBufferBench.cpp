@@ -0,0 +1,140 @@
+#include "Bench.h"
+#include "Math/OcclusionBuffer.h"
+#include "Math/CommonMath.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// same size the occlusion culler uses
+static const uint32_t bufferWidth = 256;
+static const uint32_t bufferHeight = 128;
+
+// camera at the origin looking down -z, with a 4x4 wall 10 units in front
+static const float occluderDistance = 10.0f;
+static const float occluderHalfSize = 2.0f;
+
+struct BoxCase {
+	const char* description;
+	glm::vec3 center;
+	glm::vec3 extents;
+	bool visible;
+};
+
+static const BoxCase boxCases[] = {
+	{ "small box right behind the wall", glm::vec3(0.0f, 0.0f, -20.0f),
+		glm::vec3(0.5f), false },
+	{ "box near a corner of the wall's shadow", glm::vec3(2.5f, 2.5f, -20.0f),
+		glm::vec3(0.5f), false },
+	{ "box far behind the wall", glm::vec3(0.0f, 0.0f, -500.0f),
+		glm::vec3(10.0f), false },
+	{ "box in front of the wall", glm::vec3(0.0f, 0.0f, -5.0f),
+		glm::vec3(0.5f), true },
+	{ "box beside the wall", glm::vec3(6.0f, 0.0f, -20.0f),
+		glm::vec3(0.5f), true },
+	{ "box straddling the wall's edge", glm::vec3(4.0f, 0.0f, -20.0f),
+		glm::vec3(0.5f), true },
+	{ "box bigger than the wall's shadow", glm::vec3(0.0f, 0.0f, -20.0f),
+		glm::vec3(5.0f), true },
+	{ "box through the wall", glm::vec3(0.0f, 0.0f, -10.0f),
+		glm::vec3(0.5f), true },
+	{ "box around the camera", glm::vec3(0.0f), glm::vec3(1.0f), true },
+};
+
+static glm::mat4 GetViewProjection() {
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f));
+	return CommonMath::ConstructProjectionMatrix(bufferWidth, bufferHeight) *
+		view;
+}
+
+static void RasterizeWall(OcclusionBuffer& occlusionBuffer,
+	glm::mat4 const& viewProjection) {
+	glm::vec3 corners[4] = {
+		glm::vec3(-occluderHalfSize, -occluderHalfSize, -occluderDistance),
+		glm::vec3(occluderHalfSize, -occluderHalfSize, -occluderDistance),
+		glm::vec3(occluderHalfSize, occluderHalfSize, -occluderDistance),
+		glm::vec3(-occluderHalfSize, occluderHalfSize, -occluderDistance)
+	};
+	glm::vec4 clipPositions[4];
+	for (int i = 0; i < 4; i++) {
+		clipPositions[i] = viewProjection * glm::vec4(corners[i], 1.0f);
+	}
+	uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+	occlusionBuffer.RasterizeTriangles(clipPositions, indices, 6);
+}
+
+bool Bench::RunOcclusionBufferBench() {
+	glm::mat4 viewProjection = GetViewProjection();
+	OcclusionBuffer occlusionBuffer(bufferWidth, bufferHeight);
+
+	// nothing drawn yet, so nothing is hidden
+	occlusionBuffer.BuildHierarchy();
+	if (!occlusionBuffer.IsBoxVisible(boxCases[0].center,
+		boxCases[0].extents, viewProjection)) {
+		return Fail("box hidden by an empty buffer");
+	}
+
+	RasterizeWall(occlusionBuffer, viewProjection);
+	occlusionBuffer.BuildHierarchy();
+	if (occlusionBuffer.GetNumRasterizedTriangles() != 2) {
+		return Fail("expected both of the wall's triangles to be drawn");
+	}
+	if (occlusionBuffer.GetDepth(bufferWidth / 2, bufferHeight / 2) >=
+		occlusionBuffer.GetDepth(0, 0)) {
+		return Fail("wall missing from the middle of the buffer");
+	}
+
+	bool passed = true;
+	for (auto const& boxCase : boxCases) {
+		bool visible = occlusionBuffer.IsBoxVisible(boxCase.center,
+			boxCase.extents, viewProjection);
+		if (visible != boxCase.visible) {
+			passed = Fail(std::string(boxCase.description) + " is " +
+				(visible ? "visible" : "hidden"));
+		}
+	}
+
+	// random boxes behind the wall and around it
+	const size_t numBoxes = 100000;
+	std::mt19937 randomEngine(2016);
+	std::uniform_real_distribution<float> lateral(-8.0f, 8.0f);
+	std::uniform_real_distribution<float> depth(-100.0f, -15.0f);
+	std::vector<glm::vec3> centers(numBoxes);
+	for (auto& center : centers) {
+		center = glm::vec3(lateral(randomEngine), lateral(randomEngine),
+			depth(randomEngine));
+	}
+
+	const int numRepeats = 10;
+	size_t numHidden = 0;
+	double rasterizeSeconds = 0.0;
+	double testSeconds = 0.0;
+	for (int repeat = 0; repeat < numRepeats; repeat++) {
+		double startTime = GetSeconds();
+		occlusionBuffer.Clear();
+		RasterizeWall(occlusionBuffer, viewProjection);
+		occlusionBuffer.BuildHierarchy();
+		double rasterizedTime = GetSeconds();
+		numHidden = 0;
+		for (auto const& center : centers) {
+			if (!occlusionBuffer.IsBoxVisible(center, glm::vec3(0.25f),
+				viewProjection)) {
+				numHidden++;
+			}
+		}
+		rasterizeSeconds += rasterizedTime - startTime;
+		testSeconds += GetSeconds() - rasterizedTime;
+	}
+	if (numHidden == 0 || numHidden == numBoxes) {
+		return Fail("random boxes were all hidden or all visible");
+	}
+
+	std::cout << "  clear, rasterize and build: "
+		<< rasterizeSeconds * 1e3 / numRepeats << " ms\n"
+		<< "  " << numBoxes << " box tests: "
+		<< testSeconds * 1e3 / numRepeats << " ms ("
+		<< testSeconds * 1e9 / (numRepeats * (double)numBoxes)
+		<< " ns per box), " << numHidden << " hidden\n";
+	return passed;
+}
@@ -0,0 +1,154 @@
+#include "Bench.h"
+#include "Resources/Model.h"
+#include "Math/NoiseGenerator.h"
+#include "ThreadPool.h"
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+// several bands of rows, and a last one that's only partly filled
+static const uint32_t checkSide1Points = 500;
+static const uint32_t checkSide2Points = 100;
+static const uint32_t checkNoiseLayers = 3;
+
+static const uint32_t timedSide1Points = 1024;
+static const uint32_t timedSide2Points = 1024;
+static const uint32_t timedNoiseLayers = 4;
+
+static const glm::vec3 lowerLeft(-500.0f, 0.0f, -500.0f);
+static const glm::vec3 side1Vec(1000.0f, 0.0f, 0.0f);
+static const glm::vec3 side2Vec(0.0f, 0.0f, 1000.0f);
+
+// the whole grid in one loop, one point and one Eval at a time, the way
+// the plane would be built without tiles or batches
+static void CreateUntiledPlane(uint32_t numSide1Points,
+	uint32_t numSide2Points, NoiseGeneratorType noiseGeneratorType,
+	uint32_t numNoiseLayers, std::vector<Model::ModelVert>& vertices,
+	std::vector<uint32_t>& indices) {
+	glm::vec3 side1Div = side1Vec / (float)(numSide1Points - 1);
+	glm::vec3 side2Div = side2Vec / (float)(numSide2Points - 1);
+	float uDiv = 1.0f / (float)(numSide1Points - 1);
+	float vDiv = 1.0f / (float)(numSide2Points - 1);
+	NoiseGenerator* noiseGenerator = NoiseGenerator::Create(
+		noiseGeneratorType);
+
+	vertices.clear();
+	for (uint32_t side1Index = 0; side1Index < numSide1Points; side1Index++) {
+		glm::vec3 rowStart = (float)side1Index * side1Div + lowerLeft;
+		for (uint32_t side2Index = 0; side2Index < numSide2Points;
+			side2Index++) {
+			glm::vec3 position = rowStart + (float)side2Index * side2Div;
+			glm::vec3 normal(0.0f, 1.0f, 0.0f);
+			if (noiseGenerator != nullptr) {
+				glm::vec3 samplePoint = position;
+				glm::vec3 derivs(0.0f, 1.0f, 0.0f);
+				for (uint32_t layerIndex = 0; layerIndex < numNoiseLayers;
+					layerIndex++) {
+					noiseGenerator->Eval(samplePoint, derivs);
+					samplePoint *= 2.0f;
+				}
+				glm::vec3 derivativeVal = glm::normalize(derivs);
+				normal = glm::normalize(glm::vec3(-derivativeVal.x, 1.0f,
+					-derivativeVal.z));
+			}
+			glm::vec2 texCoord((float)side1Index * uDiv,
+				1.0f - (float)side2Index * vDiv);
+			vertices.push_back(Model::ModelVert(position, normal,
+				glm::vec3(1.0f, 1.0f, 1.0f), texCoord));
+		}
+	}
+	delete noiseGenerator;
+
+	indices.clear();
+	for (uint32_t side1Index = 0; side1Index + 1 < numSide1Points;
+		side1Index++) {
+		for (uint32_t side2Index = 0; side2Index < numSide2Points;
+			side2Index++) {
+			indices.push_back((side1Index + 1) * numSide2Points + side2Index);
+			indices.push_back(side1Index * numSide2Points + side2Index);
+		}
+	}
+}
+
+static bool CheckPlane(NoiseGeneratorType noiseGeneratorType,
+	uint32_t numNoiseLayers, ThreadPool* threadPool,
+	const char* description) {
+	std::vector<Model::ModelVert> expectedVertices;
+	std::vector<uint32_t> expectedIndices;
+	CreateUntiledPlane(checkSide1Points, checkSide2Points,
+		noiseGeneratorType, numNoiseLayers, expectedVertices,
+		expectedIndices);
+
+	std::shared_ptr<Model> plane = Model::CreatePlane(lowerLeft, side1Vec,
+		side2Vec, checkSide1Points, checkSide2Points, noiseGeneratorType,
+		numNoiseLayers, threadPool);
+	std::vector<Model::ModelVert> const& vertices = plane->GetVertices();
+	std::vector<uint32_t> const& indices = plane->GetIndices();
+	if (vertices.size() != expectedVertices.size() ||
+		indices.size() != expectedIndices.size()) {
+		return Bench::Fail(std::string(description) +
+			": tiled plane has a different number of vertices or indices");
+	}
+	for (size_t i = 0; i < vertices.size(); i++) {
+		if (!(vertices[i] == expectedVertices[i])) {
+			std::stringstream message;
+			message << description << ": tiled vertex " << i
+				<< " differs from the untiled one";
+			return Bench::Fail(message.str());
+		}
+	}
+	if (indices != expectedIndices) {
+		return Bench::Fail(std::string(description) +
+			": tiled indices differ from the untiled ones");
+	}
+	return true;
+}
+
+static double TimePlane(ThreadPool* threadPool) {
+	double startTime = Bench::GetSeconds();
+	std::shared_ptr<Model> plane = Model::CreatePlane(lowerLeft, side1Vec,
+		side2Vec, timedSide1Points, timedSide2Points,
+		NoiseGeneratorType::Perlin, timedNoiseLayers, threadPool);
+	return Bench::GetSeconds() - startTime;
+}
+
+bool Bench::RunPlaneBench() {
+	ThreadPool threadPool;
+	bool passed = CheckPlane(NoiseGeneratorType::None, 0, nullptr,
+		"no noise, inline") &&
+		CheckPlane(NoiseGeneratorType::Perlin, checkNoiseLayers, nullptr,
+		"perlin, inline") &&
+		CheckPlane(NoiseGeneratorType::Perlin, checkNoiseLayers, &threadPool,
+		"perlin, thread pool") &&
+		CheckPlane(NoiseGeneratorType::Simplex, checkNoiseLayers, &threadPool,
+		"simplex, thread pool");
+	if (!passed) {
+		return false;
+	}
+
+	// the corners are where the sides say, with nothing shifted by a step
+	std::shared_ptr<Model> plane = Model::CreatePlane(lowerLeft, side1Vec,
+		side2Vec, checkSide1Points, checkSide2Points,
+		NoiseGeneratorType::None, 0, nullptr);
+	auto const& vertices = plane->GetVertices();
+	glm::vec3 farCorner = lowerLeft + side1Vec + side2Vec;
+	if (vertices.front().position != lowerLeft ||
+		glm::length(vertices.back().position - farCorner) > 1e-3f) {
+		return Fail("plane corners moved");
+	}
+
+	double numVertices = (double)timedSide1Points * timedSide2Points;
+	double inlineSeconds = TimePlane(nullptr);
+	double threadPoolSeconds = TimePlane(&threadPool);
+	std::cout << "  " << timedSide1Points << "x" << timedSide2Points
+		<< " plane, " << timedNoiseLayers << " perlin layers:\n"
+		<< "    inline: " << inlineSeconds * 1e3 << " ms ("
+		<< numVertices / inlineSeconds / 1e6
+		<< " million vertices per second)\n"
+		<< "    " << threadPool.GetNumWorkers() << " workers: "
+		<< threadPoolSeconds * 1e3 << " ms ("
+		<< numVertices / threadPoolSeconds / 1e6
+		<< " million vertices per second)\n";
+	return true;
+}
@@ -0,0 +1,222 @@
+#include "Bench.h"
+#include "Math/SpatialHashGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+// same as the collision system's pawn grid and the bullets' reach
+static const float cellSize = 4.0f;
+static const float hitDistance = 2.0f;
+// reaches a few cells out in every direction
+static const float wideQueryRadius = 9.0f;
+
+// the pawns swarm a fixed volume around the mothership, so they get
+// denser as there are more of them
+static const glm::vec3 swarmExtents(50.0f, 25.0f, 50.0f);
+static const uint32_t numCounts[] = { 1000, 2500, 5000, 10000 };
+static const int numTimedRepeats = 5;
+
+// a handful of points spread over many cells, so every bucket holds
+// points of cells far apart, and wide queries visit each bucket many times
+static const uint32_t numCrowdedPoints = 16;
+static const float crowdedExtents = 80.0f;
+static const float crowdedQueryRadius = 40.0f;
+
+static void CreateRandomPositions(std::mt19937& randomEngine, size_t count,
+	glm::vec3 const& extents, std::vector<glm::vec3>& positions) {
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	positions.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		positions[i] = extents * glm::vec3(unit(randomEngine),
+			unit(randomEngine), unit(randomEngine));
+		// some right on cell borders, which floor has to put on one side
+		if (i % 8 == 0) {
+			positions[i].x = std::round(positions[i].x / cellSize) *
+				cellSize;
+		}
+	}
+}
+
+static void BuildGrid(SpatialHashGrid& grid,
+	std::vector<glm::vec3> const& positions) {
+	grid.Clear();
+	for (size_t i = 0; i < positions.size(); i++) {
+		grid.Insert(positions[i], (uint32_t)i);
+	}
+	grid.Build();
+}
+
+static float GetDistanceSquared(glm::vec3 const& first,
+	glm::vec3 const& second) {
+	glm::vec3 offset = first - second;
+	return glm::dot(offset, offset);
+}
+
+// every third point stands in for a pawn that was already destroyed
+static bool IsAccepted(uint32_t item) {
+	return item % 3 != 0;
+}
+
+// what bullets used to do: test every pawn
+static bool FindNearestBruteForce(std::vector<glm::vec3> const& positions,
+	glm::vec3 const& center, float radius, uint32_t& nearestItem) {
+	float nearestDistanceSquared = radius * radius;
+	bool found = false;
+	for (uint32_t item = 0; item < positions.size(); item++) {
+		float distanceSquared = GetDistanceSquared(positions[item], center);
+		if (distanceSquared <= nearestDistanceSquared && IsAccepted(item)) {
+			nearestDistanceSquared = distanceSquared;
+			nearestItem = item;
+			found = true;
+		}
+	}
+	return found;
+}
+
+static void QuerySphereBruteForce(std::vector<glm::vec3> const& positions,
+	glm::vec3 const& center, float radius, std::vector<uint32_t>& items) {
+	for (uint32_t item = 0; item < positions.size(); item++) {
+		if (GetDistanceSquared(positions[item], center) <= radius * radius) {
+			items.push_back(item);
+		}
+	}
+}
+
+// queries around each center against testing every point. nearest points
+// can tie, so those are compared by distance
+static bool CheckQueries(SpatialHashGrid const& grid,
+	std::vector<glm::vec3> const& positions,
+	std::vector<glm::vec3> const& centers, float queryRadius,
+	const char* description) {
+	std::vector<uint32_t> items, expectedItems;
+	for (glm::vec3 const& center : centers) {
+		uint32_t nearestItem = 0, expectedNearestItem = 0;
+		bool found = grid.FindNearest(center, hitDistance, IsAccepted,
+			nearestItem);
+		bool expectedFound = FindNearestBruteForce(positions, center,
+			hitDistance, expectedNearestItem);
+		if (found != expectedFound || (found &&
+			(!IsAccepted(nearestItem) ||
+			GetDistanceSquared(positions[nearestItem], center) !=
+			GetDistanceSquared(positions[expectedNearestItem], center)))) {
+			std::stringstream message;
+			message << description << ": FindNearest around (" << center.x
+				<< ", " << center.y << ", " << center.z
+				<< ") differs from testing every point";
+			return Bench::Fail(message.str());
+		}
+
+		items.clear();
+		expectedItems.clear();
+		grid.QuerySphere(center, queryRadius, items);
+		QuerySphereBruteForce(positions, center, queryRadius, expectedItems);
+		std::sort(items.begin(), items.end());
+		if (items != expectedItems) {
+			std::stringstream message;
+			message << description << ": QuerySphere around (" << center.x
+				<< ", " << center.y << ", " << center.z << ") found "
+				<< items.size() << " points, expected "
+				<< expectedItems.size();
+			return Bench::Fail(message.str());
+		}
+	}
+	return true;
+}
+
+bool Bench::RunSpatialHashGridBench() {
+	std::mt19937 randomEngine(2016);
+	SpatialHashGrid grid(cellSize);
+	std::vector<glm::vec3> pawns, bullets;
+
+	// an empty grid finds nothing
+	grid.Build();
+	uint32_t unusedItem;
+	std::vector<uint32_t> unusedItems;
+	grid.QuerySphere(glm::vec3(0.0f), wideQueryRadius, unusedItems);
+	if (grid.FindNearest(glm::vec3(0.0f), hitDistance, IsAccepted,
+		unusedItem) || !unusedItems.empty()) {
+		return Fail("empty grid found a point");
+	}
+
+	// a full-sized grid, then rebuilt smaller in the same storage with
+	// the pawns moved, the way it is every frame
+	CreateRandomPositions(randomEngine, 10000, swarmExtents, pawns);
+	CreateRandomPositions(randomEngine, 2000, swarmExtents, bullets);
+	BuildGrid(grid, pawns);
+	if (!CheckQueries(grid, pawns, bullets, wideQueryRadius, "10000 pawns")) {
+		return false;
+	}
+	CreateRandomPositions(randomEngine, 3000, swarmExtents, pawns);
+	BuildGrid(grid, pawns);
+	if (!CheckQueries(grid, pawns, bullets, wideQueryRadius,
+		"rebuilt with 3000 pawns")) {
+		return false;
+	}
+
+	// points of other cells are in every bucket a query looks at, and
+	// would be found again for each cell of theirs it covers
+	CreateRandomPositions(randomEngine, numCrowdedPoints,
+		glm::vec3(crowdedExtents), pawns);
+	CreateRandomPositions(randomEngine, 200, glm::vec3(crowdedExtents),
+		bullets);
+	BuildGrid(grid, pawns);
+	if (!CheckQueries(grid, pawns, bullets, crowdedQueryRadius,
+		"points of other cells in the same buckets")) {
+		return false;
+	}
+
+	std::cout << "  pawns and bullets in a " << swarmExtents.x * 2.0f << "x"
+		<< swarmExtents.y * 2.0f << "x" << swarmExtents.z * 2.0f
+		<< " swarm, cells of " << cellSize << ", hits within " << hitDistance
+		<< ":\n";
+	for (uint32_t count : numCounts) {
+		CreateRandomPositions(randomEngine, count, swarmExtents, pawns);
+		CreateRandomPositions(randomEngine, count, swarmExtents, bullets);
+
+		double buildSeconds = 0.0;
+		double querySeconds = 0.0;
+		size_t numHits = 0;
+		for (int repeat = 0; repeat < numTimedRepeats; repeat++) {
+			double startTime = GetSeconds();
+			BuildGrid(grid, pawns);
+			double builtTime = GetSeconds();
+			numHits = 0;
+			for (glm::vec3 const& bullet : bullets) {
+				uint32_t pawn;
+				if (grid.FindNearest(bullet, hitDistance, IsAccepted,
+					pawn)) {
+					numHits++;
+				}
+			}
+			buildSeconds += builtTime - startTime;
+			querySeconds += GetSeconds() - builtTime;
+		}
+
+		double startTime = GetSeconds();
+		size_t numBruteForceHits = 0;
+		for (glm::vec3 const& bullet : bullets) {
+			uint32_t pawn;
+			if (FindNearestBruteForce(pawns, bullet, hitDistance, pawn)) {
+				numBruteForceHits++;
+			}
+		}
+		double bruteForceSeconds = GetSeconds() - startTime;
+		if (numHits != numBruteForceHits) {
+			std::stringstream message;
+			message << count << " bullets: " << numHits
+				<< " hits, testing every pawn found " << numBruteForceHits;
+			return Fail(message.str());
+		}
+
+		double gridSeconds = (buildSeconds + querySeconds) / numTimedRepeats;
+		std::cout << "    " << count << " vs " << count << ": build "
+			<< buildSeconds * 1e3 / numTimedRepeats << " ms, queries "
+			<< querySeconds * 1e3 / numTimedRepeats << " ms, " << numHits
+			<< " hits; testing every pawn " << bruteForceSeconds * 1e3
+			<< " ms (" << bruteForceSeconds / gridSeconds << "x)\n";
+	}
+	return true;
+}
@@ -0,0 +1,59 @@
+#include "Bench.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+struct BenchEntry {
+	const char* name;
+	Bench::BenchFunction function;
+};
+
+static const BenchEntry benchEntries[] = {
+	{ "OcclusionBuffer", Bench::RunOcclusionBufferBench },
+	{ "Plane", Bench::RunPlaneBench },
+	{ "PerlinNoise", Bench::RunPerlinNoiseBench },
+	{ "SimplexNoise", Bench::RunSimplexNoiseBench },
+	{ "NoiseOctaves", Bench::RunNoiseOctavesBench },
+	{ "NoiseDerivatives", Bench::RunNoiseDerivativesBench },
+	{ "Icosahedron", Bench::RunIcosahedronBench },
+	{ "SpatialHashGrid", Bench::RunSpatialHashGridBench },
+	{ "DynamicAabbTree", Bench::RunDynamicAabbTreeBench },
+};
+
+bool Bench::Fail(std::string const& message) {
+	std::cerr << "  FAILED: " << message << "\n";
+	return false;
+}
+
+// runs everything, or only the benchmarks named on the command line
+int main(int argc, char* argv[]) {
+	int numFailed = 0;
+	int numRun = 0;
+	for (auto const& benchEntry : benchEntries) {
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; i++) {
+			if (strcmp(argv[i], benchEntry.name) == 0) {
+				selected = true;
+			}
+		}
+		if (!selected) {
+			continue;
+		}
+
+		std::cout << benchEntry.name << ":\n";
+		numRun++;
+		if (!benchEntry.function()) {
+			numFailed++;
+		}
+	}
+
+	if (numRun == 0) {
+		std::cerr << "No benchmark with that name.\n";
+		return EXIT_FAILURE;
+	}
+	if (numFailed > 0) {
+		std::cerr << numFailed << " of " << numRun << " failed.\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
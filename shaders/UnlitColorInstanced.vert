@@ -0,0 +1,21 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferObject {
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+} ubo;
+
+layout(location = 0) in vec3 inPosition;
+// per-instance attributes; model ubo matrix is ignored
+layout(location = 1) in mat4 instanceModel;
+layout(location = 5) in vec4 instanceTint;
+
+layout(location = 0) out vec4 fragTint;
+
+void main() {
+	gl_Position = ubo.proj * ubo.view *
+		instanceModel * vec4(inPosition, 1.0);
+	fragTint = instanceTint;
+}
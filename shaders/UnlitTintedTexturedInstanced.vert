@@ -0,0 +1,25 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferObject {
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+} ubo;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+// per-instance attributes; model ubo matrix is ignored
+layout(location = 3) in mat4 instanceModel;
+layout(location = 7) in vec4 instanceTint;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+void main() {
+	gl_Position = ubo.proj * ubo.view *
+		instanceModel * vec4(inPosition, 1.0);
+	fragColor = inColor * instanceTint.rgb;
+	fragTexCoord = inTexCoord;
+}
@@ -16,4 +16,11 @@ glslc.exe ./MotherShip.frag -o ./MotherShipFrag.spv
 glslc.exe ./TextShader.vert -o ./TextShaderVert.spv
 glslc.exe ./TextShader.frag -o ./TextShaderFrag.spv
 
+glslc.exe ./UnlitColorInstanced.vert -o ./UnlitColorInstancedVert.spv
+glslc.exe ./UnlitColorInstanced.frag -o ./UnlitColorInstancedFrag.spv
+
+glslc.exe ./UnlitTintedTexturedInstanced.vert -o ./UnlitTintedTexturedInstancedVert.spv
+
+glslc.exe ./GpuCull.comp -o ./GpuCullComp.spv
+
 pause
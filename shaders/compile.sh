@@ -15,3 +15,10 @@ glslc ./BumpySurface.frag -o ./BumpySurfaceFrag.spv
 
 glslc ./MotherShip.vert -o ./MotherShipVert.spv
 glslc ./MotherShip.frag -o ./MotherShipFrag.spv
+
+glslc ./UnlitColorInstanced.vert -o ./UnlitColorInstancedVert.spv
+glslc ./UnlitColorInstanced.frag -o ./UnlitColorInstancedFrag.spv
+
+glslc ./UnlitTintedTexturedInstanced.vert -o ./UnlitTintedTexturedInstancedVert.spv
+
+glslc ./GpuCull.comp -o ./GpuCullComp.spv
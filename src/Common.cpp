@@ -1,6 +1,8 @@
 #include "Common.h"
 #include "LogicalDeviceManager.h"
 #include "GfxDeviceManager.h"
+#include "UploadContext.h"
+#include "DeferredDestructionQueue.h"
 #include <stdexcept>
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/matrix_transform.hpp>
@@ -73,45 +75,19 @@ VkFormat Common::FindDepthFormat(VkPhysicalDevice physicalDevice) {
 		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT, physicalDevice);
 }
 
-VkCommandBuffer Common::BeginSingleTimeCommands(VkCommandPool commandPool,
+VkCommandBuffer Common::BeginSingleTimeCommands(
 	LogicalDeviceManager *logicalDeviceManager) {
-	VkCommandBufferAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandPool = commandPool;
-	allocInfo.commandBufferCount = 1;
-
-	VkCommandBuffer commandBuffer;
-	vkAllocateCommandBuffers(logicalDeviceManager->GetDevice(), &allocInfo, &commandBuffer);
-
-	VkCommandBufferBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-	vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-	return commandBuffer;
+	return logicalDeviceManager->GetUploadContext()->BeginRecording();
 }
 
-void Common::EndSingleTimeCommands(VkCommandBuffer commandBuffer, VkCommandPool commandPool,
-	LogicalDeviceManager* logicalDeviceManager) {
-	vkEndCommandBuffer(commandBuffer);
-
-	VkSubmitInfo submitInfo = {};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffer;
-
-	vkQueueSubmit(logicalDeviceManager->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(logicalDeviceManager->GetGraphicsQueue());
-
-	vkFreeCommandBuffers(logicalDeviceManager->GetDevice(), commandPool, 1, &commandBuffer);
+void Common::EndSingleTimeCommands(LogicalDeviceManager* logicalDeviceManager) {
+	logicalDeviceManager->GetUploadContext()->EndRecording();
 }
 
 void Common::TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout,
-	VkImageLayout newLayout, uint32_t mipLevels, VkCommandPool commandPool,
+	VkImageLayout newLayout, uint32_t mipLevels,
 	LogicalDeviceManager *logicalDeviceManager) {
-	VkCommandBuffer commandBuffer = Common::BeginSingleTimeCommands(commandPool,
+	VkCommandBuffer commandBuffer = Common::BeginSingleTimeCommands(
 		logicalDeviceManager);
 
 	VkImageMemoryBarrier barrier = {};
@@ -186,7 +162,7 @@ void Common::TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout
 		1, &barrier
 	);
 
-	Common::EndSingleTimeCommands(commandBuffer, commandPool, logicalDeviceManager);
+	Common::EndSingleTimeCommands(logicalDeviceManager);
 }
 
 bool Common::HasStencilComponent(VkFormat format) {
@@ -197,7 +173,8 @@ bool Common::HasStencilComponent(VkFormat format) {
 void Common::CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels,
 	VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling,
 	VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image,
-	VkDeviceMemory& imageMemory, LogicalDeviceManager *logicalDeviceManager,
+	MemoryAllocator::Allocation& imageAllocation,
+	LogicalDeviceManager *logicalDeviceManager,
 	GfxDeviceManager *gfxDeviceManager) {
 	VkImageCreateInfo imageInfo = {};
 	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -221,21 +198,29 @@ void Common::CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels,
 		throw std::runtime_error("Failed to create image!");
 	}
 
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(logicalDeviceManager->GetDevice(), image, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits,
-		properties, gfxDeviceManager);
+	imageAllocation = logicalDeviceManager->GetMemoryAllocator()->AllocateForImage(
+		image, properties);
+}
 
-	if (vkAllocateMemory(logicalDeviceManager->GetDevice(), &allocInfo, nullptr, &imageMemory)
-		!= VK_SUCCESS) {
-		throw std::runtime_error("Failed to allocate image memory!");
+void Common::DestroyImage(LogicalDeviceManager* logicalDeviceManager,
+	VkImage& image, MemoryAllocator::Allocation& imageAllocation) {
+	if (image != VK_NULL_HANDLE) {
+		vkDestroyImage(logicalDeviceManager->GetDevice(), image, nullptr);
+		image = VK_NULL_HANDLE;
 	}
+	logicalDeviceManager->GetMemoryAllocator()->Free(imageAllocation);
+}
 
-	vkBindImageMemory(logicalDeviceManager->GetDevice(), image, imageMemory, 0);
+void Common::RetireImage(LogicalDeviceManager* logicalDeviceManager,
+	VkImage& image, MemoryAllocator::Allocation& imageAllocation) {
+	VkImage retiredImage = image;
+	MemoryAllocator::Allocation retiredAllocation = imageAllocation;
+	logicalDeviceManager->GetDeferredDestructionQueue()->Enqueue(
+		[logicalDeviceManager, retiredImage, retiredAllocation]() mutable {
+			DestroyImage(logicalDeviceManager, retiredImage, retiredAllocation);
+		});
+	image = VK_NULL_HANDLE;
+	imageAllocation = MemoryAllocator::Allocation();
 }
 
 uint32_t Common::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties,
@@ -255,7 +240,9 @@ uint32_t Common::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags prope
 
 void Common::CreateBuffer(LogicalDeviceManager* logicalDeviceManager,
 	GfxDeviceManager* gfxDeviceManager, VkDeviceSize size, VkBufferUsageFlags usage,
-	VkMemoryPropertyFlags properties,VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+	VkMemoryPropertyFlags properties, VkBuffer& buffer,
+	MemoryAllocator::Allocation& bufferAllocation,
+	MemoryAllocator::AllocationLifetime lifetime) {
 	VkBufferCreateInfo bufferInfo = {};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferInfo.size = size;
@@ -267,32 +254,27 @@ void Common::CreateBuffer(LogicalDeviceManager* logicalDeviceManager,
 		throw std::runtime_error("Failed to create buffer!");
 	}
 
-	VkMemoryRequirements memRequirements;
-	vkGetBufferMemoryRequirements(logicalDeviceManager->GetDevice(), buffer, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = Common::FindMemoryType(memRequirements.memoryTypeBits,
-		properties, gfxDeviceManager);
+	bufferAllocation = logicalDeviceManager->GetMemoryAllocator()->AllocateForBuffer(
+		buffer, properties, lifetime);
+}
 
-	if (vkAllocateMemory(logicalDeviceManager->GetDevice(), &allocInfo, nullptr, &bufferMemory) !=
-		VK_SUCCESS) {
-		throw std::runtime_error("Failed to allocate vertex buffer memory!");
+void Common::DestroyBuffer(LogicalDeviceManager* logicalDeviceManager,
+	VkBuffer& buffer, MemoryAllocator::Allocation& bufferAllocation) {
+	if (buffer != VK_NULL_HANDLE) {
+		vkDestroyBuffer(logicalDeviceManager->GetDevice(), buffer, nullptr);
+		buffer = VK_NULL_HANDLE;
 	}
-	vkBindBufferMemory(logicalDeviceManager->GetDevice(), buffer, bufferMemory, 0);
+	logicalDeviceManager->GetMemoryAllocator()->Free(bufferAllocation);
 }
 
-void Common::CopyBuffer(LogicalDeviceManager* logicalDeviceManager, VkCommandPool commandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-	VkCommandBuffer commandBuffer = Common::BeginSingleTimeCommands(commandPool,
-		logicalDeviceManager);
-
-	VkBufferCopy copyRegion = {};
-	copyRegion.srcOffset = 0; // optional
-	copyRegion.dstOffset = 0; // optional
-	copyRegion.size = size;
-	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-	Common::EndSingleTimeCommands(commandBuffer, commandPool, logicalDeviceManager);
+void Common::RetireBuffer(LogicalDeviceManager* logicalDeviceManager,
+	VkBuffer& buffer, MemoryAllocator::Allocation& bufferAllocation) {
+	VkBuffer retiredBuffer = buffer;
+	MemoryAllocator::Allocation retiredAllocation = bufferAllocation;
+	logicalDeviceManager->GetDeferredDestructionQueue()->Enqueue(
+		[logicalDeviceManager, retiredBuffer, retiredAllocation]() mutable {
+			DestroyBuffer(logicalDeviceManager, retiredBuffer, retiredAllocation);
+		});
+	buffer = VK_NULL_HANDLE;
+	bufferAllocation = MemoryAllocator::Allocation();
 }
-
@@ -5,6 +5,7 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include "nlohmann/json.hpp"
+#include "MemoryAllocator.h"
 
 class LogicalDeviceManager;
 class GfxDeviceManager;
@@ -27,31 +28,42 @@ public:
 
 	static VkFormat FindDepthFormat(VkPhysicalDevice physicalDevice);
 
-	static VkCommandBuffer BeginSingleTimeCommands(VkCommandPool commandPool,
+	// commands get batched with the upload context's current submission
+	static VkCommandBuffer BeginSingleTimeCommands(
 		LogicalDeviceManager* logicalDeviceManager);
-	static void EndSingleTimeCommands(VkCommandBuffer commandBuffer,
-		VkCommandPool commandPool, LogicalDeviceManager* logicalDeviceManager);
+	static void EndSingleTimeCommands(LogicalDeviceManager* logicalDeviceManager);
 
 	static void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout,
-		VkImageLayout newLayout, uint32_t mipLevels, VkCommandPool commandPool,
+		VkImageLayout newLayout, uint32_t mipLevels,
 		LogicalDeviceManager* logicalDeviceManager);
 
 	static bool HasStencilComponent(VkFormat format);
 
 	static void CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples,
 		VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-		VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory,
+		VkMemoryPropertyFlags properties, VkImage& image,
+		MemoryAllocator::Allocation& imageAllocation,
 		LogicalDeviceManager* logicalDeviceManager, GfxDeviceManager* gfxDeviceManager);
+	static void DestroyImage(LogicalDeviceManager* logicalDeviceManager,
+		VkImage& image, MemoryAllocator::Allocation& imageAllocation);
+	// destroys the image once frames in flight are done with it
+	static void RetireImage(LogicalDeviceManager* logicalDeviceManager,
+		VkImage& image, MemoryAllocator::Allocation& imageAllocation);
 
 	static uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties,
 		GfxDeviceManager* gfxDeviceManager);
 
 	static void CreateBuffer(LogicalDeviceManager* logicalDeviceManager,
 		GfxDeviceManager* gfxDeviceManager, VkDeviceSize size, VkBufferUsageFlags usage,
-		VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
-	
-	static void CopyBuffer(LogicalDeviceManager* logicalDeviceManager, VkCommandPool commandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-
+		VkMemoryPropertyFlags properties, VkBuffer& buffer,
+		MemoryAllocator::Allocation& bufferAllocation,
+		MemoryAllocator::AllocationLifetime lifetime =
+			MemoryAllocator::AllocationLifetime::Persistent);
+	static void DestroyBuffer(LogicalDeviceManager* logicalDeviceManager,
+		VkBuffer& buffer, MemoryAllocator::Allocation& bufferAllocation);
+	// destroys the buffer once frames in flight are done with it
+	static void RetireBuffer(LogicalDeviceManager* logicalDeviceManager,
+		VkBuffer& buffer, MemoryAllocator::Allocation& bufferAllocation);
 	
 };
 
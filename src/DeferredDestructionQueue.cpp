@@ -0,0 +1,69 @@
+#include "DeferredDestructionQueue.h"
+#include <vector>
+
+DeferredDestructionQueue::DeferredDestructionQueue() : currentFrameNumber(0) {
+}
+
+DeferredDestructionQueue::~DeferredDestructionQueue() {
+	ReleaseAll();
+}
+
+void DeferredDestructionQueue::Enqueue(DestroyFunction destroyFunction) {
+	std::lock_guard<std::mutex> lock(retiredMutex);
+	retiredResources.push_back({ currentFrameNumber, destroyFunction });
+}
+
+void DeferredDestructionQueue::KeepAlive(std::shared_ptr<void> object) {
+	// the last reference goes away when the function does
+	Enqueue([object]() {});
+}
+
+void DeferredDestructionQueue::BeginFrame(uint64_t frameNumber) {
+	std::lock_guard<std::mutex> lock(retiredMutex);
+	currentFrameNumber = frameNumber;
+}
+
+void DeferredDestructionQueue::ReleaseCompletedFrames(
+	uint64_t numCompletedFrames) {
+	std::vector<DestroyFunction> destroyFunctions;
+	{
+		std::lock_guard<std::mutex> lock(retiredMutex);
+		while (!retiredResources.empty() &&
+			retiredResources.front().frameNumber < numCompletedFrames) {
+			destroyFunctions.push_back(
+				std::move(retiredResources.front().destroyFunction));
+			retiredResources.pop_front();
+		}
+	}
+
+	// destruction might retire more resources, so don't hold the lock
+	for (auto& destroyFunction : destroyFunctions) {
+		if (destroyFunction) {
+			destroyFunction();
+		}
+	}
+}
+
+void DeferredDestructionQueue::ReleaseAll() {
+	// keep going in case destroying something retired something else
+	while (true) {
+		std::deque<RetiredResource> resourcesToRelease;
+		{
+			std::lock_guard<std::mutex> lock(retiredMutex);
+			if (retiredResources.empty()) {
+				return;
+			}
+			resourcesToRelease.swap(retiredResources);
+		}
+		for (auto& resource : resourcesToRelease) {
+			if (resource.destroyFunction) {
+				resource.destroyFunction();
+			}
+		}
+	}
+}
+
+size_t DeferredDestructionQueue::GetNumPendingDestructions() {
+	std::lock_guard<std::mutex> lock(retiredMutex);
+	return retiredResources.size();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// Holds on to GPU resources that were released while frames still in flight
+// might be using them. Each one is tagged with the number of the frame being
+// recorded when it was retired, and destroyed once that frame's fence has
+// signaled, so removing objects never has to wait on the GPU.
+class DeferredDestructionQueue {
+public:
+	typedef std::function<void()> DestroyFunction;
+
+	DeferredDestructionQueue();
+	// destroys whatever is left; the device has to be idle by then
+	~DeferredDestructionQueue();
+
+	void Enqueue(DestroyFunction destroyFunction);
+	// for objects that destroy their own resources, like pipeline modules
+	void KeepAlive(std::shared_ptr<void> object);
+
+	// anything retired from now on is tagged with this frame
+	void BeginFrame(uint64_t frameNumber);
+	// destroys everything retired in frames before numCompletedFrames
+	void ReleaseCompletedFrames(uint64_t numCompletedFrames);
+	// only safe while the device is idle
+	void ReleaseAll();
+
+	size_t GetNumPendingDestructions();
+
+private:
+	struct RetiredResource {
+		uint64_t frameNumber;
+		DestroyFunction destroyFunction;
+	};
+
+	std::mutex retiredMutex;
+	// in frame order, since frame numbers only grow
+	std::deque<RetiredResource> retiredResources;
+	uint64_t currentFrameNumber;
+};
@@ -4,6 +4,10 @@
 #include "VulkanInstance.h"
 #include "GfxDeviceManager.h"
 #include "LogicalDeviceManager.h"
+#include "MemoryAllocator.h"
+#include "UploadContext.h"
+#include "DeferredDestructionQueue.h"
+#include "GpuMeshCache.h"
 #include "GraphicsEngine.h"
 #include "ResourceLoader.h"
 #include "GraphicsEngine.h"
@@ -11,6 +15,8 @@
 #include "CommonBufferModule.h"
 #include "SceneManagement/Scene.h"
 #include "SceneManagement/SceneLoader.h"
+#include "SceneManagement/Terrain.h"
+#include "SceneManagement/SceneQuery.h"
 #include "GameObjects/GameObject.h"
 #include "GameObjects/GameObjectCreationUtilFuncs.h"
 #include "GameObjects/Player/PlayerGameObjectBehavior.h"
@@ -109,19 +115,33 @@ void GameApplicationLogic::PickPhysicalDevice() {
 }
 
 void GameApplicationLogic::InitVulkan() {
+	double startTime = glfwGetTime();
 	CreateInstance();
 	CreateSurface();
 	PickPhysicalDevice();
 	CreateLogicalDevice();
 	CreateCommandPool();
+	double deviceReadyTime = glfwGetTime();
 
 	resourceLoader = new ResourceLoader();
 
 	gameEngine = new GameEngine(GameEngine::GameMode::Menu,
 		gfxDeviceManager, logicalDeviceManager, resourceLoader,
 		surface, window, commandPool, poolInfo);
+	if (sustainedFireBenchmarkEnabled) {
+		gameEngine->EnableSustainedFireBenchmark(
+			logicalDeviceManager->GetMemoryAllocator());
+	}
 
 	CreateSyncObjects();
+	double endTime = glfwGetTime();
+	logicalDeviceManager->GetMemoryAllocator()->PrintStatistics();
+	// pipeline creation dominates the engine time, so this shows whether
+	// the pipeline cache was warm
+	std::cout << "Startup took " << (endTime - startTime) * 1000.0
+		<< " ms: device " << (deviceReadyTime - startTime) * 1000.0
+		<< " ms, engine and scene " << (endTime - deviceReadyTime) * 1000.0
+		<< " ms.\n";
 }
 
 void GameApplicationLogic::CreateSurface() {
@@ -145,11 +165,18 @@ void GameApplicationLogic::RecreateSwapChain() {
 		glfwWaitEvents();
 	}
 
+	// not counting time spent minimized
+	double startTime = glfwGetTime();
 	vkDeviceWaitIdle(logicalDeviceManager->GetDevice());
+	imagesInFlight.clear();
 
 	gameEngine->RecreateGraphicsEngineForNewSwapchain(gfxDeviceManager,
 		logicalDeviceManager, resourceLoader, surface, window, commandPool,
 		poolInfo);
+	// nothing has been submitted since the wait, so all of it can go
+	logicalDeviceManager->GetDeferredDestructionQueue()->ReleaseAll();
+	std::cout << "Swapchain recreation took "
+		<< (glfwGetTime() - startTime) * 1000.0 << " ms.\n";
 }
 
 void GameApplicationLogic::CreateCommandPool() {
@@ -214,6 +241,10 @@ void GameApplicationLogic::MainLoop() {
 			lastFrameReportTime = currentFrameTime;
 			std::cout << "Current FPS: " << 1.0f / deltaTime
 				<< ".\n";
+			// the rest only on request, it's a lot to scroll through
+			if (gameEngine->IsDetailedStatisticsEnabled()) {
+				ReportDetailedStatistics();
+			}
 		}
 
 		glfwPollEvents();
@@ -223,11 +254,87 @@ void GameApplicationLogic::MainLoop() {
 	vkDeviceWaitIdle(logicalDeviceManager->GetDevice());
 }
 
+void GameApplicationLogic::ReportDetailedStatistics() {
+	auto const& renderStatistics =
+		gameEngine->GetGraphicsEngine()->GetRenderStatistics();
+	std::cout << "Culled objects: "
+		<< renderStatistics.numCulledGameObjects
+		<< ", GPU-tested objects: "
+		<< renderStatistics.numGpuTestedGameObjects
+		<< ", draws: " << renderStatistics.numDrawCommands
+		<< ", indices: " << renderStatistics.numIndicesDrawn
+		<< ", binds elided: pipeline "
+		<< renderStatistics.numPipelineBindsElided << ", vertex "
+		<< renderStatistics.numVertexBufferBindsElided << ", index "
+		<< renderStatistics.numIndexBufferBindsElided << ", descriptor "
+		<< renderStatistics.numDescriptorSetBindsElided << ".\n";
+	auto graphicsEngine = gameEngine->GetGraphicsEngine();
+	if (graphicsEngine->IsOcclusionCullingEnabled()) {
+		auto const& occlusionStatistics =
+			graphicsEngine->GetOcclusionStatistics();
+		std::cout << "Occlusion: " << occlusionStatistics.numOccluders
+			<< " occluders, " << occlusionStatistics.numOccluderTriangles
+			<< " triangles, " << occlusionStatistics.numOccludedGameObjects
+			<< " of " << occlusionStatistics.numTestedGameObjects
+			<< " tested objects hidden.\n";
+	}
+	auto meshCacheStatistics =
+		logicalDeviceManager->GetMeshCache()->GetStatistics();
+	std::cout << "Shared meshes: " << meshCacheStatistics.numMeshes
+		<< ", lookups hit: " << meshCacheStatistics.numHits
+		<< ", missed: " << meshCacheStatistics.numMisses
+		<< ", arena blocks: " << meshCacheStatistics.numArenaBlocks
+		<< ".\n";
+	auto modelCacheStatistics =
+		resourceLoader->GetProceduralModelStatistics();
+	auto materialCacheStatistics =
+		resourceLoader->GetMaterialStatistics();
+	std::cout << "Procedural models: "
+		<< modelCacheStatistics.numEntries
+		<< ", lookups hit: " << modelCacheStatistics.numHits
+		<< ", missed: " << modelCacheStatistics.numMisses
+		<< "; materials: " << materialCacheStatistics.numEntries
+		<< ", lookups hit: " << materialCacheStatistics.numHits
+		<< ", missed: " << materialCacheStatistics.numMisses
+		<< ".\n";
+	auto poolStatistics =
+		gameEngine->GetMainGameScene()->GetPoolStatistics();
+	std::cout << "Pooled objects: "
+		<< poolStatistics.numPooledGameObjects << ", free: "
+		<< poolStatistics.numFreeGameObjects << ", active: "
+		<< poolStatistics.numActiveGameObjects << ", spawns reused: "
+		<< poolStatistics.numHits << ", created: "
+		<< poolStatistics.numMisses << ".\n";
+	auto queryStatistics = gameEngine->GetMainGameScene()
+		->GetSceneQuery()->GetStatistics();
+	std::cout << "Queryable objects: " << queryStatistics.numObjects
+		<< ", tree height: " << queryStatistics.treeHeight
+		<< ", reinserted last frame: "
+		<< queryStatistics.numReinsertedObjects << ".\n";
+	Terrain* terrain = gameEngine->GetMainGameScene()->GetTerrain();
+	if (terrain != nullptr) {
+		auto terrainStatistics = terrain->GetStatistics();
+		std::cout << "Terrain: " << terrainStatistics.numLoadedChunks
+			<< " chunks, " << terrainStatistics.numGeneratingChunks
+			<< " generating, " << terrainStatistics.numLoadedVertices
+			<< " vertices.\n";
+	}
+}
+
 bool GameApplicationLogic::CanAcquireNextPresentableImageIndex(
 	uint32_t& imageIndex) {
 	vkWaitForFences(logicalDeviceManager->GetDevice(), 1,
 		&inFlightFences[currentFrame], VK_TRUE,
 		std::numeric_limits<uint64_t>::max());
+	// frames complete in submission order, so everything up to the one
+	// this fence belongs to is done
+	DeferredDestructionQueue* deferredDestructionQueue =
+		logicalDeviceManager->GetDeferredDestructionQueue();
+	uint64_t maxFramesInFlight = (uint64_t)MAX_FRAMES_IN_FLIGHT;
+	if (frameNumber >= maxFramesInFlight) {
+		deferredDestructionQueue->ReleaseCompletedFrames(
+			frameNumber - maxFramesInFlight + 1);
+	}
 
 	VkResult result = vkAcquireNextImageKHR(logicalDeviceManager->GetDevice(),
 		gameEngine->GetGraphicsEngine()->GetSwapChainManager()->GetSwapChain(),
@@ -241,6 +348,19 @@ bool GameApplicationLogic::CanAcquireNextPresentableImageIndex(
 		throw std::runtime_error("Failed to acquire swap chain image!");
 	}
 
+	// images can come back in any order, so the frame that used this one
+	// last might not be the one we just waited for
+	if (imagesInFlight.size() <= imageIndex) {
+		imagesInFlight.resize(imageIndex + 1, VK_NULL_HANDLE);
+	}
+	if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
+		vkWaitForFences(logicalDeviceManager->GetDevice(), 1,
+			&imagesInFlight[imageIndex], VK_TRUE,
+			std::numeric_limits<uint64_t>::max());
+	}
+	imagesInFlight[imageIndex] = inFlightFences[currentFrame];
+	deferredDestructionQueue->BeginFrame(frameNumber);
+
 	return true;
 }
 
@@ -271,12 +391,16 @@ void GameApplicationLogic::DrawFrame(uint32_t imageIndex) {
 
 	vkResetFences(logicalDeviceManager->GetDevice(), 1, &inFlightFences[currentFrame]);
 
+	// this frame's uploads go right ahead of it on the same queue
+	logicalDeviceManager->GetUploadContext()->Flush();
+
 	VkResult submitResult = vkQueueSubmit(logicalDeviceManager->GetGraphicsQueue(),
 		1, &submitInfo, inFlightFences[currentFrame]);
 	if (submitResult != VK_SUCCESS) {
 		std::cerr << "Submit result: " << submitResult << std::endl;
 		throw std::runtime_error("Failed to submit draw command buffer!");
 	}
+	frameNumber++;
 
 	VkPresentInfoKHR presentInfo = {};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -18,6 +18,10 @@ class ResourceLoader;
 class GameApplicationLogic {
 public:
 	void Run();
+	// for --sustained-fire; has to be called before Run
+	void EnableSustainedFireBenchmark() {
+		sustainedFireBenchmarkEnabled = true;
+	}
 
 	static void MouseCallback(GLFWwindow* window, double xpos, double ypos);
 	static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
@@ -52,9 +56,17 @@ private:
 	std::vector<VkSemaphore> imageAvailableSemaphores;
 	std::vector<VkSemaphore> renderFinishedSemaphores;
 	std::vector<VkFence> inFlightFences;
+	// fence of the frame that last rendered to each swap chain image. the
+	// image's command buffers and uniform data can't be touched until it
+	// signals
+	std::vector<VkFence> imagesInFlight;
 	size_t currentFrame = 0;
+	// frames submitted so far; resources retired while recording a frame
+	// are tagged with this
+	uint64_t frameNumber = 0;
 
 	bool framebufferResized = false;
+	bool sustainedFireBenchmarkEnabled = false;
 
 	ResourceLoader* resourceLoader;
 	// this has to be static because we feed
@@ -81,6 +93,7 @@ private:
 	void CreateCommandPool();
 	void CreateSyncObjects();
 	void MainLoop();
+	void ReportDetailedStatistics();
 
 	bool CanAcquireNextPresentableImageIndex(uint32_t& imageIndex);
 	void UpdateGameState(float time, float deltaTime, uint32_t imageIndex);
@@ -7,6 +7,7 @@
 #include "Camera.h"
 #include "SwapChainManager.h"
 #include "SceneManagement/SceneLoader.h"
+#include "SceneManagement/SceneQuery.h"
 #include "GameObjects/GameObject.h"
 #include "GameObjects/MeshGameObject.h"
 #include "GameObjects/GameObjectCreationUtilFuncs.h"
@@ -21,6 +22,8 @@
 #include "Resources/TextureCreator.h"
 #include "Math/CommonMath.h"
 #include "Common.h"
+#include "ThreadPool.h"
+#include "SustainedFireBenchmark.h"
 #define GLM_FORCE_LEFT_HANDED
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <iostream>
@@ -30,6 +33,11 @@ GameEngine::GameEngine(GameMode currentGameMode, GfxDeviceManager* gfxDeviceMana
 	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
 	ResourceLoader* resourceLoader, VkSurfaceKHR surface, GLFWwindow* window,
 	VkCommandPool commandPool, VkCommandPoolCreateInfo poolInfo) {
+	// outlives graphics engines, which get recreated with the swapchain
+	recordingThreadPool = new ThreadPool();
+	gpuCullingEnabled = false;
+	occlusionCullingEnabled = false;
+	detailedStatisticsEnabled = false;
 	sceneSettings =
 		CreateSceneAndReturnSettings(gfxDeviceManager, logicalDeviceManager,
 		resourceLoader, commandPool, poolInfo, surface, window);
@@ -47,6 +55,11 @@ GameEngine::GameEngine(GameMode currentGameMode, GfxDeviceManager* gfxDeviceMana
 	for (auto& gameObject : mainGameObjects) {
 		startingGameObjects.push_back(gameObject);
 	}
+	// pooled objects aren't starting objects; they stay in the scene
+	mainGameScene->PrewarmGameObjectPool(Scene::SpawnType::Bullet,
+		numPrewarmedBullets);
+	mainGameScene->PrewarmGameObjectPool(Scene::SpawnType::Pawn,
+		numPrewarmedPawns);
 	CreateMenuObjects(gfxDeviceManager, logicalDeviceManager,
 		resourceLoader, commandPool);
 
@@ -62,6 +75,7 @@ GameEngine::~GameEngine() {
 	// should auto-delete map of menu object
 
 	delete graphicsEngine;
+	delete recordingThreadPool;
 
 	delete mainGameScene;
 }
@@ -78,7 +92,7 @@ void GameEngine::CreateMenuObjects(GfxDeviceManager* gfxDeviceManager,
 	fontTextureSheet = resourceLoader->BuildRawTexture(textureSheetName,
 		fontTextureBuffer->GetBuffer(), fontTextureBuffer->GetTextureWidth(),
 		fontTextureBuffer->GetTextureHeight(), fontTextureBuffer->GetBytesPerPixel(),
-		gfxDeviceManager, logicalDeviceManager, commandPool);
+		gfxDeviceManager, logicalDeviceManager);
 
 	glm::vec3 characterScale = glm::vec3(0.4f, 0.4f, 0.4f);
 	glm::vec3 characterScaleDifficulty = glm::vec3(0.3f, 0.3f, 0.3f);
@@ -161,12 +175,11 @@ void GameEngine::UpdateGameMode(GameMode newGameMode) {
 	currentGameMode = newGameMode;
 	mainCamera->SetPositionYawPitch(sceneSettings.cameraPosition,
 		sceneSettings.cameraYaw, sceneSettings.cameraPitch);
+	// terrain chunks come and go with the rest of the scene
+	mainGameScene->SetTerrainActive(currentGameMode != GameMode::Menu);
 	if (currentGameMode == GameMode::Menu) {
 		mainCamera->SetPosition(cameraMenuPos);
-		auto& mainGameObjects = mainGameScene->GetGameObjects();
-		for (auto & gameObject : mainGameObjects) {
-			gameObject->SetMarkedForDeletionInScene(true);
-		}
+		mainGameScene->MarkGameObjectsForDeletion();
 		AddMenuItems(MenuPart::Base);
 	}
 	else {
@@ -194,17 +207,28 @@ void GameEngine::RecreateGraphicsEngineForNewSwapchain(
 	ResourceLoader* resourceLoader, VkSurfaceKHR surface, GLFWwindow* window,
 	VkCommandPool commandPool,
 	VkCommandPoolCreateInfo poolCreateInfo) {
+	if (graphicsEngine->RecreateSwapChain(surface, window)) {
+		return;
+	}
+	std::cout << "New swapchain doesn't fit the graphics engine; "
+		<< "rebuilding it.\n";
 	delete graphicsEngine;
 	graphicsEngine = new GraphicsEngine(gfxDeviceManager, logicalDeviceManager,
 		resourceLoader, surface, window, commandPool, poolCreateInfo,
-		mainGameScene->GetGameObjects());
+		recordingThreadPool, mainGameScene->GetGameObjects());
+	graphicsEngine->SetGpuCullingEnabled(gpuCullingEnabled);
+	graphicsEngine->SetOcclusionCullingEnabled(occlusionCullingEnabled);
 }
 
 void GameEngine::UpdateFrame(float time, float deltaTime, uint32_t imageIndex,
 	GfxDeviceManager* gfxDeviceManager, ResourceLoader* resourceLoader,
 	std::vector<VkFence> const& inFlightFences) {
-	mainGameScene->Update(time, deltaTime, imageIndex,
-		mainCamera->ConstructViewMatrix(),
+	if (sustainedFireBenchmark) {
+		sustainedFireBenchmark->Update(time);
+	}
+
+	glm::mat4 viewMatrix = mainCamera->ConstructViewMatrix();
+	mainGameScene->Update(time, deltaTime, imageIndex, viewMatrix,
 		graphicsEngine->GetSwapChainManager()->GetSwapChainExtent());
 
 	auto& gameObjects = mainGameScene->GetGameObjects();
@@ -221,26 +245,19 @@ void GameEngine::UpdateFrame(float time, float deltaTime, uint32_t imageIndex,
 		}
 	}
 
-	bool removedGameObjects = gameObjectsToRemove.size() > 0;
-	if (removedGameObjects) {
+	// removals and additions only touch the objects involved; everything
+	// gets recorded again below anyway
+	if (gameObjectsToRemove.size() > 0) {
 		mainGameScene->RemoveGameObjects(gameObjectsToRemove);
-		if (atLeastOneUnitializedGameObject) {
-			graphicsEngine->RemoveGameObjectsAndReRecordCommandsForAddedGameObjects(
-				gfxDeviceManager, resourceLoader, inFlightFences, gameObjectsToRemove,
-				gameObjects);
-		}
-		else {
-			graphicsEngine->RemoveGameObjectsAndRecordCommands(
-				inFlightFences, gameObjectsToRemove,
-				gameObjects);
-		}
+		graphicsEngine->RemoveGameObjects(gameObjectsToRemove);
 	}
-	else if (atLeastOneUnitializedGameObject) {
-		graphicsEngine->ReRecordCommandsForGameObjects(gfxDeviceManager,
-			resourceLoader, inFlightFences, gameObjects);
+	if (atLeastOneUnitializedGameObject) {
+		graphicsEngine->AddAndInitializeNewGameObjects(gfxDeviceManager,
+			resourceLoader, gameObjects);
 	}
 
-	graphicsEngine->Update(inFlightFences);
+	graphicsEngine->RecordCommandsForFrame(imageIndex, gameObjects,
+		viewMatrix);
 }
 
 SceneLoader::SceneSettings GameEngine::CreateSceneAndReturnSettings(
@@ -260,11 +277,15 @@ SceneLoader::SceneSettings GameEngine::CreateSceneAndReturnSettings(
 
 	SceneLoader::DeserializeJSONFileIntoScene(
 		resourceLoader, gfxDeviceManager, logicalDeviceManager,
-		commandPool, mainGameScene, sceneSettings, scenePath);
+		commandPool, recordingThreadPool, mainGameScene, sceneSettings,
+		scenePath);
 
 	graphicsEngine = new GraphicsEngine(gfxDeviceManager,
 		logicalDeviceManager, resourceLoader, surface, window,
-		commandPool, poolCreateInfo, mainGameScene->GetGameObjects());
+		commandPool, poolCreateInfo, recordingThreadPool,
+		mainGameScene->GetGameObjects());
+	graphicsEngine->SetGpuCullingEnabled(gpuCullingEnabled);
+	graphicsEngine->SetOcclusionCullingEnabled(occlusionCullingEnabled);
 
 	return sceneSettings;
 }
@@ -308,12 +329,60 @@ void GameEngine::ProcessInput(GLFWwindow* window, float frameTime, float lastFra
 
 void GameEngine::ProcessKeyCallback(GLFWwindow* window, int key,
 	int scancode, int action, int mods) {
+	// works in menus and in game
+	if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+		ToggleGpuCulling();
+	}
+	else if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+		ToggleOcclusionCulling();
+	}
+	else if (key == GLFW_KEY_V && action == GLFW_PRESS) {
+		ToggleDetailedStatistics();
+	}
 	if (currentGameMode == GameMode::Game) {
+		if (key == GLFW_KEY_B && action == GLFW_PRESS &&
+			sustainedFireBenchmark) {
+			sustainedFireBenchmark->Start((float)glfwGetTime());
+		}
+		else if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+			PickUnderMouse();
+		}
 		return;
 	}
 	HandleMainMenuControls(window, key, scancode, action, mods);
 }
 
+void GameEngine::ToggleGpuCulling() {
+	if (!graphicsEngine->IsGpuCullingSupported()) {
+		std::cout << "GPU culling isn't supported on this device.\n";
+		return;
+	}
+	gpuCullingEnabled = !gpuCullingEnabled;
+	graphicsEngine->SetGpuCullingEnabled(gpuCullingEnabled);
+	std::cout << "GPU culling " << (gpuCullingEnabled ? "on" : "off")
+		<< ".\n";
+}
+
+void GameEngine::ToggleOcclusionCulling() {
+	occlusionCullingEnabled = !occlusionCullingEnabled;
+	graphicsEngine->SetOcclusionCullingEnabled(occlusionCullingEnabled);
+	std::cout << "Occlusion culling " << (occlusionCullingEnabled ? "on" : "off")
+		<< ".\n";
+}
+
+void GameEngine::ToggleDetailedStatistics() {
+	detailedStatisticsEnabled = !detailedStatisticsEnabled;
+	std::cout << "Detailed statistics " << (detailedStatisticsEnabled ?
+		"on" : "off") << ".\n";
+}
+
+void GameEngine::EnableSustainedFireBenchmark(
+	MemoryAllocator* memoryAllocator) {
+	sustainedFireBenchmark = std::make_unique<SustainedFireBenchmark>(this,
+		memoryAllocator);
+	std::cout << "Sustained fire benchmark on, press B in game to start.\n";
+}
+
 void GameEngine::HandleMainMenuControls(GLFWwindow* window, int key,
 	int scancode, int action, int mods) {
 	bool pressAction = action == GLFW_PRESS;
@@ -521,6 +590,36 @@ void GameEngine::FireMainCannon(float latestFrameTime) {
 	}
 }
 
+void GameEngine::PickUnderMouse() {
+	// unproject the cursor at the front and back of clip space, and cast
+	// through both. GetCurrentMouseWorldCoordAndDir aims at the mothership
+	// instead of through the cursor
+	VkExtent2D extent2D = graphicsEngine->GetSwapChainManager()->GetSwapChainExtent();
+	float ndcX = ((mouseXPos + 0.5f) / extent2D.width) * 2.0f - 1.0f;
+	// y is flipped in projection matrix
+	float ndcY = 2.0f * ((mouseYPos + 0.5f) / extent2D.height) - 1.0f;
+	glm::mat4 projectionViewInv = glm::inverse(
+		CommonMath::ConstructProjectionMatrix(extent2D.width, extent2D.height) *
+		mainCamera->ConstructViewMatrix());
+	glm::vec4 nearPoint = projectionViewInv * glm::vec4(ndcX, ndcY, 0.0f, 1.0f);
+	glm::vec4 farPoint = projectionViewInv * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+	glm::vec3 mouseCoords = glm::vec3(nearPoint) / nearPoint.w;
+	glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w -
+		mouseCoords);
+	// bullets and the player would be in the way of everything
+	uint32_t categoryMask = SceneQuery::AllCategories &
+		~(SceneQuery::BulletCategory | SceneQuery::PlayerCategory);
+	SceneQuery::RaycastHit hit;
+	if (!mainGameScene->GetSceneQuery()->Raycast(mouseCoords, direction,
+		maxPickDistance, categoryMask, hit)) {
+		std::cout << "Picked nothing.\n";
+		return;
+	}
+	std::cout << "Picked object " << hit.distance << " away, at ("
+		<< hit.position.x << ", " << hit.position.y << ", "
+		<< hit.position.z << ").\n";
+}
+
 void GameEngine::GetCurrentMouseWorldCoordAndDir(glm::vec3& mouseCoords,
 	glm::vec3& direction) {
 	glm::vec4 mousePosWithDepth(mouseXPos, mouseYPos, 0.98f, 1.0f);
@@ -20,6 +20,8 @@ class Camera;
 class MenuObject;
 class Model;
 class Material;
+class MemoryAllocator;
+class SustainedFireBenchmark;
 
 class GameEngine {
 public:
@@ -53,11 +55,30 @@ public:
 		return graphicsEngine;
 	}
 
+	Scene* GetMainGameScene() {
+		return mainGameScene;
+	}
+
+	Camera* GetMainCamera() {
+		return mainCamera.get();
+	}
+
+	GameMode GetGameMode() const {
+		return currentGameMode;
+	}
+
+	// lets B start the sustained fire benchmark in game
+	void EnableSustainedFireBenchmark(MemoryAllocator* memoryAllocator);
+
+	// statistics past the FPS line in the periodic report
+	bool IsDetailedStatisticsEnabled() const {
+		return detailedStatisticsEnabled;
+	}
+
 	void SpawnGameObject(Scene::SpawnType spawnType,
 		glm::vec3 const& spawnPosition,
 		glm::vec3 const& forwardDir) {
-		mainGameScene->SpawnGameObject(
-			Scene::SpawnType::Bullet, spawnPosition,
+		mainGameScene->SpawnGameObject(spawnType, spawnPosition,
 			forwardDir);
 	}
 
@@ -73,6 +94,8 @@ private:
 	std::shared_ptr<Camera> mainCamera;
 	Scene* mainGameScene;
 	GraphicsEngine* graphicsEngine;
+	// command buffers are recorded on these every frame
+	class ThreadPool* recordingThreadPool;
 
 	float lastFireTime;
 	float fireInterval;
@@ -90,6 +113,12 @@ private:
 	GLFWwindow* window;
 	SceneLoader::SceneSettings sceneSettings;
 	float mouseXPos, mouseYPos;
+	// kept here so it survives graphics engine rebuilds
+	bool gpuCullingEnabled;
+	bool occlusionCullingEnabled;
+	bool detailedStatisticsEnabled;
+	// only with --sustained-fire on the command line
+	std::unique_ptr<SustainedFireBenchmark> sustainedFireBenchmark;
 
 	static constexpr int numMenus = 3;
 	static inline const std::string playMenuOptionText = "Play";
@@ -102,6 +131,11 @@ private:
 	static inline const std::string backButtonText = "Back";
 	static inline const glm::vec3 textOrigin = glm::vec3(0.0f, 0.0f, 0.0f);
 	static inline const glm::vec3 cameraMenuPos = glm::vec3(0.0f, 0.0f, 80.0f);
+	// enough for a few seconds of firing, and a few waves of pawns
+	static const size_t numPrewarmedBullets = 16;
+	static const size_t numPrewarmedPawns = 16;
+	// past the mothership from anywhere the camera goes
+	static constexpr float maxPickDistance = 1000.0f;
 	static const bool mobileCamera = true;
 	static const bool staticView = false;
 	// TODO: use somehow
@@ -117,6 +151,9 @@ private:
 		std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
 		ResourceLoader* resourceLoader, VkCommandPool commandPool);
 
+	void ToggleGpuCulling();
+	void ToggleOcclusionCulling();
+	void ToggleDetailedStatistics();
 	void HandleMainMenuControls(GLFWwindow* window, int key,
 		int scancode, int action, int mods);
 	void ActivateButtonInCurrentMenu();
@@ -131,6 +168,7 @@ private:
 
 	void HandleMainGameControls(GLFWwindow* window, float frameTime, float lastFrameTime);
 	void FireMainCannon(float latestFrameTime);
+	void PickUnderMouse();
 
 	void GetCurrentMouseWorldCoordAndDir(glm::vec3& mouseCoords,
 		glm::vec3& direction);
@@ -4,9 +4,12 @@ GameObject::GameObject(std::string const& name) :
 	gameObjectBehavior(nullptr),
 	initializedInEngine(false),
 	markedForDeletion(false),
+	active(true),
 	localTransform(1.0f),
 	parentRelativeTransform(1.0f),
 	localToWorld(1.0f),
+	culled(false),
+	occluder(false),
 	name(name) {
 }
 
@@ -15,9 +18,12 @@ GameObject::GameObject(std::shared_ptr<GameObjectBehavior> behavior,
 	gameObjectBehavior(behavior),
 	initializedInEngine(false),
 	markedForDeletion(false),
+	active(true),
 	localTransform(1.0f),
 	parentRelativeTransform(1.0f),
 	localToWorld(1.0f),
+	culled(false),
+	occluder(false),
 	name(name) {
 }
 
@@ -6,6 +6,8 @@
 #include <memory>
 #include <vector>
 
+class UniformRingBufferModule;
+
 // TODO: make a mesh renderer component
 // then, make material responsible for ubo functionality, and
 // make them components of game object
@@ -29,6 +31,12 @@ public:
 		return true;
 	}
 
+	// false while buffers or textures are still streaming in; such
+	// objects are left out of command buffers until they land
+	virtual bool IsReadyToDraw() const {
+		return true;
+	}
+
 	virtual std::shared_ptr<Model> GetModel() {
 		return nullptr;
 	}
@@ -51,6 +59,7 @@ public:
 		this->localToWorld = this->parentRelativeTransform *
 			this->localTransform;
 
+		UpdateWorldBounds();
 		SyncChildTransforms();
 	}
 
@@ -61,6 +70,7 @@ public:
 		this->localToWorld = this->parentRelativeTransform *
 			this->localTransform;
 
+		UpdateWorldBounds();
 		SyncChildTransforms();
 	}
 
@@ -73,6 +83,7 @@ public:
 		this->localTransform = model;
 		this->localToWorld = this->parentRelativeTransform * this->localTransform;
 
+		UpdateWorldBounds();
 		SyncChildTransforms();
 	}
 
@@ -84,6 +95,7 @@ public:
 		this->parentRelativeTransform = model;
 		this->localToWorld = this->parentRelativeTransform * this->localTransform;
 
+		UpdateWorldBounds();
 		SyncChildTransforms();
 	}
 
@@ -91,9 +103,44 @@ public:
 		// affect local transform in such a way that world transform is affected
 		this->localToWorld = matrix;
 		this->localTransform = glm::inverse(this->parentRelativeTransform) * this->localToWorld;
+		UpdateWorldBounds();
 		SyncChildTransforms();
 	}
 
+	// world space, kept up to date as the transform changes. empty if
+	// the object has no geometry of its own
+	AABB const& GetWorldBounds() const {
+		return worldBounds;
+	}
+
+	// set by frustum culling every frame, for every object in the scene.
+	// each one is tested against the bounds of its whole subtree, so a
+	// culled object's children are always culled too
+	bool IsCulled() const {
+		return culled;
+	}
+
+	void SetCulled(bool value) {
+		culled = value;
+	}
+
+	// occluders are drawn into the CPU occlusion buffer, so that objects
+	// behind them can be culled. big meshes can give a simpler model that
+	// covers no more than they do
+	bool IsOccluder() const {
+		return occluder;
+	}
+
+	void SetOccluder(bool value,
+		std::shared_ptr<Model> const& occluderModel = nullptr) {
+		occluder = value;
+		this->occluderModel = occluderModel;
+	}
+
+	std::shared_ptr<Model> GetOccluderModel() {
+		return occluderModel != nullptr ? occluderModel : GetModel();
+	}
+
 	bool GetInitializedInEngine() const {
 		return initializedInEngine;
 	}
@@ -110,6 +157,17 @@ public:
 		markedForDeletion = value;
 	}
 
+	// inactive objects keep everything they were initialized with in the
+	// engine, but aren't updated or drawn. pooled objects wait like this
+	// until they are spawned again
+	bool IsActive() const {
+		return active;
+	}
+
+	void SetActive(bool value) {
+		active = value;
+	}
+
 	virtual void UpdateState(float time, float deltaTime);
 	virtual void UpdateVisualState(uint32_t imageIndex, const glm::mat4& viewMatrix,
 		float time, float deltaTime,
@@ -124,6 +182,26 @@ public:
 		return VK_NULL_HANDLE;
 	}
 
+	// where the object's geometry starts in the buffers above, which can
+	// be shared with other objects
+	virtual int32_t GetVertexOffset() const {
+		return 0;
+	}
+
+	virtual uint32_t GetFirstIndex() const {
+		return 0;
+	}
+
+	virtual uint32_t GetIndexCount() const {
+		return 0;
+	}
+
+	// which of the model's levels of detail the buffers above hold. 0 is
+	// the model itself
+	virtual size_t GetLodLevel() const {
+		return 0;
+	}
+
 	virtual std::string GetVertexShaderName() const {
 		return "";
 	}
@@ -132,10 +210,41 @@ public:
 		return "";
 	}
 
+	virtual std::shared_ptr<Material> GetMaterial() const {
+		return nullptr;
+	}
+
+	// objects that support instancing can be batched with others that
+	// share their model, pipeline and texture into one draw call
+	virtual bool SupportsInstancing() const {
+		return false;
+	}
+
+	virtual std::string GetInstancedVertexShaderName() const {
+		return "";
+	}
+
+	virtual std::string GetInstancedFragmentShaderName() const {
+		return "";
+	}
+
+	virtual glm::vec4 GetInstanceTint() const {
+		return glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+	}
+
 	virtual VkDescriptorSet* GetDescriptorSetPtr(size_t swapChainIndex) {
 		return nullptr;
 	}
 
+	static const uint32_t maxDynamicOffsets = 2;
+
+	// writes dynamic offsets of uniform buffers, in binding order.
+	// returns number of offsets written, at most maxDynamicOffsets
+	virtual uint32_t GetDynamicOffsets(size_t swapChainIndex,
+		uint32_t* dynamicOffsets) const {
+		return 0;
+	}
+
 	virtual VkDescriptorSetLayout GetDescriptorSetLayout() const {
 		return VK_NULL_HANDLE;
 	}
@@ -144,8 +253,8 @@ public:
 		return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	}
 
-	virtual void InitAndCreateUniformBuffers(GfxDeviceManager* gfxDeviceManager,
-		size_t numSwapChainImages) {
+	virtual void InitAndCreateUniformBuffers(
+		std::shared_ptr<UniformRingBufferModule> const& uniformRingBuffer) {
 	}
 
 	virtual void CreateDescriptorPoolAndSets(size_t numSwapChainImages) {
@@ -197,13 +306,30 @@ protected:
 
 	bool initializedInEngine;
 	bool markedForDeletion;
+	bool active;
 
 	glm::mat4 localTransform;
 	glm::mat4 parentRelativeTransform;
 	glm::mat4 localToWorld;
+	AABB worldBounds;
+	bool culled;
+	bool occluder;
+	std::shared_ptr<Model> occluderModel;
 
 	std::string name;
 
+	// local space bounds of whatever the object draws. objects that
+	// don't draw anything have none
+	virtual AABB GetLocalBounds() const {
+		return AABB();
+	}
+
+	// has to be called when the local bounds change. transform setters
+	// call it on their own
+	void UpdateWorldBounds() {
+		worldBounds = GetLocalBounds().Transformed(localToWorld);
+	}
+
 	void SyncChildTransforms() {
 		if (childGameObjects.size() > 0) {
 			for (auto& gameObject : childGameObjects) {
@@ -7,6 +7,11 @@
 #include "LogicalDeviceManager.h"
 #include "Resources/Model.h"
 
+static std::shared_ptr<TextureCreator> GetMainTexture(
+	std::string const& mainTextureName, bool isRawTexture,
+	ResourceLoader* resourceLoader, GfxDeviceManager* gfxDeviceManager,
+	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager);
+
 std::shared_ptr<MeshGameObject> GameObjectCreator::CreateMeshGameObject(
 	std::shared_ptr<Material> const& material,
 	std::shared_ptr<Model> const& gameObjectModel,
@@ -40,18 +45,9 @@ std::shared_ptr<Material> GameObjectCreator::CreateMaterial(
 	GfxDeviceManager* gfxDeviceManager,
 	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
 	VkCommandPool commandPool) {
-#if __APPLE__
-	const std::string texturePathPrefix = "../../textures/";
-#else
-	const std::string texturePathPrefix = "../textures/";
-#endif
-	std::string texturePath = texturePathPrefix + mainTextureName;
-
-	std::shared_ptr<TextureCreator> mainTexture =
-		isRawTexture ?
-		resourceLoader->GetRawTexture(mainTextureName) :
-		resourceLoader->GetTexture(texturePath, gfxDeviceManager,
-			logicalDeviceManager, commandPool);
+	std::shared_ptr<TextureCreator> mainTexture = GetMainTexture(
+		mainTextureName, isRawTexture, resourceLoader, gfxDeviceManager,
+		logicalDeviceManager);
 
 	return std::make_shared<Material>(mainTexture,
 		materialEnumType, materialNode);
@@ -63,6 +59,30 @@ std::shared_ptr<Material> GameObjectCreator::CreateMaterial(
 	return std::make_shared<Material>(materialEnumType, materialNode);
 }
 
+std::shared_ptr<Material> GameObjectCreator::GetSharedMaterial(
+	DescriptorSetFunctions::MaterialType materialEnumType,
+	std::string const& mainTextureName,
+	nlohmann::json const& materialNode,
+	bool isRawTexture,
+	ResourceLoader* resourceLoader,
+	GfxDeviceManager* gfxDeviceManager,
+	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager) {
+	std::shared_ptr<TextureCreator> mainTexture = GetMainTexture(
+		mainTextureName, isRawTexture, resourceLoader, gfxDeviceManager,
+		logicalDeviceManager);
+
+	return resourceLoader->GetMaterial(materialEnumType, mainTexture,
+		materialNode);
+}
+
+std::shared_ptr<Material> GameObjectCreator::GetSharedMaterial(
+	DescriptorSetFunctions::MaterialType materialEnumType,
+	nlohmann::json const& materialNode,
+	ResourceLoader* resourceLoader) {
+	return resourceLoader->GetMaterial(materialEnumType, nullptr,
+		materialNode);
+}
+
 std::shared_ptr<Model> GameObjectCreator::LoadModelFromName(
 	std::string const& modelName,
 	ResourceLoader* resourceLoader) {
@@ -75,3 +95,19 @@ std::shared_ptr<Model> GameObjectCreator::LoadModelFromName(
 	return resourceLoader->GetModel(modelPath);
 }
 
+static std::shared_ptr<TextureCreator> GetMainTexture(
+	std::string const& mainTextureName, bool isRawTexture,
+	ResourceLoader* resourceLoader, GfxDeviceManager* gfxDeviceManager,
+	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager) {
+#if __APPLE__
+	const std::string texturePathPrefix = "../../textures/";
+#else
+	const std::string texturePathPrefix = "../textures/";
+#endif
+	std::string texturePath = texturePathPrefix + mainTextureName;
+
+	return isRawTexture ?
+		resourceLoader->GetRawTexture(mainTextureName) :
+		resourceLoader->GetTexture(texturePath, gfxDeviceManager,
+			logicalDeviceManager);
+}
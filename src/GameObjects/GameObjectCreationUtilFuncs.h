@@ -45,6 +45,23 @@ public:
 		DescriptorSetFunctions::MaterialType materialEnumType,
 		nlohmann::json const& materialNode = nlohmann::json());
 
+	// like CreateMaterial, but everyone asking for the same type, texture
+	// and parameters gets the same material from the resource loader.
+	// meant for objects spawned at runtime
+	static std::shared_ptr<Material> GetSharedMaterial(
+		DescriptorSetFunctions::MaterialType materialEnumType,
+		std::string const& mainTextureName,
+		nlohmann::json const& materialNode,
+		bool isRawTexture,
+		ResourceLoader* resourceLoader,
+		GfxDeviceManager* gfxDeviceManager,
+		std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager);
+
+	static std::shared_ptr<Material> GetSharedMaterial(
+		DescriptorSetFunctions::MaterialType materialEnumType,
+		nlohmann::json const& materialNode,
+		ResourceLoader* resourceLoader);
+
 	static std::shared_ptr<Model> LoadModelFromName(
 		std::string const& modelName,
 		ResourceLoader* resourceLoader);
@@ -3,10 +3,17 @@
 #include "Vertex.h"
 #include "GfxDeviceManager.h"
 #include "LogicalDeviceManager.h"
+#include "GpuMeshCache.h"
+#include "DeferredDestructionQueue.h"
 #include "Math/CommonMath.h"
 #include "Resources/TextureCreator.h"
+#include "UniformRingBufferModule.h"
 
 #include <iostream>
+#include <cfloat>
+#include <cmath>
+
+const float MeshGameObject::lodHysteresis = 0.1f;
 
 MeshGameObject::MeshGameObject(
 	std::shared_ptr<GameObjectBehavior> behavior,
@@ -20,17 +27,12 @@ MeshGameObject::MeshGameObject(
 	logicalDeviceManager(logicalDeviceManager),
 	descriptorPool(VK_NULL_HANDLE),
 	descriptorSetLayout(VK_NULL_HANDLE),
-	vertexStagingBuffer(VK_NULL_HANDLE),
-	vertexStagingBufferMemory(VK_NULL_HANDLE),
-	vertexBuffer(VK_NULL_HANDLE),
-	vertexBufferMemory(VK_NULL_HANDLE),
-	indexStagingBuffer(VK_NULL_HANDLE),
-	indexStagingBufferMemory(VK_NULL_HANDLE),
-	indexBuffer(VK_NULL_HANDLE),
-	indexBufferMemory(VK_NULL_HANDLE),
 	commandPool(commandPool),
 	gfxDeviceManager(gfxDeviceManager),
 	vertUboData(nullptr), fragUboData(nullptr),
+	vertSliceOffset(0), vertSliceSize(0),
+	fragSliceOffset(0), fragSliceSize(0),
+	vertexLayout(VertexLayout::Pos), lodLevel(0),
 	objModel(model), material(material) {
 	InitializeMeshState();
 }
@@ -43,15 +45,10 @@ MeshGameObject::MeshGameObject(GfxDeviceManager* gfxDeviceManager,
 	logicalDeviceManager(logicalDeviceManager), commandPool(commandPool),
 	descriptorPool(VK_NULL_HANDLE),
 	descriptorSetLayout(VK_NULL_HANDLE),
-	vertexStagingBuffer(VK_NULL_HANDLE),
-	vertexStagingBufferMemory(VK_NULL_HANDLE),
-	vertexBuffer(VK_NULL_HANDLE),
-	vertexBufferMemory(VK_NULL_HANDLE),
-	indexStagingBuffer(VK_NULL_HANDLE),
-	indexStagingBufferMemory(VK_NULL_HANDLE),
-	indexBuffer(VK_NULL_HANDLE),
-	indexBufferMemory(VK_NULL_HANDLE),
 	vertUboData(nullptr), fragUboData(nullptr),
+	vertSliceOffset(0), vertSliceSize(0),
+	fragSliceOffset(0), fragSliceSize(0),
+	vertexLayout(VertexLayout::Pos), lodLevel(0),
 	objModel(nullptr), material(nullptr) {
 }
 
@@ -63,82 +60,124 @@ void MeshGameObject::InitializeMeshState() {
 	descriptorSetLayout = DescriptorSetFunctions::CreateDescriptorSetLayout(
 		logicalDeviceManager->GetDevice(), GetMaterialType());
 
-	CreateOrUpdateVertexBufferForMaterial(gfxDeviceManager,
-		commandPool);
+	AcquireMeshForMaterial(gfxDeviceManager);
 
-	CreateOrUpdateIndexBuffer(gfxDeviceManager, commandPool);
+	UpdateWorldBounds();
 }
 
-void MeshGameObject::CreateOrUpdateVertexBufferForMaterial(GfxDeviceManager* gfxDeviceManager,
-	VkCommandPool commandPool) {
+AABB MeshGameObject::GetLocalBounds() const {
 	if (objModel == nullptr) {
-		vertexBuffer = VK_NULL_HANDLE;
-		vertexStagingBuffer = VK_NULL_HANDLE;
+		return AABB();
+	}
+	AABB localBounds = objModel->GetBoundingBox();
+	localBounds.Expand(GetMaxVertexDisplacement(GetMaterialType()));
+	return localBounds;
+}
+
+float MeshGameObject::GetMaxVertexDisplacement(
+	DescriptorSetFunctions::MaterialType materialType) {
+	switch (materialType) {
+		// sum of the three gerstner wave amplitudes
+		case DescriptorSetFunctions::MaterialType::WavySurface:
+			return 6.0f;
+		// ripples, stalks and shudder all push outwards
+		case DescriptorSetFunctions::MaterialType::MotherShip:
+			return 32.0f;
+		default:
+			return 0.0f;
+	}
+}
+
+void MeshGameObject::AcquireMeshForMaterial(GfxDeviceManager* gfxDeviceManager) {
+	lodMeshes.clear();
+	lodLevel = 0;
+	if (objModel == nullptr) {
+		mesh = nullptr;
 		return;
 	}
 
 	switch (GetMaterialType()) {
 		case DescriptorSetFunctions::MaterialType::UnlitColor:
-			CreateOrUpdateVertexBuffer(objModel->BuildAndReturnVertsPos(),
-				gfxDeviceManager, commandPool);
+			vertexLayout = VertexLayout::Pos;
 			break;
 		case DescriptorSetFunctions::MaterialType::UnlitTintedTextured:
-			CreateOrUpdateVertexBuffer(objModel->BuildAndReturnVertsPosColorTexCoord(),
-				gfxDeviceManager, commandPool);
-			break;
 		case DescriptorSetFunctions::MaterialType::MotherShip:
-			CreateOrUpdateVertexBuffer(objModel->BuildAndReturnVertsPosColorTexCoord(),
-				gfxDeviceManager, commandPool);
+			vertexLayout = VertexLayout::PosColorTexCoord;
 			break;
 		case DescriptorSetFunctions::MaterialType::WavySurface:
-			CreateOrUpdateVertexBuffer(objModel->BuildAndReturnVertsPosNormalColorTexCoord(),
-				gfxDeviceManager, commandPool);
-			break;
 		case DescriptorSetFunctions::MaterialType::BumpySurface:
-			CreateOrUpdateVertexBuffer(objModel->BuildAndReturnVertsPosNormalColorTexCoord(),
-				gfxDeviceManager, commandPool);
+			vertexLayout = VertexLayout::PosNormalColorTexCoord;
 			break;
 		case DescriptorSetFunctions::MaterialType::Text:
-			CreateOrUpdateVertexBuffer(objModel->BuildAndReturnVertsPosTex(),
-				gfxDeviceManager, commandPool);
+			vertexLayout = VertexLayout::PosTex;
 			break;
 		default:
-			vertexBuffer = VK_NULL_HANDLE;
-			vertexStagingBuffer = VK_NULL_HANDLE;
-			break;
+			mesh = nullptr;
+			return;
 	}
+	mesh = logicalDeviceManager->GetMeshCache()->GetMesh(objModel,
+		vertexLayout, gfxDeviceManager);
+	lodMeshes.resize(1 + objModel->GetLods().size());
+	lodMeshes[0] = mesh;
 }
 
-template<typename VertexType>
-void MeshGameObject::CreateOrUpdateVertexBuffer(std::vector<VertexType> const & vertices,
-											GfxDeviceManager *gfxDeviceManager,
-											VkCommandPool commandPool) {
-	VkDeviceSize bufferSize = sizeof(vertices[0])*vertices.size();
-	if (bufferSize == 0) {
-		return;
+Model* MeshGameObject::GetLodModel(size_t level) const {
+	return level == 0 ? objModel.get() :
+		objModel->GetLods()[level - 1].model.get();
+}
+
+uint32_t MeshGameObject::GetIndexCount() const {
+	if (objModel == nullptr) {
+		return 0;
 	}
+	return (uint32_t)GetLodModel(lodLevel)->GetIndices().size();
+}
 
-	if (vertexStagingBuffer == VK_NULL_HANDLE) {
-		Common::CreateBuffer(logicalDeviceManager.get(), gfxDeviceManager, bufferSize,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			vertexStagingBuffer, vertexStagingBufferMemory);
+void MeshGameObject::UpdateLodLevel(const glm::mat4& viewMatrix,
+	VkExtent2D const& swapChainExtent) {
+	if (lodMeshes.size() < 2) {
+		return;
 	}
 
-	void *data;
-	vkMapMemory(logicalDeviceManager->GetDevice(), vertexStagingBufferMemory, 0,
-		bufferSize, 0, &data);
-	memcpy(data, vertices.data(), (size_t)bufferSize);
-	vkUnmapMemory(logicalDeviceManager->GetDevice(), vertexStagingBufferMemory);
+	// level i > 0 is drawn below lods[i - 1].maxScreenSize
+	auto const& lods = objModel->GetLods();
+	float screenSize = GetScreenSize(viewMatrix, swapChainExtent);
+	size_t newLodLevel = lodLevel;
+	while (newLodLevel > 0 && screenSize >
+		lods[newLodLevel - 1].maxScreenSize * (1.0f + lodHysteresis)) {
+		newLodLevel--;
+	}
+	while (newLodLevel < lods.size() && screenSize <
+		lods[newLodLevel].maxScreenSize * (1.0f - lodHysteresis)) {
+		newLodLevel++;
+	}
+	if (newLodLevel == lodLevel) {
+		return;
+	}
 
-	if (vertexBuffer == VK_NULL_HANDLE) {
-		Common::CreateBuffer(logicalDeviceManager.get(), gfxDeviceManager, bufferSize,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
+	lodLevel = newLodLevel;
+	if (lodMeshes[lodLevel] == nullptr) {
+		lodMeshes[lodLevel] = logicalDeviceManager->GetMeshCache()->GetMesh(
+			lods[lodLevel - 1].model, vertexLayout, gfxDeviceManager);
 	}
+	mesh = lodMeshes[lodLevel];
+}
 
-	Common::CopyBuffer(logicalDeviceManager.get(), commandPool, vertexStagingBuffer,
-		vertexBuffer, bufferSize);
+float MeshGameObject::GetScreenSize(const glm::mat4& viewMatrix,
+	VkExtent2D const& swapChainExtent) const {
+	BoundingSphere localSphere = objModel->GetBoundingSphere();
+	localSphere.radius += GetMaxVertexDisplacement(GetMaterialType());
+	BoundingSphere viewSphere = localSphere.Transformed(
+		viewMatrix * localToWorld);
+	float distance = glm::length(viewSphere.center);
+	// the camera is inside of it
+	if (distance <= viewSphere.radius) {
+		return FLT_MAX;
+	}
+	// [1][1] is one over the tangent of half the vertical field of view
+	glm::mat4 projectionMatrix = CommonMath::ConstructProjectionMatrix(
+		swapChainExtent.width, swapChainExtent.height);
+	return viewSphere.radius * fabs(projectionMatrix[1][1]) / distance;
 }
 
 MeshGameObject::~MeshGameObject() {
@@ -149,44 +188,37 @@ MeshGameObject::~MeshGameObject() {
 		delete fragUboData;
 	}
 
-	if (vertexStagingBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(logicalDeviceManager->GetDevice(), vertexStagingBuffer, nullptr);
-	}
-	if (vertexStagingBufferMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(logicalDeviceManager->GetDevice(), vertexStagingBufferMemory, nullptr);
-	}
-	if (vertexBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(logicalDeviceManager->GetDevice(), vertexBuffer, nullptr);
-	}
-	if (vertexBufferMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(logicalDeviceManager->GetDevice(), vertexBufferMemory, nullptr);
-	}
-	
-	if (indexStagingBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(logicalDeviceManager->GetDevice(), indexStagingBuffer, nullptr);
-	}
-	if (indexStagingBufferMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(logicalDeviceManager->GetDevice(), indexStagingBufferMemory, nullptr);
-	}
-	if (indexBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(logicalDeviceManager->GetDevice(), indexBuffer, nullptr);
-	}
-	if (indexBufferMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(logicalDeviceManager->GetDevice(), indexBufferMemory, nullptr);
-	}
+	// the mesh retires its buffers once its last user is gone
+	mesh = nullptr;
 	if (descriptorSetLayout != VK_NULL_HANDLE) {
-		vkDestroyDescriptorSetLayout(logicalDeviceManager->GetDevice(), descriptorSetLayout, nullptr);
+		VkDevice device = logicalDeviceManager->GetDevice();
+		VkDescriptorSetLayout retiredLayout = descriptorSetLayout;
+		logicalDeviceManager->GetDeferredDestructionQueue()->Enqueue(
+			[device, retiredLayout]() {
+				vkDestroyDescriptorSetLayout(device, retiredLayout, nullptr);
+			});
+		descriptorSetLayout = VK_NULL_HANDLE;
 	}
 
 	CleanUpUniformBuffers();
 	CleanUpDescriptorPool();
 }
 
+bool MeshGameObject::IsReadyToDraw() const {
+	TextureCreator* textureCreator = material == nullptr ? nullptr :
+		material->GetTextureLoader();
+	return textureCreator == nullptr || textureCreator->IsResident();
+}
+
 void MeshGameObject::SetupShaderNames() {
+	instancedVertexShaderName = "";
+	instancedFragmentShaderName = "";
 	switch (GetMaterialType()) {
 		case DescriptorSetFunctions::MaterialType::UnlitColor:
 			vertexShaderName = "UnlitColorVert.spv";
 			fragmentShaderName = "UnlitColorFrag.spv";
+			instancedVertexShaderName = "UnlitColorInstancedVert.spv";
+			instancedFragmentShaderName = "UnlitColorInstancedFrag.spv";
 			break;
 		case DescriptorSetFunctions::MaterialType::MotherShip:
 			vertexShaderName = "MotherShipVert.spv";
@@ -195,6 +227,9 @@ void MeshGameObject::SetupShaderNames() {
 		case DescriptorSetFunctions::MaterialType::UnlitTintedTextured:
 			vertexShaderName = "UnlitTintedTexturedVert.spv";
 			fragmentShaderName = "UnlitTintedTexturedFrag.spv";
+			// fragment stage doesn't change when instanced
+			instancedVertexShaderName = "UnlitTintedTexturedInstancedVert.spv";
+			instancedFragmentShaderName = "UnlitTintedTexturedFrag.spv";
 			break;
 		case DescriptorSetFunctions::MaterialType::WavySurface:
 			vertexShaderName = "WavySurfaceVert.spv";
@@ -215,70 +250,66 @@ void MeshGameObject::SetupShaderNames() {
 	}
 }
 
-void MeshGameObject::CreateOrUpdateIndexBuffer(GfxDeviceManager *gfxDeviceManager,
-											VkCommandPool commandPool) {
-	if (objModel == nullptr) {
-		return;
-	}
-	std::vector<uint32_t> const& indices = objModel->GetIndices();
-
-	VkDeviceSize bufferSize = sizeof(indices[0])*indices.size();
-
-	if (indexStagingBuffer == VK_NULL_HANDLE) {
-		Common::CreateBuffer(logicalDeviceManager.get(), gfxDeviceManager,
-			bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			indexStagingBuffer, indexStagingBufferMemory);
-	}
-
-	void* data;
-	vkMapMemory(logicalDeviceManager->GetDevice(), indexStagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, indices.data(), (size_t)bufferSize);
-	vkUnmapMemory(logicalDeviceManager->GetDevice(), indexStagingBufferMemory);
-
-	if (indexBuffer == VK_NULL_HANDLE) {
-		Common::CreateBuffer(logicalDeviceManager.get(), gfxDeviceManager, bufferSize,
-			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
+glm::vec4 MeshGameObject::GetInstanceTint() const {
+	// unlit color objects store their color in the fragment ubo,
+	// which instanced draws don't read from
+	if (GetMaterialType() == DescriptorSetFunctions::MaterialType::UnlitColor &&
+		fragUboData != nullptr) {
+		return ((UniformBufferUnlitColor*)fragUboData)->objectColor;
 	}
-
-	Common::CopyBuffer(logicalDeviceManager.get(), commandPool, indexStagingBuffer,
-		indexBuffer, bufferSize);
+	return glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 }
 
-void MeshGameObject::CreateUniformBuffers(GfxDeviceManager* gfxDeviceManager, size_t numSwapChainImages) {
+void MeshGameObject::CreateUniformBuffers() {
 	if (IsInvisible()) {
 		return;
 	}
-	VkDeviceSize bufferSizeVert = GetMaterialUniformBufferSizeVert();
-	VkDeviceSize bufferSizeFrag = GetMaterialUniformBufferSizeFrag();
+	vertSliceSize = GetMaterialUniformBufferSizeVert();
+	fragSliceSize = GetMaterialUniformBufferSizeFrag();
 	
-	for (size_t i = 0; i < numSwapChainImages; i++) {
-		uniformBuffersVert.push_back(new GameObjectUniformBufferObj(logicalDeviceManager, gfxDeviceManager,
-			(int)bufferSizeVert));
-		uniformBuffersFrag.push_back(new GameObjectUniformBufferObj(logicalDeviceManager, gfxDeviceManager,
-			(int)bufferSizeFrag));
+	if (vertSliceSize > 0) {
+		vertSliceOffset = uniformRingBuffer->AllocateSlice(vertSliceSize);
+	}
+	if (fragSliceSize > 0) {
+		fragSliceOffset = uniformRingBuffer->AllocateSlice(fragSliceSize);
 	}
 }
 
 void MeshGameObject::CleanUpUniformBuffers() {
-	size_t numBuffers = uniformBuffersVert.size();
-	
-	for (size_t bufferIndex = 0; bufferIndex < numBuffers;
-		 bufferIndex++)
-	{
-		delete uniformBuffersVert[bufferIndex];
-		delete uniformBuffersFrag[bufferIndex];
+	if (uniformRingBuffer == nullptr) {
+		return;
 	}
 	
-	uniformBuffersVert.clear();
-	uniformBuffersFrag.clear();
+	if (vertSliceSize > 0) {
+		uniformRingBuffer->FreeSlice(vertSliceOffset, vertSliceSize);
+	}
+	if (fragSliceSize > 0) {
+		uniformRingBuffer->FreeSlice(fragSliceOffset, fragSliceSize);
+	}
+	vertSliceSize = 0;
+	fragSliceSize = 0;
+	uniformRingBuffer = nullptr;
 }
 
-void MeshGameObject::InitAndCreateUniformBuffers(GfxDeviceManager* gfxDeviceManager,
-							size_t numSwapChainImages) {
+void MeshGameObject::InitAndCreateUniformBuffers(
+	std::shared_ptr<UniformRingBufferModule> const& uniformRingBuffer) {
 	CleanUpUniformBuffers();
-	CreateUniformBuffers(gfxDeviceManager, numSwapChainImages);
+	this->uniformRingBuffer = uniformRingBuffer;
+	CreateUniformBuffers();
+}
+
+uint32_t MeshGameObject::GetDynamicOffsets(size_t swapChainIndex,
+	uint32_t* dynamicOffsets) const {
+	uint32_t numDynamicOffsets = 0;
+	if (vertSliceSize > 0) {
+		dynamicOffsets[numDynamicOffsets++] =
+			uniformRingBuffer->GetDynamicOffset(swapChainIndex, vertSliceOffset);
+	}
+	if (fragSliceSize > 0) {
+		dynamicOffsets[numDynamicOffsets++] =
+			uniformRingBuffer->GetDynamicOffset(swapChainIndex, fragSliceOffset);
+	}
+	return numDynamicOffsets;
 }
 
 void MeshGameObject::CreateDescriptorPoolAndSets(size_t numSwapChainImages) {
@@ -296,37 +327,33 @@ void MeshGameObject::UpdateVisualState(uint32_t imageIndex,
 	if (IsInvisible()) {
 		return;
 	}
+	UpdateLodLevel(viewMatrix, swapChainExtent);
 	
 	AllocateVertexUBODataIfNecessary(vertUboSize, imageIndex, viewMatrix,
 		time, deltaTime, swapChainExtent);
 	UpdateVertUBOData(vertUboData,
 		swapChainExtent, viewMatrix, time, deltaTime);
-	if (vertUboData != nullptr) {
-		void* data;
-		vkMapMemory(logicalDeviceManager->GetDevice(),
-			uniformBuffersVert[imageIndex]->GetUniformBufferMemory(), 0,
-			vertUboSize, 0, &data);
-		memcpy(data, vertUboData, vertUboSize);
-		vkUnmapMemory(logicalDeviceManager->GetDevice(),
-			uniformBuffersVert[imageIndex]->GetUniformBufferMemory());
+	// ring buffer stays mapped, so just copy into our slice
+	if (vertUboData != nullptr && vertSliceSize > 0) {
+		memcpy(uniformRingBuffer->GetSliceData(imageIndex, vertSliceOffset),
+			vertUboData, vertUboSize);
 	}
 
 	AllocateFragUBODataIfNecessary(fragUboSize);
 	UpdateFragUBOData(fragUboData);
-	if (fragUboData != nullptr) {
-		void* data;
-		vkMapMemory(logicalDeviceManager->GetDevice(),
-			uniformBuffersFrag[imageIndex]->GetUniformBufferMemory(), 0,
-			fragUboSize, 0, &data);
-		memcpy(data, fragUboData, fragUboSize);
-		vkUnmapMemory(logicalDeviceManager->GetDevice(),
-			uniformBuffersFrag[imageIndex]->GetUniformBufferMemory());
+	if (fragUboData != nullptr && fragSliceSize > 0) {
+		memcpy(uniformRingBuffer->GetSliceData(imageIndex, fragSliceOffset),
+			fragUboData, fragUboSize);
 	}
 }
 
 void MeshGameObject::UpdateVertexBufferWithLatestModelVerts() {
-	CreateOrUpdateVertexBufferForMaterial(gfxDeviceManager,
-		commandPool);
+	// levels that haven't been drawn yet upload their model when they are
+	for (auto& lodMesh : lodMeshes) {
+		if (lodMesh != nullptr) {
+			lodMesh->UpdateVertices();
+		}
+	}
 }
 
 void MeshGameObject::CreateDescriptorPool(size_t numSwapChainImages) {
@@ -362,16 +389,19 @@ void MeshGameObject::CreateDescriptorSets(size_t numSwapChainImages) {
 		throw std::runtime_error("Failed to allocate descriptor sets!");
 	}
 	
+	// the actual slice is picked with dynamic offsets when binding
 	for (size_t i = 0; i < numSwapChainImages; ++i) {
 		VkDescriptorBufferInfo bufferInfoVert = {};
-		bufferInfoVert.buffer = uniformBuffersVert[i]->GetUniformBuffer();
+		bufferInfoVert.buffer = uniformRingBuffer->GetUniformBuffer(
+			vertSliceOffset);
 		bufferInfoVert.offset = 0;
-		bufferInfoVert.range = uniformBuffersVert[i]->GetBufferSize();
+		bufferInfoVert.range = vertSliceSize;
 		
 		VkDescriptorBufferInfo bufferInfoFrag = {};
-		bufferInfoFrag.buffer = uniformBuffersFrag[i]->GetUniformBuffer();
+		bufferInfoFrag.buffer = uniformRingBuffer->GetUniformBuffer(
+			fragSliceOffset);
 		bufferInfoFrag.offset = 0;
-		bufferInfoFrag.range = uniformBuffersFrag[i]->GetBufferSize();
+		bufferInfoFrag.range = fragSliceSize;
 
 		DescriptorSetFunctions::UpdateDescriptorSet(logicalDeviceManager->GetDevice(),
 			material,
@@ -383,7 +413,13 @@ void MeshGameObject::CreateDescriptorSets(size_t numSwapChainImages) {
 
 void MeshGameObject::CleanUpDescriptorPool() {
 	if (descriptorPool != nullptr) {
-		vkDestroyDescriptorPool(logicalDeviceManager->GetDevice(), descriptorPool, nullptr);
+		// sets from the old pool might be bound in frames in flight
+		VkDevice device = logicalDeviceManager->GetDevice();
+		VkDescriptorPool retiredPool = descriptorPool;
+		logicalDeviceManager->GetDeferredDestructionQueue()->Enqueue(
+			[device, retiredPool]() {
+				vkDestroyDescriptorPool(device, retiredPool, nullptr);
+			});
 		descriptorPool = nullptr;
 	}
 }
@@ -410,15 +446,13 @@ VkDeviceSize MeshGameObject::GetMaterialUniformBufferSizeVert()
 }
 
 VkDeviceSize MeshGameObject::GetMaterialUniformBufferSizeFrag() {
-	VkDeviceSize bufferSizeFrag = sizeof(UniformBufferObjectLighting);
+	// only materials that bind a fragment ubo get a slice for it
+	VkDeviceSize bufferSizeFrag = 0;
 	auto materialType = material->GetMaterialType();
 	if (materialType == DescriptorSetFunctions::MaterialType::UnlitColor ||
 		materialType == DescriptorSetFunctions::MaterialType::Text) {
 		bufferSizeFrag = sizeof(UniformBufferUnlitColor);
 	}
-	else if (materialType == DescriptorSetFunctions::MaterialType::Unspecified) {
-		bufferSizeFrag = 0;
-	}
 
 	return bufferSizeFrag;
 }
@@ -6,8 +6,9 @@
 #include "vulkan/vulkan.h"
 #include <glm/glm.hpp>
 #include "DescriptorSetFunctions.h"
+#include "MemoryAllocator.h"
+#include "GpuMeshCache.h"
 #include "GameObjects/GameObject.h"
-#include "GameObjects/GameObjectUniformBufferObj.h"
 #include "GameObjects/GameObjectBehavior.h"
 #include "Resources/Material.h"
 #include "Resources/Model.h"
@@ -16,6 +17,7 @@ struct VertexPosColorTexCoord;
 class GfxDeviceManager;
 class LogicalDeviceManager;
 class ImageTextureLoader;
+class UniformRingBufferModule;
 
 enum GameObjectType
 {
@@ -55,10 +57,14 @@ public:
 			DescriptorSetFunctions::MaterialType::Unspecified ||
 			objModel == nullptr;
 	}
+
+	virtual bool IsReadyToDraw() const override;
 	
 	virtual std::shared_ptr<Model> GetModel() override {
 		return objModel;
 	}
+
+	virtual AABB GetLocalBounds() const override;
 	
 	virtual std::string GetVertexShaderName() const override {
 		return vertexShaderName;
@@ -67,34 +73,53 @@ public:
 	virtual std::string GetFragmentShaderName() const override {
 		return fragmentShaderName;
 	}
+
+	virtual std::shared_ptr<Material> GetMaterial() const override {
+		return material;
+	}
+
+	virtual bool SupportsInstancing() const override {
+		return !instancedVertexShaderName.empty();
+	}
+
+	virtual std::string GetInstancedVertexShaderName() const override {
+		return instancedVertexShaderName;
+	}
+
+	virtual std::string GetInstancedFragmentShaderName() const override {
+		return instancedFragmentShaderName;
+	}
+
+	virtual glm::vec4 GetInstanceTint() const override;
 	
 	virtual VkBuffer GetVertexBuffer() const override {
-		return vertexBuffer;
+		return mesh == nullptr ? VK_NULL_HANDLE : mesh->GetVertexBuffer();
 	}
 	
 	virtual VkBuffer GetIndexBuffer() const override {
-		return indexBuffer;
-	}
-	
-	VkBuffer GetUniformBufferVert(size_t swapChainIndex) const {
-		return uniformBuffersVert[swapChainIndex]->GetUniformBuffer();
+		return mesh == nullptr ? VK_NULL_HANDLE : mesh->GetIndexBuffer();
 	}
-	
-	VkBuffer GetUniformBufferFrag(size_t swapChainIndex) const {
-		return uniformBuffersFrag[swapChainIndex]->GetUniformBuffer();
+
+	virtual int32_t GetVertexOffset() const override {
+		return mesh == nullptr ? 0 : mesh->GetVertexOffset();
 	}
-	
-	VkDeviceMemory GetUniformBufferMemoryVert(size_t swapChainIndex) {
-		return uniformBuffersVert[swapChainIndex]->GetUniformBufferMemory();
+
+	virtual uint32_t GetFirstIndex() const override {
+		return mesh == nullptr ? 0 : mesh->GetFirstIndex();
 	}
-	
-	VkDeviceMemory GetUniformBufferMemoryFrag(size_t swapChainIndex) {
-		return uniformBuffersFrag[swapChainIndex]->GetUniformBufferMemory();
+
+	virtual uint32_t GetIndexCount() const override;
+
+	virtual size_t GetLodLevel() const override {
+		return lodLevel;
 	}
 	
 	virtual VkDescriptorSet* GetDescriptorSetPtr(size_t swapChainIndex) override {
 		return &descriptorSets[swapChainIndex];
 	}
+
+	virtual uint32_t GetDynamicOffsets(size_t swapChainIndex,
+		uint32_t* dynamicOffsets) const override;
 	
 	virtual VkDescriptorSetLayout GetDescriptorSetLayout() const override {
 		return descriptorSetLayout;
@@ -106,8 +131,8 @@ public:
 			VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
 	}
 	
-	virtual void InitAndCreateUniformBuffers(GfxDeviceManager* gfxDeviceManager,
-											size_t numSwapChainImages) override;
+	virtual void InitAndCreateUniformBuffers(
+		std::shared_ptr<UniformRingBufferModule> const& uniformRingBuffer) override;
 	
 	virtual void CreateDescriptorPoolAndSets(size_t numSwapChainImages) override;
 	
@@ -124,19 +149,27 @@ protected:
 private:
 	std::string vertexShaderName;
 	std::string fragmentShaderName;
+	// empty if the material can't be drawn instanced
+	std::string instancedVertexShaderName;
+	std::string instancedFragmentShaderName;
 	
-	VkBuffer vertexStagingBuffer;
-	VkDeviceMemory vertexStagingBufferMemory;
-	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexBufferMemory;
-	VkBuffer indexStagingBuffer;
-	VkDeviceMemory indexStagingBufferMemory;
-	VkBuffer indexBuffer;
-	VkDeviceMemory indexBufferMemory;
+	// shared with every other object drawing the same model in the same
+	// vertex layout. null if the object has nothing to draw. this is the
+	// mesh of the current level of detail
+	std::shared_ptr<GpuMesh> mesh;
+	// one per level of detail of the model, uploaded the first time the
+	// level is drawn
+	std::vector<std::shared_ptr<GpuMesh>> lodMeshes;
+	VertexLayout vertexLayout;
+	size_t lodLevel;
 	
 	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager;
 	
-	std::vector<GameObjectUniformBufferObj*> uniformBuffersVert, uniformBuffersFrag;
+	// slices are at the same offset in each swap chain image's region.
+	// a size of zero means the object has no such slice
+	std::shared_ptr<UniformRingBufferModule> uniformRingBuffer;
+	VkDeviceSize vertSliceOffset, vertSliceSize;
+	VkDeviceSize fragSliceOffset, fragSliceSize;
 	
 	VkDescriptorPool descriptorPool;
 	VkDescriptorSetLayout descriptorSetLayout;
@@ -155,18 +188,26 @@ private:
 
 	void SetupShaderNames();
 	
-	void CreateOrUpdateVertexBufferForMaterial(GfxDeviceManager* gfxDeviceManager,
-		VkCommandPool commandPool);
+	void AcquireMeshForMaterial(GfxDeviceManager* gfxDeviceManager);
 
-	template<typename VertexType>
-	void CreateOrUpdateVertexBuffer(std::vector<VertexType> const & vertices,
-									GfxDeviceManager *gfxDeviceManager,
-									VkCommandPool commandPool);
-	void CreateOrUpdateIndexBuffer(GfxDeviceManager *gfxDeviceManager,
-									VkCommandPool commandPool);
-	
-	void CreateUniformBuffers(GfxDeviceManager* gfxDeviceManager,
-							  size_t numSwapChainImages);
+	// how far past a level's screen size the object has to get before it
+	// switches, as a fraction of that size. keeps objects sitting right at
+	// a threshold from flickering between levels
+	static const float lodHysteresis;
+
+	Model* GetLodModel(size_t level) const;
+	void UpdateLodLevel(const glm::mat4& viewMatrix,
+		VkExtent2D const& swapChainExtent);
+	// diameter of the bounding sphere over the screen's height
+	float GetScreenSize(const glm::mat4& viewMatrix,
+		VkExtent2D const& swapChainExtent) const;
+
+	// how far the material's vertex shader can move vertices away from
+	// where the model has them, in model space
+	static float GetMaxVertexDisplacement(
+		DescriptorSetFunctions::MaterialType materialType);
+
+	void CreateUniformBuffers();
 	void CleanUpUniformBuffers();
 	
 	void CreateDescriptorPool(size_t numSwapChainImages);
@@ -16,6 +16,7 @@ Mothership::Mothership(std::shared_ptr<GameObjectBehavior> behavior,
 		std::dynamic_pointer_cast<MothershipBehavior>(behavior);
 	localTransform = localToWorldTransform;
 	localToWorld = localToWorldTransform;
+	UpdateWorldBounds();
 }
 
 void* Mothership::CreateUniformBufferModelViewProjRipple(
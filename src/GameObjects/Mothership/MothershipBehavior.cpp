@@ -5,6 +5,7 @@
 #include "Rendering/DescriptorSetFunctions.h"
 #include "GameObjects/MeshGameObject.h"
 #include "Resources/Model.h"
+#include "Math/CommonMath.h"
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
@@ -72,12 +73,12 @@ void MothershipBehavior::SpawnPawn() {
 			glm::vec3 vectorToPlayer = glm::normalize(playerWorldPosition -
 				pointOnPlaneCrossingThroughSphere);
 			float tVal;
-			if (RaySphereIntersection(vectorToPlayer, pointOnPlaneCrossingThroughSphere,
+			if (CommonMath::RaySphereIntersection(vectorToPlayer, pointOnPlaneCrossingThroughSphere,
 				radius, planePosition, tVal)) {
 				positionOnSphere = pointOnPlaneCrossingThroughSphere +
 					(tVal + radius*0.01f) * vectorToPlayer;
 				// make sure we don't hit from inside -- not sure if possible
-				if (!RaySphereIntersection(vectorToPlayer, positionOnSphere,
+				if (!CommonMath::RaySphereIntersection(vectorToPlayer, positionOnSphere,
 					radius, planePosition, tVal)) {
 					break;
 				}
@@ -243,8 +244,27 @@ void MothershipBehavior::UpdateModelColorsBasedOnCurrentModifiers() {
 		topmostModifier = vertexColorModifiers.front();
 	}
 
-	std::shared_ptr<Model> gameObjectModel = gameObject->GetModel();
-	std::vector<Model::ModelVert>& modelVerts = gameObjectModel->GetVertices();
+	// every level of detail gets the same colors, so they don't pop when
+	// the ship switches levels
+	std::vector<std::shared_ptr<Model>> models;
+	GetModelsWithLods(models);
+	bool modifiedVertColors = false;
+	for (size_t lodLevel = 0; lodLevel < models.size(); lodLevel++) {
+		if (ApplyVertexColorModifiers(models[lodLevel]->GetVertices(),
+			originalModelColors[lodLevel])) {
+			modifiedVertColors = true;
+		}
+	}
+
+	// update on demand
+	if (modifiedVertColors) {
+		gameObject->UpdateVertexBufferWithLatestModelVerts();
+	}
+}
+
+bool MothershipBehavior::ApplyVertexColorModifiers(
+	std::vector<Model::ModelVert>& modelVerts,
+	std::vector<glm::vec3> const& originalColors) {
 	size_t numVertexModifiers = vertexColorModifiers.size();
 	bool modifiedVertColors = false;
 	for (size_t i = 0; i < numVertexModifiers; i++) {
@@ -269,24 +289,29 @@ void MothershipBehavior::UpdateModelColorsBasedOnCurrentModifiers() {
 				lerpVal = lerpVal > 1.0f ? 1.0f : lerpVal;
 				// lerp desired colorval over time
 				glm::vec3 desiredColor = lerpVal * currentModifier.desiredColor +
-					(1.0f - lerpVal) * originalModelColors[index];
+					(1.0f - lerpVal) * originalColors[index];
 
 				// if angle is closer to 0, lerp value should 1. otherwise,
 				// it is 0
 				float lerpValDist = 1.0f - currAngle / currentModifier.maxAngleRadians;
 				modelVerts[index].color = lerpValDist * desiredColor +
-					(1.0f - lerpValDist)* originalModelColors[index];
+					(1.0f - lerpValDist)* originalColors[index];
 			}
 			else {
-				modelVerts[index].color = originalModelColors[index];
+				modelVerts[index].color = originalColors[index];
 			}
 			modifiedVertColors = true;
 		}
 	}
+	return modifiedVertColors;
+}
 
-	// update on demand
-	if (modifiedVertColors) {
-		gameObject->UpdateVertexBufferWithLatestModelVerts();
+void MothershipBehavior::GetModelsWithLods(
+	std::vector<std::shared_ptr<Model>>& models) {
+	std::shared_ptr<Model> gameObjectModel = gameObject->GetModel();
+	models.push_back(gameObjectModel);
+	for (auto const& lod : gameObjectModel->GetLods()) {
+		models.push_back(lod.model);
 	}
 }
 
@@ -295,25 +320,34 @@ void MothershipBehavior::StoreOriginalColorsIfRequired() {
 		return;
 	}
 
-	std::shared_ptr<Model> gameObjectModel = gameObject->GetModel();
-	std::vector<Model::ModelVert>& modelVerts = gameObjectModel->GetVertices();
-	for (auto const & modelVert : modelVerts) {
-		originalModelColors.push_back(modelVert.color);
+	std::vector<std::shared_ptr<Model>> models;
+	GetModelsWithLods(models);
+	originalModelColors.resize(models.size());
+	for (size_t lodLevel = 0; lodLevel < models.size(); lodLevel++) {
+		for (auto const & modelVert : models[lodLevel]->GetVertices()) {
+			originalModelColors[lodLevel].push_back(modelVert.color);
+		}
 	}
 }
 
 void MothershipBehavior::RestoreOldColorsIfRequired() {
-	std::shared_ptr<Model> gameObjectModel = gameObject->GetModel();
-	std::vector<Model::ModelVert>& modelVerts = gameObjectModel->GetVertices();
+	std::vector<std::shared_ptr<Model>> models;
+	GetModelsWithLods(models);
 	glm::vec3 originalColor(1, 1, 1);
 	bool colorsNeedRestoration = false;
 
-	for (size_t index = 0; index < modelVerts.size(); index++) {
-		glm::vec3 colorDiff = modelVerts[index].color - originalModelColors[index];
-		if (colorDiff.x * colorDiff.x + colorDiff.y * colorDiff.y
-			+ colorDiff.z * colorDiff.z > 0.001f) {
-			modelVerts[index].color = originalColor;
-			colorsNeedRestoration = true;
+	for (size_t lodLevel = 0; lodLevel < models.size(); lodLevel++) {
+		std::vector<Model::ModelVert>& modelVerts =
+			models[lodLevel]->GetVertices();
+		std::vector<glm::vec3> const& originalColors =
+			originalModelColors[lodLevel];
+		for (size_t index = 0; index < modelVerts.size(); index++) {
+			glm::vec3 colorDiff = modelVerts[index].color - originalColors[index];
+			if (colorDiff.x * colorDiff.x + colorDiff.y * colorDiff.y
+				+ colorDiff.z * colorDiff.z > 0.001f) {
+				modelVerts[index].color = originalColor;
+				colorsNeedRestoration = true;
+			}
 		}
 	}
 
@@ -421,38 +455,6 @@ glm::vec3 MothershipBehavior::FindVectorPerpendicularToInputVec(
 	return perpVec;
 }
 
-bool MothershipBehavior::RaySphereIntersection(glm::vec3 const& rayDir,
-	glm::vec3 const& rayOrigin, float radius, glm::vec3 const& sphereOrigin,
-	float& tVal) {
-	glm::vec3 centerToRayOrigin = rayOrigin - sphereOrigin;
-	float a = glm::dot(rayDir, rayDir);
-	float b = 2.0f * glm::dot(centerToRayOrigin, rayDir);
-	float c = glm::dot(centerToRayOrigin, centerToRayOrigin) - radius* radius;
-	float discr = b * b - 4.0f * a * c;
-
-	if (discr < 0.0f) {
-		return false;
-	}
-
-	float e = sqrt(discr);
-	float denom = 2.0f * a;
-	float t = (-b - e) / denom;
-	// smaller root
-	if (t > 0.0f) {
-		tVal = t;
-		return true;
-	}
-
-	t = (-b + e) / denom;
-	if (t > 0.0f) {
-		tVal = t;
-		return true;
-	}
-
-	// all tests failed so far
-	return false;
-}
-
 int MothershipBehavior::FindIndexOfStalkCloseToPosition(
 	glm::vec3 const& surfacePointLocal, float maxAngleRadians) {
 	int foundIndex = -1;
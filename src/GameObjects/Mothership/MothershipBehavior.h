@@ -2,9 +2,11 @@
 
 #include "GameObjectBehavior.h"
 #include "ShipStateBehavior.h"
+#include "Resources/Model.h"
 #include <glm/glm.hpp>
 #include <memory>
 #include <deque>
+#include <vector>
 
 class GameObject;
 struct UniformBufferObjectModelViewProjRipple;
@@ -94,7 +96,8 @@ private:
 	std::deque<RippleData> ripples;
 	std::deque<StalkData> stalks;
 	std::deque<VertexColorModifierData> vertexColorModifiers;
-	std::vector<glm::vec3> originalModelColors;
+	// one list per level of detail
+	std::vector<std::vector<glm::vec3>> originalModelColors;
 	float shudderStartTime;
 
 	float deathStartTime;
@@ -105,6 +108,9 @@ private:
 	void AddVertexColorModifier(glm::vec3 const& localPosition,
 		float radius, glm::vec3 const& color);
 	void UpdateModelColorsBasedOnCurrentModifiers();
+	bool ApplyVertexColorModifiers(std::vector<Model::ModelVert>& modelVerts,
+		std::vector<glm::vec3> const& originalColors);
+	void GetModelsWithLods(std::vector<std::shared_ptr<Model>>& models);
 	void StoreOriginalColorsIfRequired();
 	void RestoreOldColorsIfRequired();
 
@@ -116,8 +122,6 @@ private:
 	glm::vec3 SamplePositionOnPlane(glm::vec3 const& planePosition,
 		glm::vec3 const& planeNormal, float maxRadius);
 	glm::vec3 FindVectorPerpendicularToInputVec(glm::vec3 const& inputVector);
-	bool RaySphereIntersection(glm::vec3 const& rayDir, glm::vec3 const& rayOrigin,
-		float radius, glm::vec3 const& sphereOrigin, float& tVal);
 
 	int FindIndexOfStalkCloseToPosition(glm::vec3 const& surfacePointLocal,
 		float maxAngleRadians);
@@ -23,6 +23,12 @@ PawnBehavior::PawnBehavior(Scene* const scene,
 PawnBehavior::~PawnBehavior() {
 }
 
+void PawnBehavior::Reset(glm::vec3 const& initialForwardVec) {
+	currentVelocity = 0.0f;
+	currentPawnState = JustCreated;
+	currentForwardVec = initialForwardVec;
+}
+
 GameObjectBehavior::BehaviorStatus PawnBehavior::UpdateSelf(float time,
 	float deltaTime) {
 	if (currentPawnState == Destroyed) {
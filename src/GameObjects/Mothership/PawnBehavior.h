@@ -17,6 +17,13 @@ public:
 		currentPawnState = Destroyed;
 	}
 
+	bool IsDestroyed() const {
+		return currentPawnState == Destroyed;
+	}
+
+	// starts over as a new pawn, for pooled pawns that are spawned again
+	void Reset(glm::vec3 const& initialForwardVec);
+
 	virtual GameObjectBehavior::BehaviorStatus UpdateSelf(float time,
 		float deltaTime) override;
 
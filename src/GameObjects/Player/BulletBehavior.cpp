@@ -2,6 +2,7 @@
 #include "Mothership/PawnBehavior.h"
 #include "Mothership/MothershipBehavior.h"
 #include "GameObject.h"
+#include "SceneManagement/CollisionSystem.h"
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/gtc/matrix_transform.hpp>
@@ -9,6 +10,7 @@
 
 const float BulletBehavior::acceleration = 1.2f;
 const float BulletBehavior::maxVelocityMagnitude = 11.2f;
+const float BulletBehavior::pawnHitDistance = 2.0f;
 
 BulletBehavior::BulletBehavior() : currentVelocity(0.0f) {
 }
@@ -24,6 +26,13 @@ BulletBehavior::BulletBehavior(Scene* const scene,
 BulletBehavior::~BulletBehavior() {
 }
 
+void BulletBehavior::Reset(glm::vec3 const& velocityVector) {
+	currentVelocity = 0.0f;
+	this->velocityVector = glm::normalize(velocityVector);
+	distanceTraveled = 0.0f;
+	destroyed = false;
+}
+
 GameObjectBehavior::BehaviorStatus BulletBehavior::UpdateSelf(float time,
 	float deltaTime) {
 	if (destroyed) {
@@ -62,45 +71,21 @@ GameObjectBehavior::BehaviorStatus BulletBehavior::UpdateSelf(float time,
 }
 
 void BulletBehavior::CheckForCollisions(glm::vec3 const & bulletPosition) {
-	std::vector<std::shared_ptr<GameObject>>& gameObjects =
-		scene->GetGameObjects();
-	CheckForCollisionsRecursive(bulletPosition, gameObjects);
-}
-
-bool BulletBehavior::CheckForCollisionsRecursive(
-	glm::vec3 const& bulletPosition,
-	std::vector<std::shared_ptr<GameObject>> const& gameObjects) {
-	for (std::shared_ptr<GameObject> const& gameObject : gameObjects) {
-		GameObjectBehavior* behavInst = gameObject->GetGameObjectBehavior();
-		PawnBehavior* pawnBehav = dynamic_cast<PawnBehavior*>(behavInst);
-		if (pawnBehav != nullptr) {
-			auto pawnPos = pawnBehav->GetGameObject()->GetWorldPosition();
-			auto vecToPawnPos = bulletPosition - pawnPos;
-			if (glm::length(vecToPawnPos) < 2.0f) {
-				destroyed = true;
-				pawnBehav->Destroy();
-				return true;
-			}
-		}
-
-		// there might be cases where we might hit mothership first in
-		// loop even though it is further away than a pawn. but that's
-		// unlikely. until we have real physics this is OK
-		MothershipBehavior* motherBehav =
-			dynamic_cast<MothershipBehavior*>(behavInst);
-		if (motherBehav != nullptr) {
-			if (motherBehav->TakeDamageIfHit(10, bulletPosition)) {
-				destroyed = true;
-				return true;
-			}
-		}
-
-		std::vector<std::shared_ptr<GameObject>> const & children =
-			gameObject->GetChildren();
-		if (CheckForCollisionsRecursive(bulletPosition, children)) {
-			return true;
-		}
+	CollisionSystem const* collisionSystem = scene->GetCollisionSystem();
+	PawnBehavior* pawnBehav = collisionSystem->FindPawn(bulletPosition,
+		pawnHitDistance);
+	if (pawnBehav != nullptr) {
+		destroyed = true;
+		pawnBehav->Destroy();
+		return;
 	}
 
-	return false;
+	// the ship decides whether it takes damage; while idle it only shudders
+	// and lets the bullet through
+	MothershipBehavior* motherBehav =
+		collisionSystem->FindMothership(bulletPosition);
+	if (motherBehav != nullptr &&
+		motherBehav->TakeDamageIfHit(10, bulletPosition)) {
+		destroyed = true;
+	}
 }
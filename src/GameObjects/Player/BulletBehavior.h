@@ -13,12 +13,16 @@ public:
 	
 	~BulletBehavior();
 
+	// fires it again, for pooled bullets that are spawned again
+	void Reset(glm::vec3 const& velocityVector);
+
 	virtual GameObjectBehavior::BehaviorStatus UpdateSelf(float time,
 		float deltaTime) override;
 
 private:
 	static const float acceleration;
 	static const float maxVelocityMagnitude;
+	static const float pawnHitDistance;
 
 	float currentVelocity;
 	glm::vec3 velocityVector;
@@ -27,6 +31,4 @@ private:
 	bool destroyed;
 
 	void CheckForCollisions(glm::vec3 const & bulletPosition);
-	bool CheckForCollisionsRecursive(glm::vec3 const& bulletPosition,
-		std::vector<std::shared_ptr<GameObject>> const & gameObjects);
 };
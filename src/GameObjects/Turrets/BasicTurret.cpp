@@ -1,6 +1,7 @@
 
 #include "BasicTurret.h"
 #include "GameObjectCreationUtilFuncs.h"
+#include "Resources/ResourceLoader.h"
 #include "StationaryGameObjectBehavior.h"
 #include "GameObjects/GameObject.h"
 #include "GameObjects/MeshGameObject.h"
@@ -34,14 +35,14 @@ BasicTurret::BasicTurret(Scene* const scene,
 	auto baseRightVec = glm::vec3(turretWidth, 0.0f, 0.0f);
 	auto baseUpVec = glm::vec3(0.0f, turretHeight*0.25f, 0.0f);
 	auto baseForwardVec = glm::vec3(0.0f, 0.0f, turretDepth);
-	auto baseModel = Model::CreateBox(baseCenter, baseRightVec,
+	auto baseModel = resourceLoader->GetBox(baseCenter, baseRightVec,
 		baseUpVec, baseForwardVec);
 	nlohmann::json metadataNode = {
 		{"tint_color",{0.0f, 1.0f, 0.0f, 1.0f }}
 	};
-	auto baseMaterial = GameObjectCreator::CreateMaterial(
+	auto baseMaterial = GameObjectCreator::GetSharedMaterial(
 		DescriptorSetFunctions::MaterialType::UnlitColor,
-		metadataNode);
+		metadataNode, resourceLoader);
 	glm::mat4 baseRelTransform(1.0f);
 	baseRelTransform = glm::translate(baseRelTransform,
 		baseUpVec * 0.5f);
@@ -56,15 +57,15 @@ BasicTurret::BasicTurret(Scene* const scene,
 	auto boxUpVec =  glm::vec3(0.0f, turretHeight, 0.0f);
 	auto boxForwardVec = glm::vec3(0.0f, 0.0f, turretDepth);
 	auto boxCenter = glm::vec3(0.0f, 0.0f, 0.0f);
-	auto bodyModel = Model::CreateBox(boxCenter, boxRightVec,
+	auto bodyModel = resourceLoader->GetBox(boxCenter, boxRightVec,
 		boxUpVec, boxForwardVec);
 	name = "BasicTurret";
 	metadataNode = {
 		{"tint_color",{1.0f, 0.0f, 0.0f, 1.0f }}
 	};
-	auto bodyMaterial = GameObjectCreator::CreateMaterial(
+	auto bodyMaterial = GameObjectCreator::GetSharedMaterial(
 		DescriptorSetFunctions::MaterialType::UnlitColor,
-		metadataNode);
+		metadataNode, resourceLoader);
 	auto boxRelativeTransform = glm::mat4(1.0f);
 	boxRelativeTransform = glm::translate(boxRelativeTransform,
 		baseUpVec + boxUpVec * 0.5f);
@@ -73,15 +74,17 @@ BasicTurret::BasicTurret(Scene* const scene,
 		boxRelativeTransform, gfxDeviceManager,
 		logicalDeviceManager, resourceLoader,
 		commandPool, "turretBody", this);
+	// the body is big enough to hide pawns and bullets behind it
+	turretBody->SetOccluder(true);
 
 	// top of turret
-	auto turretTopModel = Model::CreateIcosahedron(topRadius, 2);
+	auto turretTopModel = resourceLoader->GetIcosahedron(topRadius, 2);
 	metadataNode = {
 		{"tint_color",{0.0f, 1.0f, 0.0f, 1.0f }}
 	};
-	auto topMaterial = GameObjectCreator::CreateMaterial(
+	auto topMaterial = GameObjectCreator::GetSharedMaterial(
 		DescriptorSetFunctions::MaterialType::UnlitColor,
-		metadataNode);
+		metadataNode, resourceLoader);
 	auto topRelativeTransform = glm::mat4(1.0f);
 	glm::vec3 topCenter = baseUpVec + boxUpVec * (1.0f + topRadius);
 	topRelativeTransform = glm::translate(topRelativeTransform,
@@ -97,14 +100,14 @@ BasicTurret::BasicTurret(Scene* const scene,
 	auto gunUpVec = glm::vec3(0.0f, turretHeight * 0.08f, 0.0f);
 	auto gunForwardVec = glm::vec3(0.0f, 0.0f, gunLength);
 	gunCenter = glm::vec3(0.0f, 0.0f, 0.0f);
-	auto gunModel = Model::CreateBox(gunCenter, gunRightVec,
+	auto gunModel = resourceLoader->GetBox(gunCenter, gunRightVec,
 		gunUpVec, gunForwardVec);
 	metadataNode = {
 		{"tint_color",{1.0f, 0.0f, 0.0f, 1.0f }}
 	};
-	auto gunMaterial = GameObjectCreator::CreateMaterial(
+	auto gunMaterial = GameObjectCreator::GetSharedMaterial(
 		DescriptorSetFunctions::MaterialType::UnlitColor,
-		metadataNode);
+		metadataNode, resourceLoader);
 	auto gunBehavior = std::make_shared<StationaryGameObjectBehavior>(scene);
 	float azim = glm::radians(80.0f);
 	float polar = glm::radians(90.0f);
@@ -148,6 +151,14 @@ void BasicTurret::SetGunLookRotation(glm::vec3 const& lookAtPoint, bool sLerp) {
 	}
 }
 
+void BasicTurret::SetGunLookRotationWorld(glm::vec3 const& worldLookAtPoint,
+	bool sLerp) {
+	// look at points are relative to the top, which the gun hangs off
+	glm::vec4 lookAtPointTop = glm::inverse(turretTop->GetLocalToWorld()) *
+		glm::vec4(worldLookAtPoint, 1.0f);
+	SetGunLookRotation(glm::vec3(lookAtPointTop), sLerp);
+}
+
 void BasicTurret::UpdateState(float time, float deltaTime) {
 	GameObject::UpdateState(time, deltaTime);
 
@@ -21,6 +21,14 @@ public:
 
 	void SetGunTransformForSphericalCoords(float azim, float polar, bool sLerp = false);
 	void SetGunLookRotation(glm::vec3 const& lookAtPoint, bool sLerp = false);
+	// same as above, for a point given in world space
+	void SetGunLookRotationWorld(glm::vec3 const& worldLookAtPoint,
+		bool sLerp = false);
+
+	// where the gun turns around
+	glm::vec3 GetGunWorldPosition() const {
+		return turretTop->GetWorldPosition();
+	}
 
 	glm::vec3 GetCurrentLookAtPoint() const {
 		return currentLookAtPoint;
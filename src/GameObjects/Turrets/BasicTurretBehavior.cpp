@@ -2,13 +2,17 @@
 #include "GameObjects/Turrets/BasicTurretBehavior.h"
 #include "GameObjects/Turrets/BasicTurret.h"
 #include "SceneManagement/Scene.h"
+#include "SceneManagement/SceneQuery.h"
+#include "GameObjects/GameObject.h"
 
 const int BasicTurretBehavior::maxHealth = 200;
+const float BasicTurretBehavior::targetingRange = 50.0f;
 
 BasicTurretBehavior::BasicTurretBehavior(Scene* scene)
 	: GameObjectBehavior(scene) {
 	currentTurretState = TurretState::Idling;
 	currentHealth = maxHealth;
+	targetsNearestPawn = false;
 	idleTransitionTime = -1.0f;
 
 	std::random_device rd;
@@ -59,6 +63,17 @@ void BasicTurretBehavior::Idle(float currentTime) {
 
 	if (idleTransitionTime < currentTime) {
 		idleTransitionTime = currentTime + 2.0f;
+		// track the nearest pawn, and look around if there is none
+		if (targetsNearestPawn && scene != nullptr) {
+			GameObject* target = scene->GetSceneQuery()->FindNearest(
+				turret->GetGunWorldPosition(), targetingRange,
+				SceneQuery::PawnCategory);
+			if (target != nullptr) {
+				turret->SetGunLookRotationWorld(target->GetWorldPosition(),
+					true);
+				return;
+			}
+		}
 		// TODO: debug slerp
 		auto currLookAtPoint = turret->GetCurrentLookAtPoint();
 		auto newPoint = glm::vec3(distX(mt), distY(mt), distZ(mt));
@@ -16,6 +16,11 @@ public:
 		turret = basicTurret;
 	}
 
+	// off by default, so the turret just looks around
+	void SetTargetsNearestPawn(bool targets) {
+		targetsNearestPawn = targets;
+	}
+
 	void TakeDamage();
 
 private:
@@ -26,8 +31,11 @@ private:
 
 	TurretState currentTurretState;
 	int currentHealth;
+	bool targetsNearestPawn;
 
 	static const int maxHealth;
+	// pawns farther away than this are left alone
+	static const float targetingRange;
 	std::mt19937 mt;
 	std::uniform_real_distribution<float> distX, distY, distZ;
 
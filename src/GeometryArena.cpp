@@ -0,0 +1,114 @@
+#include "GeometryArena.h"
+#include "Common.h"
+#include "LogicalDeviceManager.h"
+#include "DeferredDestructionQueue.h"
+#include <algorithm>
+#include <iterator>
+
+const VkDeviceSize GeometryArena::blockSize = 32 * 1024 * 1024;
+
+GeometryArena::GeometryArena(LogicalDeviceManager* logicalDeviceManager,
+	GfxDeviceManager* gfxDeviceManager, VkBufferUsageFlags usage,
+	VkDeviceSize elementSize) : logicalDeviceManager(logicalDeviceManager),
+	gfxDeviceManager(gfxDeviceManager), usage(usage),
+	elementSize(elementSize) {
+}
+
+GeometryArena::~GeometryArena() {
+	for (auto& block : blocks) {
+		Common::DestroyBuffer(logicalDeviceManager, block.buffer,
+			block.allocation);
+	}
+}
+
+GeometryArena::Range GeometryArena::Allocate(uint32_t numElements) {
+	std::lock_guard<std::mutex> lock(arenaMutex);
+	Range range;
+	if (numElements == 0) {
+		return range;
+	}
+	for (uint32_t blockIndex = 0; blockIndex < (uint32_t)blocks.size();
+		blockIndex++) {
+		if (AllocateFromBlock(blockIndex, numElements, range)) {
+			return range;
+		}
+	}
+
+	// meshes bigger than a block get a block to themselves
+	Block block;
+	block.numElements = std::max((uint32_t)(blockSize / elementSize),
+		numElements);
+	Common::CreateBuffer(logicalDeviceManager, gfxDeviceManager,
+		block.numElements * elementSize,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, block.buffer, block.allocation);
+	block.freeRanges[0] = block.numElements;
+	blocks.push_back(block);
+
+	AllocateFromBlock((uint32_t)blocks.size() - 1, numElements, range);
+	return range;
+}
+
+void GeometryArena::Retire(Range& range) {
+	if (range.buffer == VK_NULL_HANDLE) {
+		return;
+	}
+	Range retiredRange = range;
+	logicalDeviceManager->GetDeferredDestructionQueue()->Enqueue(
+		[this, retiredRange]() {
+			std::lock_guard<std::mutex> lock(arenaMutex);
+			Free(retiredRange.blockIndex, retiredRange.firstElement,
+				retiredRange.numElements);
+		});
+	range = Range();
+}
+
+size_t GeometryArena::GetNumBlocks() {
+	std::lock_guard<std::mutex> lock(arenaMutex);
+	return blocks.size();
+}
+
+bool GeometryArena::AllocateFromBlock(uint32_t blockIndex,
+	uint32_t numElements, Range& range) {
+	// first fit. meshes are mostly allocated once and kept, so
+	// fragmentation stays low
+	Block& block = blocks[blockIndex];
+	for (auto freeIt = block.freeRanges.begin();
+		freeIt != block.freeRanges.end(); freeIt++) {
+		if (freeIt->second < numElements) {
+			continue;
+		}
+		uint32_t firstElement = freeIt->first;
+		uint32_t numRemaining = freeIt->second - numElements;
+		block.freeRanges.erase(freeIt);
+		if (numRemaining > 0) {
+			block.freeRanges[firstElement + numElements] = numRemaining;
+		}
+
+		range.buffer = block.buffer;
+		range.blockIndex = blockIndex;
+		range.firstElement = firstElement;
+		range.numElements = numElements;
+		return true;
+	}
+	return false;
+}
+
+void GeometryArena::Free(uint32_t blockIndex, uint32_t firstElement,
+	uint32_t numElements) {
+	auto& freeRanges = blocks[blockIndex].freeRanges;
+	auto nextIt = freeRanges.lower_bound(firstElement);
+	if (nextIt != freeRanges.end() &&
+		firstElement + numElements == nextIt->first) {
+		numElements += nextIt->second;
+		nextIt = freeRanges.erase(nextIt);
+	}
+	if (nextIt != freeRanges.begin()) {
+		auto previousIt = std::prev(nextIt);
+		if (previousIt->first + previousIt->second == firstElement) {
+			previousIt->second += numElements;
+			return;
+		}
+	}
+	freeRanges[firstElement] = numElements;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include "MemoryAllocator.h"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+class GfxDeviceManager;
+class LogicalDeviceManager;
+
+// Large vertex or index buffers that meshes get ranges of, so that draws
+// can share one bind and address their mesh with firstIndex/vertexOffset.
+// Ranges are counted in elements for that reason. Blocks are added as the
+// arena fills up, and live as long as the arena does.
+class GeometryArena {
+public:
+	struct Range {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		uint32_t blockIndex = 0;
+		uint32_t firstElement = 0;
+		uint32_t numElements = 0;
+	};
+
+	GeometryArena(LogicalDeviceManager* logicalDeviceManager,
+		GfxDeviceManager* gfxDeviceManager, VkBufferUsageFlags usage,
+		VkDeviceSize elementSize);
+	// destroys the blocks right away; nothing can be using them anymore
+	~GeometryArena();
+
+	Range Allocate(uint32_t numElements);
+	// the range is reused once frames in flight are done with it
+	void Retire(Range& range);
+
+	VkDeviceSize GetElementSize() const {
+		return elementSize;
+	}
+
+	size_t GetNumBlocks();
+
+private:
+	struct Block {
+		VkBuffer buffer;
+		MemoryAllocator::Allocation allocation;
+		uint32_t numElements;
+		// first element to number of elements, merged with neighbors
+		// when freed
+		std::map<uint32_t, uint32_t> freeRanges;
+	};
+
+	// not owned by us
+	LogicalDeviceManager* logicalDeviceManager;
+	GfxDeviceManager* gfxDeviceManager;
+
+	VkBufferUsageFlags usage;
+	VkDeviceSize elementSize;
+	std::vector<Block> blocks;
+	std::mutex arenaMutex;
+
+	static const VkDeviceSize blockSize;
+
+	bool AllocateFromBlock(uint32_t blockIndex, uint32_t numElements,
+		Range& range);
+	void Free(uint32_t blockIndex, uint32_t firstElement, uint32_t numElements);
+};
@@ -9,6 +9,7 @@ GfxDeviceManager::GfxDeviceManager(const VkInstance& vkInstance,
 	const VkSurfaceKHR surface, const std::vector<const char*>& deviceExtensions) {
 	physicalDevice = VK_NULL_HANDLE;
 	msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+	drawIndirectCountSupported = false;
 	PickPhysicalDevice(vkInstance, surface, deviceExtensions);
 }
 
@@ -32,6 +33,8 @@ void GfxDeviceManager::PickPhysicalDevice(const VkInstance& vkInstance,
 		if (IsDeviceSuitable(device, surface, deviceExtensions)) {
 			physicalDevice = device;
 			msaaSamples = GetMaxUsableSampleCount(device);
+			drawIndirectCountSupported = CheckDrawIndirectCountSupport(device,
+				surface);
 			break;
 		}
 	}
@@ -124,6 +127,22 @@ GfxDeviceManager::QueueFamilyIndices GfxDeviceManager::FindQueueFamilies(
 		i++;
 	}
 
+	// families without graphics or compute usually map to the DMA engines,
+	// so uploads there run alongside rendering
+	for (uint32_t family = 0; family < queueFamilyCount; family++) {
+		const auto& queueFamily = queueFamilies[family];
+		if (queueFamily.queueCount > 0 &&
+			(queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+			!(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+			!(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
+			indices.transferFamily = family;
+			break;
+		}
+	}
+	if (!indices.transferFamily.has_value()) {
+		indices.transferFamily = indices.graphicsFamily;
+	}
+
 	return indices;
 }
 
@@ -147,6 +166,27 @@ bool GfxDeviceManager::CheckDeviceExtensionSupport(VkPhysicalDevice device,
 	return requiredExtensions.empty();
 }
 
+bool GfxDeviceManager::CheckDrawIndirectCountSupport(VkPhysicalDevice device,
+	VkSurfaceKHR surface) {
+	// the culling pass is recorded into the graphics command buffers
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+	uint32_t graphicsFamily = FindQueueFamilies(device, surface).graphicsFamily.value();
+	if ((queueFamilies[graphicsFamily].queueFlags & VK_QUEUE_COMPUTE_BIT) == 0) {
+		return false;
+	}
+
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+	// draws need to pick their own instances, and there can be many per call
+	return supportedFeatures.multiDrawIndirect &&
+		supportedFeatures.drawIndirectFirstInstance &&
+		CheckDeviceExtensionSupport(device,
+			{ VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME });
+}
+
 GfxDeviceManager::SwapChainSupportDetails GfxDeviceManager::QuerySwapChainSupport(
 	VkSurfaceKHR surface) const {
 	return QuerySwapChainSupport(physicalDevice, surface);
@@ -14,6 +14,8 @@ public:
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
 //#endif
+		// a transfer-only family if there is one, graphics otherwise
+		std::optional<uint32_t> transferFamily;
 
 		bool IsComplete() {
 			return graphicsFamily.has_value() &&
@@ -41,6 +43,12 @@ public:
 	VkSampleCountFlagBits GetMSAASamples() const {
 		return msaaSamples;
 	}
+
+	// whether draw commands and their count can come from GPU buffers.
+	// optional, so it doesn't affect which device gets picked
+	bool SupportsDrawIndirectCount() const {
+		return drawIndirectCountSupported;
+	}
 private:
 	QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice device,
 		VkSurfaceKHR surface) const;
@@ -55,7 +63,10 @@ private:
 	bool CheckDeviceExtensionSupport(VkPhysicalDevice device,
 		const std::vector<const char*>& deviceExtensions);
 	VkSampleCountFlagBits GetMaxUsableSampleCount(VkPhysicalDevice device);
+	bool CheckDrawIndirectCountSupport(VkPhysicalDevice device,
+		VkSurfaceKHR surface);
 
 	VkPhysicalDevice physicalDevice;
 	VkSampleCountFlagBits msaaSamples;
+	bool drawIndirectCountSupported;
 };
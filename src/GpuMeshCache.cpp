@@ -0,0 +1,164 @@
+#include "GpuMeshCache.h"
+#include "LogicalDeviceManager.h"
+#include "UploadContext.h"
+#include "Resources/Model.h"
+#include "Vertex.h"
+
+GpuMesh::GpuMesh(std::shared_ptr<Model> const& model,
+	VertexLayout vertexLayout, GeometryArena* vertexArena,
+	GeometryArena* indexArena, LogicalDeviceManager* logicalDeviceManager) :
+	model(model), vertexLayout(vertexLayout), vertexArena(vertexArena),
+	indexArena(indexArena), logicalDeviceManager(logicalDeviceManager) {
+	UpdateVertices();
+	UpdateIndices();
+}
+
+GpuMesh::~GpuMesh() {
+	// frames in flight might still draw from these ranges
+	vertexArena->Retire(vertexRange);
+	indexArena->Retire(indexRange);
+}
+
+void GpuMesh::UpdateVertices() {
+	switch (vertexLayout) {
+		case VertexLayout::Pos:
+			UploadVertices(model->BuildAndReturnVertsPos());
+			break;
+		case VertexLayout::PosColorTexCoord:
+			UploadVertices(model->BuildAndReturnVertsPosColorTexCoord());
+			break;
+		case VertexLayout::PosNormalColorTexCoord:
+			UploadVertices(model->BuildAndReturnVertsPosNormalColorTexCoord());
+			break;
+		case VertexLayout::PosTex:
+			UploadVertices(model->BuildAndReturnVertsPosTex());
+			break;
+	}
+}
+
+void GpuMesh::UpdateIndices() {
+	std::vector<uint32_t> const& indices = model->GetIndices();
+	WriteRange(indexArena, indexRange, indices.data(),
+		(uint32_t)indices.size());
+}
+
+template<typename VertexType>
+void GpuMesh::UploadVertices(std::vector<VertexType> const& vertices) {
+	WriteRange(vertexArena, vertexRange, vertices.data(),
+		(uint32_t)vertices.size());
+}
+
+void GpuMesh::WriteRange(GeometryArena* arena, GeometryArena::Range& range,
+	void const* data, uint32_t numElements) {
+	if (numElements == 0) {
+		return;
+	}
+	// first upload, or the data outgrew the range
+	if (range.numElements < numElements) {
+		arena->Retire(range);
+		range = arena->Allocate(numElements);
+	}
+	VkDeviceSize elementSize = arena->GetElementSize();
+	logicalDeviceManager->GetUploadContext()->UploadToBuffer(data,
+		numElements * elementSize, range.buffer,
+		range.firstElement * elementSize);
+}
+
+GpuMeshCache::GpuMeshCache(LogicalDeviceManager* logicalDeviceManager) :
+	logicalDeviceManager(logicalDeviceManager), indexArena(nullptr),
+	numHits(0), numMisses(0) {
+}
+
+GpuMeshCache::~GpuMeshCache() {
+	for (auto& vertexArena : vertexArenas) {
+		delete vertexArena.second;
+	}
+	if (indexArena != nullptr) {
+		delete indexArena;
+	}
+}
+
+std::shared_ptr<GpuMesh> GpuMeshCache::GetMesh(
+	std::shared_ptr<Model> const& model, VertexLayout vertexLayout,
+	GfxDeviceManager* gfxDeviceManager) {
+	std::lock_guard<std::mutex> lock(meshMutex);
+	auto key = std::make_pair((Model const*)model.get(), vertexLayout);
+	auto meshIt = meshes.find(key);
+	if (meshIt != meshes.end()) {
+		std::shared_ptr<GpuMesh> mesh = meshIt->second.lock();
+		if (mesh != nullptr) {
+			numHits++;
+			return mesh;
+		}
+	}
+
+	// models that come and go, like text, would otherwise pile up here
+	numMisses++;
+	RemoveExpiredMeshes();
+	if (indexArena == nullptr) {
+		indexArena = new GeometryArena(logicalDeviceManager, gfxDeviceManager,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sizeof(uint32_t));
+	}
+	std::shared_ptr<GpuMesh> mesh = std::make_shared<GpuMesh>(model,
+		vertexLayout, GetVertexArena(vertexLayout, gfxDeviceManager),
+		indexArena, logicalDeviceManager);
+	meshes[key] = mesh;
+	return mesh;
+}
+
+GpuMeshCache::Statistics GpuMeshCache::GetStatistics() {
+	std::lock_guard<std::mutex> lock(meshMutex);
+	Statistics statistics;
+	for (auto const& mesh : meshes) {
+		if (!mesh.second.expired()) {
+			statistics.numMeshes++;
+		}
+	}
+	statistics.numHits = numHits;
+	statistics.numMisses = numMisses;
+	for (auto& vertexArena : vertexArenas) {
+		statistics.numArenaBlocks += vertexArena.second->GetNumBlocks();
+	}
+	if (indexArena != nullptr) {
+		statistics.numArenaBlocks += indexArena->GetNumBlocks();
+	}
+	return statistics;
+}
+
+void GpuMeshCache::RemoveExpiredMeshes() {
+	for (auto meshIt = meshes.begin(); meshIt != meshes.end();) {
+		if (meshIt->second.expired()) {
+			meshIt = meshes.erase(meshIt);
+		}
+		else {
+			meshIt++;
+		}
+	}
+}
+
+GeometryArena* GpuMeshCache::GetVertexArena(VertexLayout vertexLayout,
+	GfxDeviceManager* gfxDeviceManager) {
+	auto arenaIt = vertexArenas.find(vertexLayout);
+	if (arenaIt != vertexArenas.end()) {
+		return arenaIt->second;
+	}
+	GeometryArena* vertexArena = new GeometryArena(logicalDeviceManager,
+		gfxDeviceManager, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		GetVertexSize(vertexLayout));
+	vertexArenas[vertexLayout] = vertexArena;
+	return vertexArena;
+}
+
+VkDeviceSize GpuMeshCache::GetVertexSize(VertexLayout vertexLayout) {
+	switch (vertexLayout) {
+		case VertexLayout::Pos:
+			return sizeof(VertexPos);
+		case VertexLayout::PosColorTexCoord:
+			return sizeof(VertexPosColorTexCoord);
+		case VertexLayout::PosNormalColorTexCoord:
+			return sizeof(VertexPosNormalColorTexCoord);
+		case VertexLayout::PosTex:
+			return sizeof(VertexPosTex);
+	}
+	return 0;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include "GeometryArena.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+class Model;
+class GfxDeviceManager;
+class LogicalDeviceManager;
+
+// vertex formats a model's geometry can be uploaded in; materials pick
+// one of these
+enum class VertexLayout {
+	Pos = 0,
+	PosColorTexCoord,
+	PosNormalColorTexCoord,
+	PosTex
+};
+
+// Geometry for one model in one vertex layout, as ranges of the layout's
+// vertex arena and the shared index arena. Every object drawing the model
+// with that layout shares them, and they're retired once the last one lets
+// go. Holding on to the model keeps its address from being reused while
+// the mesh is cached.
+class GpuMesh {
+public:
+	GpuMesh(std::shared_ptr<Model> const& model, VertexLayout vertexLayout,
+		GeometryArena* vertexArena, GeometryArena* indexArena,
+		LogicalDeviceManager* logicalDeviceManager);
+	~GpuMesh();
+
+	// arena blocks, shared with other meshes. can change if the model's
+	// data outgrows its ranges
+	VkBuffer GetVertexBuffer() const {
+		return vertexRange.buffer;
+	}
+
+	VkBuffer GetIndexBuffer() const {
+		return indexRange.buffer;
+	}
+
+	int32_t GetVertexOffset() const {
+		return (int32_t)vertexRange.firstElement;
+	}
+
+	uint32_t GetFirstIndex() const {
+		return indexRange.firstElement;
+	}
+
+	// upload the model's current data. affects every object sharing the
+	// mesh, which share the model too
+	void UpdateVertices();
+	void UpdateIndices();
+
+private:
+	std::shared_ptr<Model> model;
+	VertexLayout vertexLayout;
+	// not owned by us
+	GeometryArena* vertexArena;
+	GeometryArena* indexArena;
+	LogicalDeviceManager* logicalDeviceManager;
+
+	GeometryArena::Range vertexRange;
+	GeometryArena::Range indexRange;
+
+	template<typename VertexType>
+	void UploadVertices(std::vector<VertexType> const& vertices);
+	// copies go through the graphics batch, so they land before any frame
+	// that's submitted after them
+	void WriteRange(GeometryArena* arena, GeometryArena::Range& range,
+		void const* data, uint32_t numElements);
+};
+
+// Hands out GpuMeshes keyed by model and vertex layout, so objects that
+// share a model don't allocate or upload any geometry of their own. Only
+// weak references are kept; meshes go away with their last user. Owns the
+// arenas the meshes live in: one per vertex layout, and one for indices.
+class GpuMeshCache {
+public:
+	struct Statistics {
+		size_t numMeshes = 0;
+		// lookups that found a live mesh vs. ones that had to upload
+		uint64_t numHits = 0;
+		uint64_t numMisses = 0;
+		size_t numArenaBlocks = 0;
+	};
+
+	GpuMeshCache(LogicalDeviceManager* logicalDeviceManager);
+	// has to outlive every mesh, and every range retired by one
+	~GpuMeshCache();
+
+	std::shared_ptr<GpuMesh> GetMesh(std::shared_ptr<Model> const& model,
+		VertexLayout vertexLayout, GfxDeviceManager* gfxDeviceManager);
+
+	Statistics GetStatistics();
+
+private:
+	LogicalDeviceManager* logicalDeviceManager;
+	std::map<std::pair<Model const*, VertexLayout>, std::weak_ptr<GpuMesh>>
+		meshes;
+	// created on first use
+	std::map<VertexLayout, GeometryArena*> vertexArenas;
+	GeometryArena* indexArena;
+	std::mutex meshMutex;
+	uint64_t numHits;
+	uint64_t numMisses;
+
+	void RemoveExpiredMeshes();
+	GeometryArena* GetVertexArena(VertexLayout vertexLayout,
+		GfxDeviceManager* gfxDeviceManager);
+	static VkDeviceSize GetVertexSize(VertexLayout vertexLayout);
+};
@@ -1,8 +1,15 @@
 #include "LogicalDeviceManager.h"
 #include "GfxDeviceManager.h"
 #include "VulkanInstance.h"
+#include "MemoryAllocator.h"
+#include "UploadContext.h"
+#include "DeferredDestructionQueue.h"
+#include "PipelineCache.h"
+#include "GpuMeshCache.h"
 #include <set>
 
+const std::string LogicalDeviceManager::pipelineCachePath = "pipeline_cache.bin";
+
 LogicalDeviceManager::LogicalDeviceManager(const GfxDeviceManager *gfxDeviceManager,
 	const VulkanInstance *instance, const VkSurfaceKHR surface,
 	const std::vector<const char*>& deviceExtensions,
@@ -12,7 +19,7 @@ LogicalDeviceManager::LogicalDeviceManager(const GfxDeviceManager *gfxDeviceMana
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(),
-		indices.presentFamily.value() };
+		indices.presentFamily.value(), indices.transferFamily.value() };
 
 	float queuePriority = 1.0f;
 	for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -32,6 +39,16 @@ LogicalDeviceManager::LogicalDeviceManager(const GfxDeviceManager *gfxDeviceMana
 	deviceFeatures.fillModeNonSolid = true;
 	// out interior of object at pref cost
 
+	// GPU culling is only turned on if the device can do it
+	std::vector<const char*> enabledExtensions = deviceExtensions;
+	bool drawIndirectCountSupported =
+		gfxDeviceManager->SupportsDrawIndirectCount();
+	if (drawIndirectCountSupported) {
+		deviceFeatures.multiDrawIndirect = VK_TRUE;
+		deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+		enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+	}
+
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
@@ -39,8 +56,8 @@ LogicalDeviceManager::LogicalDeviceManager(const GfxDeviceManager *gfxDeviceMana
 	createInfo.pEnabledFeatures = &deviceFeatures;
 
 	// necessary for stuff like swap chains!
-	createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+	createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 	if (enableValidationLayers) {
 		auto& validationLayers = instance->validationLayers;
@@ -60,8 +77,39 @@ LogicalDeviceManager::LogicalDeviceManager(const GfxDeviceManager *gfxDeviceMana
 		0, &graphicsQueue);
 	vkGetDeviceQueue(device, indices.presentFamily.value(),
 		0, &presentQueue);
+	vkGetDeviceQueue(device, indices.transferFamily.value(),
+		0, &transferQueue);
+
+	cmdDrawIndexedIndirectCount = nullptr;
+	if (drawIndirectCountSupported) {
+		cmdDrawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCountKHR)
+			vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountKHR");
+	}
+
+	memoryAllocator = new MemoryAllocator(device,
+		gfxDeviceManager->GetPhysicalDevice());
+	uploadContext = new UploadContext(device, graphicsQueue,
+		indices.graphicsFamily.value(), transferQueue,
+		indices.transferFamily.value(), memoryAllocator);
+	deferredDestructionQueue = new DeferredDestructionQueue();
+	pipelineCache = new PipelineCache(device,
+		gfxDeviceManager->GetPhysicalDevice(), pipelineCachePath);
+	meshCache = new GpuMeshCache(this);
 }
 
 LogicalDeviceManager::~LogicalDeviceManager() {
+	// waits for pending uploads, so it has to go before the allocator.
+	// canceled uploads retire their resources on the way out
+	delete uploadContext;
+	delete deferredDestructionQueue;
+	// after the queue, which can still be holding on to pipelines and
+	// arena ranges
+	delete pipelineCache;
+	delete meshCache;
+	delete memoryAllocator;
 	vkDestroyDevice(device, nullptr);
 }
+
+VkPipelineCache LogicalDeviceManager::GetPipelineCache() {
+	return pipelineCache->GetPipelineCache();
+}
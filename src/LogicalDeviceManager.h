@@ -1,10 +1,16 @@
 #pragma once
 
 #include "vulkan/vulkan.h"
+#include <string>
 #include <vector>
 
 class VulkanInstance;
 class GfxDeviceManager;
+class MemoryAllocator;
+class UploadContext;
+class DeferredDestructionQueue;
+class PipelineCache;
+class GpuMeshCache;
 
 class LogicalDeviceManager {
 public:
@@ -26,9 +32,52 @@ public:
 		return presentQueue;
 	}
 
+	// same as the graphics queue if there's no dedicated transfer family
+	VkQueue GetTransferQueue() {
+		return transferQueue;
+	}
+
+	MemoryAllocator* GetMemoryAllocator() {
+		return memoryAllocator;
+	}
+
+	UploadContext* GetUploadContext() {
+		return uploadContext;
+	}
+
+	DeferredDestructionQueue* GetDeferredDestructionQueue() {
+		return deferredDestructionQueue;
+	}
+
+	VkPipelineCache GetPipelineCache();
+
+	GpuMeshCache* GetMeshCache() {
+		return meshCache;
+	}
+
+	// null if the device doesn't support VK_KHR_draw_indirect_count
+	PFN_vkCmdDrawIndexedIndirectCountKHR GetCmdDrawIndexedIndirectCount() {
+		return cmdDrawIndexedIndirectCount;
+	}
+
 private:
 	VkDevice device;
+	// all buffer and image memory comes from here
+	MemoryAllocator* memoryAllocator;
+	// staging copies and one-off commands get batched through this
+	UploadContext* uploadContext;
+	// resources that frames in flight might still use wait here
+	DeferredDestructionQueue* deferredDestructionQueue;
+	// every pipeline is created through this; persisted between runs
+	PipelineCache* pipelineCache;
+	// geometry buffers shared by objects that use the same model
+	GpuMeshCache* meshCache;
+
+	static const std::string pipelineCachePath;
 
 	VkQueue graphicsQueue;
 	VkQueue presentQueue;
+	VkQueue transferQueue;
+
+	PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount;
 };
@@ -0,0 +1,78 @@
+#include "BoundingVolumes.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+AABB::AABB() : min(std::numeric_limits<float>::max()),
+	max(-std::numeric_limits<float>::max()) {
+}
+
+AABB::AABB(glm::vec3 const& min, glm::vec3 const& max) : min(min), max(max) {
+}
+
+float AABB::GetDistanceSquared(glm::vec3 const& point) const {
+	glm::vec3 offset = point - glm::clamp(point, min, max);
+	return glm::dot(offset, offset);
+}
+
+float AABB::IntersectRay(glm::vec3 const& origin,
+	glm::vec3 const& inverseDirection, float maxDistance) const {
+	// slab test. divisions by zero in the inverse direction give
+	// infinities, which work out
+	glm::vec3 t1 = (min - origin) * inverseDirection;
+	glm::vec3 t2 = (max - origin) * inverseDirection;
+	glm::vec3 tNear = glm::min(t1, t2);
+	glm::vec3 tFar = glm::max(t1, t2);
+	float entry = std::max(std::max(tNear.x, tNear.y),
+		std::max(tNear.z, 0.0f));
+	float exit = std::min(std::min(tFar.x, tFar.y),
+		std::min(tFar.z, maxDistance));
+	if (entry > exit) {
+		return -1.0f;
+	}
+	return entry;
+}
+
+void AABB::AddPoint(glm::vec3 const& point) {
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+void AABB::Merge(AABB const& other) {
+	min = glm::min(min, other.min);
+	max = glm::max(max, other.max);
+}
+
+void AABB::Expand(float amount) {
+	if (IsEmpty()) {
+		return;
+	}
+	min -= glm::vec3(amount);
+	max += glm::vec3(amount);
+}
+
+AABB AABB::Transformed(glm::mat4 const& transform) const {
+	if (IsEmpty()) {
+		return AABB();
+	}
+
+	// Arvo's method: the new extents are the old ones pushed through the
+	// absolute value of the rotation/scale part
+	glm::vec3 center = GetCenter();
+	glm::vec3 extents = GetExtents();
+	glm::vec3 newCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+	glm::vec3 newExtents(0.0f);
+	for (int column = 0; column < 3; column++) {
+		newExtents += glm::abs(glm::vec3(transform[column])) * extents[column];
+	}
+	return AABB(newCenter - newExtents, newCenter + newExtents);
+}
+
+BoundingSphere BoundingSphere::Transformed(glm::mat4 const& transform) const {
+	// non-uniform scale stretches the sphere by the largest axis
+	float maxScale = std::max(glm::length(glm::vec3(transform[0])),
+		std::max(glm::length(glm::vec3(transform[1])),
+		glm::length(glm::vec3(transform[2]))));
+	return BoundingSphere(glm::vec3(transform * glm::vec4(center, 1.0f)),
+		radius * maxScale);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Axis-aligned box. An empty box has min above max, so merging anything
+// into it gives back the other box.
+class AABB {
+public:
+	AABB();
+	AABB(glm::vec3 const& min, glm::vec3 const& max);
+
+	bool IsEmpty() const {
+		return min.x > max.x || min.y > max.y || min.z > max.z;
+	}
+
+	glm::vec3 GetCenter() const {
+		return (min + max) * 0.5f;
+	}
+
+	glm::vec3 GetExtents() const {
+		return (max - min) * 0.5f;
+	}
+
+	bool Contains(AABB const& other) const {
+		return min.x <= other.min.x && min.y <= other.min.y &&
+			min.z <= other.min.z && other.max.x <= max.x &&
+			other.max.y <= max.y && other.max.z <= max.z;
+	}
+
+	// zero for points inside
+	float GetDistanceSquared(glm::vec3 const& point) const;
+	// distance along the ray to where it enters the box, zero if it starts
+	// inside, or a negative value if it misses the box within maxDistance.
+	// takes one over the direction so it can be shared between boxes
+	float IntersectRay(glm::vec3 const& origin,
+		glm::vec3 const& inverseDirection, float maxDistance) const;
+
+	void AddPoint(glm::vec3 const& point);
+	void Merge(AABB const& other);
+	void Expand(float amount);
+	// box around this one after it's been transformed. it can be looser
+	// than the transformed geometry, but never tighter
+	AABB Transformed(glm::mat4 const& transform) const;
+
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+class BoundingSphere {
+public:
+	BoundingSphere() : center(0.0f, 0.0f, 0.0f), radius(0.0f) {}
+	BoundingSphere(glm::vec3 const& center, float radius) :
+		center(center), radius(radius) {}
+
+	BoundingSphere Transformed(glm::mat4 const& transform) const;
+
+	glm::vec3 center;
+	float radius;
+};
@@ -104,3 +104,35 @@ CommonMath::Quaternion CommonMath::Slerp(CommonMath::Quaternion const& q1,
 	result.r = (q1.r * ratioA + q2.r * ratioB);
 	return result;
 }
+
+bool CommonMath::RaySphereIntersection(glm::vec3 const& rayDir,
+	glm::vec3 const& rayOrigin, float radius, glm::vec3 const& sphereOrigin,
+	float& tVal) {
+	glm::vec3 centerToRayOrigin = rayOrigin - sphereOrigin;
+	float a = glm::dot(rayDir, rayDir);
+	float b = 2.0f * glm::dot(centerToRayOrigin, rayDir);
+	float c = glm::dot(centerToRayOrigin, centerToRayOrigin) - radius* radius;
+	float discr = b * b - 4.0f * a * c;
+
+	if (discr < 0.0f) {
+		return false;
+	}
+
+	float e = sqrt(discr);
+	float denom = 2.0f * a;
+	float t = (-b - e) / denom;
+	// smaller root
+	if (t > 0.0f) {
+		tVal = t;
+		return true;
+	}
+
+	t = (-b + e) / denom;
+	if (t > 0.0f) {
+		tVal = t;
+		return true;
+	}
+
+	// all tests failed so far
+	return false;
+}
@@ -27,4 +27,10 @@ public:
 		glm::vec3& up, glm::vec3& right);
 
 	static Quaternion Slerp(Quaternion const& q1, Quaternion const& q2, float t);
+
+	// nearest intersection in front of the ray's origin. tVal is in units
+	// of rayDir
+	static bool RaySphereIntersection(glm::vec3 const& rayDir,
+		glm::vec3 const& rayOrigin, float radius,
+		glm::vec3 const& sphereOrigin, float& tVal);
 };
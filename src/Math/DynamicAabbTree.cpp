@@ -0,0 +1,266 @@
+#include "Math/DynamicAabbTree.h"
+#include <algorithm>
+
+const int32_t DynamicAabbTree::nullNode = -1;
+
+DynamicAabbTree::DynamicAabbTree(float fatMargin) : fatMargin(fatMargin),
+	root(nullNode), freeList(nullNode), numProxies(0) {
+}
+
+int32_t DynamicAabbTree::CreateProxy(AABB const& bounds, uint32_t item,
+	uint32_t categoryBits) {
+	int32_t proxy = AllocateNode();
+	Node& node = nodes[proxy];
+	node.bounds = bounds;
+	node.bounds.Expand(fatMargin);
+	node.item = item;
+	node.categoryBits = categoryBits;
+	node.height = 0;
+	InsertLeaf(proxy);
+	numProxies++;
+	return proxy;
+}
+
+void DynamicAabbTree::DestroyProxy(int32_t proxy) {
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	numProxies--;
+}
+
+bool DynamicAabbTree::MoveProxy(int32_t proxy, AABB const& bounds) {
+	if (nodes[proxy].bounds.Contains(bounds)) {
+		return false;
+	}
+
+	RemoveLeaf(proxy);
+	nodes[proxy].bounds = bounds;
+	nodes[proxy].bounds.Expand(fatMargin);
+	InsertLeaf(proxy);
+	return true;
+}
+
+void DynamicAabbTree::SetCategoryBits(int32_t proxy, uint32_t categoryBits) {
+	if (nodes[proxy].categoryBits == categoryBits) {
+		return;
+	}
+	nodes[proxy].categoryBits = categoryBits;
+	RefitAncestors(nodes[proxy].parent);
+}
+
+void DynamicAabbTree::Clear() {
+	nodes.clear();
+	root = nullNode;
+	freeList = nullNode;
+	numProxies = 0;
+}
+
+int32_t DynamicAabbTree::AllocateNode() {
+	int32_t node;
+	if (freeList != nullNode) {
+		node = freeList;
+		freeList = nodes[node].parent;
+	}
+	else {
+		node = (int32_t)nodes.size();
+		nodes.push_back(Node());
+	}
+
+	Node& newNode = nodes[node];
+	newNode.parent = nullNode;
+	newNode.child1 = nullNode;
+	newNode.child2 = nullNode;
+	newNode.height = 0;
+	newNode.item = 0;
+	newNode.categoryBits = 0;
+	return node;
+}
+
+void DynamicAabbTree::FreeNode(int32_t node) {
+	nodes[node].parent = freeList;
+	nodes[node].height = -1;
+	freeList = node;
+}
+
+void DynamicAabbTree::InsertLeaf(int32_t leaf) {
+	if (root == nullNode) {
+		root = leaf;
+		nodes[root].parent = nullNode;
+		return;
+	}
+
+	// the leaf and its new sibling share a new parent, which takes the
+	// sibling's place
+	int32_t sibling = FindBestSibling(nodes[leaf].bounds);
+	int32_t oldParent = nodes[sibling].parent;
+	int32_t newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent == nullNode) {
+		root = newParent;
+	}
+	else if (nodes[oldParent].child1 == sibling) {
+		nodes[oldParent].child1 = newParent;
+	}
+	else {
+		nodes[oldParent].child2 = newParent;
+	}
+
+	RefitAncestors(newParent);
+}
+
+void DynamicAabbTree::RemoveLeaf(int32_t leaf) {
+	if (leaf == root) {
+		root = nullNode;
+		return;
+	}
+
+	// the sibling takes the parent's place, and the parent goes away
+	int32_t parent = nodes[leaf].parent;
+	int32_t grandParent = nodes[parent].parent;
+	int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 :
+		nodes[parent].child1;
+
+	if (grandParent == nullNode) {
+		root = sibling;
+		nodes[sibling].parent = nullNode;
+		FreeNode(parent);
+		return;
+	}
+
+	if (nodes[grandParent].child1 == parent) {
+		nodes[grandParent].child1 = sibling;
+	}
+	else {
+		nodes[grandParent].child2 = sibling;
+	}
+	nodes[sibling].parent = grandParent;
+	FreeNode(parent);
+
+	RefitAncestors(grandParent);
+}
+
+int32_t DynamicAabbTree::FindBestSibling(AABB const& leafBounds) const {
+	// walks down the cheaper side, where cost is how much surface area the
+	// tree gains. every ancestor of the sibling grows to take in the leaf
+	// too, which is paid no matter where the walk goes from there
+	int32_t node = root;
+	while (!nodes[node].IsLeaf()) {
+		Node const& current = nodes[node];
+		float area = GetSurfaceArea(current.bounds);
+		float combinedArea = GetSurfaceArea(GetMerged(current.bounds,
+			leafBounds));
+
+		// making a new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+		// what going further down adds to every ancestor on the way
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCosts[2];
+		int32_t children[2] = { current.child1, current.child2 };
+		for (int i = 0; i < 2; i++) {
+			Node const& child = nodes[children[i]];
+			float mergedArea = GetSurfaceArea(GetMerged(child.bounds,
+				leafBounds));
+			if (child.IsLeaf()) {
+				childCosts[i] = mergedArea + inheritanceCost;
+			}
+			else {
+				// a lower bound, since deeper nodes only add to it
+				childCosts[i] = mergedArea - GetSurfaceArea(child.bounds) +
+					inheritanceCost;
+			}
+		}
+
+		if (cost < childCosts[0] && cost < childCosts[1]) {
+			break;
+		}
+		node = childCosts[0] < childCosts[1] ? children[0] : children[1];
+	}
+	return node;
+}
+
+void DynamicAabbTree::RefitAncestors(int32_t node) {
+	while (node != nullNode) {
+		node = Balance(node);
+		UpdateFromChildren(node);
+		node = nodes[node].parent;
+	}
+}
+
+int32_t DynamicAabbTree::Balance(int32_t a) {
+	// the AVL rotation from Box2D's dynamic tree: if one child of a is
+	// two levels taller than the other, its taller child swaps places
+	// with a
+	Node& nodeA = nodes[a];
+	if (nodeA.IsLeaf()) {
+		return a;
+	}
+
+	int32_t b = nodeA.child1;
+	int32_t c = nodeA.child2;
+	int32_t balance = nodes[c].height - nodes[b].height;
+	if (balance >= -1 && balance <= 1) {
+		return a;
+	}
+
+	// the taller child comes up, and a goes below it
+	int32_t up = balance > 1 ? c : b;
+	Node& upNode = nodes[up];
+	int32_t f = upNode.child1;
+	int32_t g = upNode.child2;
+
+	upNode.child1 = a;
+	upNode.parent = nodeA.parent;
+	nodeA.parent = up;
+	if (upNode.parent == nullNode) {
+		root = up;
+	}
+	else if (nodes[upNode.parent].child1 == a) {
+		nodes[upNode.parent].child1 = up;
+	}
+	else {
+		nodes[upNode.parent].child2 = up;
+	}
+
+	// the taller grandchild stays with the node that came up, and the
+	// shorter one goes to a in its place
+	int32_t keep = nodes[f].height > nodes[g].height ? f : g;
+	int32_t give = keep == f ? g : f;
+	upNode.child2 = keep;
+	nodes[keep].parent = up;
+	if (balance > 1) {
+		nodeA.child2 = give;
+	}
+	else {
+		nodeA.child1 = give;
+	}
+	nodes[give].parent = a;
+
+	UpdateFromChildren(a);
+	UpdateFromChildren(up);
+	return up;
+}
+
+void DynamicAabbTree::UpdateFromChildren(int32_t node) {
+	Node& parent = nodes[node];
+	Node const& child1 = nodes[parent.child1];
+	Node const& child2 = nodes[parent.child2];
+	parent.bounds = GetMerged(child1.bounds, child2.bounds);
+	parent.height = 1 + std::max(child1.height, child2.height);
+	parent.categoryBits = child1.categoryBits | child2.categoryBits;
+}
+
+float DynamicAabbTree::GetSurfaceArea(AABB const& bounds) {
+	glm::vec3 size = bounds.max - bounds.min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+AABB DynamicAabbTree::GetMerged(AABB const& first, AABB const& second) {
+	AABB merged = first;
+	merged.Merge(second);
+	return merged;
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include "Math/BoundingVolumes.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Bounding volume hierarchy over boxes that move, for objects that can't
+// wait for a rebuild from scratch. Leaves hold boxes fattened by a margin,
+// so an object that moves a little stays inside its leaf and the tree
+// doesn't change at all; only objects that leave theirs are taken out and
+// inserted again. Insertion picks the sibling that grows the tree's
+// surface area the least, and rotations keep it balanced, so queries stay
+// logarithmic as it grows. Every proxy has category bits, and nodes keep
+// the union of the bits under them, so queries can skip whole subtrees
+// that hold nothing they're looking for. Doesn't need a GPU, so it can be
+// tested on its own.
+class DynamicAabbTree {
+public:
+	static const int32_t nullNode;
+
+	explicit DynamicAabbTree(float fatMargin);
+
+	// item is handed back by queries; usually an index into the caller's
+	// own array
+	int32_t CreateProxy(AABB const& bounds, uint32_t item,
+		uint32_t categoryBits);
+	void DestroyProxy(int32_t proxy);
+	// returns false if the box still fits in the proxy's fattened one, in
+	// which case nothing changed
+	bool MoveProxy(int32_t proxy, AABB const& bounds);
+	void SetCategoryBits(int32_t proxy, uint32_t categoryBits);
+	void Clear();
+
+	uint32_t GetItem(int32_t proxy) const {
+		return nodes[proxy].item;
+	}
+
+	AABB const& GetFatBounds(int32_t proxy) const {
+		return nodes[proxy].bounds;
+	}
+
+	size_t GetNumProxies() const {
+		return numProxies;
+	}
+
+	int32_t GetHeight() const {
+		return root == nullNode ? 0 : nodes[root].height;
+	}
+
+	// calls visitItem for each proxy whose fattened box touches the
+	// sphere and shares a bit with categoryMask. it returns false to stop
+	template<typename VisitItem>
+	void QuerySphere(glm::vec3 const& center, float radius,
+		uint32_t categoryMask, VisitItem const& visitItem) const;
+	// walks the proxies the ray passes through, nearest boxes first.
+	// raycastItem does the exact test and returns the distance along the
+	// ray where it hit, or a negative value if it missed; hits shorten the
+	// ray for the rest of the walk. direction has to be normalized
+	template<typename RaycastItem>
+	void Raycast(glm::vec3 const& origin, glm::vec3 const& direction,
+		float maxDistance, uint32_t categoryMask,
+		RaycastItem const& raycastItem) const;
+	// item with the smallest distance within maxDistance, or false if
+	// there is none. distanceToItem returns the exact distance to an item,
+	// or a negative value to skip it, and can't be smaller than the
+	// distance to the item's box
+	template<typename DistanceToItem>
+	bool FindNearest(glm::vec3 const& point, float maxDistance,
+		uint32_t categoryMask, DistanceToItem const& distanceToItem,
+		uint32_t& nearestItem, float& nearestDistance) const;
+
+private:
+	struct Node {
+		// fattened for leaves
+		AABB bounds;
+		// the next free node when this one is free
+		int32_t parent;
+		int32_t child1;
+		int32_t child2;
+		// zero for leaves, -1 for free nodes
+		int32_t height;
+		uint32_t item;
+		// union of the children's bits for inner nodes
+		uint32_t categoryBits;
+
+		bool IsLeaf() const {
+			return child1 == nullNode;
+		}
+	};
+
+	float fatMargin;
+	std::vector<Node> nodes;
+	int32_t root;
+	int32_t freeList;
+	size_t numProxies;
+	// reused by queries, which are const. so queries can't run on
+	// several threads, or from another query's callback
+	mutable std::vector<int32_t> stack;
+
+	int32_t AllocateNode();
+	void FreeNode(int32_t node);
+	void InsertLeaf(int32_t leaf);
+	void RemoveLeaf(int32_t leaf);
+	int32_t FindBestSibling(AABB const& leafBounds) const;
+	// fixes the bounds, heights and bits from node up to the root
+	void RefitAncestors(int32_t node);
+	// rotates node's subtree if one side is more than one level taller
+	int32_t Balance(int32_t node);
+	void UpdateFromChildren(int32_t node);
+
+	static float GetSurfaceArea(AABB const& bounds);
+	static AABB GetMerged(AABB const& first, AABB const& second);
+};
+
+template<typename VisitItem>
+void DynamicAabbTree::QuerySphere(glm::vec3 const& center, float radius,
+	uint32_t categoryMask, VisitItem const& visitItem) const {
+	if (root == nullNode) {
+		return;
+	}
+
+	float radiusSquared = radius * radius;
+	stack.clear();
+	stack.push_back(root);
+	while (!stack.empty()) {
+		Node const& node = nodes[stack.back()];
+		stack.pop_back();
+		if ((node.categoryBits & categoryMask) == 0 ||
+			node.bounds.GetDistanceSquared(center) > radiusSquared) {
+			continue;
+		}
+
+		if (node.IsLeaf()) {
+			if (!visitItem(node.item)) {
+				return;
+			}
+		}
+		else {
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+}
+
+template<typename RaycastItem>
+void DynamicAabbTree::Raycast(glm::vec3 const& origin,
+	glm::vec3 const& direction, float maxDistance, uint32_t categoryMask,
+	RaycastItem const& raycastItem) const {
+	if (root == nullNode) {
+		return;
+	}
+
+	glm::vec3 inverseDirection = 1.0f / direction;
+	stack.clear();
+	stack.push_back(root);
+	while (!stack.empty()) {
+		Node const& node = nodes[stack.back()];
+		stack.pop_back();
+		if ((node.categoryBits & categoryMask) == 0 ||
+			node.bounds.IntersectRay(origin, inverseDirection,
+				maxDistance) < 0.0f) {
+			continue;
+		}
+
+		if (node.IsLeaf()) {
+			float hitDistance = raycastItem(node.item);
+			if (hitDistance >= 0.0f && hitDistance < maxDistance) {
+				maxDistance = hitDistance;
+			}
+			continue;
+		}
+
+		// the nearer child goes on top, so its hits can cut the farther
+		// one off
+		float distance1 = nodes[node.child1].bounds.IntersectRay(origin,
+			inverseDirection, maxDistance);
+		float distance2 = nodes[node.child2].bounds.IntersectRay(origin,
+			inverseDirection, maxDistance);
+		int32_t child1 = node.child1;
+		int32_t child2 = node.child2;
+		if (distance2 >= 0.0f && (distance1 < 0.0f || distance2 < distance1)) {
+			std::swap(child1, child2);
+			std::swap(distance1, distance2);
+		}
+		if (distance2 >= 0.0f) {
+			stack.push_back(child2);
+		}
+		if (distance1 >= 0.0f) {
+			stack.push_back(child1);
+		}
+	}
+}
+
+template<typename DistanceToItem>
+bool DynamicAabbTree::FindNearest(glm::vec3 const& point, float maxDistance,
+	uint32_t categoryMask, DistanceToItem const& distanceToItem,
+	uint32_t& nearestItem, float& nearestDistance) const {
+	if (root == nullNode) {
+		return false;
+	}
+
+	float nearestDistanceSquared = maxDistance * maxDistance;
+	bool found = false;
+	stack.clear();
+	stack.push_back(root);
+	while (!stack.empty()) {
+		Node const& node = nodes[stack.back()];
+		stack.pop_back();
+		// nodes found before this one was reached may have narrowed things
+		if ((node.categoryBits & categoryMask) == 0 ||
+			node.bounds.GetDistanceSquared(point) > nearestDistanceSquared) {
+			continue;
+		}
+
+		if (node.IsLeaf()) {
+			float distance = distanceToItem(node.item);
+			if (distance >= 0.0f &&
+				distance * distance <= nearestDistanceSquared) {
+				nearestDistanceSquared = distance * distance;
+				nearestItem = node.item;
+				nearestDistance = distance;
+				found = true;
+			}
+			continue;
+		}
+
+		// the nearer child goes on top, so it gets visited first
+		float distance1 = nodes[node.child1].bounds.GetDistanceSquared(point);
+		float distance2 = nodes[node.child2].bounds.GetDistanceSquared(point);
+		if (distance1 < distance2) {
+			stack.push_back(node.child2);
+			stack.push_back(node.child1);
+		}
+		else {
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+	return found;
+}
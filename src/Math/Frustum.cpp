@@ -0,0 +1,109 @@
+#include "Frustum.h"
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define FRUSTUM_USE_SSE
+	#include <xmmintrin.h>
+#endif
+
+Frustum::Frustum(glm::mat4 const& viewProjection) {
+	// Gribb/Hartmann: each plane is the last row plus or minus another.
+	// glm is column major, so rows are gathered across columns
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++) {
+		rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row],
+			viewProjection[2][row], viewProjection[3][row]);
+	}
+	// near uses the [-1, 1] depth convention of the projection matrix
+	glm::vec4 planes[numPlanes] = {
+		rows[3] + rows[0], rows[3] - rows[0],
+		rows[3] + rows[1], rows[3] - rows[1],
+		rows[3] + rows[2], rows[3] - rows[2]
+	};
+
+	for (size_t i = 0; i < numPlanes; i++) {
+		// normalized so that box extents project to real distances
+		float normalLength = glm::length(glm::vec3(planes[i]));
+		glm::vec4 plane = planes[i] / normalLength;
+		planeX[i] = plane.x;
+		planeY[i] = plane.y;
+		planeZ[i] = plane.z;
+		planeW[i] = plane.w;
+	}
+}
+
+void Frustum::TestBoxes(float const* centersX, float const* centersY,
+	float const* centersZ, float const* extentsX, float const* extentsY,
+	float const* extentsZ, size_t numBoxes, uint8_t* visible) const {
+	size_t boxIndex = 0;
+#ifdef FRUSTUM_USE_SSE
+	// a box is outside if it's entirely behind any one plane. it's behind
+	// when the distance to its center plus its extents projected onto the
+	// plane normal is negative
+	__m128 zero = _mm_setzero_ps();
+	__m128 signMask = _mm_set1_ps(-0.0f);
+	for (; boxIndex + 4 <= numBoxes; boxIndex += 4) {
+		__m128 centerX = _mm_loadu_ps(centersX + boxIndex);
+		__m128 centerY = _mm_loadu_ps(centersY + boxIndex);
+		__m128 centerZ = _mm_loadu_ps(centersZ + boxIndex);
+		__m128 extentX = _mm_loadu_ps(extentsX + boxIndex);
+		__m128 extentY = _mm_loadu_ps(extentsY + boxIndex);
+		__m128 extentZ = _mm_loadu_ps(extentsZ + boxIndex);
+
+		__m128 outside = _mm_setzero_ps();
+		for (size_t planeIndex = 0; planeIndex < numPlanes; planeIndex++) {
+			__m128 normalX = _mm_set1_ps(planeX[planeIndex]);
+			__m128 normalY = _mm_set1_ps(planeY[planeIndex]);
+			__m128 normalZ = _mm_set1_ps(planeZ[planeIndex]);
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(centerX, normalX),
+					_mm_mul_ps(centerY, normalY)),
+				_mm_add_ps(_mm_mul_ps(centerZ, normalZ),
+					_mm_set1_ps(planeW[planeIndex])));
+			__m128 radius = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(extentX, _mm_andnot_ps(signMask, normalX)),
+					_mm_mul_ps(extentY, _mm_andnot_ps(signMask, normalY))),
+				_mm_mul_ps(extentZ, _mm_andnot_ps(signMask, normalZ)));
+			outside = _mm_or_ps(outside,
+				_mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		for (int lane = 0; lane < 4; lane++) {
+			visible[boxIndex + lane] = (outsideMask >> lane) & 1 ? 0 : 1;
+		}
+	}
+#endif
+	for (; boxIndex < numBoxes; boxIndex++) {
+		visible[boxIndex] = IsBoxVisible(
+			glm::vec3(centersX[boxIndex], centersY[boxIndex], centersZ[boxIndex]),
+			glm::vec3(extentsX[boxIndex], extentsY[boxIndex],
+				extentsZ[boxIndex])) ? 1 : 0;
+	}
+}
+
+bool Frustum::IsBoxVisible(glm::vec3 const& center,
+	glm::vec3 const& extents) const {
+	for (size_t i = 0; i < numPlanes; i++) {
+		float distance = center.x * planeX[i] + center.y * planeY[i] +
+			center.z * planeZ[i] + planeW[i];
+		float radius = extents.x * fabsf(planeX[i]) +
+			extents.y * fabsf(planeY[i]) + extents.z * fabsf(planeZ[i]);
+		if (distance + radius < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::IsSphereVisible(glm::vec3 const& center, float radius) const {
+	for (size_t i = 0; i < numPlanes; i++) {
+		float distance = center.x * planeX[i] + center.y * planeY[i] +
+			center.z * planeZ[i] + planeW[i];
+		if (distance < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// View frustum as six planes facing inwards, pulled out of a
+// projection * view matrix. Planes are stored one component per array so
+// that boxes can be tested four at a time.
+class Frustum {
+public:
+	explicit Frustum(glm::mat4 const& viewProjection);
+
+	// boxes are given as centers and half extents, one component per array.
+	// visible[i] is set to 1 if box i is at least partly inside, 0 if not
+	void TestBoxes(float const* centersX, float const* centersY,
+		float const* centersZ, float const* extentsX, float const* extentsY,
+		float const* extentsZ, size_t numBoxes, uint8_t* visible) const;
+
+	bool IsBoxVisible(glm::vec3 const& center, glm::vec3 const& extents) const;
+	bool IsSphereVisible(glm::vec3 const& center, float radius) const;
+
+	// normal in xyz, distance in w
+	glm::vec4 GetPlane(size_t planeIndex) const {
+		return glm::vec4(planeX[planeIndex], planeY[planeIndex],
+			planeZ[planeIndex], planeW[planeIndex]);
+	}
+
+	static const size_t numPlanes = 6;
+
+private:
+	// plane i is normal (planeX[i], planeY[i], planeZ[i]) and distance
+	// planeW[i]. points inside give a positive dot product
+	alignas(16) float planeX[numPlanes];
+	alignas(16) float planeY[numPlanes];
+	alignas(16) float planeZ[numPlanes];
+	alignas(16) float planeW[numPlanes];
+};
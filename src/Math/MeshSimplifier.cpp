@@ -0,0 +1,397 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <utility>
+
+// boundary edges get a plane of their own so open meshes don't shrink
+// away from their borders. weighed by the edge's squared length
+static const double boundaryWeight = 100.0;
+// collapses that turn a triangle further than this away from where it
+// faced, or make it degenerate, are rejected
+static const double minNormalDot = 0.25;
+
+MeshSimplifier::Quadric::Quadric() {
+	std::fill(values, values + 10, 0.0);
+}
+
+MeshSimplifier::Quadric::Quadric(glm::dvec4 const& plane, double weight) {
+	double a = plane.x, b = plane.y, c = plane.z, d = plane.w;
+	values[0] = a * a * weight;
+	values[1] = a * b * weight;
+	values[2] = a * c * weight;
+	values[3] = a * d * weight;
+	values[4] = b * b * weight;
+	values[5] = b * c * weight;
+	values[6] = b * d * weight;
+	values[7] = c * c * weight;
+	values[8] = c * d * weight;
+	values[9] = d * d * weight;
+}
+
+void MeshSimplifier::Quadric::Add(Quadric const& other) {
+	for (size_t i = 0; i < 10; i++) {
+		values[i] += other.values[i];
+	}
+}
+
+double MeshSimplifier::Quadric::Evaluate(glm::dvec3 const& point) const {
+	double x = point.x, y = point.y, z = point.z;
+	return values[0] * x * x + 2.0 * values[1] * x * y +
+		2.0 * values[2] * x * z + 2.0 * values[3] * x +
+		values[4] * y * y + 2.0 * values[5] * y * z + 2.0 * values[6] * y +
+		values[7] * z * z + 2.0 * values[8] * z + values[9];
+}
+
+MeshSimplifier::MeshSimplifier(std::vector<glm::vec3> const& positions,
+	std::vector<uint32_t> const& indices) : numLiveTriangles(0) {
+	WeldVertices(positions);
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		Triangle triangle;
+		triangle.corners[0] = indices[i];
+		triangle.corners[1] = indices[i + 1];
+		triangle.corners[2] = indices[i + 2];
+		triangle.live = true;
+		uint32_t group0 = vertexGroups[triangle.corners[0]];
+		uint32_t group1 = vertexGroups[triangle.corners[1]];
+		uint32_t group2 = vertexGroups[triangle.corners[2]];
+		// already degenerate, so it wouldn't be drawn anyway
+		if (group0 == group1 || group1 == group2 || group0 == group2) {
+			continue;
+		}
+
+		uint32_t triangleIndex = (uint32_t)triangles.size();
+		triangles.push_back(triangle);
+		groups[group0].triangles.push_back(triangleIndex);
+		groups[group1].triangles.push_back(triangleIndex);
+		groups[group2].triangles.push_back(triangleIndex);
+		numLiveTriangles++;
+	}
+
+	AddQuadrics();
+	std::vector<uint32_t> neighbours;
+	for (uint32_t groupIndex = 0; groupIndex < (uint32_t)groups.size();
+		groupIndex++) {
+		GetNeighbours(groupIndex, neighbours);
+		// each edge is seen from both ends
+		for (uint32_t neighbour : neighbours) {
+			if (neighbour > groupIndex) {
+				PushCollapse(groupIndex, neighbour);
+			}
+		}
+	}
+}
+
+void MeshSimplifier::WeldVertices(std::vector<glm::vec3> const& positions) {
+	std::vector<uint32_t> sortedVertices(positions.size());
+	for (uint32_t i = 0; i < (uint32_t)positions.size(); i++) {
+		sortedVertices[i] = i;
+	}
+	std::sort(sortedVertices.begin(), sortedVertices.end(),
+		[&positions](uint32_t first, uint32_t second) {
+			glm::vec3 const& a = positions[first];
+			glm::vec3 const& b = positions[second];
+			if (a.x != b.x) {
+				return a.x < b.x;
+			}
+			if (a.y != b.y) {
+				return a.y < b.y;
+			}
+			return a.z < b.z;
+		});
+
+	vertexGroups.resize(positions.size());
+	for (size_t i = 0; i < sortedVertices.size(); i++) {
+		uint32_t vertex = sortedVertices[i];
+		if (i == 0 || positions[vertex] != positions[sortedVertices[i - 1]]) {
+			Group group;
+			group.position = glm::dvec3(positions[vertex]);
+			group.version = 0;
+			group.live = true;
+			groups.push_back(group);
+		}
+		vertexGroups[vertex] = (uint32_t)groups.size() - 1;
+		groups.back().vertices.push_back(vertex);
+	}
+}
+
+void MeshSimplifier::AddQuadrics() {
+	// group edges, and the one triangle seen using each
+	std::map<std::pair<uint32_t, uint32_t>, std::pair<uint32_t, uint32_t>>
+		edgeUses;
+	for (uint32_t triangleIndex = 0; triangleIndex < (uint32_t)triangles.size();
+		triangleIndex++) {
+		Triangle const& triangle = triangles[triangleIndex];
+		glm::dvec3 p0 = GetCornerPosition(triangle, 0);
+		glm::dvec3 p1 = GetCornerPosition(triangle, 1);
+		glm::dvec3 p2 = GetCornerPosition(triangle, 2);
+		glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		double doubleArea = glm::length(normal);
+		if (doubleArea > 0.0) {
+			normal /= doubleArea;
+			Quadric quadric(glm::dvec4(normal, -glm::dot(normal, p0)),
+				doubleArea * 0.5);
+			for (uint32_t corner = 0; corner < 3; corner++) {
+				groups[vertexGroups[triangle.corners[corner]]].quadric.Add(
+					quadric);
+			}
+		}
+
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			uint32_t group1 = vertexGroups[triangle.corners[corner]];
+			uint32_t group2 = vertexGroups[triangle.corners[(corner + 1) % 3]];
+			auto edge = std::make_pair(std::min(group1, group2),
+				std::max(group1, group2));
+			auto& edgeUse = edgeUses[edge];
+			edgeUse.first++;
+			edgeUse.second = triangleIndex;
+		}
+	}
+
+	for (auto const& edgeUse : edgeUses) {
+		if (edgeUse.second.first != 1) {
+			continue;
+		}
+		Triangle const& triangle = triangles[edgeUse.second.second];
+		glm::dvec3 p0 = GetCornerPosition(triangle, 0);
+		glm::dvec3 p1 = GetCornerPosition(triangle, 1);
+		glm::dvec3 p2 = GetCornerPosition(triangle, 2);
+		glm::dvec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+
+		uint32_t group1 = edgeUse.first.first;
+		uint32_t group2 = edgeUse.first.second;
+		glm::dvec3 edgeVec = groups[group2].position - groups[group1].position;
+		glm::dvec3 normal = glm::cross(edgeVec, faceNormal);
+		double normalLength = glm::length(normal);
+		if (normalLength == 0.0) {
+			continue;
+		}
+		normal /= normalLength;
+		Quadric quadric(glm::dvec4(normal,
+			-glm::dot(normal, groups[group1].position)),
+			boundaryWeight * glm::dot(edgeVec, edgeVec));
+		groups[group1].quadric.Add(quadric);
+		groups[group2].quadric.Add(quadric);
+	}
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(size_t targetNumTriangles) {
+	while (numLiveTriangles > targetNumTriangles && !collapses.empty()) {
+		Collapse collapse = collapses.top();
+		collapses.pop();
+		Group const& fromGroup = groups[collapse.from];
+		Group const& toGroup = groups[collapse.to];
+		if (!fromGroup.live || !toGroup.live ||
+			fromGroup.version != collapse.fromVersion ||
+			toGroup.version != collapse.toVersion) {
+			continue;
+		}
+		TryCollapse(collapse);
+	}
+
+	std::vector<uint32_t> indices;
+	indices.reserve(numLiveTriangles * 3);
+	for (auto const& triangle : triangles) {
+		if (triangle.live) {
+			indices.push_back(triangle.corners[0]);
+			indices.push_back(triangle.corners[1]);
+			indices.push_back(triangle.corners[2]);
+		}
+	}
+	return indices;
+}
+
+void MeshSimplifier::PushCollapsesForGroup(uint32_t groupIndex) {
+	std::vector<uint32_t> neighbours;
+	GetNeighbours(groupIndex, neighbours);
+	for (uint32_t neighbour : neighbours) {
+		PushCollapse(groupIndex, neighbour);
+	}
+}
+
+void MeshSimplifier::PushCollapse(uint32_t group1, uint32_t group2) {
+	Quadric quadric = groups[group1].quadric;
+	quadric.Add(groups[group2].quadric);
+	double costTo2 = quadric.Evaluate(groups[group2].position);
+	double costTo1 = quadric.Evaluate(groups[group1].position);
+
+	Collapse collapse;
+	if (costTo2 <= costTo1) {
+		collapse.cost = costTo2;
+		collapse.from = group1;
+		collapse.to = group2;
+	}
+	else {
+		collapse.cost = costTo1;
+		collapse.from = group2;
+		collapse.to = group1;
+	}
+	collapse.fromVersion = groups[collapse.from].version;
+	collapse.toVersion = groups[collapse.to].version;
+	collapses.push(collapse);
+}
+
+bool MeshSimplifier::TryCollapse(Collapse const& collapse) {
+	uint32_t from = collapse.from;
+	uint32_t to = collapse.to;
+	Group& fromGroup = groups[from];
+	Group& toGroup = groups[to];
+
+	size_t numSharedTriangles = 0;
+	for (uint32_t triangleIndex : fromGroup.triangles) {
+		Triangle const& triangle = triangles[triangleIndex];
+		if (triangle.live && TriangleHasGroup(triangle, to)) {
+			numSharedTriangles++;
+		}
+	}
+	if (numSharedTriangles == 0) {
+		return false;
+	}
+
+	// the link condition: if the two share more neighbours than the
+	// triangles on their edge, collapsing would pinch the surface
+	std::vector<uint32_t> fromNeighbours, toNeighbours, sharedNeighbours;
+	GetNeighbours(from, fromNeighbours);
+	GetNeighbours(to, toNeighbours);
+	std::set_intersection(fromNeighbours.begin(), fromNeighbours.end(),
+		toNeighbours.begin(), toNeighbours.end(),
+		std::back_inserter(sharedNeighbours));
+	if (sharedNeighbours.size() > numSharedTriangles) {
+		return false;
+	}
+	if (CollapseFoldsTriangles(from, to)) {
+		return false;
+	}
+
+	// has to be worked out before the triangles on the edge go away
+	std::vector<std::pair<uint32_t, uint32_t>> replacements;
+	for (uint32_t vertex : fromGroup.vertices) {
+		replacements.push_back(std::make_pair(vertex,
+			FindReplacementVertex(vertex, from, to)));
+	}
+
+	for (uint32_t triangleIndex : fromGroup.triangles) {
+		Triangle& triangle = triangles[triangleIndex];
+		if (!triangle.live) {
+			continue;
+		}
+		if (TriangleHasGroup(triangle, to)) {
+			triangle.live = false;
+			numLiveTriangles--;
+			continue;
+		}
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			if (vertexGroups[triangle.corners[corner]] != from) {
+				continue;
+			}
+			for (auto const& replacement : replacements) {
+				if (replacement.first == triangle.corners[corner]) {
+					triangle.corners[corner] = replacement.second;
+					break;
+				}
+			}
+		}
+		toGroup.triangles.push_back(triangleIndex);
+	}
+
+	toGroup.triangles.erase(std::remove_if(toGroup.triangles.begin(),
+		toGroup.triangles.end(), [this](uint32_t triangleIndex) {
+			return !triangles[triangleIndex].live;
+		}), toGroup.triangles.end());
+	toGroup.quadric.Add(fromGroup.quadric);
+	toGroup.version++;
+	fromGroup.live = false;
+	fromGroup.triangles.clear();
+	fromGroup.triangles.shrink_to_fit();
+
+	PushCollapsesForGroup(to);
+	return true;
+}
+
+bool MeshSimplifier::CollapseFoldsTriangles(uint32_t from, uint32_t to) const {
+	glm::dvec3 const& newPosition = groups[to].position;
+	for (uint32_t triangleIndex : groups[from].triangles) {
+		Triangle const& triangle = triangles[triangleIndex];
+		// those on the collapsing edge go away
+		if (!triangle.live || TriangleHasGroup(triangle, to)) {
+			continue;
+		}
+
+		glm::dvec3 oldPositions[3], newPositions[3];
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			oldPositions[corner] = GetCornerPosition(triangle, corner);
+			newPositions[corner] = vertexGroups[triangle.corners[corner]] ==
+				from ? newPosition : oldPositions[corner];
+		}
+		glm::dvec3 oldNormal = glm::cross(oldPositions[1] - oldPositions[0],
+			oldPositions[2] - oldPositions[0]);
+		glm::dvec3 newNormal = glm::cross(newPositions[1] - newPositions[0],
+			newPositions[2] - newPositions[0]);
+		double oldLength = glm::length(oldNormal);
+		double newLength = glm::length(newNormal);
+		if (oldLength == 0.0 || newLength == 0.0) {
+			return true;
+		}
+		if (glm::dot(oldNormal, newNormal) < minNormalDot * oldLength *
+			newLength) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void MeshSimplifier::GetNeighbours(uint32_t groupIndex,
+	std::vector<uint32_t>& neighbours) const {
+	neighbours.clear();
+	for (uint32_t triangleIndex : groups[groupIndex].triangles) {
+		Triangle const& triangle = triangles[triangleIndex];
+		if (!triangle.live) {
+			continue;
+		}
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			uint32_t cornerGroup = vertexGroups[triangle.corners[corner]];
+			if (cornerGroup != groupIndex) {
+				neighbours.push_back(cornerGroup);
+			}
+		}
+	}
+	std::sort(neighbours.begin(), neighbours.end());
+	neighbours.erase(std::unique(neighbours.begin(), neighbours.end()),
+		neighbours.end());
+}
+
+uint32_t MeshSimplifier::FindReplacementVertex(uint32_t vertex, uint32_t from,
+	uint32_t to) const {
+	// a vertex joined to the target by an edge is on the same side of any
+	// seam, so it has matching attributes
+	for (uint32_t triangleIndex : groups[from].triangles) {
+		Triangle const& triangle = triangles[triangleIndex];
+		if (!triangle.live) {
+			continue;
+		}
+		bool hasVertex = triangle.corners[0] == vertex ||
+			triangle.corners[1] == vertex || triangle.corners[2] == vertex;
+		if (!hasVertex) {
+			continue;
+		}
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			if (vertexGroups[triangle.corners[corner]] == to) {
+				return triangle.corners[corner];
+			}
+		}
+	}
+	return groups[to].vertices[0];
+}
+
+bool MeshSimplifier::TriangleHasGroup(Triangle const& triangle,
+	uint32_t groupIndex) const {
+	return vertexGroups[triangle.corners[0]] == groupIndex ||
+		vertexGroups[triangle.corners[1]] == groupIndex ||
+		vertexGroups[triangle.corners[2]] == groupIndex;
+}
+
+glm::dvec3 MeshSimplifier::GetCornerPosition(Triangle const& triangle,
+	uint32_t corner) const {
+	return groups[vertexGroups[triangle.corners[corner]]].position;
+}
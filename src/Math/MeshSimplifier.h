@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+// Reduces a triangle list with quadric error metric edge collapses
+// (Garland and Heckbert). Collapses are half edge collapses: a vertex always
+// moves onto one of its neighbours, so the result only refers to vertices
+// of the original mesh and their attributes stay valid. Vertices at the
+// same position are collapsed together, so that seams in texture
+// coordinates or normals don't tear open.
+class MeshSimplifier {
+public:
+	MeshSimplifier(std::vector<glm::vec3> const& positions,
+		std::vector<uint32_t> const& indices);
+
+	// keeps collapsing from where the last call left off, so a chain of
+	// coarser and coarser meshes can be pulled out of one simplifier.
+	// returns a triangle list into the original vertices. stops early if
+	// nothing more can be collapsed without folding triangles over
+	std::vector<uint32_t> Simplify(size_t targetNumTriangles);
+
+	size_t GetNumTriangles() const {
+		return numLiveTriangles;
+	}
+
+private:
+	// symmetric 4x4 matrix, upper triangle only
+	struct Quadric {
+		double values[10];
+
+		Quadric();
+		Quadric(glm::dvec4 const& plane, double weight);
+		void Add(Quadric const& other);
+		double Evaluate(glm::dvec3 const& point) const;
+	};
+
+	struct Triangle {
+		uint32_t corners[3];
+		bool live;
+	};
+
+	// vertices at the same position. only groups are collapsed
+	struct Group {
+		glm::dvec3 position;
+		Quadric quadric;
+		std::vector<uint32_t> vertices;
+		std::vector<uint32_t> triangles;
+		uint32_t version;
+		bool live;
+	};
+
+	// moves group "from" onto group "to". stale once either group changes
+	struct Collapse {
+		double cost;
+		uint32_t from;
+		uint32_t to;
+		uint32_t fromVersion;
+		uint32_t toVersion;
+
+		bool operator>(Collapse const& other) const {
+			return cost > other.cost;
+		}
+	};
+
+	std::vector<uint32_t> vertexGroups;
+	std::vector<Group> groups;
+	std::vector<Triangle> triangles;
+	std::priority_queue<Collapse, std::vector<Collapse>,
+		std::greater<Collapse>> collapses;
+	size_t numLiveTriangles;
+
+	void WeldVertices(std::vector<glm::vec3> const& positions);
+	void AddQuadrics();
+	void PushCollapsesForGroup(uint32_t groupIndex);
+	void PushCollapse(uint32_t group1, uint32_t group2);
+	bool TryCollapse(Collapse const& collapse);
+	bool CollapseFoldsTriangles(uint32_t from, uint32_t to) const;
+	void GetNeighbours(uint32_t groupIndex,
+		std::vector<uint32_t>& neighbours) const;
+	uint32_t FindReplacementVertex(uint32_t vertex, uint32_t from,
+		uint32_t to) const;
+	bool TriangleHasGroup(Triangle const& triangle, uint32_t groupIndex) const;
+	glm::dvec3 GetCornerPosition(Triangle const& triangle,
+		uint32_t corner) const;
+};
@@ -0,0 +1,52 @@
+#include "NoiseGenerator.h"
+#include "PerlinNoise.h"
+#include "SimplexNoise.h"
+#include "NoiseSimd.h"
+
+static NoiseGenerator::SimdLevel DetectSimdLevel() {
+#if defined(NOISE_USE_X86_SIMD)
+	#if defined(_MSC_VER)
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+	int maxLeaf = cpuInfo[0];
+	__cpuid(cpuInfo, 1);
+	bool hasSse41 = (cpuInfo[2] & (1 << 19)) != 0;
+	// the os has to save ymm registers too
+	bool hasAvx = (cpuInfo[2] & (1 << 27)) != 0 &&
+		(cpuInfo[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+	bool hasAvx2 = false;
+	if (hasAvx && maxLeaf >= 7) {
+		__cpuidex(cpuInfo, 7, 0);
+		hasAvx2 = (cpuInfo[1] & (1 << 5)) != 0;
+	}
+	#else
+	__builtin_cpu_init();
+	bool hasSse41 = __builtin_cpu_supports("sse4.1");
+	bool hasAvx2 = __builtin_cpu_supports("avx2");
+	#endif
+	if (hasAvx2) {
+		return NoiseGenerator::SimdLevel::Avx2;
+	}
+	if (hasSse41) {
+		return NoiseGenerator::SimdLevel::Sse41;
+	}
+#endif
+	return NoiseGenerator::SimdLevel::None;
+}
+
+NoiseGenerator* NoiseGenerator::Create(NoiseGeneratorType noiseGeneratorType,
+	unsigned int seed) {
+	switch (noiseGeneratorType) {
+		case NoiseGeneratorType::Perlin:
+			return new PerlinNoise(seed);
+		case NoiseGeneratorType::Simplex:
+			return new SimplexNoise(seed);
+		default:
+			return nullptr;
+	}
+}
+
+NoiseGenerator::SimdLevel NoiseGenerator::GetSimdLevel() {
+	static const SimdLevel simdLevel = DetectSimdLevel();
+	return simdLevel;
+}
@@ -1,17 +1,51 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <cstddef>
 
-enum class NoiseGeneratorType : char { None = 0, Perlin };
+enum class NoiseGeneratorType : char { None = 0, Perlin, Simplex };
+
+// Points and results for evaluating many points in one call, as separate
+// arrays per component, so they can be loaded straight into SIMD registers.
+struct NoiseBatch {
+	float const* x;
+	float const* y;
+	float const* z;
+	float* values;
+	float* derivX;
+	float* derivY;
+	float* derivZ;
+	size_t count;
+};
 
 class NoiseGenerator {
 public:
+	enum class SimdLevel : char { None = 0, Sse41, Avx2 };
 	
 	virtual ~NoiseGenerator() {
 		
 	}
+
+	// null for NoiseGeneratorType::None
+	static NoiseGenerator* Create(NoiseGeneratorType noiseGeneratorType,
+		unsigned int seed = 2016);
 	
 	virtual float Eval(const glm::vec3& p, glm::vec3& derivs) const = 0;
 
+	// same results as calling Eval on each point
+	virtual void EvalBatch(NoiseBatch const& batch) const {
+		for (size_t i = 0; i < batch.count; i++) {
+			glm::vec3 derivs;
+			batch.values[i] = Eval(glm::vec3(batch.x[i], batch.y[i],
+				batch.z[i]), derivs);
+			batch.derivX[i] = derivs.x;
+			batch.derivY[i] = derivs.y;
+			batch.derivZ[i] = derivs.z;
+		}
+	}
+
+	// best instruction set the CPU has for batch kernels, decided once
+	static SimdLevel GetSimdLevel();
+
 private:
 };
@@ -0,0 +1,20 @@
+#pragma once
+
+// What the noise generators' SIMD kernels need: x86 intrinsics, and a way
+// to compile single functions for instruction sets the rest of the build
+// doesn't assume. Which kernel runs is decided at run time with
+// NoiseGenerator::GetSimdLevel.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+	defined(_M_IX86)
+	#define NOISE_USE_X86_SIMD
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+		// msvc lets any function use any instruction set
+		#define NOISE_TARGET_SSE41
+		#define NOISE_TARGET_AVX2
+	#else
+		#define NOISE_TARGET_SSE41 __attribute__((target("sse4.1")))
+		#define NOISE_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
@@ -0,0 +1,279 @@
+#include "OcclusionBuffer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define OCCLUSION_USE_SSE
+	#include <xmmintrin.h>
+#endif
+
+// clip space w that counts as being on the near plane. anything closer
+// would blow up when divided by
+static const float nearW = 1e-4f;
+// triangles smaller than this in pixels squared can't cover a pixel center
+static const float minTriangleArea = 1e-6f;
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height) :
+	width(width), height(height), numRasterizedTriangles(0) {
+	if (width == 0 || height == 0 || width % 4 != 0) {
+		throw std::runtime_error("Failed to create occlusion buffer: width has "
+			"to be a non-zero multiple of 4!");
+	}
+
+	uint32_t levelWidth = width;
+	uint32_t levelHeight = height;
+	while (true) {
+		levels.push_back(std::vector<float>(levelWidth * levelHeight, FLT_MAX));
+		levelWidths.push_back(levelWidth);
+		levelHeights.push_back(levelHeight);
+		if (levelWidth == 1 && levelHeight == 1) {
+			break;
+		}
+		levelWidth = std::max(1u, (levelWidth + 1) / 2);
+		levelHeight = std::max(1u, (levelHeight + 1) / 2);
+	}
+}
+
+void OcclusionBuffer::Clear() {
+	std::fill(levels[0].begin(), levels[0].end(), FLT_MAX);
+	numRasterizedTriangles = 0;
+}
+
+void OcclusionBuffer::RasterizeTriangles(glm::vec4 const* clipPositions,
+	uint32_t const* indices, size_t numIndices) {
+	for (size_t i = 0; i + 2 < numIndices; i += 3) {
+		glm::vec4 const& v0 = clipPositions[indices[i]];
+		glm::vec4 const& v1 = clipPositions[indices[i + 1]];
+		glm::vec4 const& v2 = clipPositions[indices[i + 2]];
+
+		// entirely off to one side of the view
+		if ((v0.x > v0.w && v1.x > v1.w && v2.x > v2.w) ||
+			(v0.x < -v0.w && v1.x < -v1.w && v2.x < -v2.w) ||
+			(v0.y > v0.w && v1.y > v1.w && v2.y > v2.w) ||
+			(v0.y < -v0.w && v1.y < -v1.w && v2.y < -v2.w)) {
+			continue;
+		}
+
+		int numInFront = (v0.w > nearW ? 1 : 0) + (v1.w > nearW ? 1 : 0) +
+			(v2.w > nearW ? 1 : 0);
+		if (numInFront == 3) {
+			RasterizeTriangle(ToScreen(v0), ToScreen(v1), ToScreen(v2));
+		}
+		else if (numInFront > 0) {
+			RasterizeClippedTriangle(v0, v1, v2);
+		}
+	}
+}
+
+void OcclusionBuffer::RasterizeClippedTriangle(glm::vec4 const& v0,
+	glm::vec4 const& v1, glm::vec4 const& v2) {
+	// one plane cuts a triangle into at most a quad
+	glm::vec4 const* vertices[3] = { &v0, &v1, &v2 };
+	glm::vec4 polygon[4];
+	size_t numPolygonVertices = 0;
+	for (size_t i = 0; i < 3; i++) {
+		glm::vec4 const& current = *vertices[i];
+		glm::vec4 const& next = *vertices[(i + 1) % 3];
+		bool currentInFront = current.w > nearW;
+		bool nextInFront = next.w > nearW;
+		if (currentInFront) {
+			polygon[numPolygonVertices++] = current;
+		}
+		if (currentInFront != nextInFront) {
+			float t = (nearW - current.w) / (next.w - current.w);
+			polygon[numPolygonVertices++] = current + (next - current) * t;
+		}
+	}
+
+	glm::vec3 screenPositions[4];
+	for (size_t i = 0; i < numPolygonVertices; i++) {
+		screenPositions[i] = ToScreen(polygon[i]);
+	}
+	for (size_t i = 2; i < numPolygonVertices; i++) {
+		RasterizeTriangle(screenPositions[0], screenPositions[i - 1],
+			screenPositions[i]);
+	}
+}
+
+glm::vec3 OcclusionBuffer::ToScreen(glm::vec4 const& clipPosition) const {
+	float inverseW = 1.0f / clipPosition.w;
+	return glm::vec3(
+		(clipPosition.x * inverseW * 0.5f + 0.5f) * (float)width,
+		(clipPosition.y * inverseW * 0.5f + 0.5f) * (float)height,
+		clipPosition.z * inverseW);
+}
+
+void OcclusionBuffer::RasterizeTriangle(glm::vec3 const& v0,
+	glm::vec3 const& v1, glm::vec3 const& v2) {
+	float minX = std::min(v0.x, std::min(v1.x, v2.x));
+	float maxX = std::max(v0.x, std::max(v1.x, v2.x));
+	float minY = std::min(v0.y, std::min(v1.y, v2.y));
+	float maxY = std::max(v0.y, std::max(v1.y, v2.y));
+	// pixel centers are at +0.5
+	int x0 = std::max(0, (int)std::floor(minX));
+	int x1 = std::min((int)width - 1, (int)std::floor(maxX));
+	int y0 = std::max(0, (int)std::floor(minY));
+	int y1 = std::min((int)height - 1, (int)std::floor(maxY));
+	if (x0 > x1 || y0 > y1) {
+		return;
+	}
+
+	// edge i is opposite vertex i, as a*x + b*y + c. at a point inside,
+	// each one is that vertex's barycentric weight times the area
+	float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v2.x * v1.y;
+	float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v0.x * v2.y;
+	float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v1.x * v0.y;
+	float area = c0 + c1 + c2;
+	if (std::fabs(area) < minTriangleArea) {
+		return;
+	}
+	// both windings are drawn
+	if (area < 0.0f) {
+		a0 = -a0; b0 = -b0; c0 = -c0;
+		a1 = -a1; b1 = -b1; c1 = -c1;
+		a2 = -a2; b2 = -b2; c2 = -c2;
+		area = -area;
+	}
+	float inverseArea = 1.0f / area;
+	float z0 = v0.z * inverseArea;
+	float z1 = v1.z * inverseArea;
+	float z2 = v2.z * inverseArea;
+	numRasterizedTriangles++;
+
+	std::vector<float>& depths = levels[0];
+#ifdef OCCLUSION_USE_SSE
+	// rows are a multiple of 4 wide, so starting at a multiple of 4 keeps
+	// every group in the row. lanes outside the box are outside the
+	// triangle too
+	__m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	__m128 zero = _mm_setzero_ps();
+	__m128 edgeA0 = _mm_set1_ps(a0), edgeA1 = _mm_set1_ps(a1),
+		edgeA2 = _mm_set1_ps(a2);
+	__m128 depth0 = _mm_set1_ps(z0), depth1 = _mm_set1_ps(z1),
+		depth2 = _mm_set1_ps(z2);
+	int xStart = x0 & ~3;
+	for (int y = y0; y <= y1; y++) {
+		float pixelY = (float)y + 0.5f;
+		__m128 rowEdge0 = _mm_set1_ps(b0 * pixelY + c0);
+		__m128 rowEdge1 = _mm_set1_ps(b1 * pixelY + c1);
+		__m128 rowEdge2 = _mm_set1_ps(b2 * pixelY + c2);
+		float* row = depths.data() + (size_t)y * width;
+		for (int x = xStart; x <= x1; x += 4) {
+			__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+			__m128 edge0 = _mm_add_ps(_mm_mul_ps(edgeA0, pixelX), rowEdge0);
+			__m128 edge1 = _mm_add_ps(_mm_mul_ps(edgeA1, pixelX), rowEdge1);
+			__m128 edge2 = _mm_add_ps(_mm_mul_ps(edgeA2, pixelX), rowEdge2);
+			__m128 inside = _mm_and_ps(_mm_cmpge_ps(edge0, zero),
+				_mm_and_ps(_mm_cmpge_ps(edge1, zero), _mm_cmpge_ps(edge2, zero)));
+			if (_mm_movemask_ps(inside) == 0) {
+				continue;
+			}
+
+			__m128 depth = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(edge0, depth0), _mm_mul_ps(edge1, depth1)),
+				_mm_mul_ps(edge2, depth2));
+			__m128 oldDepth = _mm_loadu_ps(row + x);
+			__m128 newDepth = _mm_min_ps(oldDepth, depth);
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, newDepth),
+				_mm_andnot_ps(inside, oldDepth)));
+		}
+	}
+#else
+	for (int y = y0; y <= y1; y++) {
+		float pixelY = (float)y + 0.5f;
+		float* row = depths.data() + (size_t)y * width;
+		for (int x = x0; x <= x1; x++) {
+			float pixelX = (float)x + 0.5f;
+			float edge0 = a0 * pixelX + b0 * pixelY + c0;
+			float edge1 = a1 * pixelX + b1 * pixelY + c1;
+			float edge2 = a2 * pixelX + b2 * pixelY + c2;
+			if (edge0 < 0.0f || edge1 < 0.0f || edge2 < 0.0f) {
+				continue;
+			}
+			float depth = edge0 * z0 + edge1 * z1 + edge2 * z2;
+			row[x] = std::min(row[x], depth);
+		}
+	}
+#endif
+}
+
+void OcclusionBuffer::BuildHierarchy() {
+	for (size_t level = 1; level < levels.size(); level++) {
+		std::vector<float> const& below = levels[level - 1];
+		std::vector<float>& current = levels[level];
+		uint32_t belowWidth = levelWidths[level - 1];
+		uint32_t belowHeight = levelHeights[level - 1];
+		uint32_t levelWidth = levelWidths[level];
+		uint32_t levelHeight = levelHeights[level];
+		for (uint32_t y = 0; y < levelHeight; y++) {
+			// odd sizes make the last texel cover one row or column less
+			uint32_t belowY0 = y * 2;
+			uint32_t belowY1 = std::min(belowY0 + 1, belowHeight - 1);
+			for (uint32_t x = 0; x < levelWidth; x++) {
+				uint32_t belowX0 = x * 2;
+				uint32_t belowX1 = std::min(belowX0 + 1, belowWidth - 1);
+				current[y * levelWidth + x] = std::max(
+					std::max(below[belowY0 * belowWidth + belowX0],
+						below[belowY0 * belowWidth + belowX1]),
+					std::max(below[belowY1 * belowWidth + belowX0],
+						below[belowY1 * belowWidth + belowX1]));
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::IsBoxVisible(glm::vec3 const& center,
+	glm::vec3 const& extents, glm::mat4 const& viewProjection) const {
+	float minX = FLT_MAX, maxX = -FLT_MAX;
+	float minY = FLT_MAX, maxY = -FLT_MAX;
+	float nearestDepth = FLT_MAX;
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec3 offset((corner & 1) ? extents.x : -extents.x,
+			(corner & 2) ? extents.y : -extents.y,
+			(corner & 4) ? extents.z : -extents.z);
+		glm::vec4 clipPosition = viewProjection *
+			glm::vec4(center + offset, 1.0f);
+		if (clipPosition.w <= nearW) {
+			return true;
+		}
+		glm::vec3 screenPosition = ToScreen(clipPosition);
+		minX = std::min(minX, screenPosition.x);
+		maxX = std::max(maxX, screenPosition.x);
+		minY = std::min(minY, screenPosition.y);
+		maxY = std::max(maxY, screenPosition.y);
+		nearestDepth = std::min(nearestDepth, screenPosition.z);
+	}
+
+	// frustum culling is someone else's job
+	int x0 = std::max(0, (int)std::floor(minX));
+	int x1 = std::min((int)width - 1, (int)std::floor(maxX));
+	int y0 = std::max(0, (int)std::floor(minY));
+	int y1 = std::min((int)height - 1, (int)std::floor(maxY));
+	if (x0 > x1 || y0 > y1) {
+		return true;
+	}
+
+	// go up until the box covers a few texels at most
+	size_t level = 0;
+	while ((x1 - x0 > 3 || y1 - y0 > 3) && level + 1 < levels.size()) {
+		x0 >>= 1;
+		x1 >>= 1;
+		y0 >>= 1;
+		y1 >>= 1;
+		level++;
+	}
+
+	std::vector<float> const& depths = levels[level];
+	uint32_t levelWidth = levelWidths[level];
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			if (depths[y * levelWidth + x] >= nearestDepth) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Low resolution depth buffer that occluder triangles are rasterized into
+// on the CPU, with a hierarchy of max depths on top so that boxes can be
+// tested against it with a handful of reads. Depth is clip z / w, and
+// only has to increase with distance; anything nothing was drawn to is
+// infinitely far away. Doesn't need a GPU, so it can be tested on its own.
+class OcclusionBuffer {
+public:
+	// width has to be a multiple of 4, so rows can be filled four pixels
+	// at a time
+	OcclusionBuffer(uint32_t width, uint32_t height);
+
+	void Clear();
+	// triangle list in clip space. triangles are drawn from both sides and
+	// clipped against the near plane
+	void RasterizeTriangles(glm::vec4 const* clipPositions,
+		uint32_t const* indices, size_t numIndices);
+	// has to be called after rasterizing and before testing
+	void BuildHierarchy();
+
+	// false only if the box is entirely behind what has been rasterized.
+	// boxes that cross the near plane or leave the screen count as visible
+	bool IsBoxVisible(glm::vec3 const& center, glm::vec3 const& extents,
+		glm::mat4 const& viewProjection) const;
+
+	uint32_t GetWidth() const {
+		return width;
+	}
+
+	uint32_t GetHeight() const {
+		return height;
+	}
+
+	// depth at a pixel of the full resolution level
+	float GetDepth(uint32_t x, uint32_t y) const {
+		return levels[0][y * width + x];
+	}
+
+	// since the last Clear
+	size_t GetNumRasterizedTriangles() const {
+		return numRasterizedTriangles;
+	}
+
+private:
+	uint32_t width;
+	uint32_t height;
+	// level 0 is what triangles are drawn into. each level above holds the
+	// farthest depth of 2x2 texels of the one below
+	std::vector<std::vector<float>> levels;
+	std::vector<uint32_t> levelWidths;
+	std::vector<uint32_t> levelHeights;
+	size_t numRasterizedTriangles;
+
+	// screen space x and y, depth in z
+	void RasterizeTriangle(glm::vec3 const& v0, glm::vec3 const& v1,
+		glm::vec3 const& v2);
+	void RasterizeClippedTriangle(glm::vec4 const& v0, glm::vec4 const& v1,
+		glm::vec4 const& v2);
+	glm::vec3 ToScreen(glm::vec4 const& clipPosition) const;
+};
@@ -1,35 +1,47 @@
 #include "PerlinNoise.h"
+#include "NoiseSimd.h"
 #include <random>
 #include <algorithm>
 #include <numeric>
 #include <cmath>
 #include <functional>
 
+// the twelve edge directions of a cube, with four of them repeated to
+// fill up sixteen entries
+const float PerlinNoise::gradientX[16] = { 1, -1, 1, -1, 1, -1, 1, -1,
+	0, 0, 0, 0, 1, -1, 0, 0 };
+const float PerlinNoise::gradientY[16] = { 1, 1, -1, -1, 0, 0, 0, 0,
+	1, -1, 1, -1, 1, 1, -1, -1 };
+const float PerlinNoise::gradientZ[16] = { 0, 0, 0, 0, 1, 1, -1, -1,
+	1, 1, -1, -1, 0, 0, 1, -1 };
+
 PerlinNoise::PerlinNoise(const unsigned int seed) {
 	std::mt19937 generator(seed);
-	std::uniform_real_distribution<float> distribution;
-	auto dice = std::bind(distribution, generator);
 	for (unsigned i = 0; i < tableSize; ++i) {
-#if 0 
-		// bad
-		float gradientLen2;
-		do {
-			gradients[i] = Vec3f(2 * dice() - 1, 2 * dice() - 1, 2 * dice() - 1);
-			gradientLen2 = gradients[i].length2();
-		} while (gradientLen2 > 1);
-		gradients[i].normalize();
-#else 
-		// better
-		float theta = acos(2 * dice() - 1);
-		float phi = (float)(2.0 * dice() * 3.1415);
-
-		float x = cos(phi) * sin(theta);
-		float y = sin(phi) * sin(theta);
-		float z = cos(theta);
-		gradients[i] = glm::vec3(x, y, z);
-#endif 
 		permutationTable[i] = i;
 	}
+	std::shuffle(permutationTable, permutationTable + tableSize, generator);
+	// repeated, so that hashing can add a coordinate to an entry without
+	// wrapping around
+	for (unsigned i = 0; i < tableSize; ++i) {
+		permutationTable[tableSize + i] = permutationTable[i];
+	}
+}
+
+// trilinear blend of values at the corners of a cell, in the order
+// (0, 0, 0), (1, 0, 0), (0, 1, 0), (1, 1, 0), (0, 0, 1) and so on
+static float BlendCorners(float const* corners, float u, float v, float w) {
+	float k0 = corners[0];
+	float k1 = (corners[1] - corners[0]);
+	float k2 = (corners[2] - corners[0]);
+	float k3 = (corners[4] - corners[0]);
+	float k4 = (corners[0] + corners[3] - corners[1] - corners[2]);
+	float k5 = (corners[0] + corners[5] - corners[1] - corners[4]);
+	float k6 = (corners[0] + corners[6] - corners[2] - corners[4]);
+	float k7 = (corners[1] + corners[2] + corners[4] + corners[7] -
+		corners[0] - corners[3] - corners[5] - corners[6]);
+	return k0 + k1 * u + k2 * v + k3 * w + k4 * u * v + k5 * u * w +
+		k6 * v * w + k7 * u * v * w;
 }
 
 float PerlinNoise::Eval(const glm::vec3 & p, glm::vec3 & derivs) const {
@@ -54,14 +66,17 @@ float PerlinNoise::Eval(const glm::vec3 & p, glm::vec3 & derivs) const {
 	float y0 = ty, y1 = ty - 1;
 	float z0 = tz, z1 = tz - 1;
 
-	float a = GradientDotV(Hash(xi0, yi0, zi0), x0, y0, z0);
-	float b = GradientDotV(Hash(xi1, yi0, zi0), x1, y0, z0);
-	float c = GradientDotV(Hash(xi0, yi1, zi0), x0, y1, z0);
-	float d = GradientDotV(Hash(xi1, yi1, zi0), x1, y1, z0);
-	float e = GradientDotV(Hash(xi0, yi0, zi1), x0, y0, z1);
-	float f = GradientDotV(Hash(xi1, yi0, zi1), x1, y0, z1);
-	float g = GradientDotV(Hash(xi0, yi1, zi1), x0, y1, z1);
-	float h = GradientDotV(Hash(xi1, yi1, zi1), x1, y1, z1);
+	uint8_t hashes[8] = { Hash(xi0, yi0, zi0), Hash(xi1, yi0, zi0),
+		Hash(xi0, yi1, zi0), Hash(xi1, yi1, zi0), Hash(xi0, yi0, zi1),
+		Hash(xi1, yi0, zi1), Hash(xi0, yi1, zi1), Hash(xi1, yi1, zi1) };
+	float a = GradientDotV(hashes[0], x0, y0, z0);
+	float b = GradientDotV(hashes[1], x1, y0, z0);
+	float c = GradientDotV(hashes[2], x0, y1, z0);
+	float d = GradientDotV(hashes[3], x1, y1, z0);
+	float e = GradientDotV(hashes[4], x0, y0, z1);
+	float f = GradientDotV(hashes[5], x1, y0, z1);
+	float g = GradientDotV(hashes[6], x0, y1, z1);
+	float h = GradientDotV(hashes[7], x1, y1, z1);
 
 	float du = QuinticDeriv(tx);
 	float dv = QuinticDeriv(ty);
@@ -76,9 +91,21 @@ float PerlinNoise::Eval(const glm::vec3 & p, glm::vec3 & derivs) const {
 	float k6 = (a + g - c - e);
 	float k7 = (b + c + e + h - a - d - f - g);
 
-	derivs.x = du * (k1 + k4 * v + k5 * w + k7 * v * w);
-	derivs.y = dv * (k2 + k4 * u + k6 * w + k7 * v * w);
-	derivs.z = dw * (k3 + k5 * u + k6 * v + k7 * v * w);
+	// the dot products change with p as well as the weights do, and their
+	// rate of change is the blend of the corners' gradients
+	float cornerGradients[3][8];
+	for (int corner = 0; corner < 8; corner++) {
+		unsigned gradientIndex = hashes[corner] & 15;
+		cornerGradients[0][corner] = gradientX[gradientIndex];
+		cornerGradients[1][corner] = gradientY[gradientIndex];
+		cornerGradients[2][corner] = gradientZ[gradientIndex];
+	}
+	derivs.x = BlendCorners(cornerGradients[0], u, v, w) +
+		du * (k1 + k4 * v + k5 * w + k7 * v * w);
+	derivs.y = BlendCorners(cornerGradients[1], u, v, w) +
+		dv * (k2 + k4 * u + k6 * w + k7 * u * w);
+	derivs.z = BlendCorners(cornerGradients[2], u, v, w) +
+		dw * (k3 + k5 * u + k6 * v + k7 * u * v);
 
 	return k0 + k1 * u + k2 * v + k3 * w + k4 * u * v + k5 * u * w +
 		k6 * v * w + k7 * u * v * w;
@@ -86,40 +113,15 @@ float PerlinNoise::Eval(const glm::vec3 & p, glm::vec3 & derivs) const {
 
 uint8_t PerlinNoise::Hash(const int x, const int y,
 	const int z) const {
-	auto indexOne = permutationTable[x] + y;
-	// this is stupid; real perlin code would not have this bug
-	if (indexOne > 255) {
-		indexOne = 255;
-	}
-	auto indexTwo = permutationTable[indexOne] + z;
-	if (indexTwo > 255) {
-		indexTwo = 255;
-	}
-	return permutationTable[indexTwo];
+	return (uint8_t)permutationTable[permutationTable[permutationTable[x] +
+		y] + z];
 }
 
 float PerlinNoise::GradientDotV(uint8_t perm, // a value between 0 and 255 
 	float x, float y, float z) const {
-	switch (perm & 15) {
-		case  0: return  x + y; // (1,1,0) 
-		case  1: return -x + y; // (-1,1,0) 
-		case  2: return  x - y; // (1,-1,0) 
-		case  3: return -x - y; // (-1,-1,0) 
-		case  4: return  x + z; // (1,0,1) 
-		case  5: return -x + z; // (-1,0,1) 
-		case  6: return  x - z; // (1,0,-1) 
-		case  7: return -x - z; // (-1,0,-1) 
-		case  8: return  y + z; // (0,1,1), 
-		case  9: return -y + z; // (0,-1,1), 
-		case 10: return  y - z; // (0,1,-1), 
-		case 11: return -y - z; // (0,-1,-1) 
-		case 12: return  y + x; // (1,1,0) 
-		case 13: return -x + y; // (-1,1,0) 
-		case 14: return -y + z; // (0,-1,1)
-		case 15:
-		default:
-			return -y - z; // (0,-1,-1) 
-	}
+	unsigned gradientIndex = perm & 15;
+	return gradientX[gradientIndex] * x + gradientY[gradientIndex] * y +
+		gradientZ[gradientIndex] * z;
 }
 
 float PerlinNoise::Quintic(const float t) const {
@@ -129,3 +131,329 @@ float PerlinNoise::Quintic(const float t) const {
 float PerlinNoise::QuinticDeriv(const float t) const {
 	return 30 * t * t * (t * (t - 2) + 1);
 }
+
+void PerlinNoise::EvalBatch(NoiseBatch const& batch) const {
+	EvalBatch(batch, GetSimdLevel());
+}
+
+void PerlinNoise::EvalBatch(NoiseBatch const& batch,
+	SimdLevel maxSimdLevel) const {
+	SimdLevel simdLevel = std::min(maxSimdLevel, GetSimdLevel());
+	size_t numEvaluated = 0;
+	switch (simdLevel) {
+		case SimdLevel::Avx2:
+			numEvaluated = EvalBatchAvx2(batch);
+			break;
+		case SimdLevel::Sse41:
+			numEvaluated = EvalBatchSse41(batch);
+			break;
+		default:
+			break;
+	}
+
+	for (size_t i = numEvaluated; i < batch.count; i++) {
+		glm::vec3 derivs;
+		batch.values[i] = Eval(glm::vec3(batch.x[i], batch.y[i], batch.z[i]),
+			derivs);
+		batch.derivX[i] = derivs.x;
+		batch.derivY[i] = derivs.y;
+		batch.derivZ[i] = derivs.z;
+	}
+}
+
+#if defined(NOISE_USE_X86_SIMD)
+
+// the kernels below follow Eval step by step, without fused multiply-adds,
+// so they give the same results bit for bit
+
+NOISE_TARGET_SSE41 static inline __m128 BlendCornersSse41(
+	__m128 const* corners, __m128 u, __m128 v, __m128 w) {
+	__m128 k0 = corners[0];
+	__m128 k1 = _mm_sub_ps(corners[1], corners[0]);
+	__m128 k2 = _mm_sub_ps(corners[2], corners[0]);
+	__m128 k3 = _mm_sub_ps(corners[4], corners[0]);
+	__m128 k4 = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(corners[0], corners[3]),
+		corners[1]), corners[2]);
+	__m128 k5 = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(corners[0], corners[5]),
+		corners[1]), corners[4]);
+	__m128 k6 = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(corners[0], corners[6]),
+		corners[2]), corners[4]);
+	__m128 k7 = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_add_ps(
+		_mm_add_ps(_mm_add_ps(corners[1], corners[2]), corners[4]),
+		corners[7]), corners[0]), corners[3]), corners[5]), corners[6]);
+	__m128 blend = _mm_add_ps(k0, _mm_mul_ps(k1, u));
+	blend = _mm_add_ps(blend, _mm_mul_ps(k2, v));
+	blend = _mm_add_ps(blend, _mm_mul_ps(k3, w));
+	blend = _mm_add_ps(blend, _mm_mul_ps(_mm_mul_ps(k4, u), v));
+	blend = _mm_add_ps(blend, _mm_mul_ps(_mm_mul_ps(k5, u), w));
+	blend = _mm_add_ps(blend, _mm_mul_ps(_mm_mul_ps(k6, v), w));
+	return _mm_add_ps(blend, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(k7, u), v), w));
+}
+
+NOISE_TARGET_AVX2 static inline __m256 BlendCornersAvx2(
+	__m256 const* corners, __m256 u, __m256 v, __m256 w) {
+	__m256 k0 = corners[0];
+	__m256 k1 = _mm256_sub_ps(corners[1], corners[0]);
+	__m256 k2 = _mm256_sub_ps(corners[2], corners[0]);
+	__m256 k3 = _mm256_sub_ps(corners[4], corners[0]);
+	__m256 k4 = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(corners[0],
+		corners[3]), corners[1]), corners[2]);
+	__m256 k5 = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(corners[0],
+		corners[5]), corners[1]), corners[4]);
+	__m256 k6 = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(corners[0],
+		corners[6]), corners[2]), corners[4]);
+	__m256 k7 = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(
+		_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(corners[1], corners[2]),
+		corners[4]), corners[7]), corners[0]), corners[3]), corners[5]),
+		corners[6]);
+	__m256 blend = _mm256_add_ps(k0, _mm256_mul_ps(k1, u));
+	blend = _mm256_add_ps(blend, _mm256_mul_ps(k2, v));
+	blend = _mm256_add_ps(blend, _mm256_mul_ps(k3, w));
+	blend = _mm256_add_ps(blend, _mm256_mul_ps(_mm256_mul_ps(k4, u), v));
+	blend = _mm256_add_ps(blend, _mm256_mul_ps(_mm256_mul_ps(k5, u), w));
+	blend = _mm256_add_ps(blend, _mm256_mul_ps(_mm256_mul_ps(k6, v), w));
+	return _mm256_add_ps(blend, _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(
+		k7, u), v), w));
+}
+
+NOISE_TARGET_SSE41 size_t PerlinNoise::EvalBatchSse41(
+	NoiseBatch const& batch) const {
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 six = _mm_set1_ps(6.0f);
+	const __m128 ten = _mm_set1_ps(10.0f);
+	const __m128 fifteen = _mm_set1_ps(15.0f);
+	const __m128 thirty = _mm_set1_ps(30.0f);
+	const __m128i mask = _mm_set1_epi32((int)tableSizeMask);
+
+	size_t numGroups = batch.count / 4;
+	for (size_t group = 0; group < numGroups; group++) {
+		size_t first = group * 4;
+		__m128 p[3] = { _mm_loadu_ps(batch.x + first),
+			_mm_loadu_ps(batch.y + first), _mm_loadu_ps(batch.z + first) };
+		__m128i lattice0[3], lattice1[3];
+		__m128 t[3], s[3], ds[3];
+		for (int axis = 0; axis < 3; axis++) {
+			__m128 floored = _mm_floor_ps(p[axis]);
+			lattice0[axis] = _mm_and_si128(_mm_cvttps_epi32(floored), mask);
+			lattice1[axis] = _mm_and_si128(_mm_add_epi32(lattice0[axis],
+				_mm_set1_epi32(1)), mask);
+			t[axis] = _mm_sub_ps(p[axis], floored);
+			__m128 tt = t[axis];
+			// t * t * t * (t * (t * 6 - 15) + 10)
+			s[axis] = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(tt, tt), tt),
+				_mm_add_ps(_mm_mul_ps(tt, _mm_sub_ps(_mm_mul_ps(tt, six),
+				fifteen)), ten));
+			// 30 * t * t * (t * (t - 2) + 1)
+			ds[axis] = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(thirty, tt), tt),
+				_mm_add_ps(_mm_mul_ps(tt, _mm_sub_ps(tt, two)), one));
+		}
+
+		// corners are hashed a lane at a time, which beats gathers anyway
+		alignas(16) int xi[2][4], yi[2][4], zi[2][4];
+		_mm_store_si128((__m128i*)xi[0], lattice0[0]);
+		_mm_store_si128((__m128i*)xi[1], lattice1[0]);
+		_mm_store_si128((__m128i*)yi[0], lattice0[1]);
+		_mm_store_si128((__m128i*)yi[1], lattice1[1]);
+		_mm_store_si128((__m128i*)zi[0], lattice0[2]);
+		_mm_store_si128((__m128i*)zi[1], lattice1[2]);
+
+		__m128 cornerDots[8];
+		__m128 cornerGradients[3][8];
+		for (int corner = 0; corner < 8; corner++) {
+			int cx = corner & 1, cy = (corner >> 1) & 1, cz = corner >> 2;
+			alignas(16) float gx[4], gy[4], gz[4];
+			for (int lane = 0; lane < 4; lane++) {
+				uint8_t hash = Hash(xi[cx][lane], yi[cy][lane], zi[cz][lane]);
+				gx[lane] = gradientX[hash & 15];
+				gy[lane] = gradientY[hash & 15];
+				gz[lane] = gradientZ[hash & 15];
+			}
+			cornerGradients[0][corner] = _mm_load_ps(gx);
+			cornerGradients[1][corner] = _mm_load_ps(gy);
+			cornerGradients[2][corner] = _mm_load_ps(gz);
+			__m128 vx = cx ? _mm_sub_ps(t[0], one) : t[0];
+			__m128 vy = cy ? _mm_sub_ps(t[1], one) : t[1];
+			__m128 vz = cz ? _mm_sub_ps(t[2], one) : t[2];
+			cornerDots[corner] = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(cornerGradients[0][corner], vx),
+				_mm_mul_ps(cornerGradients[1][corner], vy)),
+				_mm_mul_ps(cornerGradients[2][corner], vz));
+		}
+
+		__m128 a = cornerDots[0], b = cornerDots[1], c = cornerDots[2],
+			d = cornerDots[3], e = cornerDots[4], f = cornerDots[5],
+			g = cornerDots[6], h = cornerDots[7];
+		__m128 u = s[0], v = s[1], w = s[2];
+		__m128 k0 = a;
+		__m128 k1 = _mm_sub_ps(b, a);
+		__m128 k2 = _mm_sub_ps(c, a);
+		__m128 k3 = _mm_sub_ps(e, a);
+		__m128 k4 = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(a, d), b), c);
+		__m128 k5 = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(a, f), b), e);
+		__m128 k6 = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(a, g), c), e);
+		__m128 k7 = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_add_ps(
+			_mm_add_ps(_mm_add_ps(b, c), e), h), a), d), f), g);
+		__m128 k7u = _mm_mul_ps(k7, u);
+
+		_mm_storeu_ps(batch.derivX + first, _mm_add_ps(
+			BlendCornersSse41(cornerGradients[0], u, v, w),
+			_mm_mul_ps(ds[0], _mm_add_ps(_mm_add_ps(_mm_add_ps(k1,
+			_mm_mul_ps(k4, v)), _mm_mul_ps(k5, w)),
+			_mm_mul_ps(_mm_mul_ps(k7, v), w)))));
+		_mm_storeu_ps(batch.derivY + first, _mm_add_ps(
+			BlendCornersSse41(cornerGradients[1], u, v, w),
+			_mm_mul_ps(ds[1], _mm_add_ps(_mm_add_ps(_mm_add_ps(k2,
+			_mm_mul_ps(k4, u)), _mm_mul_ps(k6, w)), _mm_mul_ps(k7u, w)))));
+		_mm_storeu_ps(batch.derivZ + first, _mm_add_ps(
+			BlendCornersSse41(cornerGradients[2], u, v, w),
+			_mm_mul_ps(ds[2], _mm_add_ps(_mm_add_ps(_mm_add_ps(k3,
+			_mm_mul_ps(k5, u)), _mm_mul_ps(k6, v)), _mm_mul_ps(k7u, v)))));
+		__m128 value = _mm_add_ps(k0, _mm_mul_ps(k1, u));
+		value = _mm_add_ps(value, _mm_mul_ps(k2, v));
+		value = _mm_add_ps(value, _mm_mul_ps(k3, w));
+		value = _mm_add_ps(value, _mm_mul_ps(_mm_mul_ps(k4, u), v));
+		value = _mm_add_ps(value, _mm_mul_ps(_mm_mul_ps(k5, u), w));
+		value = _mm_add_ps(value, _mm_mul_ps(_mm_mul_ps(k6, v), w));
+		value = _mm_add_ps(value, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(k7, u), v),
+			w));
+		_mm_storeu_ps(batch.values + first, value);
+	}
+	return numGroups * 4;
+}
+
+NOISE_TARGET_AVX2 size_t PerlinNoise::EvalBatchAvx2(
+	NoiseBatch const& batch) const {
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 six = _mm256_set1_ps(6.0f);
+	const __m256 ten = _mm256_set1_ps(10.0f);
+	const __m256 fifteen = _mm256_set1_ps(15.0f);
+	const __m256 thirty = _mm256_set1_ps(30.0f);
+	const __m256i mask = _mm256_set1_epi32((int)tableSizeMask);
+	const __m256i gradientMask = _mm256_set1_epi32(15);
+	const __m256i upperHalfBit = _mm256_set1_epi32(8);
+	// the gradient tables in two halves of eight, which a permute can index
+	const __m256 gradients[3][2] = {
+		{ _mm256_loadu_ps(gradientX), _mm256_loadu_ps(gradientX + 8) },
+		{ _mm256_loadu_ps(gradientY), _mm256_loadu_ps(gradientY + 8) },
+		{ _mm256_loadu_ps(gradientZ), _mm256_loadu_ps(gradientZ + 8) } };
+
+	size_t numGroups = batch.count / 8;
+	for (size_t group = 0; group < numGroups; group++) {
+		size_t first = group * 8;
+		__m256 p[3] = { _mm256_loadu_ps(batch.x + first),
+			_mm256_loadu_ps(batch.y + first),
+			_mm256_loadu_ps(batch.z + first) };
+		__m256i lattice[2][3];
+		__m256 t[3], s[3], ds[3];
+		for (int axis = 0; axis < 3; axis++) {
+			__m256 floored = _mm256_floor_ps(p[axis]);
+			lattice[0][axis] = _mm256_and_si256(_mm256_cvttps_epi32(floored),
+				mask);
+			lattice[1][axis] = _mm256_and_si256(_mm256_add_epi32(
+				lattice[0][axis], _mm256_set1_epi32(1)), mask);
+			t[axis] = _mm256_sub_ps(p[axis], floored);
+			__m256 tt = t[axis];
+			s[axis] = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(tt, tt), tt),
+				_mm256_add_ps(_mm256_mul_ps(tt, _mm256_sub_ps(
+				_mm256_mul_ps(tt, six), fifteen)), ten));
+			ds[axis] = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(thirty, tt),
+				tt), _mm256_add_ps(_mm256_mul_ps(tt, _mm256_sub_ps(tt, two)),
+				one));
+		}
+
+		// the three dependent lookups of a hash are faster a lane at a time
+		// than as gathers, which are slow on most CPUs that have them
+		alignas(32) int lattices[2][3][8];
+		for (int side = 0; side < 2; side++) {
+			for (int axis = 0; axis < 3; axis++) {
+				_mm256_store_si256((__m256i*)lattices[side][axis],
+					lattice[side][axis]);
+			}
+		}
+
+		__m256 cornerDots[8];
+		__m256 cornerGradients[3][8];
+		for (int corner = 0; corner < 8; corner++) {
+			int cx = corner & 1, cy = (corner >> 1) & 1, cz = corner >> 2;
+			alignas(32) int hashes[8];
+			for (int lane = 0; lane < 8; lane++) {
+				hashes[lane] = Hash(lattices[cx][0][lane],
+					lattices[cy][1][lane], lattices[cz][2][lane]);
+			}
+			__m256i gradientIndex = _mm256_and_si256(
+				_mm256_load_si256((__m256i const*)hashes), gradientMask);
+			// permutes only look at the low three bits
+			__m256 inUpperHalf = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+				_mm256_and_si256(gradientIndex, upperHalfBit), upperHalfBit));
+			for (int axis = 0; axis < 3; axis++) {
+				cornerGradients[axis][corner] = _mm256_blendv_ps(
+					_mm256_permutevar8x32_ps(gradients[axis][0], gradientIndex),
+					_mm256_permutevar8x32_ps(gradients[axis][1], gradientIndex),
+					inUpperHalf);
+			}
+			__m256 vx = cx ? _mm256_sub_ps(t[0], one) : t[0];
+			__m256 vy = cy ? _mm256_sub_ps(t[1], one) : t[1];
+			__m256 vz = cz ? _mm256_sub_ps(t[2], one) : t[2];
+			cornerDots[corner] = _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(cornerGradients[0][corner], vx),
+				_mm256_mul_ps(cornerGradients[1][corner], vy)),
+				_mm256_mul_ps(cornerGradients[2][corner], vz));
+		}
+
+		__m256 a = cornerDots[0], b = cornerDots[1], c = cornerDots[2],
+			d = cornerDots[3], e = cornerDots[4], f = cornerDots[5],
+			g = cornerDots[6], h = cornerDots[7];
+		__m256 u = s[0], v = s[1], w = s[2];
+		__m256 k0 = a;
+		__m256 k1 = _mm256_sub_ps(b, a);
+		__m256 k2 = _mm256_sub_ps(c, a);
+		__m256 k3 = _mm256_sub_ps(e, a);
+		__m256 k4 = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(a, d), b), c);
+		__m256 k5 = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(a, f), b), e);
+		__m256 k6 = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(a, g), c), e);
+		__m256 k7 = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(
+			_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(b, c), e), h), a), d),
+			f), g);
+		__m256 k7u = _mm256_mul_ps(k7, u);
+
+		_mm256_storeu_ps(batch.derivX + first, _mm256_add_ps(
+			BlendCornersAvx2(cornerGradients[0], u, v, w),
+			_mm256_mul_ps(ds[0], _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(k1,
+			_mm256_mul_ps(k4, v)), _mm256_mul_ps(k5, w)),
+			_mm256_mul_ps(_mm256_mul_ps(k7, v), w)))));
+		_mm256_storeu_ps(batch.derivY + first, _mm256_add_ps(
+			BlendCornersAvx2(cornerGradients[1], u, v, w),
+			_mm256_mul_ps(ds[1], _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(k2,
+			_mm256_mul_ps(k4, u)), _mm256_mul_ps(k6, w)),
+			_mm256_mul_ps(k7u, w)))));
+		_mm256_storeu_ps(batch.derivZ + first, _mm256_add_ps(
+			BlendCornersAvx2(cornerGradients[2], u, v, w),
+			_mm256_mul_ps(ds[2], _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(k3,
+			_mm256_mul_ps(k5, u)), _mm256_mul_ps(k6, v)),
+			_mm256_mul_ps(k7u, v)))));
+		__m256 value = _mm256_add_ps(k0, _mm256_mul_ps(k1, u));
+		value = _mm256_add_ps(value, _mm256_mul_ps(k2, v));
+		value = _mm256_add_ps(value, _mm256_mul_ps(k3, w));
+		value = _mm256_add_ps(value, _mm256_mul_ps(_mm256_mul_ps(k4, u), v));
+		value = _mm256_add_ps(value, _mm256_mul_ps(_mm256_mul_ps(k5, u), w));
+		value = _mm256_add_ps(value, _mm256_mul_ps(_mm256_mul_ps(k6, v), w));
+		value = _mm256_add_ps(value, _mm256_mul_ps(_mm256_mul_ps(
+			_mm256_mul_ps(k7, u), v), w));
+		_mm256_storeu_ps(batch.values + first, value);
+	}
+	return numGroups * 8;
+}
+
+#else
+
+size_t PerlinNoise::EvalBatchSse41(NoiseBatch const& batch) const {
+	return 0;
+}
+
+size_t PerlinNoise::EvalBatchAvx2(NoiseBatch const& batch) const {
+	return 0;
+}
+
+#endif
@@ -1,17 +1,29 @@
 // https://github.com/sol-prog/Perlin_Noise/blob/master/PerlinNoise.h
 // https://www.scratchapixel.com/code.php?id=57&origin=/lessons/procedural-generation-virtual-worlds/perlin-noise-part-2
-// TODO: re-write, this code has bugs!!!
 #pragma once
 
 #include "NoiseGenerator.h"
+#include <cstdint>
 
 class PerlinNoise : public NoiseGenerator {
 public:
 	PerlinNoise(const unsigned int seed = 2016);
 
 	float Eval(const glm::vec3& p, glm::vec3& derivs) const;
+	// uses AVX2 or SSE4.1 if the CPU has them, decided once at run time
+	void EvalBatch(NoiseBatch const& batch) const override;
+	// no higher than maxSimdLevel, so each path can be checked and timed
+	// against the others. levels the CPU doesn't have fall back to the
+	// best one it does
+	void EvalBatch(NoiseBatch const& batch, SimdLevel maxSimdLevel) const;
 
 private:
+	// gradient picked by the low four bits of a hash, as components, so
+	// they can be looked up for several points at once
+	static const float gradientX[16];
+	static const float gradientY[16];
+	static const float gradientZ[16];
+
 	uint8_t Hash(const int x, const int y, const int z) const;
 	float GradientDotV(uint8_t perm, // a value between 0 and 255 
 		float x, float y, float z) const;
@@ -19,8 +31,13 @@ private:
 	float Quintic(const float t) const;
 	float QuinticDeriv(const float t) const;
 
+	// evaluate the front of the batch in groups of four or eight points
+	// and return how many that was. Eval does the rest
+	size_t EvalBatchSse41(NoiseBatch const& batch) const;
+	size_t EvalBatchAvx2(NoiseBatch const& batch) const;
+
 	static const unsigned tableSize = 256;
 	static const unsigned tableSizeMask = tableSize - 1;
-	glm::vec3 gradients[tableSize];
+	// a shuffle of 0 to 255, twice over
 	unsigned permutationTable[tableSize * 2];
 };
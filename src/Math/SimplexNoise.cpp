@@ -0,0 +1,399 @@
+#include "SimplexNoise.h"
+#include "NoiseSimd.h"
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+// the twelve edge directions of a cube. padded to sixteen, so the AVX2
+// kernel can load them as two halves of eight
+static const unsigned numGradients = 12;
+static const float gradientX[16] = { 1, -1, 1, -1, 1, -1, 1, -1,
+	0, 0, 0, 0 };
+static const float gradientY[16] = { 1, 1, -1, -1, 0, 0, 0, 0,
+	1, -1, 1, -1 };
+static const float gradientZ[16] = { 0, 0, 0, 0, 1, 1, -1, -1,
+	1, 1, -1, -1 };
+
+// skews the grid of tetrahedra onto a grid of cubes, and back
+static const float skewFactor = 1.0f / 3.0f;
+static const float unskewFactor = 1.0f / 6.0f;
+// brings the sum of the corners' falloffs to about [-1, 1]
+static const float valueScale = 72.0f;
+
+// adds one corner's share of the value and the derivatives. x, y and z go
+// from the corner to the point
+static inline void AddCorner(unsigned hash, float x, float y, float z,
+	float& value, float& derivX, float& derivY, float& derivZ) {
+	// each corner only reaches as far as the faces opposite of it, so the
+	// noise stays smooth where the tetrahedra meet
+	float falloff = std::max(0.5f - x * x - y * y - z * z, 0.0f);
+	unsigned gradientIndex = hash % numGradients;
+	float gx = gradientX[gradientIndex];
+	float gy = gradientY[gradientIndex];
+	float gz = gradientZ[gradientIndex];
+	float gradientDot = gx * x + gy * y + gz * z;
+	float falloff2 = falloff * falloff;
+	float falloff4 = falloff2 * falloff2;
+	value += falloff4 * gradientDot;
+	// product rule on falloff^4 * (gradient . offset)
+	float slope = -8.0f * falloff2 * falloff * gradientDot;
+	derivX += slope * x + falloff4 * gx;
+	derivY += slope * y + falloff4 * gy;
+	derivZ += slope * z + falloff4 * gz;
+}
+
+SimplexNoise::SimplexNoise(const unsigned int seed) {
+	std::mt19937 generator(seed);
+	for (unsigned i = 0; i < tableSize; ++i) {
+		permutationTable[i] = i;
+	}
+	std::shuffle(permutationTable, permutationTable + tableSize, generator);
+	for (unsigned i = 0; i < tableSize; ++i) {
+		permutationTable[tableSize + i] = permutationTable[i];
+	}
+}
+
+float SimplexNoise::Eval(const glm::vec3& p, glm::vec3& derivs) const {
+	// find the cube the point is in, in the skewed grid
+	float skew = (p.x + p.y + p.z) * skewFactor;
+	int i = FastFloor(p.x + skew);
+	int j = FastFloor(p.y + skew);
+	int k = FastFloor(p.z + skew);
+	float unskew = (float)(i + j + k) * unskewFactor;
+	float x0 = p.x - ((float)i - unskew);
+	float y0 = p.y - ((float)j - unskew);
+	float z0 = p.z - ((float)k - unskew);
+
+	// the cube is split into six tetrahedra, one for each order of the
+	// offsets. going from the first corner to the last one along the
+	// largest offset first gives the one the point is in. counting instead
+	// of branching, since the order changes at random from point to point
+	int rankX = (x0 > y0) + (x0 > z0);
+	int rankY = (y0 >= x0) + (y0 > z0);
+	int rankZ = (z0 >= x0) + (z0 >= y0);
+	int i1 = rankX >= 2, j1 = rankY >= 2, k1 = rankZ >= 2;
+	int i2 = rankX >= 1, j2 = rankY >= 1, k2 = rankZ >= 1;
+
+	int wrappedI = i & tableSizeMask;
+	int wrappedJ = j & tableSizeMask;
+	int wrappedK = k & tableSizeMask;
+	float value = 0.0f, derivX = 0.0f, derivY = 0.0f, derivZ = 0.0f;
+	AddCorner(Hash(wrappedI, wrappedJ, wrappedK), x0, y0, z0, value,
+		derivX, derivY, derivZ);
+	AddCorner(Hash(wrappedI + i1, wrappedJ + j1, wrappedK + k1),
+		x0 - (float)i1 + unskewFactor, y0 - (float)j1 + unskewFactor,
+		z0 - (float)k1 + unskewFactor, value, derivX, derivY, derivZ);
+	AddCorner(Hash(wrappedI + i2, wrappedJ + j2, wrappedK + k2),
+		x0 - (float)i2 + 2.0f * unskewFactor,
+		y0 - (float)j2 + 2.0f * unskewFactor,
+		z0 - (float)k2 + 2.0f * unskewFactor, value, derivX, derivY, derivZ);
+	AddCorner(Hash(wrappedI + 1, wrappedJ + 1, wrappedK + 1),
+		x0 - 1.0f + 3.0f * unskewFactor, y0 - 1.0f + 3.0f * unskewFactor,
+		z0 - 1.0f + 3.0f * unskewFactor, value, derivX, derivY, derivZ);
+
+	derivs = glm::vec3(derivX, derivY, derivZ) * valueScale;
+	return value * valueScale;
+}
+
+int SimplexNoise::FastFloor(float x) {
+	int truncated = (int)x;
+	return x < (float)truncated ? truncated - 1 : truncated;
+}
+
+uint8_t SimplexNoise::Hash(const int x, const int y, const int z) const {
+	return (uint8_t)permutationTable[permutationTable[permutationTable[x] +
+		y] + z];
+}
+
+void SimplexNoise::EvalBatch(NoiseBatch const& batch) const {
+	EvalBatch(batch, GetSimdLevel());
+}
+
+void SimplexNoise::EvalBatch(NoiseBatch const& batch,
+	SimdLevel maxSimdLevel) const {
+	SimdLevel simdLevel = std::min(maxSimdLevel, GetSimdLevel());
+	size_t numEvaluated = 0;
+	switch (simdLevel) {
+		case SimdLevel::Avx2:
+			numEvaluated = EvalBatchAvx2(batch);
+			break;
+		case SimdLevel::Sse41:
+			numEvaluated = EvalBatchSse41(batch);
+			break;
+		default:
+			break;
+	}
+
+	for (size_t i = numEvaluated; i < batch.count; i++) {
+		glm::vec3 derivs;
+		batch.values[i] = Eval(glm::vec3(batch.x[i], batch.y[i], batch.z[i]),
+			derivs);
+		batch.derivX[i] = derivs.x;
+		batch.derivY[i] = derivs.y;
+		batch.derivZ[i] = derivs.z;
+	}
+}
+
+#if defined(NOISE_USE_X86_SIMD)
+
+// the kernels below follow Eval and AddCorner step by step, without fused
+// multiply-adds, so they give the same results bit for bit. corners are
+// hashed a lane at a time, like in PerlinNoise's kernels
+
+NOISE_TARGET_SSE41 static inline void AddCornerSse41(__m128 gx, __m128 gy,
+	__m128 gz, __m128 x, __m128 y, __m128 z, __m128& value, __m128& derivX,
+	__m128& derivY, __m128& derivZ) {
+	// zero first, so a falloff of -0 stays -0 the way std::max keeps it
+	__m128 falloff = _mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(_mm_sub_ps(
+		_mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y)),
+		_mm_mul_ps(z, z)));
+	__m128 gradientDot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(gx, x),
+		_mm_mul_ps(gy, y)), _mm_mul_ps(gz, z));
+	__m128 falloff2 = _mm_mul_ps(falloff, falloff);
+	__m128 falloff4 = _mm_mul_ps(falloff2, falloff2);
+	value = _mm_add_ps(value, _mm_mul_ps(falloff4, gradientDot));
+	__m128 slope = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(-8.0f),
+		falloff2), falloff), gradientDot);
+	derivX = _mm_add_ps(derivX, _mm_add_ps(_mm_mul_ps(slope, x),
+		_mm_mul_ps(falloff4, gx)));
+	derivY = _mm_add_ps(derivY, _mm_add_ps(_mm_mul_ps(slope, y),
+		_mm_mul_ps(falloff4, gy)));
+	derivZ = _mm_add_ps(derivZ, _mm_add_ps(_mm_mul_ps(slope, z),
+		_mm_mul_ps(falloff4, gz)));
+}
+
+NOISE_TARGET_AVX2 static inline void AddCornerAvx2(__m256 gx, __m256 gy,
+	__m256 gz, __m256 x, __m256 y, __m256 z, __m256& value, __m256& derivX,
+	__m256& derivY, __m256& derivZ) {
+	__m256 falloff = _mm256_max_ps(_mm256_setzero_ps(), _mm256_sub_ps(
+		_mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(x, x)),
+		_mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+	__m256 gradientDot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(gx, x),
+		_mm256_mul_ps(gy, y)), _mm256_mul_ps(gz, z));
+	__m256 falloff2 = _mm256_mul_ps(falloff, falloff);
+	__m256 falloff4 = _mm256_mul_ps(falloff2, falloff2);
+	value = _mm256_add_ps(value, _mm256_mul_ps(falloff4, gradientDot));
+	__m256 slope = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(
+		_mm256_set1_ps(-8.0f), falloff2), falloff), gradientDot);
+	derivX = _mm256_add_ps(derivX, _mm256_add_ps(_mm256_mul_ps(slope, x),
+		_mm256_mul_ps(falloff4, gx)));
+	derivY = _mm256_add_ps(derivY, _mm256_add_ps(_mm256_mul_ps(slope, y),
+		_mm256_mul_ps(falloff4, gy)));
+	derivZ = _mm256_add_ps(derivZ, _mm256_add_ps(_mm256_mul_ps(slope, z),
+		_mm256_mul_ps(falloff4, gz)));
+}
+
+NOISE_TARGET_SSE41 size_t SimplexNoise::EvalBatchSse41(
+	NoiseBatch const& batch) const {
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128i mask = _mm_set1_epi32((int)tableSizeMask);
+	// the same constants Eval adds to each corner's offsets
+	const __m128 cornerOffsets[4] = { _mm_setzero_ps(),
+		_mm_set1_ps(unskewFactor), _mm_set1_ps(2.0f * unskewFactor),
+		_mm_set1_ps(3.0f * unskewFactor) };
+
+	size_t numGroups = batch.count / 4;
+	for (size_t group = 0; group < numGroups; group++) {
+		size_t first = group * 4;
+		__m128 p[3] = { _mm_loadu_ps(batch.x + first),
+			_mm_loadu_ps(batch.y + first), _mm_loadu_ps(batch.z + first) };
+		__m128 skew = _mm_mul_ps(_mm_add_ps(_mm_add_ps(p[0], p[1]), p[2]),
+			_mm_set1_ps(skewFactor));
+		__m128i cell[3];
+		for (int axis = 0; axis < 3; axis++) {
+			// FastFloor: truncate, then one lower if that went up
+			__m128 skewed = _mm_add_ps(p[axis], skew);
+			__m128i truncated = _mm_cvttps_epi32(skewed);
+			cell[axis] = _mm_add_epi32(truncated, _mm_castps_si128(
+				_mm_cmplt_ps(skewed, _mm_cvtepi32_ps(truncated))));
+		}
+		__m128 unskew = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(
+			cell[0], cell[1]), cell[2])), _mm_set1_ps(unskewFactor));
+		__m128 offset0[3];
+		for (int axis = 0; axis < 3; axis++) {
+			offset0[axis] = _mm_sub_ps(p[axis], _mm_sub_ps(
+				_mm_cvtepi32_ps(cell[axis]), unskew));
+		}
+
+		// the tetrahedron's second corner steps along the largest offset,
+		// the third along the two largest
+		__m128 xy = _mm_cmpgt_ps(offset0[0], offset0[1]);
+		__m128 xz = _mm_cmpgt_ps(offset0[0], offset0[2]);
+		__m128 yx = _mm_cmpge_ps(offset0[1], offset0[0]);
+		__m128 yz = _mm_cmpgt_ps(offset0[1], offset0[2]);
+		__m128 zx = _mm_cmpge_ps(offset0[2], offset0[0]);
+		__m128 zy = _mm_cmpge_ps(offset0[2], offset0[1]);
+		__m128 steps1[3] = { _mm_and_ps(_mm_and_ps(xy, xz), one),
+			_mm_and_ps(_mm_and_ps(yx, yz), one),
+			_mm_and_ps(_mm_and_ps(zx, zy), one) };
+		__m128 steps2[3] = { _mm_and_ps(_mm_or_ps(xy, xz), one),
+			_mm_and_ps(_mm_or_ps(yx, yz), one),
+			_mm_and_ps(_mm_or_ps(zx, zy), one) };
+
+		alignas(16) int wrapped[3][4], step1[3][4], step2[3][4];
+		for (int axis = 0; axis < 3; axis++) {
+			_mm_store_si128((__m128i*)wrapped[axis], _mm_and_si128(cell[axis],
+				mask));
+			_mm_store_si128((__m128i*)step1[axis],
+				_mm_cvttps_epi32(steps1[axis]));
+			_mm_store_si128((__m128i*)step2[axis],
+				_mm_cvttps_epi32(steps2[axis]));
+		}
+
+		__m128 value = _mm_setzero_ps(), derivX = _mm_setzero_ps(),
+			derivY = _mm_setzero_ps(), derivZ = _mm_setzero_ps();
+		for (int corner = 0; corner < 4; corner++) {
+			alignas(16) float gx[4], gy[4], gz[4];
+			for (int lane = 0; lane < 4; lane++) {
+				int stepX = corner == 0 ? 0 : corner == 1 ? step1[0][lane] :
+					corner == 2 ? step2[0][lane] : 1;
+				int stepY = corner == 0 ? 0 : corner == 1 ? step1[1][lane] :
+					corner == 2 ? step2[1][lane] : 1;
+				int stepZ = corner == 0 ? 0 : corner == 1 ? step1[2][lane] :
+					corner == 2 ? step2[2][lane] : 1;
+				unsigned gradientIndex = Hash(wrapped[0][lane] + stepX,
+					wrapped[1][lane] + stepY, wrapped[2][lane] + stepZ) %
+					numGradients;
+				gx[lane] = gradientX[gradientIndex];
+				gy[lane] = gradientY[gradientIndex];
+				gz[lane] = gradientZ[gradientIndex];
+			}
+			__m128 offset[3];
+			for (int axis = 0; axis < 3; axis++) {
+				__m128 step = corner == 0 ? _mm_setzero_ps() : corner == 1 ?
+					steps1[axis] : corner == 2 ? steps2[axis] : one;
+				offset[axis] = corner == 0 ? offset0[axis] : _mm_add_ps(
+					_mm_sub_ps(offset0[axis], step), cornerOffsets[corner]);
+			}
+			AddCornerSse41(_mm_load_ps(gx), _mm_load_ps(gy), _mm_load_ps(gz),
+				offset[0], offset[1], offset[2], value, derivX, derivY, derivZ);
+		}
+
+		const __m128 scale = _mm_set1_ps(valueScale);
+		_mm_storeu_ps(batch.values + first, _mm_mul_ps(value, scale));
+		_mm_storeu_ps(batch.derivX + first, _mm_mul_ps(derivX, scale));
+		_mm_storeu_ps(batch.derivY + first, _mm_mul_ps(derivY, scale));
+		_mm_storeu_ps(batch.derivZ + first, _mm_mul_ps(derivZ, scale));
+	}
+	return numGroups * 4;
+}
+
+NOISE_TARGET_AVX2 size_t SimplexNoise::EvalBatchAvx2(
+	NoiseBatch const& batch) const {
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256i mask = _mm256_set1_epi32((int)tableSizeMask);
+	const __m256i upperHalfBit = _mm256_set1_epi32(8);
+	const __m256 cornerOffsets[4] = { _mm256_setzero_ps(),
+		_mm256_set1_ps(unskewFactor), _mm256_set1_ps(2.0f * unskewFactor),
+		_mm256_set1_ps(3.0f * unskewFactor) };
+	// the gradient tables in two halves of eight, which a permute can index
+	const __m256 gradients[3][2] = {
+		{ _mm256_loadu_ps(gradientX), _mm256_loadu_ps(gradientX + 8) },
+		{ _mm256_loadu_ps(gradientY), _mm256_loadu_ps(gradientY + 8) },
+		{ _mm256_loadu_ps(gradientZ), _mm256_loadu_ps(gradientZ + 8) } };
+
+	size_t numGroups = batch.count / 8;
+	for (size_t group = 0; group < numGroups; group++) {
+		size_t first = group * 8;
+		__m256 p[3] = { _mm256_loadu_ps(batch.x + first),
+			_mm256_loadu_ps(batch.y + first),
+			_mm256_loadu_ps(batch.z + first) };
+		__m256 skew = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(p[0], p[1]),
+			p[2]), _mm256_set1_ps(skewFactor));
+		__m256i cell[3];
+		for (int axis = 0; axis < 3; axis++) {
+			__m256 skewed = _mm256_add_ps(p[axis], skew);
+			__m256i truncated = _mm256_cvttps_epi32(skewed);
+			cell[axis] = _mm256_add_epi32(truncated, _mm256_castps_si256(
+				_mm256_cmp_ps(skewed, _mm256_cvtepi32_ps(truncated),
+				_CMP_LT_OQ)));
+		}
+		__m256 unskew = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(
+			_mm256_add_epi32(cell[0], cell[1]), cell[2])),
+			_mm256_set1_ps(unskewFactor));
+		__m256 offset0[3];
+		for (int axis = 0; axis < 3; axis++) {
+			offset0[axis] = _mm256_sub_ps(p[axis], _mm256_sub_ps(
+				_mm256_cvtepi32_ps(cell[axis]), unskew));
+		}
+
+		__m256 xy = _mm256_cmp_ps(offset0[0], offset0[1], _CMP_GT_OQ);
+		__m256 xz = _mm256_cmp_ps(offset0[0], offset0[2], _CMP_GT_OQ);
+		__m256 yx = _mm256_cmp_ps(offset0[1], offset0[0], _CMP_GE_OQ);
+		__m256 yz = _mm256_cmp_ps(offset0[1], offset0[2], _CMP_GT_OQ);
+		__m256 zx = _mm256_cmp_ps(offset0[2], offset0[0], _CMP_GE_OQ);
+		__m256 zy = _mm256_cmp_ps(offset0[2], offset0[1], _CMP_GE_OQ);
+		__m256 steps1[3] = { _mm256_and_ps(_mm256_and_ps(xy, xz), one),
+			_mm256_and_ps(_mm256_and_ps(yx, yz), one),
+			_mm256_and_ps(_mm256_and_ps(zx, zy), one) };
+		__m256 steps2[3] = { _mm256_and_ps(_mm256_or_ps(xy, xz), one),
+			_mm256_and_ps(_mm256_or_ps(yx, yz), one),
+			_mm256_and_ps(_mm256_or_ps(zx, zy), one) };
+
+		alignas(32) int wrapped[3][8], step1[3][8], step2[3][8];
+		for (int axis = 0; axis < 3; axis++) {
+			_mm256_store_si256((__m256i*)wrapped[axis], _mm256_and_si256(
+				cell[axis], mask));
+			_mm256_store_si256((__m256i*)step1[axis],
+				_mm256_cvttps_epi32(steps1[axis]));
+			_mm256_store_si256((__m256i*)step2[axis],
+				_mm256_cvttps_epi32(steps2[axis]));
+		}
+
+		__m256 value = _mm256_setzero_ps(), derivX = _mm256_setzero_ps(),
+			derivY = _mm256_setzero_ps(), derivZ = _mm256_setzero_ps();
+		for (int corner = 0; corner < 4; corner++) {
+			alignas(32) int gradientIndices[8];
+			for (int lane = 0; lane < 8; lane++) {
+				int stepX = corner == 0 ? 0 : corner == 1 ? step1[0][lane] :
+					corner == 2 ? step2[0][lane] : 1;
+				int stepY = corner == 0 ? 0 : corner == 1 ? step1[1][lane] :
+					corner == 2 ? step2[1][lane] : 1;
+				int stepZ = corner == 0 ? 0 : corner == 1 ? step1[2][lane] :
+					corner == 2 ? step2[2][lane] : 1;
+				gradientIndices[lane] = Hash(wrapped[0][lane] + stepX,
+					wrapped[1][lane] + stepY, wrapped[2][lane] + stepZ) %
+					numGradients;
+			}
+			__m256i gradientIndex = _mm256_load_si256(
+				(__m256i const*)gradientIndices);
+			// permutes only look at the low three bits
+			__m256 inUpperHalf = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+				_mm256_and_si256(gradientIndex, upperHalfBit), upperHalfBit));
+			__m256 cornerGradient[3];
+			__m256 offset[3];
+			for (int axis = 0; axis < 3; axis++) {
+				cornerGradient[axis] = _mm256_blendv_ps(
+					_mm256_permutevar8x32_ps(gradients[axis][0], gradientIndex),
+					_mm256_permutevar8x32_ps(gradients[axis][1], gradientIndex),
+					inUpperHalf);
+				__m256 step = corner == 0 ? _mm256_setzero_ps() : corner == 1 ?
+					steps1[axis] : corner == 2 ? steps2[axis] : one;
+				offset[axis] = corner == 0 ? offset0[axis] : _mm256_add_ps(
+					_mm256_sub_ps(offset0[axis], step), cornerOffsets[corner]);
+			}
+			AddCornerAvx2(cornerGradient[0], cornerGradient[1],
+				cornerGradient[2], offset[0], offset[1], offset[2], value, derivX,
+				derivY, derivZ);
+		}
+
+		const __m256 scale = _mm256_set1_ps(valueScale);
+		_mm256_storeu_ps(batch.values + first, _mm256_mul_ps(value, scale));
+		_mm256_storeu_ps(batch.derivX + first, _mm256_mul_ps(derivX, scale));
+		_mm256_storeu_ps(batch.derivY + first, _mm256_mul_ps(derivY, scale));
+		_mm256_storeu_ps(batch.derivZ + first, _mm256_mul_ps(derivZ, scale));
+	}
+	return numGroups * 8;
+}
+
+#else
+
+size_t SimplexNoise::EvalBatchSse41(NoiseBatch const& batch) const {
+	return 0;
+}
+
+size_t SimplexNoise::EvalBatchAvx2(NoiseBatch const& batch) const {
+	return 0;
+}
+
+#endif
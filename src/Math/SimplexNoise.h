@@ -0,0 +1,35 @@
+// http://staffwww.itn.liu.se/~stegu/simplexnoise/simplexnoise.pdf
+// http://staffwww.itn.liu.se/~stegu/aqsis/aqsis-newnoise/sdnoise1234.c
+#pragma once
+
+#include "NoiseGenerator.h"
+#include <cstdint>
+
+// Gradient noise on a grid of tetrahedra instead of cubes, so each sample
+// only sums up four corners instead of eight. Values are roughly in [-1, 1]
+// like PerlinNoise's, but the two don't look the same.
+class SimplexNoise : public NoiseGenerator {
+public:
+	SimplexNoise(const unsigned int seed = 2016);
+
+	float Eval(const glm::vec3& p, glm::vec3& derivs) const override;
+	// uses AVX2 or SSE4.1 if the CPU has them, like PerlinNoise
+	void EvalBatch(NoiseBatch const& batch) const override;
+	// no higher than maxSimdLevel, so each path can be checked and timed
+	void EvalBatch(NoiseBatch const& batch, SimdLevel maxSimdLevel) const;
+
+private:
+	static const unsigned tableSize = 256;
+	static const unsigned tableSizeMask = tableSize - 1;
+	// a shuffle of 0 to 255, twice over
+	unsigned permutationTable[tableSize * 2];
+
+	uint8_t Hash(const int x, const int y, const int z) const;
+	// std::floor is slow, and samples don't get anywhere near int limits
+	static int FastFloor(float x);
+
+	// evaluate the front of the batch in groups of four or eight points
+	// and return how many that was. Eval does the rest
+	size_t EvalBatchSse41(NoiseBatch const& batch) const;
+	size_t EvalBatchAvx2(NoiseBatch const& batch) const;
+};
@@ -0,0 +1,75 @@
+#include "Math/SpatialHashGrid.h"
+#include <cmath>
+
+SpatialHashGrid::SpatialHashGrid(float cellSize) :
+	inverseCellSize(1.0f / cellSize), bucketMask(0) {
+}
+
+void SpatialHashGrid::Clear() {
+	points.clear();
+	sortedPoints.clear();
+}
+
+void SpatialHashGrid::Insert(glm::vec3 const& position, uint32_t item) {
+	Point point;
+	point.position = position;
+	point.item = item;
+	point.cell = GetCell(position);
+	points.push_back(point);
+}
+
+void SpatialHashGrid::Build() {
+	// about two buckets per point keeps collisions between cells rare
+	uint32_t numBuckets = 1;
+	while (numBuckets < points.size() * 2) {
+		numBuckets *= 2;
+	}
+	bucketMask = numBuckets - 1;
+
+	// counting sort by bucket, so each bucket's points are next to each
+	// other
+	bucketStarts.assign(numBuckets + 1, 0);
+	for (Point const& point : points) {
+		bucketStarts[GetBucket(point.cell) + 1]++;
+	}
+	for (uint32_t bucket = 0; bucket < numBuckets; bucket++) {
+		bucketStarts[bucket + 1] += bucketStarts[bucket];
+	}
+
+	sortedPoints.resize(points.size());
+	std::vector<uint32_t>& nextIndices = bucketStarts;
+	for (Point const& point : points) {
+		sortedPoints[nextIndices[GetBucket(point.cell)]++] = point;
+	}
+	// filling moved every start to the next bucket's start
+	for (uint32_t bucket = numBuckets; bucket > 0; bucket--) {
+		bucketStarts[bucket] = bucketStarts[bucket - 1];
+	}
+	bucketStarts[0] = 0;
+}
+
+void SpatialHashGrid::QuerySphere(glm::vec3 const& center, float radius,
+	std::vector<uint32_t>& items) const {
+	float radiusSquared = radius * radius;
+	VisitCells(center, radius,
+		[&](glm::vec3 const& position, uint32_t item) {
+			glm::vec3 offset = position - center;
+			if (glm::dot(offset, offset) <= radiusSquared) {
+				items.push_back(item);
+			}
+			return true;
+		});
+}
+
+glm::ivec3 SpatialHashGrid::GetCell(glm::vec3 const& position) const {
+	return glm::ivec3((int)std::floor(position.x * inverseCellSize),
+		(int)std::floor(position.y * inverseCellSize),
+		(int)std::floor(position.z * inverseCellSize));
+}
+
+uint32_t SpatialHashGrid::GetBucket(glm::ivec3 const& cell) const {
+	// large primes, from Teschner et al.'s spatial hashing paper
+	uint32_t hash = ((uint32_t)cell.x * 73856093u) ^
+		((uint32_t)cell.y * 19349663u) ^ ((uint32_t)cell.z * 83492791u);
+	return hash & bucketMask;
+}
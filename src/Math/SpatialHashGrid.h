@@ -0,0 +1,112 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Points bucketed by the cell of a uniform grid they fall in. Cells are
+// hashed into a table, so the grid has no bounds and costs nothing where
+// there are no points. Meant to be rebuilt from scratch whenever the
+// points move: insert them all, build, then query. Storage is kept between
+// rebuilds. Doesn't need a GPU, so it can be tested on its own.
+class SpatialHashGrid {
+public:
+	// queries are cheapest with cells about as big as the spheres they
+	// look for
+	explicit SpatialHashGrid(float cellSize);
+
+	void Clear();
+	// item is handed back by queries; usually an index into the caller's
+	// own array
+	void Insert(glm::vec3 const& position, uint32_t item);
+	// has to be called after inserting and before querying
+	void Build();
+
+	// appends the items of all points within radius of center
+	void QuerySphere(glm::vec3 const& center, float radius,
+		std::vector<uint32_t>& items) const;
+	// item of the nearest point within radius, or false if there is none.
+	// points that acceptItem turns down are skipped
+	template<typename AcceptItem>
+	bool FindNearest(glm::vec3 const& center, float radius,
+		AcceptItem const& acceptItem, uint32_t& nearestItem) const;
+
+	size_t GetNumPoints() const {
+		return points.size();
+	}
+
+private:
+	struct Point {
+		glm::vec3 position;
+		uint32_t item;
+		glm::ivec3 cell;
+	};
+
+	float inverseCellSize;
+	// in insertion order until built, then sorted by bucket
+	std::vector<Point> points;
+	std::vector<Point> sortedPoints;
+	// points of bucket i are [bucketStarts[i], bucketStarts[i + 1]).
+	// the number of buckets is a power of two
+	std::vector<uint32_t> bucketStarts;
+	uint32_t bucketMask;
+
+	glm::ivec3 GetCell(glm::vec3 const& position) const;
+	uint32_t GetBucket(glm::ivec3 const& cell) const;
+	// calls visitPoint for each point in cells the sphere's bounds touch.
+	// it returns false to stop early
+	template<typename VisitPoint>
+	void VisitCells(glm::vec3 const& center, float radius,
+		VisitPoint const& visitPoint) const;
+};
+
+template<typename VisitPoint>
+void SpatialHashGrid::VisitCells(glm::vec3 const& center, float radius,
+	VisitPoint const& visitPoint) const {
+	if (sortedPoints.empty()) {
+		return;
+	}
+
+	glm::ivec3 minCell = GetCell(center - glm::vec3(radius));
+	glm::ivec3 maxCell = GetCell(center + glm::vec3(radius));
+	for (int x = minCell.x; x <= maxCell.x; x++) {
+		for (int y = minCell.y; y <= maxCell.y; y++) {
+			for (int z = minCell.z; z <= maxCell.z; z++) {
+				glm::ivec3 cell(x, y, z);
+				uint32_t bucket = GetBucket(cell);
+				uint32_t end = bucketStarts[bucket + 1];
+				for (uint32_t i = bucketStarts[bucket]; i < end; i++) {
+					Point const& point = sortedPoints[i];
+					// other cells can land in the same bucket
+					if (point.cell != cell) {
+						continue;
+					}
+					if (!visitPoint(point.position, point.item)) {
+						return;
+					}
+				}
+			}
+		}
+	}
+}
+
+template<typename AcceptItem>
+bool SpatialHashGrid::FindNearest(glm::vec3 const& center, float radius,
+	AcceptItem const& acceptItem, uint32_t& nearestItem) const {
+	float nearestDistanceSquared = radius * radius;
+	bool found = false;
+	VisitCells(center, radius,
+		[&](glm::vec3 const& position, uint32_t item) {
+			glm::vec3 offset = position - center;
+			float distanceSquared = glm::dot(offset, offset);
+			if (distanceSquared <= nearestDistanceSquared &&
+				acceptItem(item)) {
+				nearestDistanceSquared = distanceSquared;
+				nearestItem = item;
+				found = true;
+			}
+			return true;
+		});
+	return found;
+}
@@ -0,0 +1,415 @@
+#include "MemoryAllocator.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+const VkDeviceSize MemoryAllocator::maxBlockSize = 64 * 1024 * 1024;
+const VkDeviceSize MemoryAllocator::minBlockSize = 1024 * 1024;
+const VkDeviceSize MemoryAllocator::minChunkSize = 256;
+
+MemoryAllocator::MemoryAllocator(VkDevice device,
+	VkPhysicalDevice physicalDevice) : device(device) {
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	uint32_t memoryTypeCount = memoryProperties.memoryTypeCount;
+	pools.resize(memoryTypeCount * NumPoolKinds);
+	numDedicatedAllocationsPerType.resize(memoryTypeCount, 0);
+	dedicatedBytesPerType.resize(memoryTypeCount, 0);
+	numRequestsPerType.resize(memoryTypeCount, 0);
+	numDeviceMemoryAllocationsPerType.resize(memoryTypeCount, 0);
+
+	for (uint32_t typeIndex = 0; typeIndex < memoryTypeCount; typeIndex++) {
+		auto const& memoryType = memoryProperties.memoryTypes[typeIndex];
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryType.heapIndex].size;
+		// don't let one block eat up a small heap. keep it a power of two
+		// for the buddy allocator
+		VkDeviceSize blockSize = maxBlockSize;
+		while (blockSize > minBlockSize && blockSize > heapSize / 8) {
+			blockSize /= 2;
+		}
+
+		for (int poolKind = 0; poolKind < NumPoolKinds; poolKind++) {
+			MemoryPool& pool = pools[typeIndex * NumPoolKinds + poolKind];
+			pool.memoryTypeIndex = typeIndex;
+			pool.isLinear = poolKind == LinearPool;
+			pool.isHostVisible = (memoryType.propertyFlags &
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+			pool.blockSize = blockSize;
+		}
+	}
+}
+
+MemoryAllocator::~MemoryAllocator() {
+	for (auto& pool : pools) {
+		for (auto block : pool.blocks) {
+			DestroyBlock(block);
+		}
+		pool.blocks.clear();
+	}
+}
+
+MemoryAllocator::Allocation MemoryAllocator::AllocateForBuffer(VkBuffer buffer,
+	VkMemoryPropertyFlags properties, AllocationLifetime lifetime) {
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+
+	Allocation allocation = Allocate(memRequirements, properties,
+		lifetime == AllocationLifetime::Transient ? LinearPool : BufferPool);
+	vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+	return allocation;
+}
+
+MemoryAllocator::Allocation MemoryAllocator::AllocateForImage(VkImage image,
+	VkMemoryPropertyFlags properties) {
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(device, image, &memRequirements);
+
+	Allocation allocation = Allocate(memRequirements, properties, ImagePool);
+	vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+	return allocation;
+}
+
+void MemoryAllocator::Free(Allocation& allocation) {
+	if (allocation.memory == VK_NULL_HANDLE) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+	MemoryBlock* block = allocation.block;
+	if (block == nullptr) {
+		if (allocation.mappedData != nullptr) {
+			vkUnmapMemory(device, allocation.memory);
+		}
+		vkFreeMemory(device, allocation.memory, nullptr);
+		numDedicatedAllocationsPerType[allocation.memoryTypeIndex]--;
+		dedicatedBytesPerType[allocation.memoryTypeIndex] -= allocation.size;
+		allocation = Allocation();
+		return;
+	}
+
+	MemoryPool* pool = block->pool;
+	if (pool->isLinear) {
+		FreeFromLinearBlock(block, allocation.offset, allocation.size);
+	}
+	else {
+		FreeFromBuddyBlock(block, allocation.offset);
+	}
+	block->numAllocations--;
+	block->usedBytes -= allocation.size;
+
+	if (block->numAllocations == 0) {
+		block->linearOffset = 0;
+		// keep one block around so that steady churn doesn't
+		// keep allocating and freeing memory
+		if (pool->blocks.size() > 1) {
+			pool->blocks.erase(std::find(pool->blocks.begin(),
+				pool->blocks.end(), block));
+			DestroyBlock(block);
+		}
+	}
+	allocation = Allocation();
+}
+
+uint32_t MemoryAllocator::FindMemoryType(uint32_t typeFilter,
+	VkMemoryPropertyFlags properties) const {
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags
+			& properties) == properties) {
+			return i;
+		}
+	}
+
+	throw std::runtime_error("Failed to find suitable memory type!");
+}
+
+MemoryAllocator::Allocation MemoryAllocator::Allocate(
+	VkMemoryRequirements const& memRequirements,
+	VkMemoryPropertyFlags properties, PoolKind poolKind) {
+	uint32_t memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits,
+		properties);
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+	numRequestsPerType[memoryTypeIndex]++;
+	MemoryPool& pool = pools[memoryTypeIndex * NumPoolKinds + poolKind];
+	if (memRequirements.size > pool.blockSize / 2) {
+		return AllocateDedicated(memRequirements.size, memoryTypeIndex);
+	}
+
+	VkDeviceSize offset = 0;
+	MemoryBlock* foundBlock = nullptr;
+	for (auto block : pool.blocks) {
+		bool allocated = pool.isLinear ?
+			AllocateFromLinearBlock(block, memRequirements.size,
+				memRequirements.alignment, offset) :
+			AllocateFromBuddyBlock(block, memRequirements.size,
+				memRequirements.alignment, offset);
+		if (allocated) {
+			foundBlock = block;
+			break;
+		}
+	}
+
+	if (foundBlock == nullptr) {
+		foundBlock = CreateBlock(pool);
+		bool allocated = pool.isLinear ?
+			AllocateFromLinearBlock(foundBlock, memRequirements.size,
+				memRequirements.alignment, offset) :
+			AllocateFromBuddyBlock(foundBlock, memRequirements.size,
+				memRequirements.alignment, offset);
+		if (!allocated) {
+			throw std::runtime_error("Failed to sub-allocate device memory!");
+		}
+	}
+	foundBlock->numAllocations++;
+	foundBlock->usedBytes += memRequirements.size;
+
+	Allocation allocation;
+	allocation.memory = foundBlock->memory;
+	allocation.offset = offset;
+	allocation.size = memRequirements.size;
+	allocation.mappedData = foundBlock->mappedData != nullptr ?
+		foundBlock->mappedData + offset : nullptr;
+	allocation.memoryTypeIndex = memoryTypeIndex;
+	allocation.block = foundBlock;
+	return allocation;
+}
+
+MemoryAllocator::Allocation MemoryAllocator::AllocateDedicated(VkDeviceSize size,
+	uint32_t memoryTypeIndex) {
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	Allocation allocation;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &allocation.memory)
+		!= VK_SUCCESS) {
+		throw std::runtime_error("Failed to allocate dedicated device memory!");
+	}
+	numDeviceMemoryAllocationsPerType[memoryTypeIndex]++;
+	allocation.offset = 0;
+	allocation.size = size;
+	allocation.memoryTypeIndex = memoryTypeIndex;
+	if ((memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags &
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) {
+		if (vkMapMemory(device, allocation.memory, 0, VK_WHOLE_SIZE, 0,
+			&allocation.mappedData) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to map dedicated device memory!");
+		}
+	}
+
+	numDedicatedAllocationsPerType[memoryTypeIndex]++;
+	dedicatedBytesPerType[memoryTypeIndex] += size;
+	return allocation;
+}
+
+MemoryAllocator::MemoryBlock* MemoryAllocator::CreateBlock(MemoryPool& pool) {
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = pool.blockSize;
+	allocInfo.memoryTypeIndex = pool.memoryTypeIndex;
+
+	VkDeviceMemory memory;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to allocate device memory block!");
+	}
+	numDeviceMemoryAllocationsPerType[pool.memoryTypeIndex]++;
+
+	MemoryBlock* block = new MemoryBlock();
+	block->pool = &pool;
+	block->memory = memory;
+	block->mappedData = nullptr;
+	block->numAllocations = 0;
+	block->usedBytes = 0;
+	block->linearOffset = 0;
+	if (pool.isHostVisible) {
+		void* data;
+		if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &data)
+			!= VK_SUCCESS) {
+			throw std::runtime_error("Failed to map device memory block!");
+		}
+		block->mappedData = (char*)data;
+	}
+
+	if (!pool.isLinear) {
+		// the whole block starts out as one free chunk of the highest order
+		uint32_t numOrders = 1;
+		while ((minChunkSize << (numOrders - 1)) < pool.blockSize) {
+			numOrders++;
+		}
+		block->freeChunks.resize(numOrders);
+		block->freeChunks[numOrders - 1].insert(0);
+	}
+
+	pool.blocks.push_back(block);
+	return block;
+}
+
+void MemoryAllocator::DestroyBlock(MemoryBlock* block) {
+	if (block->mappedData != nullptr) {
+		vkUnmapMemory(device, block->memory);
+	}
+	vkFreeMemory(device, block->memory, nullptr);
+	delete block;
+}
+
+bool MemoryAllocator::AllocateFromBuddyBlock(MemoryBlock* block, VkDeviceSize size,
+	VkDeviceSize alignment, VkDeviceSize& offset) {
+	// chunks are aligned to their own size, so asking for a chunk at least
+	// as big as the alignment takes care of it
+	VkDeviceSize chunkSize = std::max(std::max(size, alignment), minChunkSize);
+	uint32_t order = 0;
+	while ((minChunkSize << order) < chunkSize) {
+		order++;
+	}
+	uint32_t numOrders = (uint32_t)block->freeChunks.size();
+	if (order >= numOrders) {
+		return false;
+	}
+
+	uint32_t foundOrder = order;
+	while (foundOrder < numOrders && block->freeChunks[foundOrder].empty()) {
+		foundOrder++;
+	}
+	if (foundOrder == numOrders) {
+		return false;
+	}
+
+	auto& foundChunks = block->freeChunks[foundOrder];
+	offset = *foundChunks.begin();
+	foundChunks.erase(foundChunks.begin());
+	// split until we have the size we want; upper halves become free
+	while (foundOrder > order) {
+		foundOrder--;
+		block->freeChunks[foundOrder].insert(offset + (minChunkSize << foundOrder));
+	}
+	block->allocatedOrders[offset] = order;
+	return true;
+}
+
+void MemoryAllocator::FreeFromBuddyBlock(MemoryBlock* block, VkDeviceSize offset) {
+	auto allocatedIt = block->allocatedOrders.find(offset);
+	if (allocatedIt == block->allocatedOrders.end()) {
+		throw std::runtime_error("Freeing memory that was not allocated!");
+	}
+	uint32_t order = allocatedIt->second;
+	block->allocatedOrders.erase(allocatedIt);
+
+	// merge with our buddy for as long as it's free
+	uint32_t numOrders = (uint32_t)block->freeChunks.size();
+	while (order + 1 < numOrders) {
+		VkDeviceSize buddyOffset = offset ^ (minChunkSize << order);
+		auto& freeChunksOfOrder = block->freeChunks[order];
+		auto buddyIt = freeChunksOfOrder.find(buddyOffset);
+		if (buddyIt == freeChunksOfOrder.end()) {
+			break;
+		}
+		freeChunksOfOrder.erase(buddyIt);
+		offset = std::min(offset, buddyOffset);
+		order++;
+	}
+	block->freeChunks[order].insert(offset);
+}
+
+bool MemoryAllocator::AllocateFromLinearBlock(MemoryBlock* block, VkDeviceSize size,
+	VkDeviceSize alignment, VkDeviceSize& offset) {
+	VkDeviceSize alignedOffset = (block->linearOffset + alignment - 1) &
+		~(alignment - 1);
+	if (alignedOffset + size > block->pool->blockSize) {
+		return false;
+	}
+	offset = alignedOffset;
+	block->linearOffset = alignedOffset + size;
+	return true;
+}
+
+void MemoryAllocator::FreeFromLinearBlock(MemoryBlock* block, VkDeviceSize offset,
+	VkDeviceSize size) {
+	// the newest allocation can be rolled back. anything else comes
+	// back once the block is empty
+	if (offset + size == block->linearOffset) {
+		block->linearOffset = offset;
+	}
+}
+
+void MemoryAllocator::AddBlockStatistics(MemoryBlock* block,
+	Statistics& stats) const {
+	MemoryPool* pool = block->pool;
+	stats.numBlocks++;
+	stats.blockBytes += pool->blockSize;
+	stats.numAllocations += block->numAllocations;
+	stats.usedBytes += block->usedBytes;
+
+	if (pool->isLinear) {
+		VkDeviceSize freeBytes = pool->blockSize - block->linearOffset;
+		stats.freeBytes += freeBytes;
+		stats.largestFreeRange = std::max(stats.largestFreeRange, freeBytes);
+		return;
+	}
+
+	uint32_t numOrders = (uint32_t)block->freeChunks.size();
+	for (uint32_t order = 0; order < numOrders; order++) {
+		VkDeviceSize chunkSize = minChunkSize << order;
+		size_t numFreeChunks = block->freeChunks[order].size();
+		stats.freeBytes += chunkSize * numFreeChunks;
+		if (numFreeChunks > 0) {
+			stats.largestFreeRange = std::max(stats.largestFreeRange, chunkSize);
+		}
+	}
+}
+
+std::vector<MemoryAllocator::Statistics> MemoryAllocator::GetStatisticsPerMemoryType() {
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+	std::vector<Statistics> statsPerType(memoryProperties.memoryTypeCount);
+	for (auto& pool : pools) {
+		for (auto block : pool.blocks) {
+			AddBlockStatistics(block, statsPerType[pool.memoryTypeIndex]);
+		}
+	}
+	for (uint32_t typeIndex = 0; typeIndex < memoryProperties.memoryTypeCount;
+		typeIndex++) {
+		statsPerType[typeIndex].numDedicatedAllocations =
+			numDedicatedAllocationsPerType[typeIndex];
+		statsPerType[typeIndex].dedicatedBytes = dedicatedBytesPerType[typeIndex];
+		statsPerType[typeIndex].numRequests = numRequestsPerType[typeIndex];
+		statsPerType[typeIndex].numDeviceMemoryAllocations =
+			numDeviceMemoryAllocationsPerType[typeIndex];
+	}
+	return statsPerType;
+}
+
+MemoryAllocator::Statistics MemoryAllocator::GetStatistics() {
+	Statistics totalStats;
+	for (auto const& stats : GetStatisticsPerMemoryType()) {
+		totalStats.numBlocks += stats.numBlocks;
+		totalStats.numDedicatedAllocations += stats.numDedicatedAllocations;
+		totalStats.numAllocations += stats.numAllocations;
+		totalStats.blockBytes += stats.blockBytes;
+		totalStats.usedBytes += stats.usedBytes;
+		totalStats.freeBytes += stats.freeBytes;
+		totalStats.largestFreeRange = std::max(totalStats.largestFreeRange,
+			stats.largestFreeRange);
+		totalStats.dedicatedBytes += stats.dedicatedBytes;
+		totalStats.numRequests += stats.numRequests;
+		totalStats.numDeviceMemoryAllocations +=
+			stats.numDeviceMemoryAllocations;
+	}
+	return totalStats;
+}
+
+void MemoryAllocator::PrintStatistics() {
+	auto statsPerType = GetStatisticsPerMemoryType();
+	std::cout << "Device memory usage:\n";
+	for (size_t typeIndex = 0; typeIndex < statsPerType.size(); typeIndex++) {
+		auto const& stats = statsPerType[typeIndex];
+		if (stats.numBlocks == 0 && stats.numDedicatedAllocations == 0) {
+			continue;
+		}
+		std::cout << "  memory type " << typeIndex << ": "
+			<< stats.numAllocations << " allocations in " << stats.numBlocks
+			<< " blocks, " << stats.usedBytes / 1024 << " of "
+			<< stats.blockBytes / 1024 << " KB used, "
+			<< stats.GetFragmentation() * 100.0f << "% fragmented, "
+			<< stats.numDedicatedAllocations << " dedicated allocations ("
+			<< stats.dedicatedBytes / 1024 << " KB)\n";
+	}
+}
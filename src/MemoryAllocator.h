@@ -0,0 +1,131 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <mutex>
+
+// Hands out device memory from large blocks, so that we don't call
+// vkAllocateMemory for every buffer and image. Each memory type gets a
+// buddy-allocated pool for buffers, another for images (so we never have to
+// worry about bufferImageGranularity), and a linear pool for short-lived
+// buffers like staging. Allocations that are too big for a block get their
+// own VkDeviceMemory.
+class MemoryAllocator {
+public:
+	enum class AllocationLifetime : char { Persistent = 0, Transient };
+
+	struct MemoryBlock;
+
+	struct Allocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		// host-visible memory stays mapped, so this is set for those
+		void* mappedData = nullptr;
+		uint32_t memoryTypeIndex = 0;
+		// null if the allocation has its own memory
+		MemoryBlock* block = nullptr;
+	};
+
+	struct Statistics {
+		size_t numBlocks = 0;
+		size_t numDedicatedAllocations = 0;
+		// these are only for allocations that live in blocks
+		size_t numAllocations = 0;
+		VkDeviceSize blockBytes = 0;
+		VkDeviceSize usedBytes = 0;
+		VkDeviceSize freeBytes = 0;
+		VkDeviceSize largestFreeRange = 0;
+		VkDeviceSize dedicatedBytes = 0;
+		// running totals since the allocator was created. each request is
+		// for a buffer or image the caller just created with vkCreate*
+		uint64_t numRequests = 0;
+		uint64_t numDeviceMemoryAllocations = 0;
+
+		// zero when all free space in blocks is contiguous, close to
+		// one when it is scattered in small ranges
+		float GetFragmentation() const {
+			return freeBytes == 0 ? 0.0f :
+				1.0f - (float)largestFreeRange / (float)freeBytes;
+		}
+	};
+
+	MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+	~MemoryAllocator();
+
+	// allocates and binds memory for the resource
+	Allocation AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties,
+		AllocationLifetime lifetime = AllocationLifetime::Persistent);
+	Allocation AllocateForImage(VkImage image, VkMemoryPropertyFlags properties);
+
+	void Free(Allocation& allocation);
+
+	Statistics GetStatistics();
+	// per memory type
+	std::vector<Statistics> GetStatisticsPerMemoryType();
+	void PrintStatistics();
+
+	struct MemoryPool {
+		uint32_t memoryTypeIndex;
+		bool isLinear;
+		bool isHostVisible;
+		VkDeviceSize blockSize;
+		std::vector<MemoryBlock*> blocks;
+	};
+
+	struct MemoryBlock {
+		MemoryPool* pool;
+		VkDeviceMemory memory;
+		char* mappedData;
+		size_t numAllocations;
+		VkDeviceSize usedBytes;
+
+		// buddy pools: offsets of free chunks per order, and orders of
+		// allocated chunks by offset
+		std::vector<std::set<VkDeviceSize>> freeChunks;
+		std::unordered_map<VkDeviceSize, uint32_t> allocatedOrders;
+
+		// linear pools
+		VkDeviceSize linearOffset;
+	};
+
+private:
+	enum PoolKind { BufferPool = 0, ImagePool, LinearPool, NumPoolKinds };
+
+	VkDevice device;
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	std::vector<MemoryPool> pools;
+	std::mutex allocatorMutex;
+
+	std::vector<size_t> numDedicatedAllocationsPerType;
+	std::vector<VkDeviceSize> dedicatedBytesPerType;
+	std::vector<uint64_t> numRequestsPerType;
+	// calls to vkAllocateMemory, for blocks and dedicated allocations
+	std::vector<uint64_t> numDeviceMemoryAllocationsPerType;
+
+	static const VkDeviceSize maxBlockSize;
+	static const VkDeviceSize minBlockSize;
+	static const VkDeviceSize minChunkSize;
+
+	uint32_t FindMemoryType(uint32_t typeFilter,
+		VkMemoryPropertyFlags properties) const;
+
+	Allocation Allocate(VkMemoryRequirements const& memRequirements,
+		VkMemoryPropertyFlags properties, PoolKind poolKind);
+	Allocation AllocateDedicated(VkDeviceSize size, uint32_t memoryTypeIndex);
+
+	MemoryBlock* CreateBlock(MemoryPool& pool);
+	void DestroyBlock(MemoryBlock* block);
+
+	bool AllocateFromBuddyBlock(MemoryBlock* block, VkDeviceSize size,
+		VkDeviceSize alignment, VkDeviceSize& offset);
+	void FreeFromBuddyBlock(MemoryBlock* block, VkDeviceSize offset);
+	bool AllocateFromLinearBlock(MemoryBlock* block, VkDeviceSize size,
+		VkDeviceSize alignment, VkDeviceSize& offset);
+	void FreeFromLinearBlock(MemoryBlock* block, VkDeviceSize offset,
+		VkDeviceSize size);
+
+	void AddBlockStatistics(MemoryBlock* block, Statistics& stats) const;
+};
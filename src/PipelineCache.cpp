@@ -0,0 +1,148 @@
+#include "PipelineCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+// "VKPC"
+const uint32_t PipelineCache::fileMagic = 0x43504b56;
+const uint32_t PipelineCache::fileVersion = 1;
+
+PipelineCache::PipelineCache(VkDevice device, VkPhysicalDevice physicalDevice,
+	std::string const& cachePath) : device(device), cachePath(cachePath) {
+	vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+	std::vector<char> cacheData = LoadCacheData();
+	VkPipelineCacheCreateInfo cacheInfo = {};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.initialDataSize = cacheData.size();
+	cacheInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+	VkResult result = vkCreatePipelineCache(device, &cacheInfo, nullptr,
+		&pipelineCache);
+	if (result != VK_SUCCESS && !cacheData.empty()) {
+		// the driver can still reject data that passed our checks
+		std::cout << "Pipeline cache data rejected by driver; starting empty.\n";
+		cacheInfo.initialDataSize = 0;
+		cacheInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(device, &cacheInfo, nullptr,
+			&pipelineCache);
+	}
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create pipeline cache!");
+	}
+}
+
+PipelineCache::~PipelineCache() {
+	Save();
+	vkDestroyPipelineCache(device, pipelineCache, nullptr);
+}
+
+void PipelineCache::Save() {
+	size_t dataSize = 0;
+	if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr) !=
+		VK_SUCCESS || dataSize == 0) {
+		return;
+	}
+	std::vector<char> data(dataSize);
+	if (vkGetPipelineCacheData(device, pipelineCache, &dataSize,
+		data.data()) != VK_SUCCESS) {
+		std::cerr << "Could not read pipeline cache data.\n";
+		return;
+	}
+	data.resize(dataSize);
+
+	// written next to the old file and moved over it, so a crash halfway
+	// through doesn't leave a broken cache behind
+	std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			std::cerr << "Could not open " << tempPath << " for writing.\n";
+			return;
+		}
+		FileHeader header = CreateHeader(data);
+		file.write((char const*)&header, sizeof(header));
+		file.write(data.data(), (std::streamsize)data.size());
+		if (!file) {
+			std::cerr << "Could not write pipeline cache to " << tempPath << ".\n";
+			return;
+		}
+	}
+	std::remove(cachePath.c_str());
+	if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+		std::cerr << "Could not move pipeline cache to " << cachePath << ".\n";
+		return;
+	}
+	std::cout << "Saved pipeline cache, " << data.size() << " bytes.\n";
+}
+
+std::vector<char> PipelineCache::LoadCacheData() {
+	std::ifstream file(cachePath, std::ios::binary | std::ios::ate);
+	if (!file) {
+		std::cout << "No pipeline cache at " << cachePath << ".\n";
+		return std::vector<char>();
+	}
+
+	uint64_t fileSize = (uint64_t)file.tellg();
+	file.seekg(0);
+	FileHeader header;
+	if (!file.read((char*)&header, sizeof(header)) ||
+		header.dataSize != fileSize - sizeof(header)) {
+		std::cout << "Pipeline cache file is truncated; ignoring it.\n";
+		return std::vector<char>();
+	}
+
+	// a different driver or GPU might not understand the data, or worse,
+	// misread it
+	FileHeader expectedHeader = CreateHeader(std::vector<char>());
+	if (header.magic != fileMagic || header.fileVersion != fileVersion) {
+		std::cout << "Pipeline cache file has an unknown format; ignoring it.\n";
+		return std::vector<char>();
+	}
+	if (header.vendorID != expectedHeader.vendorID ||
+		header.deviceID != expectedHeader.deviceID ||
+		header.driverVersion != expectedHeader.driverVersion ||
+		memcmp(header.pipelineCacheUUID, expectedHeader.pipelineCacheUUID,
+			VK_UUID_SIZE) != 0) {
+		std::cout << "Pipeline cache is from another device or driver; "
+			<< "ignoring it.\n";
+		return std::vector<char>();
+	}
+
+	std::vector<char> data((size_t)header.dataSize);
+	if (!file.read(data.data(), (std::streamsize)data.size()) ||
+		HashData(data) != header.dataHash) {
+		std::cout << "Pipeline cache data is corrupt; ignoring it.\n";
+		return std::vector<char>();
+	}
+
+	std::cout << "Loaded pipeline cache, " << data.size() << " bytes.\n";
+	return data;
+}
+
+PipelineCache::FileHeader PipelineCache::CreateHeader(
+	std::vector<char> const& data) const {
+	FileHeader header = {};
+	header.magic = fileMagic;
+	header.fileVersion = fileVersion;
+	header.vendorID = deviceProperties.vendorID;
+	header.deviceID = deviceProperties.deviceID;
+	header.driverVersion = deviceProperties.driverVersion;
+	memcpy(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID,
+		VK_UUID_SIZE);
+	header.dataSize = data.size();
+	header.dataHash = HashData(data);
+	return header;
+}
+
+uint64_t PipelineCache::HashData(std::vector<char> const& data) {
+	// FNV-1a; only meant to catch truncated or damaged files
+	uint64_t hash = 14695981039346656037ull;
+	for (char byte : data) {
+		hash ^= (uint8_t)byte;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
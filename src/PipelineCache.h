@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// VkPipelineCache shared by every pipeline the game creates, so pipelines
+// rebuilt on swapchain recreation come out of the cache. Its contents are
+// written to disk on shutdown and loaded at boot. The file is only used if
+// it was written by the same device and driver.
+class PipelineCache {
+public:
+	PipelineCache(VkDevice device, VkPhysicalDevice physicalDevice,
+		std::string const& cachePath);
+	// saves the cache before destroying it
+	~PipelineCache();
+
+	VkPipelineCache GetPipelineCache() {
+		return pipelineCache;
+	}
+
+	void Save();
+
+private:
+	// goes ahead of the driver's data in the file
+	struct FileHeader {
+		uint32_t magic;
+		uint32_t fileVersion;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+		uint64_t dataHash;
+	};
+
+	VkDevice device;
+	VkPhysicalDeviceProperties deviceProperties;
+	std::string cachePath;
+	VkPipelineCache pipelineCache;
+
+	static const uint32_t fileMagic;
+	static const uint32_t fileVersion;
+
+	// empty if there's no file, or it can't be used with this device
+	std::vector<char> LoadCacheData();
+	FileHeader CreateHeader(std::vector<char> const& data) const;
+	static uint64_t HashData(std::vector<char> const& data);
+};
@@ -3,8 +3,8 @@
 #include <stdexcept>
 
 CommandBufferModule::CommandBufferModule(size_t numBuffers,
-	VkDevice logicalDevice, VkCommandPoolCreateInfo poolInfo) {
-	commandBuffers.resize(numBuffers);
+	VkDevice logicalDevice, VkCommandPoolCreateInfo poolInfo,
+	VkCommandBufferLevel level) : level(level), numCommandBuffersUsed(0) {
 	if (vkCreateCommandPool(logicalDevice, &poolInfo, nullptr,
 		&commandPool) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to create command pool!");
@@ -12,22 +12,48 @@ CommandBufferModule::CommandBufferModule(size_t numBuffers,
 
 	this->logicalDevice = logicalDevice;
 
+	AllocateCommandBuffers(numBuffers);
+}
+
+CommandBufferModule::~CommandBufferModule() {
+	if (!commandBuffers.empty()) {
+		vkFreeCommandBuffers(logicalDevice, commandPool,
+			static_cast<uint32_t>(commandBuffers.size()),
+			commandBuffers.data());
+	}
+	vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
+}
+
+VkCommandBuffer CommandBufferModule::GetNextCommandBuffer() {
+	if (numCommandBuffersUsed == commandBuffers.size()) {
+		// grow a few at a time
+		AllocateCommandBuffers(commandBuffers.empty() ? 4 : commandBuffers.size());
+	}
+	return commandBuffers[numCommandBuffersUsed++];
+}
+
+void CommandBufferModule::Reset() {
+	if (vkResetCommandPool(logicalDevice, commandPool, 0) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to reset command pool!");
+	}
+	numCommandBuffersUsed = 0;
+}
+
+void CommandBufferModule::AllocateCommandBuffers(size_t numBuffers) {
+	if (numBuffers == 0) {
+		return;
+	}
+	size_t firstNewBuffer = commandBuffers.size();
+	commandBuffers.resize(firstNewBuffer + numBuffers);
+
 	VkCommandBufferAllocateInfo allocInfo = {};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	allocInfo.commandPool = commandPool;
-	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+	allocInfo.level = level;
+	allocInfo.commandBufferCount = (uint32_t)numBuffers;
 
-	if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, commandBuffers.data())
-		!= VK_SUCCESS) {
+	if (vkAllocateCommandBuffers(logicalDevice, &allocInfo,
+		commandBuffers.data() + firstNewBuffer) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to allocate command buffers!");
 	}
 }
-
-CommandBufferModule::~CommandBufferModule() {
-	vkFreeCommandBuffers(logicalDevice, commandPool,
-		static_cast<uint32_t>(commandBuffers.size()),
-		commandBuffers.data());
-	vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
-}
-
@@ -6,16 +6,28 @@
 class CommandBufferModule {
 public:
 	CommandBufferModule(size_t numBuffers,
-		VkDevice logicalDevice, VkCommandPoolCreateInfo poolInfo);
+		VkDevice logicalDevice, VkCommandPoolCreateInfo poolInfo,
+		VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 	~CommandBufferModule();
 
 	std::vector<VkCommandBuffer>& GetCommandBuffers() {
 		return commandBuffers;
 	}
 
+	// hands out command buffers in order, allocating more when the ones
+	// we have run out. none of them can be pending execution
+	VkCommandBuffer GetNextCommandBuffer();
+	// resets the pool and every buffer allocated from it in one go, and
+	// starts handing out buffers from the beginning again
+	void Reset();
+
 private:
 	VkDevice logicalDevice;
 
 	std::vector<VkCommandBuffer> commandBuffers;
 	VkCommandPool commandPool;
+	VkCommandBufferLevel level;
+	size_t numCommandBuffersUsed;
+
+	void AllocateCommandBuffers(size_t numBuffers);
 };
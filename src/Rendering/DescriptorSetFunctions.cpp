@@ -127,7 +127,7 @@ VkDescriptorSetLayout DescriptorSetFunctions::CreateTextDescriptorSetLayout(VkDe
 	VkDescriptorSetLayoutBinding uboLayoutBinding = {};
 	uboLayoutBinding.binding = 0;
 	uboLayoutBinding.descriptorCount = 1;
-	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	uboLayoutBinding.pImmutableSamplers = nullptr;
 	uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -141,7 +141,7 @@ VkDescriptorSetLayout DescriptorSetFunctions::CreateTextDescriptorSetLayout(VkDe
 	VkDescriptorSetLayoutBinding uboLayoutBindingFrag = {};
 	uboLayoutBindingFrag.binding = 2;
 	uboLayoutBindingFrag.descriptorCount = 1;
-	uboLayoutBindingFrag.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBindingFrag.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	uboLayoutBindingFrag.pImmutableSamplers = nullptr;
 	uboLayoutBindingFrag.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
@@ -176,7 +176,7 @@ void DescriptorSetFunctions::UpdateDescriptorSetText(VkDevice device,
 	descriptorWrites[0].dstSet = descriptorSet;
 	descriptorWrites[0].dstBinding = 0;
 	descriptorWrites[0].dstArrayElement = 0;
-	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	descriptorWrites[0].descriptorCount = 1;
 	descriptorWrites[0].pBufferInfo = bufferInfoVert;
 
@@ -197,7 +197,7 @@ void DescriptorSetFunctions::UpdateDescriptorSetText(VkDevice device,
 	descriptorWrites[2].dstSet = descriptorSet;
 	descriptorWrites[2].dstBinding = 2;
 	descriptorWrites[2].dstArrayElement = 0;
-	descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	descriptorWrites[2].descriptorCount = 1;
 	descriptorWrites[2].pBufferInfo = bufferInfoFrag;
 
@@ -208,11 +208,11 @@ void DescriptorSetFunctions::UpdateDescriptorSetText(VkDevice device,
 VkDescriptorPool DescriptorSetFunctions::CreateDescriptorPoolText(VkDevice device,
 	size_t numSwapChainImages) {
 	std::array<VkDescriptorPoolSize, 3> poolSizes = {};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	poolSizes[0].descriptorCount = static_cast<uint32_t>(numSwapChainImages);
 	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	poolSizes[1].descriptorCount = static_cast<uint32_t>(numSwapChainImages);
-	poolSizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	poolSizes[2].descriptorCount = static_cast<uint32_t>(numSwapChainImages);
 
 	VkDescriptorPoolCreateInfo poolInfo = {};
@@ -234,14 +234,14 @@ VkDescriptorSetLayout DescriptorSetFunctions::CreateUnlitColorDescriptorSetLayou
 	VkDescriptorSetLayoutBinding uboLayoutBinding = {};
 	uboLayoutBinding.binding = 0;
 	uboLayoutBinding.descriptorCount = 1;
-	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	uboLayoutBinding.pImmutableSamplers = nullptr;
 	uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
 	VkDescriptorSetLayoutBinding uboLayoutBindingFrag = {};
 	uboLayoutBindingFrag.binding = 1;
 	uboLayoutBindingFrag.descriptorCount = 1;
-	uboLayoutBindingFrag.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBindingFrag.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	uboLayoutBindingFrag.pImmutableSamplers = nullptr;
 	uboLayoutBindingFrag.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
@@ -272,7 +272,7 @@ void DescriptorSetFunctions::UpdateDescriptorSetUnlitColor(VkDevice device,
 	descriptorWrites[0].dstSet = descriptorSet;
 	descriptorWrites[0].dstBinding = 0;
 	descriptorWrites[0].dstArrayElement = 0;
-	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	descriptorWrites[0].descriptorCount = 1;
 	descriptorWrites[0].pBufferInfo = bufferInfoVert;
 
@@ -280,7 +280,7 @@ void DescriptorSetFunctions::UpdateDescriptorSetUnlitColor(VkDevice device,
 	descriptorWrites[1].dstSet = descriptorSet;
 	descriptorWrites[1].dstBinding = 1;
 	descriptorWrites[1].dstArrayElement = 0;
-	descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	descriptorWrites[1].descriptorCount = 1;
 	descriptorWrites[1].pBufferInfo = bufferInfoFrag;
 
@@ -292,9 +292,9 @@ VkDescriptorPool DescriptorSetFunctions::CreateDescriptorPoolUnlitColor(
 	VkDevice device,
 	size_t numSwapChainImages) {
 	std::array<VkDescriptorPoolSize, 2> poolSizes = {};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	poolSizes[0].descriptorCount = static_cast<uint32_t>(numSwapChainImages);
-	poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	poolSizes[1].descriptorCount = static_cast<uint32_t>(numSwapChainImages);
 
 	VkDescriptorPoolCreateInfo poolInfo = {};
@@ -316,7 +316,7 @@ VkDescriptorSetLayout DescriptorSetFunctions::
 	VkDescriptorSetLayoutBinding uboLayoutBinding = {};
 	uboLayoutBinding.binding = 0;
 	uboLayoutBinding.descriptorCount = 1;
-	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	uboLayoutBinding.pImmutableSamplers = nullptr;
 	uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 	
@@ -357,7 +357,7 @@ void DescriptorSetFunctions::UpdateDescriptorSetUnlitTintedTextured(VkDevice dev
 	descriptorWrites[0].dstSet = descriptorSet;
 	descriptorWrites[0].dstBinding = 0;
 	descriptorWrites[0].dstArrayElement = 0;
-	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	descriptorWrites[0].descriptorCount = 1;
 	descriptorWrites[0].pBufferInfo = bufferInfoVert;
 
@@ -377,7 +377,7 @@ void DescriptorSetFunctions::UpdateDescriptorSetUnlitTintedTextured(VkDevice dev
 VkDescriptorPool DescriptorSetFunctions::CreateDescriptorPoolUnlitTintedTextured(VkDevice device,
    size_t numSwapChainImages) {
 	std::array<VkDescriptorPoolSize, 2> poolSizes = {};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	poolSizes[0].descriptorCount = static_cast<uint32_t>(numSwapChainImages);
 	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	poolSizes[1].descriptorCount = static_cast<uint32_t>(numSwapChainImages);
@@ -402,7 +402,7 @@ VkDescriptorSetLayout DescriptorSetFunctions::
 	VkDescriptorSetLayoutBinding uboLayoutBindingVertexShader = {};
 	uboLayoutBindingVertexShader.binding = 0;
 	uboLayoutBindingVertexShader.descriptorCount = 1;
-	uboLayoutBindingVertexShader.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBindingVertexShader.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	uboLayoutBindingVertexShader.pImmutableSamplers = nullptr;
 	uboLayoutBindingVertexShader.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 	
@@ -443,7 +443,7 @@ void DescriptorSetFunctions::UpdateDescriptorSetWavySurface(VkDevice device,
 	descriptorWrites[0].dstSet = descriptorSet;
 	descriptorWrites[0].dstBinding = 0;
 	descriptorWrites[0].dstArrayElement = 0;
-	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	descriptorWrites[0].descriptorCount = 1;
 	descriptorWrites[0].pBufferInfo = bufferInfoVert;
 	
@@ -461,7 +461,7 @@ void DescriptorSetFunctions::UpdateDescriptorSetWavySurface(VkDevice device,
 VkDescriptorPool DescriptorSetFunctions::CreateDescriptorPoolWavySurface(
 						VkDevice device, size_t numSwapChainImages) {
 	std::array<VkDescriptorPoolSize, 2> poolSizes = {};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	poolSizes[0].descriptorCount = static_cast<uint32_t>(numSwapChainImages);
 	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	poolSizes[1].descriptorCount = static_cast<uint32_t>(numSwapChainImages);
@@ -485,7 +485,7 @@ VkDescriptorSetLayout DescriptorSetFunctions::CreateBumpySurfaceDescriptorSetLay
 	VkDescriptorSetLayoutBinding uboLayoutBindingVertexShader = {};
 	uboLayoutBindingVertexShader.binding = 0;
 	uboLayoutBindingVertexShader.descriptorCount = 1;
-	uboLayoutBindingVertexShader.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBindingVertexShader.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	uboLayoutBindingVertexShader.pImmutableSamplers = nullptr;
 	uboLayoutBindingVertexShader.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -526,7 +526,7 @@ void DescriptorSetFunctions::UpdateDescriptorSetBumpySurface(VkDevice device,
 	descriptorWrites[0].dstSet = descriptorSet;
 	descriptorWrites[0].dstBinding = 0;
 	descriptorWrites[0].dstArrayElement = 0;
-	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	descriptorWrites[0].descriptorCount = 1;
 	descriptorWrites[0].pBufferInfo = bufferInfoVert;
 
@@ -544,7 +544,7 @@ void DescriptorSetFunctions::UpdateDescriptorSetBumpySurface(VkDevice device,
 VkDescriptorPool DescriptorSetFunctions::CreateDescriptorPoolBumpySurface(
 	VkDevice device, size_t numSwapChainImages) {
 	std::array<VkDescriptorPoolSize, 2> poolSizes = {};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	poolSizes[0].descriptorCount = static_cast<uint32_t>(numSwapChainImages);
 	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	poolSizes[1].descriptorCount = static_cast<uint32_t>(numSwapChainImages);
@@ -0,0 +1,92 @@
+#include "FrustumCuller.h"
+#include "GameObjects/GameObject.h"
+#include "Math/Frustum.h"
+
+// big enough to pass every plane, small enough not to overflow once
+// it's multiplied by a plane normal
+static const float infiniteExtent = 1e30f;
+
+size_t FrustumCuller::CullGameObjects(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+	glm::mat4 const& viewProjection) {
+	gameObjectsToTest.clear();
+	centersX.clear();
+	centersY.clear();
+	centersZ.clear();
+	extentsX.clear();
+	extentsY.clear();
+	extentsZ.clear();
+	for (auto const& gameObject : gameObjects) {
+		AddSubtree(gameObject.get());
+	}
+
+	size_t numGameObjects = gameObjectsToTest.size();
+	visibilities.resize(numGameObjects);
+	Frustum frustum(viewProjection);
+	frustum.TestBoxes(centersX.data(), centersY.data(), centersZ.data(),
+		extentsX.data(), extentsY.data(), extentsZ.data(), numGameObjects,
+		visibilities.data());
+
+	size_t numCulled = 0;
+	for (size_t i = 0; i < numGameObjects; i++) {
+		bool culled = visibilities[i] == 0;
+		gameObjectsToTest[i]->SetCulled(culled);
+		if (culled) {
+			numCulled++;
+		}
+	}
+	return numCulled;
+}
+
+void FrustumCuller::ClearCulledFlags(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects) {
+	for (auto const& gameObject : gameObjects) {
+		gameObject->SetCulled(false);
+		ClearCulledFlags(gameObject->GetChildren());
+	}
+}
+
+AABB FrustumCuller::AddSubtree(GameObject* gameObject) {
+	size_t index = gameObjectsToTest.size();
+	gameObjectsToTest.push_back(gameObject);
+	centersX.push_back(0.0f);
+	centersY.push_back(0.0f);
+	centersZ.push_back(0.0f);
+	extentsX.push_back(infiniteExtent);
+	extentsY.push_back(infiniteExtent);
+	extentsZ.push_back(infiniteExtent);
+
+	AABB subtreeBounds = gameObject->GetWorldBounds();
+	// something that draws without bounds can't be culled, and neither
+	// can anything above it
+	bool infiniteBounds = subtreeBounds.IsEmpty() &&
+		!gameObject->IsInvisible();
+	for (auto const& child : gameObject->GetChildren()) {
+		AABB childBounds = AddSubtree(child.get());
+		if (childBounds.IsEmpty()) {
+			continue;
+		}
+		if (childBounds.GetExtents().x >= infiniteExtent) {
+			infiniteBounds = true;
+		}
+		subtreeBounds.Merge(childBounds);
+	}
+
+	if (infiniteBounds) {
+		return AABB(glm::vec3(-infiniteExtent), glm::vec3(infiniteExtent));
+	}
+	// nothing to draw, so it's left visible; it costs nothing either way
+	if (subtreeBounds.IsEmpty()) {
+		return subtreeBounds;
+	}
+
+	glm::vec3 center = subtreeBounds.GetCenter();
+	glm::vec3 extents = subtreeBounds.GetExtents();
+	centersX[index] = center.x;
+	centersY[index] = center.y;
+	centersZ[index] = center.z;
+	extentsX[index] = extents.x;
+	extentsY[index] = extents.y;
+	extentsZ[index] = extents.z;
+	return subtreeBounds;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Math/BoundingVolumes.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class GameObject;
+
+// Tests every game object against the view frustum once per frame and
+// flags the ones that are outside. Each object is tested with the bounds
+// of its whole subtree, so when a parent like a turret is culled, draw
+// list construction can skip all of its parts without looking at them.
+class FrustumCuller {
+public:
+	// returns the number of objects flagged as culled
+	size_t CullGameObjects(
+		std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+		glm::mat4 const& viewProjection);
+	// for when culling happens elsewhere, so flags from the last pass
+	// don't hide anything
+	void ClearCulledFlags(
+		std::vector<std::shared_ptr<GameObject>> const& gameObjects);
+
+private:
+	// the scene graph flattened in depth-first order, with each object's
+	// subtree bounds split into one array per component
+	std::vector<GameObject*> gameObjectsToTest;
+	std::vector<float> centersX, centersY, centersZ;
+	std::vector<float> extentsX, extentsY, extentsZ;
+	std::vector<uint8_t> visibilities;
+
+	// returns the bounds of the subtree, which can be infinite
+	AABB AddSubtree(GameObject* gameObject);
+};
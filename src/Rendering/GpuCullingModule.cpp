@@ -0,0 +1,297 @@
+#include "GpuCullingModule.h"
+#include "LogicalDeviceManager.h"
+#include "GfxDeviceManager.h"
+#include "ShaderLoader.h"
+#include "Resources/ResourceLoader.h"
+#include "Math/Frustum.h"
+#include "Common.h"
+#include "Vertex.h"
+#include <array>
+#include <stdexcept>
+
+const uint32_t GpuCullingModule::workGroupSize = 64;
+const size_t GpuCullingModule::minObjectCapacity = 256;
+const size_t GpuCullingModule::minBatchCapacity = 16;
+
+GpuCullingModule::GpuCullingModule(size_t numSwapChainImages,
+	LogicalDeviceManager* logicalDeviceManager,
+	GfxDeviceManager* gfxDeviceManager, ResourceLoader* resourceLoader) :
+	logicalDeviceManager(logicalDeviceManager),
+	gfxDeviceManager(gfxDeviceManager) {
+	frames.resize(numSwapChainImages);
+	CreateDescriptorSets(numSwapChainImages);
+	for (auto& frame : frames) {
+		CreateObjectBuffers(frame, minObjectCapacity);
+		CreateDrawCountBuffer(frame, minBatchCapacity);
+		frame.numObjects = 0;
+		frame.numBatches = 0;
+		UpdateDescriptorSet(frame);
+	}
+	CreatePipeline(resourceLoader);
+}
+
+GpuCullingModule::~GpuCullingModule() {
+	VkDevice device = logicalDeviceManager->GetDevice();
+	for (auto& frame : frames) {
+		DestroyObjectBuffers(frame);
+		DestroyDrawCountBuffer(frame);
+	}
+	vkDestroyPipeline(device, pipeline, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+}
+
+GpuCullingModule::CullObject* GpuCullingModule::BeginFrame(
+	size_t swapChainIndex, size_t numObjects, size_t numBatches,
+	glm::mat4 const& viewProjection) {
+	FrameBuffers& frame = frames[swapChainIndex];
+
+	// double so that steady spawning doesn't resize every time
+	bool buffersChanged = false;
+	if (numObjects > frame.objectCapacity) {
+		size_t newCapacity = frame.objectCapacity;
+		while (newCapacity < numObjects) {
+			newCapacity *= 2;
+		}
+		DestroyObjectBuffers(frame);
+		CreateObjectBuffers(frame, newCapacity);
+		buffersChanged = true;
+	}
+	if (numBatches > frame.batchCapacity) {
+		size_t newCapacity = frame.batchCapacity;
+		while (newCapacity < numBatches) {
+			newCapacity *= 2;
+		}
+		DestroyDrawCountBuffer(frame);
+		CreateDrawCountBuffer(frame, newCapacity);
+		buffersChanged = true;
+	}
+	if (buffersChanged) {
+		UpdateDescriptorSet(frame);
+	}
+
+	frame.numObjects = numObjects;
+	frame.numBatches = numBatches;
+	Frustum frustum(viewProjection);
+	for (size_t i = 0; i < Frustum::numPlanes; i++) {
+		frame.frustumPlanes[i] = frustum.GetPlane(i);
+	}
+	return (CullObject*)frame.objectAllocation.mappedData;
+}
+
+void GpuCullingModule::RecordCulling(VkCommandBuffer commandBuffer,
+	size_t swapChainIndex) {
+	FrameBuffers& frame = frames[swapChainIndex];
+	if (frame.numBatches == 0) {
+		return;
+	}
+
+	vkCmdFillBuffer(commandBuffer, frame.drawCountBuffer, 0,
+		frame.numBatches * sizeof(uint32_t), 0);
+
+	VkMemoryBarrier clearBarrier = {};
+	clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+		VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr,
+		0, nullptr);
+
+	if (frame.numObjects > 0) {
+		CullParameters parameters;
+		for (size_t i = 0; i < Frustum::numPlanes; i++) {
+			parameters.frustumPlanes[i] = frame.frustumPlanes[i];
+		}
+		parameters.numObjects = (uint32_t)frame.numObjects;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+			pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+			pipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipelineLayout,
+			VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullParameters), &parameters);
+		vkCmdDispatch(commandBuffer, ((uint32_t)frame.numObjects +
+			workGroupSize - 1) / workGroupSize, 1, 1);
+	}
+
+	// draws read the commands and counts, and the instance data as
+	// vertex input
+	VkMemoryBarrier cullBarrier = {};
+	cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+		VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &cullBarrier, 0, nullptr,
+		0, nullptr);
+}
+
+void GpuCullingModule::CreateDescriptorSets(size_t numSwapChainImages) {
+	VkDevice device = logicalDeviceManager->GetDevice();
+
+	// objects, instances, draw commands, draw counts
+	std::array<VkDescriptorSetLayoutBinding, 4> bindings = {};
+	for (uint32_t i = 0; i < (uint32_t)bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorCount = 1;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].pImmutableSamplers = nullptr;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+	if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr,
+		&descriptorSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create GPU culling descriptor set layout!");
+	}
+
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = static_cast<uint32_t>(numSwapChainImages *
+		bindings.size());
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = static_cast<uint32_t>(numSwapChainImages);
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool)
+		!= VK_SUCCESS) {
+		throw std::runtime_error("Failed to create GPU culling descriptor pool!");
+	}
+
+	std::vector<VkDescriptorSetLayout> layouts(numSwapChainImages,
+		descriptorSetLayout);
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = static_cast<uint32_t>(numSwapChainImages);
+	allocInfo.pSetLayouts = layouts.data();
+	std::vector<VkDescriptorSet> descriptorSets(numSwapChainImages);
+	if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data())
+		!= VK_SUCCESS) {
+		throw std::runtime_error("Failed to allocate GPU culling descriptor sets!");
+	}
+	for (size_t i = 0; i < numSwapChainImages; i++) {
+		frames[i].descriptorSet = descriptorSets[i];
+	}
+}
+
+void GpuCullingModule::CreatePipeline(ResourceLoader* resourceLoader) {
+	VkDevice device = logicalDeviceManager->GetDevice();
+#if __APPLE__
+	std::shared_ptr<ShaderLoader> compShaderModule = resourceLoader->GetShader(
+		"../../shaders/GpuCullComp.spv", device);
+#else
+	std::shared_ptr<ShaderLoader> compShaderModule = resourceLoader->GetShader(
+		"../shaders/GpuCullComp.spv", device);
+#endif
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(CullParameters);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr,
+		&pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create GPU culling pipeline layout!");
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = compShaderModule->GetVkShaderModule();
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = pipelineLayout;
+	if (vkCreateComputePipelines(device,
+		logicalDeviceManager->GetPipelineCache(), 1, &pipelineInfo, nullptr,
+		&pipeline) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create GPU culling pipeline!");
+	}
+}
+
+void GpuCullingModule::CreateObjectBuffers(FrameBuffers& frame,
+	size_t objectCapacity) {
+	// host-visible allocations stay mapped
+	Common::CreateBuffer(logicalDeviceManager, gfxDeviceManager,
+		sizeof(CullObject) * objectCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		frame.objectBuffer, frame.objectAllocation);
+	// one slot per object, since every object in a batch might be visible
+	Common::CreateBuffer(logicalDeviceManager, gfxDeviceManager,
+		sizeof(InstanceData) * objectCapacity,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.instanceBuffer,
+		frame.instanceAllocation);
+	Common::CreateBuffer(logicalDeviceManager, gfxDeviceManager,
+		drawCommandStride * objectCapacity,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.drawCommandBuffer,
+		frame.drawCommandAllocation);
+	frame.objectCapacity = objectCapacity;
+}
+
+void GpuCullingModule::CreateDrawCountBuffer(FrameBuffers& frame,
+	size_t batchCapacity) {
+	Common::CreateBuffer(logicalDeviceManager, gfxDeviceManager,
+		sizeof(uint32_t) * batchCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.drawCountBuffer,
+		frame.drawCountAllocation);
+	frame.batchCapacity = batchCapacity;
+}
+
+void GpuCullingModule::DestroyObjectBuffers(FrameBuffers& frame) {
+	Common::DestroyBuffer(logicalDeviceManager, frame.objectBuffer,
+		frame.objectAllocation);
+	Common::DestroyBuffer(logicalDeviceManager, frame.instanceBuffer,
+		frame.instanceAllocation);
+	Common::DestroyBuffer(logicalDeviceManager, frame.drawCommandBuffer,
+		frame.drawCommandAllocation);
+	frame.objectCapacity = 0;
+}
+
+void GpuCullingModule::DestroyDrawCountBuffer(FrameBuffers& frame) {
+	Common::DestroyBuffer(logicalDeviceManager, frame.drawCountBuffer,
+		frame.drawCountAllocation);
+	frame.batchCapacity = 0;
+}
+
+void GpuCullingModule::UpdateDescriptorSet(FrameBuffers& frame) {
+	std::array<VkDescriptorBufferInfo, 4> bufferInfos = {};
+	bufferInfos[0].buffer = frame.objectBuffer;
+	bufferInfos[1].buffer = frame.instanceBuffer;
+	bufferInfos[2].buffer = frame.drawCommandBuffer;
+	bufferInfos[3].buffer = frame.drawCountBuffer;
+
+	std::array<VkWriteDescriptorSet, 4> descriptorWrites = {};
+	for (uint32_t i = 0; i < (uint32_t)descriptorWrites.size(); i++) {
+		bufferInfos[i].offset = 0;
+		bufferInfos[i].range = VK_WHOLE_SIZE;
+
+		descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[i].dstSet = frame.descriptorSet;
+		descriptorWrites[i].dstBinding = i;
+		descriptorWrites[i].dstArrayElement = 0;
+		descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrites[i].descriptorCount = 1;
+		descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+	}
+
+	vkUpdateDescriptorSets(logicalDeviceManager->GetDevice(),
+		static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(),
+		0, nullptr);
+}
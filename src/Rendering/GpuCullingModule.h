@@ -0,0 +1,114 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include "MemoryAllocator.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class GfxDeviceManager;
+class LogicalDeviceManager;
+class ResourceLoader;
+
+// Frustum culling on the GPU for objects that can be drawn instanced. The
+// CPU writes one record per object, grouped into batches of objects that
+// share a pipeline, texture and geometry arena. A compute pass tests the
+// records and packs the visible ones into per-instance data and indirect
+// draw commands at the front of their batch's range, and counts them, so
+// each batch is drawn with one vkCmdDrawIndexedIndirectCount. Buffers exist
+// once per swap chain image.
+class GpuCullingModule {
+public:
+	// has to match GpuCull.comp
+	struct CullObject {
+		glm::mat4 model;
+		glm::vec4 tint;
+		// world space box
+		glm::vec4 boundsCenter;
+		glm::vec4 boundsExtents;
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t batchIndex;
+		// each batch has room for all of its objects, starting here
+		uint32_t firstCommand;
+		uint32_t padding[3];
+	};
+
+	GpuCullingModule(size_t numSwapChainImages,
+		LogicalDeviceManager* logicalDeviceManager,
+		GfxDeviceManager* gfxDeviceManager, ResourceLoader* resourceLoader);
+	~GpuCullingModule();
+
+	// grows the image's buffers to fit, which destroys the old ones right
+	// away, so the GPU has to be done with that image. returns where the
+	// records go
+	CullObject* BeginFrame(size_t swapChainIndex, size_t numObjects,
+		size_t numBatches, glm::mat4 const& viewProjection);
+	// clears the draw counts and runs the culling pass. has to be recorded
+	// outside of a render pass, before the draws that read the results
+	void RecordCulling(VkCommandBuffer commandBuffer, size_t swapChainIndex);
+
+	// per-instance data the draws read from binding 1
+	VkBuffer GetInstanceBuffer(size_t swapChainIndex) const {
+		return frames[swapChainIndex].instanceBuffer;
+	}
+
+	VkBuffer GetDrawCommandBuffer(size_t swapChainIndex) const {
+		return frames[swapChainIndex].drawCommandBuffer;
+	}
+
+	VkBuffer GetDrawCountBuffer(size_t swapChainIndex) const {
+		return frames[swapChainIndex].drawCountBuffer;
+	}
+
+	static const uint32_t drawCommandStride =
+		sizeof(VkDrawIndexedIndirectCommand);
+
+private:
+	struct FrameBuffers {
+		// host-visible, written by the CPU every frame
+		VkBuffer objectBuffer;
+		MemoryAllocator::Allocation objectAllocation;
+		VkBuffer instanceBuffer;
+		MemoryAllocator::Allocation instanceAllocation;
+		VkBuffer drawCommandBuffer;
+		MemoryAllocator::Allocation drawCommandAllocation;
+		VkBuffer drawCountBuffer;
+		MemoryAllocator::Allocation drawCountAllocation;
+		size_t objectCapacity;
+		size_t batchCapacity;
+
+		size_t numObjects;
+		size_t numBatches;
+		glm::vec4 frustumPlanes[6];
+		VkDescriptorSet descriptorSet;
+	};
+
+	struct CullParameters {
+		glm::vec4 frustumPlanes[6];
+		uint32_t numObjects;
+	};
+
+	// not owned by us
+	LogicalDeviceManager* logicalDeviceManager;
+	GfxDeviceManager* gfxDeviceManager;
+
+	std::vector<FrameBuffers> frames;
+	VkDescriptorSetLayout descriptorSetLayout;
+	VkDescriptorPool descriptorPool;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipeline;
+
+	static const uint32_t workGroupSize;
+	static const size_t minObjectCapacity;
+	static const size_t minBatchCapacity;
+
+	void CreateDescriptorSets(size_t numSwapChainImages);
+	void CreatePipeline(ResourceLoader* resourceLoader);
+	void CreateObjectBuffers(FrameBuffers& frame, size_t objectCapacity);
+	void CreateDrawCountBuffer(FrameBuffers& frame, size_t batchCapacity);
+	void DestroyObjectBuffers(FrameBuffers& frame);
+	void DestroyDrawCountBuffer(FrameBuffers& frame);
+	void UpdateDescriptorSet(FrameBuffers& frame);
+};
@@ -7,36 +7,64 @@
 #include "RenderPassModule.h"
 #include "PipelineModule.h"
 #include "CommonBufferModule.h"
+#include "InstanceBufferModule.h"
+#include "GpuCullingModule.h"
+#include "UniformRingBufferModule.h"
 #include "Resources/TextureCreator.h"
 #include "Resources/ResourceLoader.h"
+#include "LogicalDeviceManager.h"
+#include "GfxDeviceManager.h"
+#include "DeferredDestructionQueue.h"
+#include "ThreadPool.h"
+#include "Vertex.h"
+#include "Math/CommonMath.h"
 #include <thread>
+#include <algorithm>
 #include <iostream>
 
+const size_t GraphicsEngine::minInstancesPerGroup = 2;
+const size_t GraphicsEngine::maxDrawCommandsPerJob = 256;
+// per swap chain image, thousands of objects' UBOs. the ring buffer
+// adds another one like it when that runs out
+const VkDeviceSize GraphicsEngine::uniformRingBufferRegionSize = 4 * 1024 * 1024;
+
+// objects that draw without bounds can't be culled
+static const float unboundedExtent = 1e30f;
+
 GraphicsEngine::GraphicsEngine(GfxDeviceManager* gfxDeviceManager,
 	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager,
 	ResourceLoader *resourceLoader, VkSurfaceKHR surface,
 	GLFWwindow* window, VkCommandPool mainCommandPool,
 	VkCommandPoolCreateInfo poolCreateInfo,
+	ThreadPool* recordingThreadPool,
 	std::vector<std::shared_ptr<GameObject>>& gameObjects) {
 	this->logicalDeviceManager = logicalDeviceManager;
+	this->gfxDeviceManager = gfxDeviceManager;
+	this->resourceLoader = resourceLoader;
+	this->recordingThreadPool = recordingThreadPool;
 	CreateSwapChain(gfxDeviceManager, surface, window);
 	CreateSwapChainImageViews();
 	CreateRenderPassModule(gfxDeviceManager);
 
-	CreateColorResources(gfxDeviceManager, mainCommandPool);
-	CreateDepthResources(gfxDeviceManager, mainCommandPool);
+	CreateColorResources(gfxDeviceManager);
+	CreateDepthResources(gfxDeviceManager);
 	CreateFramebuffers();
 	
 	size_t numSwapchainImages = swapChainFramebuffers.size();
-	for (size_t i = 0; i < numSwapchainImages; i++) {
-		commandBufferModules.push_back(new CommandBufferModule(1,
-			logicalDeviceManager->GetDevice(), poolCreateInfo));
-	}
-	for (size_t i = 0; i < numSwapchainImages; i++) {
-		commandBufferModulesPending.push_back(new CommandBufferModule(1,
-			logicalDeviceManager->GetDevice(), poolCreateInfo));
-	}
-	pendingCommandModules = false;
+	CreateFrameRecordingData(poolCreateInfo);
+	renderStatistics = RenderStatistics();
+
+	uniformRingBuffer = std::make_shared<UniformRingBufferModule>(
+		numSwapchainImages, logicalDeviceManager, gfxDeviceManager,
+		uniformRingBufferRegionSize);
+
+	instancingData = new InstancingData();
+	instancingData->instanceBufferModule = new InstanceBufferModule(
+		numSwapchainImages, logicalDeviceManager.get(), gfxDeviceManager);
+	gpuCullingModule = nullptr;
+	gpuCullingEnabled = false;
+	occlusionCullingEnabled = false;
+	culledFlagsNeedReset = false;
 
 	AddAndInitializeNewGameObjects(gfxDeviceManager, resourceLoader,
 								   gameObjects);
@@ -45,12 +73,10 @@ GraphicsEngine::GraphicsEngine(GfxDeviceManager* gfxDeviceManager,
 void GraphicsEngine::AddAndInitializeNewGameObjects(
 	GfxDeviceManager* gfxDeviceManager,
 	ResourceLoader* resourceLoader,
-	std::vector<std::shared_ptr<GameObject>>& gameObjects) {
+	std::vector<std::shared_ptr<GameObject>> const & gameObjects) {
 	AddGraphicsPipelinesFromGameObjects(gfxDeviceManager, resourceLoader, gameObjects);
-	CreateUniformBuffersForGameObjects(gfxDeviceManager, gameObjects);
+	CreateUniformBuffersForGameObjects(gameObjects);
 	CreateDescriptorPoolAndSetsForGameObjects(gameObjects);
-
-	CreateCommandBuffersForGameObjects(gameObjects, commandBufferModules);
 	SetGameObjectsInitalizedRecursively(gameObjects);
 }
 
@@ -64,83 +90,75 @@ void GraphicsEngine::SetGameObjectsInitalizedRecursively(
 	}
 }
 
-void GraphicsEngine::ReRecordCommandsForGameObjects(
-	GfxDeviceManager* gfxDeviceManager, ResourceLoader* resourceLoader,
-	std::vector<VkFence> const & inFlightFences,
-	std::vector<std::shared_ptr<GameObject>> const & allGameObjects) {
-	AddGraphicsPipelinesFromGameObjects(gfxDeviceManager, resourceLoader, allGameObjects);
-	CreateUniformBuffersForGameObjects(gfxDeviceManager, allGameObjects);
-	CreateDescriptorPoolAndSetsForGameObjects(allGameObjects);
-	
-	CreateCommandBuffersForGameObjects(allGameObjects, commandBufferModulesPending);
-	SetGameObjectsInitalizedRecursively(allGameObjects);
-	pendingCommandModules = true;
-	std::cout << "record command buffers\n";
-}
-
-void GraphicsEngine::RemoveGameObjectsAndRecordCommands(
-	std::vector<VkFence> const& inFlightFences,
-	std::vector<std::shared_ptr<GameObject>> const & gameObjectsToRemove,
-	std::vector<std::shared_ptr<GameObject>> const & allGameObjectsSansRemovals) {
-	for (auto & gameObject : gameObjectsToRemove) {
-		gameObjectsPipelinesPendingRemoval.push(gameObject);
+void GraphicsEngine::RemoveGameObjects(
+	std::vector<std::shared_ptr<GameObject>> const & gameObjectsToRemove) {
+	for (auto& gameObject : gameObjectsToRemove) {
+		RetireGameObjectRecursive(gameObject);
 	}
+}
 
-	CreateCommandBuffersForGameObjects(allGameObjectsSansRemovals,
-		commandBufferModulesPending);
-	pendingCommandModules = true;
+GraphicsEngine::~GraphicsEngine() {
+	CleanUpSwapChain();
 }
 
-void GraphicsEngine::RemoveGameObjectsAndReRecordCommandsForAddedGameObjects(
-	GfxDeviceManager* gfxDeviceManager, ResourceLoader* resourceLoader,
-	std::vector<VkFence> const& inFlightFences,
-	std::vector<std::shared_ptr<GameObject>> const & gameObjectsToRemove,
-	std::vector<std::shared_ptr<GameObject>> const & allGameObjectsSansRemovals) {
-	for (auto& gameObject : gameObjectsToRemove) {
-		gameObjectsPipelinesPendingRemoval.push(gameObject);
+void GraphicsEngine::SetGpuCullingEnabled(bool enabled) {
+	if (enabled && !IsGpuCullingSupported()) {
+		return;
 	}
-
-	AddGraphicsPipelinesFromGameObjects(gfxDeviceManager, resourceLoader, allGameObjectsSansRemovals);
-	CreateUniformBuffersForGameObjects(gfxDeviceManager, allGameObjectsSansRemovals);
-	CreateDescriptorPoolAndSetsForGameObjects(allGameObjectsSansRemovals);
-
-	CreateCommandBuffersForGameObjects(allGameObjectsSansRemovals,
-		commandBufferModulesPending);
-	SetGameObjectsInitalizedRecursively(allGameObjectsSansRemovals);
-	pendingCommandModules = true;
-	std::cout << "remove game objects, add a few, record command buffers\n";
+	// created on first use, so devices and builds that never turn it on
+	// don't need the compute shader
+	if (enabled && gpuCullingModule == nullptr) {
+		gpuCullingModule = new GpuCullingModule(swapChainFramebuffers.size(),
+			logicalDeviceManager.get(), gfxDeviceManager, resourceLoader);
+	}
+	culledFlagsNeedReset = enabled && !gpuCullingEnabled;
+	gpuCullingEnabled = enabled;
 }
 
-GraphicsEngine::~GraphicsEngine() {
-	CleanUpSwapChain();
+bool GraphicsEngine::IsGpuCullingSupported() const {
+	return gfxDeviceManager->SupportsDrawIndirectCount() &&
+		logicalDeviceManager->GetCmdDrawIndexedIndirectCount() != nullptr;
 }
 
-void GraphicsEngine::CleanUpSwapChain() {
-	for (size_t i = 0; i < swapChainFramebuffers.size(); i++) {
-		vkDestroyFramebuffer(logicalDeviceManager->GetDevice(), swapChainFramebuffers[i],
-			nullptr);
+bool GraphicsEngine::RecreateSwapChain(VkSurfaceKHR surface,
+	GLFWwindow* window) {
+	VkFormat oldImageFormat = swapChainManager->GetSwapChainImageFormat();
+	size_t oldNumImages = swapChainManager->GetSwapChainImages().size();
+
+	DestroyFramebuffers();
+	delete swapChainManager;
+	CreateSwapChain(gfxDeviceManager, surface, window);
+	CreateSwapChainImageViews();
+
+	// the render pass is made for one format, and frame data, UBO regions
+	// and descriptor sets exist once per image
+	if (swapChainManager->GetSwapChainImageFormat() != oldImageFormat ||
+		swapChainManager->GetSwapChainImages().size() != oldNumImages) {
+		return false;
 	}
 
-	vkDestroyImageView(logicalDeviceManager->GetDevice(), colorImageView, nullptr);
-	vkDestroyImage(logicalDeviceManager->GetDevice(), colorImage, nullptr);
-	vkFreeMemory(logicalDeviceManager->GetDevice(), colorImageMemory, nullptr);
+	DestroyAttachments();
+	CreateColorResources(gfxDeviceManager);
+	CreateDepthResources(gfxDeviceManager);
+	CreateFramebuffers();
+	return true;
+}
 
-	vkDestroyImageView(logicalDeviceManager->GetDevice(), depthImageView, nullptr);
-	vkDestroyImage(logicalDeviceManager->GetDevice(), depthImage, nullptr);
-	vkFreeMemory(logicalDeviceManager->GetDevice(), depthImageMemory, nullptr);
+void GraphicsEngine::CleanUpSwapChain() {
+	DestroyFramebuffers();
+	DestroyAttachments();
+	DestroyFrameRecordingData();
 
-	if (commandBufferModules.size() > 0) {
-		for (auto commandBufferModule : commandBufferModules) {
-			delete commandBufferModule;
-		}
+	if (instancingData != nullptr) {
+		delete instancingData->instanceBufferModule;
+		delete instancingData;
 	}
-	if (commandBufferModulesPending.size() > 0) {
-		for (auto commandBufferModule : commandBufferModulesPending) {
-			delete commandBufferModule;
-		}
+	if (gpuCullingModule != nullptr) {
+		delete gpuCullingModule;
 	}
 
 	gameObjectToPipelineModule.clear();
+	instancedPipelineModules.clear();
 	
 	if (renderPassModule != nullptr) {
 		delete renderPassModule;
@@ -150,6 +168,26 @@ void GraphicsEngine::CleanUpSwapChain() {
 	}
 }
 
+void GraphicsEngine::DestroyFramebuffers() {
+	for (size_t i = 0; i < swapChainFramebuffers.size(); i++) {
+		vkDestroyFramebuffer(logicalDeviceManager->GetDevice(), swapChainFramebuffers[i],
+			nullptr);
+	}
+	swapChainFramebuffers.clear();
+}
+
+void GraphicsEngine::DestroyAttachments() {
+	vkDestroyImageView(logicalDeviceManager->GetDevice(), colorImageView, nullptr);
+	colorImageView = VK_NULL_HANDLE;
+	Common::DestroyImage(logicalDeviceManager.get(), colorImage,
+		colorImageAllocation);
+
+	vkDestroyImageView(logicalDeviceManager->GetDevice(), depthImageView, nullptr);
+	depthImageView = VK_NULL_HANDLE;
+	Common::DestroyImage(logicalDeviceManager.get(), depthImage,
+		depthImageAllocation);
+}
+
 void GraphicsEngine::CreateSwapChain(GfxDeviceManager* gfxDeviceManager,
 	VkSurfaceKHR surface, GLFWwindow* window) {
 	swapChainManager = new SwapChainManager(gfxDeviceManager,
@@ -167,8 +205,7 @@ void GraphicsEngine::CreateRenderPassModule(GfxDeviceManager* gfxDeviceManager)
 		gfxDeviceManager->GetMSAASamples());
 }
 
-void GraphicsEngine::CreateColorResources(GfxDeviceManager* gfxDeviceManager,
-	VkCommandPool commandPool) {
+void GraphicsEngine::CreateColorResources(GfxDeviceManager* gfxDeviceManager) {
 	auto swapChainImageFormat = swapChainManager->GetSwapChainImageFormat();
 	auto swapChainExtent = swapChainManager->GetSwapChainExtent();
 	VkFormat colorFormat = swapChainImageFormat;
@@ -176,28 +213,27 @@ void GraphicsEngine::CreateColorResources(GfxDeviceManager* gfxDeviceManager,
 	Common::CreateImage(swapChainExtent.width, swapChainExtent.height, 1,
 		gfxDeviceManager->GetMSAASamples(), colorFormat, VK_IMAGE_TILING_OPTIMAL,
 		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage, colorImageMemory,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage, colorImageAllocation,
 		logicalDeviceManager.get(), gfxDeviceManager);
 	colorImageView = Common::CreateImageView(colorImage, colorFormat,
 		VK_IMAGE_ASPECT_COLOR_BIT, 1, logicalDeviceManager.get());
 
 	Common::TransitionImageLayout(colorImage, colorFormat, VK_IMAGE_LAYOUT_UNDEFINED,
-		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 1, commandPool, logicalDeviceManager.get());
+		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 1, logicalDeviceManager.get());
 }
 
-void GraphicsEngine::CreateDepthResources(GfxDeviceManager* gfxDeviceManager,
-	VkCommandPool commandPool) {
+void GraphicsEngine::CreateDepthResources(GfxDeviceManager* gfxDeviceManager) {
 	VkFormat depthFormat = Common::FindDepthFormat(gfxDeviceManager->GetPhysicalDevice());
 	auto swapChainExtent = swapChainManager->GetSwapChainExtent();
 	Common::CreateImage(swapChainExtent.width, swapChainExtent.height,
 		1, gfxDeviceManager->GetMSAASamples(), depthFormat, VK_IMAGE_TILING_OPTIMAL,
 		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		depthImage, depthImageMemory, logicalDeviceManager.get(), gfxDeviceManager);
+		depthImage, depthImageAllocation, logicalDeviceManager.get(), gfxDeviceManager);
 	depthImageView = Common::CreateImageView(depthImage, depthFormat,
 		VK_IMAGE_ASPECT_DEPTH_BIT, 1, logicalDeviceManager.get());
 
 	Common::TransitionImageLayout(depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED,
-		VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1, commandPool, logicalDeviceManager.get());
+		VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1, logicalDeviceManager.get());
 }
 
 void GraphicsEngine::CreateFramebuffers() {
@@ -289,10 +325,11 @@ void GraphicsEngine::AddNewPipeline(std::shared_ptr<GameObject> gameObject,
 	*pipelineModulePtr =
 		std::make_shared<PipelineModule>(
 			gameObject->GetVertexShaderName(), gameObject->GetFragmentShaderName(),
-			logicalDeviceManager->GetDevice(), swapChainManager->GetSwapChainExtent(),
-			gfxDeviceManager, resourceLoader, gameObject->GetDescriptorSetLayout(),
+			logicalDeviceManager->GetDevice(), gfxDeviceManager, resourceLoader,
+			gameObject->GetDescriptorSetLayout(),
 			renderPassModule->GetRenderPass(), gameObject->GetMaterialType(),
-			gameObject->GetPrimitiveTopology());
+			gameObject->GetPrimitiveTopology(),
+			logicalDeviceManager->GetPipelineCache());
 }
 
 std::shared_ptr<PipelineModule> GraphicsEngine::FindMatchingPipelineFromAnotherGameObject(
@@ -309,43 +346,38 @@ std::shared_ptr<PipelineModule> GraphicsEngine::FindMatchingPipelineFromAnotherG
 	return nullptr;
 }
 
-void GraphicsEngine::RemoveGraphicsPipelinesFromPendingGameObjects() {
-	while (gameObjectsPipelinesPendingRemoval.size() > 0) {
-		std::shared_ptr<GameObject> gameObject = gameObjectsPipelinesPendingRemoval.top();
-		gameObjectsPipelinesPendingRemoval.pop();
-		if (gameObjectToPipelineModule.find(gameObject) != gameObjectToPipelineModule.end())
-		{
-			gameObjectToPipelineModule.erase(gameObject);
-		}
+void GraphicsEngine::RetireGameObjectRecursive(
+	std::shared_ptr<GameObject> const& gameObject) {
+	std::shared_ptr<PipelineModule> pipelineModule;
+	auto pipelineIt = gameObjectToPipelineModule.find(gameObject);
+	if (pipelineIt != gameObjectToPipelineModule.end()) {
+		pipelineModule = pipelineIt->second;
+		gameObjectToPipelineModule.erase(pipelineIt);
+	}
 
-		RemoveGameObjectToPipelineRecursive(gameObject);
+	// the object retires its own resources; the pipeline might have been
+	// its last user though, and frames in flight could still be bound to it
+	if (pipelineModule != nullptr) {
+		logicalDeviceManager->GetDeferredDestructionQueue()->KeepAlive(
+			pipelineModule);
 	}
-}
 
-void GraphicsEngine::RemoveGameObjectToPipelineRecursive(std::shared_ptr<GameObject> const& gameObject) {
 	size_t numChildGameObjects = gameObject->GetNumChildGameObjects();
 	for (size_t childIndex = 0; childIndex < numChildGameObjects; childIndex++) {
-		auto& childGameObject = gameObject->GetChildGameObject(childIndex);
-		if (gameObjectToPipelineModule.find(childGameObject) !=
-			gameObjectToPipelineModule.end()) {
-			gameObjectToPipelineModule.erase(childGameObject);
-		}
-		RemoveGameObjectToPipelineRecursive(childGameObject);
+		RetireGameObjectRecursive(gameObject->GetChildGameObject(childIndex));
 	}
 }
 
-void GraphicsEngine::CreateUniformBuffersForGameObjects(GfxDeviceManager* gfxDeviceManager,
+void GraphicsEngine::CreateUniformBuffersForGameObjects(
 										  std::vector<std::shared_ptr<GameObject>> const & gameObjects) {
-	const std::vector<VkImage>& swapChainImages = swapChainManager->GetSwapChainImages();
-	size_t numSwapChainImages = swapChainImages.size();
 	for(auto& gameObject : gameObjects) {
 		// if parent is initialized, then children are too
 		if (gameObject->GetInitializedInEngine()) {
 			continue;
 		}
-		gameObject->InitAndCreateUniformBuffers(gfxDeviceManager, numSwapChainImages);
+		gameObject->InitAndCreateUniformBuffers(uniformRingBuffer);
 		auto& children = gameObject->GetChildren();
-		CreateUniformBuffersForGameObjects(gfxDeviceManager, children);
+		CreateUniformBuffersForGameObjects(children);
 	}
 }
 
@@ -363,145 +395,700 @@ void GraphicsEngine::CreateDescriptorPoolAndSetsForGameObjects(
 	}
 }
 
-void GraphicsEngine::RecordCommandBuffersForCommandBufferModule(
-	std::vector<std::shared_ptr<GameObject>> const& gameObjects,
-	CommandBufferModule* commandBufferModule,
-	VkFramebuffer swapChainFramebuffer,
-	int swapChainIndex) {
-	VkCommandBufferBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+void GraphicsEngine::CreateFrameRecordingData(
+	VkCommandPoolCreateInfo const& poolCreateInfo) {
+	// everything in these pools is re-recorded every frame, and reset
+	// together by resetting the pool
+	VkCommandPoolCreateInfo framePoolInfo = poolCreateInfo;
+	framePoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
-	auto& commandBuffer = commandBufferModule->GetCommandBuffers()[0];
-	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to begin recording command buffer!");
+	VkDevice device = logicalDeviceManager->GetDevice();
+	size_t numWorkers = recordingThreadPool->GetNumWorkers();
+	size_t numSwapchainImages = swapChainFramebuffers.size();
+	frameRecordingData.resize(numSwapchainImages);
+	for (auto& frameData : frameRecordingData) {
+		frameData.primaryCommandBufferModule = new CommandBufferModule(1,
+			device, framePoolInfo);
+		frameData.primaryCommandBuffer = VK_NULL_HANDLE;
+		for (size_t i = 0; i < numWorkers; i++) {
+			frameData.secondaryCommandBufferModules.push_back(
+				new CommandBufferModule(0, device, framePoolInfo,
+					VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+		}
 	}
+}
 
-	VkRenderPassBeginInfo renderPassInfo = {};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass = renderPassModule->GetRenderPass();
-	renderPassInfo.framebuffer = swapChainFramebuffer;
-	renderPassInfo.renderArea.offset = { 0, 0 };
+void GraphicsEngine::DestroyFrameRecordingData() {
+	for (auto& frameData : frameRecordingData) {
+		delete frameData.primaryCommandBufferModule;
+		for (auto commandBufferModule : frameData.secondaryCommandBufferModules) {
+			delete commandBufferModule;
+		}
+	}
+	frameRecordingData.clear();
+}
+
+void GraphicsEngine::RecordCommandsForFrame(uint32_t imageIndex,
+	std::vector<std::shared_ptr<GameObject>> const & gameObjects,
+	glm::mat4 const& viewMatrix) {
+	FrameRecordingData& frameData = frameRecordingData[imageIndex];
+
+	// culled objects are left out of everything below
 	auto swapChainExtent = swapChainManager->GetSwapChainExtent();
-	renderPassInfo.renderArea.extent = swapChainExtent;
+	glm::mat4 projectionMatrix = CommonMath::ConstructProjectionMatrix(
+		swapChainExtent.width, swapChainExtent.height);
+	glm::mat4 viewProjection = projectionMatrix * viewMatrix;
+	size_t numCulledGameObjects = 0;
+	size_t numOccludedGameObjects = 0;
+	if (!gpuCullingEnabled) {
+		numCulledGameObjects = frustumCuller.CullGameObjects(gameObjects,
+			viewProjection);
+		if (occlusionCullingEnabled) {
+			numOccludedGameObjects = occlusionCuller.CullGameObjects(
+				gameObjects, viewProjection);
+			numCulledGameObjects += numOccludedGameObjects;
+		}
+	}
+	else if (culledFlagsNeedReset) {
+		frustumCuller.ClearCulledFlags(gameObjects);
+		culledFlagsNeedReset = false;
+	}
 
-	// order of clear values = order of attachments
-	std::array<VkClearValue, 2> clearValues = {};
-	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	clearValues[1].depthStencil = { 1.0f, 0 };
+	// grouping has to happen before recording, since it might create pipelines
+	BuildInstanceGroups(gameObjects);
+	UpdateInstanceBuffer(imageIndex);
+	size_t numGpuTestedGameObjects = 0;
+	if (gpuCullingEnabled) {
+		numGpuTestedGameObjects = WriteGpuCullingObjects(imageIndex,
+			viewProjection);
+	}
+	BuildRenderQueue(gameObjects, imageIndex, viewMatrix);
 
-	//VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
-	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-	renderPassInfo.pClearValues = clearValues.data();
+	frameData.primaryCommandBufferModule->Reset();
+	for (auto commandBufferModule : frameData.secondaryCommandBufferModules) {
+		commandBufferModule->Reset();
+	}
 
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo,
-		VK_SUBPASS_CONTENTS_INLINE);
+	// each worker records into command buffers from its own pool. the
+	// results are executed in job order, which keeps the queue's order
+	size_t numJobs = recordingJobs.size();
+	secondaryCommandBuffers.resize(numJobs);
+	jobStatistics.assign(numJobs, RenderStatistics());
+	for (size_t jobIndex = 0; jobIndex < numJobs; jobIndex++) {
+		recordingThreadPool->Enqueue([this, jobIndex, imageIndex,
+			&frameData](size_t workerIndex) {
+			secondaryCommandBuffers[jobIndex] = RecordDrawCommands(
+				recordingJobs[jobIndex], imageIndex,
+				frameData.secondaryCommandBufferModules[workerIndex],
+				jobStatistics[jobIndex]);
+		});
+	}
+	recordingThreadPool->WaitIdle();
 
-	// render opaque objects first, then transparent
-	RecordCommandForGameObjects(commandBuffer, gameObjects, false, swapChainIndex);
-	RecordCommandForGameObjects(commandBuffer, gameObjects, true, swapChainIndex);
+	renderStatistics = RenderStatistics();
+	renderStatistics.numCulledGameObjects = numCulledGameObjects;
+	renderStatistics.numOccludedGameObjects = numOccludedGameObjects;
+	renderStatistics.numGpuTestedGameObjects = numGpuTestedGameObjects;
+	renderStatistics.numDrawCommands = renderQueue.GetNumDrawCommands();
+	for (auto const& statistics : jobStatistics) {
+		renderStatistics.numPipelineBinds += statistics.numPipelineBinds;
+		renderStatistics.numPipelineBindsElided +=
+			statistics.numPipelineBindsElided;
+		renderStatistics.numVertexBufferBinds += statistics.numVertexBufferBinds;
+		renderStatistics.numVertexBufferBindsElided +=
+			statistics.numVertexBufferBindsElided;
+		renderStatistics.numIndexBufferBinds += statistics.numIndexBufferBinds;
+		renderStatistics.numIndexBufferBindsElided +=
+			statistics.numIndexBufferBindsElided;
+		renderStatistics.numDescriptorSetBinds +=
+			statistics.numDescriptorSetBinds;
+		renderStatistics.numDescriptorSetBindsElided +=
+			statistics.numDescriptorSetBindsElided;
+		renderStatistics.numIndicesDrawn += statistics.numIndicesDrawn;
+	}
 
-	vkCmdEndRenderPass(commandBuffer);
+	RecordPrimaryCommandBuffer(imageIndex);
+}
 
-	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to record command buffer!");
+void GraphicsEngine::BuildInstanceGroups(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects) {
+	instancingData->instanceGroups.clear();
+	instancingData->instancedGameObjects.clear();
+	gpuCullingBatches.clear();
+	// everything that could be instanced is batched for the GPU instead
+	if (gpuCullingEnabled) {
+		BuildGpuCullingBatches(gameObjects);
+		return;
+	}
+
+	std::map<std::tuple<Model*, size_t, PipelineModule*, TextureCreator*>,
+		std::vector<std::shared_ptr<GameObject>>> candidateGroups;
+	CollectInstancingCandidates(gameObjects, candidateGroups);
+
+	uint32_t numInstances = 0;
+	for (auto& candidateGroup : candidateGroups) {
+		auto& groupGameObjects = candidateGroup.second;
+		// lone objects are cheaper to draw the regular way
+		if (groupGameObjects.size() < minInstancesPerGroup) {
+			continue;
+		}
+
+		InstanceGroup instanceGroup;
+		instanceGroup.pipelineModule = GetOrCreateInstancedPipeline(
+			groupGameObjects[0], gameObjectToPipelineModule[groupGameObjects[0]]);
+		instanceGroup.gameObjects = groupGameObjects;
+		instanceGroup.firstInstance = numInstances;
+		numInstances += (uint32_t)groupGameObjects.size();
+
+		for (auto& gameObject : groupGameObjects) {
+			instancingData->instancedGameObjects.insert(gameObject.get());
+		}
+		instancingData->instanceGroups.push_back(instanceGroup);
 	}
 }
 
-void GraphicsEngine::Update(std::vector<VkFence> const& inFlightFences) {
-	if (pendingCommandModules) {
-		// have to wait for device to become available
-		vkWaitForFences(logicalDeviceManager->GetDevice(), (uint32_t)inFlightFences.size(),
-			inFlightFences.data(), VK_TRUE,
-			std::numeric_limits<uint64_t>::max());
-		// pending becomes active while active becomes pending
-		size_t numModules = commandBufferModules.size();
-		for (size_t i = 0; i < numModules; i++) {
-			auto* oldPtr = commandBufferModules[i];
-			commandBufferModules[i] = commandBufferModulesPending[i];
-			commandBufferModulesPending[i] = oldPtr;
+void GraphicsEngine::CollectInstancingCandidates(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+	std::map<std::tuple<Model*, size_t, PipelineModule*, TextureCreator*>,
+		std::vector<std::shared_ptr<GameObject>>>& candidateGroups) {
+	for (auto& gameObject : gameObjects) {
+		// children of culled objects are out of view too, and inactive
+		// objects aren't drawn at all
+		if (gameObject->IsCulled() || !gameObject->IsActive()) {
+			continue;
+		}
+
+		auto pipelineIt = gameObjectToPipelineModule.find(gameObject);
+		if (!gameObject->IsInvisible() && gameObject->IsReadyToDraw() &&
+			gameObject->SupportsInstancing() &&
+			pipelineIt != gameObjectToPipelineModule.end()) {
+			auto material = gameObject->GetMaterial();
+			TextureCreator* texture = material != nullptr ?
+				material->GetTextureLoader() : nullptr;
+			// objects at different levels of detail draw different geometry
+			auto groupKey = std::make_tuple(gameObject->GetModel().get(),
+				gameObject->GetLodLevel(), pipelineIt->second.get(), texture);
+			candidateGroups[groupKey].push_back(gameObject);
 		}
-		RemoveGraphicsPipelinesFromPendingGameObjects();
-		pendingCommandModules = false;
+
+		auto& children = gameObject->GetChildren();
+		CollectInstancingCandidates(children, candidateGroups);
 	}
 }
 
-// per object. have a ubo per object, then update that ubo based on the matrices associated
-void GraphicsEngine::CreateCommandBuffersForGameObjects(
-					std::vector<std::shared_ptr<GameObject>> const & gameObjects,
-					std::vector<CommandBufferModule*> commandBufferModulesToUse) {
-	// right now we have one thread per swap chain image, could expand further on that
-	size_t numThreads = commandBufferModulesToUse.size();
-	std::vector<std::thread> threads(numThreads);
-	for (int i = 0; i < numThreads; i++) {
-		// this should be ok, because each command buffer module in the array is allocated separately
-		// and exists in a separate location
-		threads[i] = std::thread(
-			&GraphicsEngine::RecordCommandBuffersForCommandBufferModule, this,
-			gameObjects, commandBufferModulesToUse[i], swapChainFramebuffers[i], i);
+std::shared_ptr<PipelineModule> GraphicsEngine::GetOrCreateInstancedPipeline(
+	std::shared_ptr<GameObject> const& gameObject,
+	std::shared_ptr<PipelineModule> const& regularPipelineModule) {
+	auto instancedPipelineIt = instancedPipelineModules.find(regularPipelineModule);
+	if (instancedPipelineIt != instancedPipelineModules.end()) {
+		return instancedPipelineIt->second;
 	}
-	
-	for (size_t i = 0; i < numThreads; i++) {
-		threads[i].join();
+
+	auto instancedPipelineModule = std::make_shared<PipelineModule>(
+		gameObject->GetInstancedVertexShaderName(),
+		gameObject->GetInstancedFragmentShaderName(),
+		logicalDeviceManager->GetDevice(), gfxDeviceManager, resourceLoader,
+		gameObject->GetDescriptorSetLayout(),
+		renderPassModule->GetRenderPass(), gameObject->GetMaterialType(),
+		gameObject->GetPrimitiveTopology(),
+		logicalDeviceManager->GetPipelineCache(), true);
+	instancedPipelineModules[regularPipelineModule] = instancedPipelineModule;
+	return instancedPipelineModule;
+}
+
+void GraphicsEngine::UpdateInstanceBuffer(uint32_t imageIndex) {
+	size_t numInstances = 0;
+	for (auto const& instanceGroup : instancingData->instanceGroups) {
+		numInstances += instanceGroup.gameObjects.size();
+	}
+	auto instanceBufferModule = instancingData->instanceBufferModule;
+	instanceBufferModule->ReserveInstances(imageIndex, numInstances);
+
+	InstanceData* instanceData = (InstanceData*)
+		instanceBufferModule->GetMappedData(imageIndex);
+	for (auto const& instanceGroup : instancingData->instanceGroups) {
+		size_t numGroupInstances = instanceGroup.gameObjects.size();
+		for (size_t i = 0; i < numGroupInstances; i++) {
+			auto const& gameObject = instanceGroup.gameObjects[i];
+			InstanceData& currentInstance =
+				instanceData[instanceGroup.firstInstance + i];
+			currentInstance.model = gameObject->GetLocalToWorld();
+			currentInstance.tint = gameObject->GetInstanceTint();
+		}
 	}
 }
 
-void GraphicsEngine::RecordCommandForGameObjects(VkCommandBuffer &commandBuffer,
+void GraphicsEngine::BuildGpuCullingBatches(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects) {
+	// models can differ within a batch, since meshes of one layout share
+	// arena buffers and each object gets its own indirect draw
+	std::map<std::tuple<PipelineModule*, TextureCreator*, VkBuffer, VkBuffer>,
+		std::vector<std::shared_ptr<GameObject>>> candidateBatches;
+	CollectGpuCullingCandidates(gameObjects, candidateBatches);
+
+	uint32_t numObjects = 0;
+	for (auto& candidateBatch : candidateBatches) {
+		auto& batchGameObjects = candidateBatch.second;
+		InstanceGroup batch;
+		batch.pipelineModule = GetOrCreateInstancedPipeline(
+			batchGameObjects[0], gameObjectToPipelineModule[batchGameObjects[0]]);
+		batch.gameObjects = batchGameObjects;
+		batch.firstInstance = numObjects;
+		numObjects += (uint32_t)batchGameObjects.size();
+
+		for (auto& gameObject : batchGameObjects) {
+			instancingData->instancedGameObjects.insert(gameObject.get());
+		}
+		gpuCullingBatches.push_back(batch);
+	}
+}
+
+void GraphicsEngine::CollectGpuCullingCandidates(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+	std::map<std::tuple<PipelineModule*, TextureCreator*, VkBuffer, VkBuffer>,
+		std::vector<std::shared_ptr<GameObject>>>& candidateBatches) {
+	for (auto& gameObject : gameObjects) {
+		if (!gameObject->IsActive()) {
+			continue;
+		}
+
+		auto pipelineIt = gameObjectToPipelineModule.find(gameObject);
+		if (!gameObject->IsInvisible() && gameObject->IsReadyToDraw() &&
+			gameObject->SupportsInstancing() &&
+			pipelineIt != gameObjectToPipelineModule.end()) {
+			auto material = gameObject->GetMaterial();
+			TextureCreator* texture = material != nullptr ?
+				material->GetTextureLoader() : nullptr;
+			auto batchKey = std::make_tuple(pipelineIt->second.get(), texture,
+				gameObject->GetVertexBuffer(), gameObject->GetIndexBuffer());
+			candidateBatches[batchKey].push_back(gameObject);
+		}
+
+		auto& children = gameObject->GetChildren();
+		CollectGpuCullingCandidates(children, candidateBatches);
+	}
+}
+
+size_t GraphicsEngine::WriteGpuCullingObjects(uint32_t imageIndex,
+	glm::mat4 const& viewProjection) {
+	size_t numObjects = 0;
+	for (auto const& batch : gpuCullingBatches) {
+		numObjects += batch.gameObjects.size();
+	}
+	GpuCullingModule::CullObject* cullObjects = gpuCullingModule->BeginFrame(
+		imageIndex, numObjects, gpuCullingBatches.size(), viewProjection);
+
+	uint32_t numBatches = (uint32_t)gpuCullingBatches.size();
+	for (uint32_t batchIndex = 0; batchIndex < numBatches; batchIndex++) {
+		auto const& batch = gpuCullingBatches[batchIndex];
+		size_t numBatchObjects = batch.gameObjects.size();
+		for (size_t i = 0; i < numBatchObjects; i++) {
+			auto const& gameObject = batch.gameObjects[i];
+			GpuCullingModule::CullObject& cullObject =
+				cullObjects[batch.firstInstance + i];
+			cullObject.model = gameObject->GetLocalToWorld();
+			cullObject.tint = gameObject->GetInstanceTint();
+			AABB const& bounds = gameObject->GetWorldBounds();
+			if (bounds.IsEmpty()) {
+				cullObject.boundsCenter = glm::vec4(0.0f);
+				cullObject.boundsExtents = glm::vec4(glm::vec3(unboundedExtent),
+					0.0f);
+			}
+			else {
+				cullObject.boundsCenter = glm::vec4(bounds.GetCenter(), 0.0f);
+				cullObject.boundsExtents = glm::vec4(bounds.GetExtents(), 0.0f);
+			}
+			cullObject.indexCount = gameObject->GetIndexCount();
+			cullObject.firstIndex = gameObject->GetFirstIndex();
+			cullObject.vertexOffset = gameObject->GetVertexOffset();
+			cullObject.batchIndex = batchIndex;
+			cullObject.firstCommand = batch.firstInstance;
+		}
+	}
+	return numObjects;
+}
+
+uint32_t GraphicsEngine::GetSortId(std::map<void const*, uint32_t>& sortIds,
+	void const* resource) {
+	auto sortIdIt = sortIds.find(resource);
+	if (sortIdIt != sortIds.end()) {
+		return sortIdIt->second;
+	}
+	uint32_t sortId = (uint32_t)sortIds.size();
+	sortIds[resource] = sortId;
+	return sortId;
+}
+
+uint64_t GraphicsEngine::MakeSortKey(std::shared_ptr<GameObject> const& gameObject,
+	RenderQueue::DrawCommand const& drawCommand, glm::mat4 const& viewMatrix) {
+	RenderQueue::Pass pass = gameObject->GetMaterialType() ==
+		DescriptorSetFunctions::MaterialType::Text ?
+		RenderQueue::Pass::Transparent : RenderQueue::Pass::Opaque;
+	auto material = gameObject->GetMaterial();
+	TextureCreator* texture = material != nullptr ?
+		material->GetTextureLoader() : nullptr;
+	// camera looks down -z
+	float viewDepth = -(viewMatrix * gameObject->GetLocalToWorld()[3]).z;
+	return RenderQueue::MakeSortKey(pass,
+		GetSortId(pipelineSortIds, drawCommand.pipelineModule),
+		GetSortId(materialSortIds, texture),
+		GetSortId(meshSortIds, drawCommand.vertexBuffer), viewDepth);
+}
+
+void GraphicsEngine::BuildRenderQueue(
 	std::vector<std::shared_ptr<GameObject>> const & gameObjects,
-	bool renderOnlyTransparent,
-	int swapChainIndex) {
+	uint32_t imageIndex, glm::mat4 const& viewMatrix) {
+	renderQueue.Clear();
+	pipelineSortIds.clear();
+	materialSortIds.clear();
+	meshSortIds.clear();
+
+	CollectDrawCommandsForGameObjects(gameObjects, imageIndex, viewMatrix);
+	CollectDrawCommandsForInstanceGroups(imageIndex, viewMatrix);
+	CollectDrawCommandsForGpuCullingBatches(imageIndex, viewMatrix);
+	renderQueue.Sort();
+
+	// the queue is split up so that one big group of draws doesn't end
+	// up holding up all the other workers
+	recordingJobs.clear();
+	size_t numDrawCommands = renderQueue.GetNumDrawCommands();
+	for (size_t firstDrawCommand = 0; firstDrawCommand < numDrawCommands;
+		firstDrawCommand += maxDrawCommandsPerJob) {
+		RecordingJob recordingJob;
+		recordingJob.firstDrawCommand = firstDrawCommand;
+		recordingJob.numDrawCommands = std::min(maxDrawCommandsPerJob,
+			numDrawCommands - firstDrawCommand);
+		recordingJobs.push_back(recordingJob);
+	}
+}
+
+void GraphicsEngine::CollectDrawCommandsForGameObjects(
+	std::vector<std::shared_ptr<GameObject>> const & gameObjects,
+	uint32_t imageIndex, glm::mat4 const& viewMatrix) {
 	size_t numGameObjects = gameObjects.size();
 	for (size_t objectIndex = 0; objectIndex < numGameObjects;
 		objectIndex++) {
 		auto& gameObject = gameObjects[objectIndex];
-		RecordCommandForGameObject(commandBuffer, gameObject, renderOnlyTransparent,
-			swapChainIndex);
+		// children of culled objects are out of view too, and inactive
+		// objects aren't drawn at all
+		if (gameObject->IsCulled() || !gameObject->IsActive()) {
+			continue;
+		}
+
+		CollectDrawCommandForGameObject(gameObject, imageIndex, viewMatrix);
 		auto& children = gameObject->GetChildren();
 		if (!children.empty()) {
-			RecordCommandForGameObjects(commandBuffer, children,
-				renderOnlyTransparent, swapChainIndex);
+			CollectDrawCommandsForGameObjects(children, imageIndex, viewMatrix);
 		}
 	}
 }
 
-void GraphicsEngine::RecordCommandForGameObject(VkCommandBuffer& commandBuffer,
-	std::shared_ptr<GameObject> const & gameObject, bool renderOnlyTransparent,
-	int swapChainIndex) {
-	auto materialType = gameObject->GetMaterialType();
-	bool isTransparentMat = materialType ==
-		DescriptorSetFunctions::MaterialType::Text;
-	// skip object is it does not pass our render-type test
-	if (isTransparentMat && !renderOnlyTransparent ||
-		!isTransparentMat && renderOnlyTransparent) {
+void GraphicsEngine::CollectDrawCommandForGameObject(
+	std::shared_ptr<GameObject> const & gameObject, uint32_t imageIndex,
+	glm::mat4 const& viewMatrix) {
+	// skip invisible objects, and ones that are still streaming in
+	if (gameObject->IsInvisible() || !gameObject->IsReadyToDraw()) {
 		return;
 	}
 
-	// skip invisible objects
-	if (gameObject->IsInvisible()) {
+	// instanced objects are drawn with the rest of their group
+	auto& instancedGameObjects = instancingData->instancedGameObjects;
+	if (instancedGameObjects.find(gameObject.get()) !=
+		instancedGameObjects.end()) {
 		return;
 	}
 
-	PipelineModule* pipelineModule = gameObjectToPipelineModule[gameObject].get();
-
+	auto pipelineIt = gameObjectToPipelineModule.find(gameObject);
 	// skip if pipeline was not found
-	if (pipelineModule == nullptr) {
+	if (pipelineIt == gameObjectToPipelineModule.end() ||
+		pipelineIt->second == nullptr) {
+		return;
+	}
+
+	RenderQueue::DrawCommand drawCommand;
+	drawCommand.pipelineModule = pipelineIt->second.get();
+	drawCommand.vertexBuffer = gameObject->GetVertexBuffer();
+	drawCommand.instanceBuffer = VK_NULL_HANDLE;
+	drawCommand.indexBuffer = gameObject->GetIndexBuffer();
+	drawCommand.vertexOffset = gameObject->GetVertexOffset();
+	drawCommand.firstIndex = gameObject->GetFirstIndex();
+	drawCommand.indexCount = gameObject->GetIndexCount();
+	drawCommand.instanceCount = 1;
+	drawCommand.firstInstance = 0;
+	drawCommand.descriptorSet = *gameObject->GetDescriptorSetPtr(imageIndex);
+	drawCommand.numDynamicOffsets = gameObject->GetDynamicOffsets(imageIndex,
+		drawCommand.dynamicOffsets);
+	drawCommand.indirectBuffer = VK_NULL_HANDLE;
+	renderQueue.Add(MakeSortKey(gameObject, drawCommand, viewMatrix),
+		drawCommand);
+}
+
+void GraphicsEngine::CollectDrawCommandsForInstanceGroups(uint32_t imageIndex,
+	glm::mat4 const& viewMatrix) {
+	VkBuffer instanceBuffer = instancingData->instanceBufferModule->
+		GetInstanceBuffer(imageIndex);
+	for (auto const& instanceGroup : instancingData->instanceGroups) {
+		// every object in the group has the same geometry
+		auto const& firstGameObject = instanceGroup.gameObjects[0];
+
+		// view and projection are the same for all objects, and so is the
+		// texture, so the first object's descriptor set works for the group
+		RenderQueue::DrawCommand drawCommand;
+		drawCommand.pipelineModule = instanceGroup.pipelineModule.get();
+		drawCommand.vertexBuffer = firstGameObject->GetVertexBuffer();
+		drawCommand.instanceBuffer = instanceBuffer;
+		drawCommand.indexBuffer = firstGameObject->GetIndexBuffer();
+		drawCommand.vertexOffset = firstGameObject->GetVertexOffset();
+		drawCommand.firstIndex = firstGameObject->GetFirstIndex();
+		drawCommand.indexCount = firstGameObject->GetIndexCount();
+		drawCommand.instanceCount = static_cast<uint32_t>(
+			instanceGroup.gameObjects.size());
+		drawCommand.firstInstance = instanceGroup.firstInstance;
+		drawCommand.descriptorSet = *firstGameObject->GetDescriptorSetPtr(
+			imageIndex);
+		drawCommand.numDynamicOffsets = firstGameObject->GetDynamicOffsets(
+			imageIndex, drawCommand.dynamicOffsets);
+		drawCommand.indirectBuffer = VK_NULL_HANDLE;
+		// instanced objects are all opaque, so the first object's depth
+		// only breaks ties
+		renderQueue.Add(MakeSortKey(firstGameObject, drawCommand, viewMatrix),
+			drawCommand);
+	}
+}
+
+void GraphicsEngine::CollectDrawCommandsForGpuCullingBatches(
+	uint32_t imageIndex, glm::mat4 const& viewMatrix) {
+	if (gpuCullingBatches.empty()) {
 		return;
 	}
+	VkBuffer instanceBuffer = gpuCullingModule->GetInstanceBuffer(imageIndex);
+	VkBuffer drawCommandBuffer = gpuCullingModule->GetDrawCommandBuffer(
+		imageIndex);
+	VkBuffer drawCountBuffer = gpuCullingModule->GetDrawCountBuffer(imageIndex);
+	uint32_t numBatches = (uint32_t)gpuCullingBatches.size();
+	for (uint32_t batchIndex = 0; batchIndex < numBatches; batchIndex++) {
+		auto const& batch = gpuCullingBatches[batchIndex];
+		auto const& firstGameObject = batch.gameObjects[0];
+
+		// same as instance groups, the first object's descriptor set works
+		// for the whole batch. the culling pass fills in the rest
+		RenderQueue::DrawCommand drawCommand;
+		drawCommand.pipelineModule = batch.pipelineModule.get();
+		drawCommand.vertexBuffer = firstGameObject->GetVertexBuffer();
+		drawCommand.instanceBuffer = instanceBuffer;
+		drawCommand.indexBuffer = firstGameObject->GetIndexBuffer();
+		drawCommand.vertexOffset = 0;
+		drawCommand.firstIndex = 0;
+		drawCommand.indexCount = 0;
+		drawCommand.instanceCount = 0;
+		drawCommand.firstInstance = 0;
+		drawCommand.descriptorSet = *firstGameObject->GetDescriptorSetPtr(
+			imageIndex);
+		drawCommand.numDynamicOffsets = firstGameObject->GetDynamicOffsets(
+			imageIndex, drawCommand.dynamicOffsets);
+		drawCommand.indirectBuffer = drawCommandBuffer;
+		drawCommand.indirectOffset = (VkDeviceSize)batch.firstInstance *
+			GpuCullingModule::drawCommandStride;
+		drawCommand.countBuffer = drawCountBuffer;
+		drawCommand.countOffset = batchIndex * sizeof(uint32_t);
+		drawCommand.maxDrawCount = (uint32_t)batch.gameObjects.size();
+		renderQueue.Add(MakeSortKey(firstGameObject, drawCommand, viewMatrix),
+			drawCommand);
+	}
+}
 
-	// TODO: we can possibly organize game objects based on similar pipelines
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-		pipelineModule->GetPipeline());
-	// bind our vertex buffers
-	VkBuffer vertexBuffers[] = { gameObject->GetVertexBuffer() };
-	VkDeviceSize offsets[] = { 0 };
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+// runs on worker threads. only reads the render queue, which doesn't change
+// until every job is done
+VkCommandBuffer GraphicsEngine::RecordDrawCommands(
+	RecordingJob const& recordingJob, uint32_t imageIndex,
+	CommandBufferModule* commandBufferModule, RenderStatistics& statistics) {
+	VkCommandBuffer commandBuffer = commandBufferModule->GetNextCommandBuffer();
 
-	vkCmdBindIndexBuffer(commandBuffer, gameObject->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	VkCommandBufferInheritanceInfo inheritanceInfo = {};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = renderPassModule->GetRenderPass();
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = swapChainFramebuffers[imageIndex];
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+		VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to begin recording command buffer!");
+	}
+
+	// dynamic state isn't inherited either, and every pipeline leaves
+	// viewport and scissor to the command buffer
+	auto swapChainExtent = swapChainManager->GetSwapChainExtent();
+	VkViewport viewport = {};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = (float)swapChainExtent.width;
+	viewport.height = (float)swapChainExtent.height;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-		pipelineModule->GetLayout(), 0, 1, gameObject->GetDescriptorSetPtr(swapChainIndex),
-		0, nullptr);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(gameObject->GetModel()->GetIndices().size()),
-		1, 0, 0, 0);
+	VkRect2D scissor = {};
+	scissor.offset = { 0, 0 };
+	scissor.extent = swapChainExtent;
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	// secondary command buffers don't inherit bound state, so each job
+	// starts from nothing
+	PipelineModule* boundPipelineModule = nullptr;
+	VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+	VkBuffer boundInstanceBuffer = VK_NULL_HANDLE;
+	VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+	RenderQueue::DrawCommand const* boundDescriptorCommand = nullptr;
+
+	size_t endDrawCommand = recordingJob.firstDrawCommand +
+		recordingJob.numDrawCommands;
+	for (size_t i = recordingJob.firstDrawCommand; i < endDrawCommand; i++) {
+		RenderQueue::DrawCommand const& drawCommand =
+			renderQueue.GetDrawCommand(i);
+		// a new pipeline layout invalidates bound descriptor sets
+		if (drawCommand.pipelineModule != boundPipelineModule) {
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+				drawCommand.pipelineModule->GetPipeline());
+			boundPipelineModule = drawCommand.pipelineModule;
+			boundDescriptorCommand = nullptr;
+			statistics.numPipelineBinds++;
+		}
+		else {
+			statistics.numPipelineBindsElided++;
+		}
+
+		// mesh goes into binding 0, per-instance data into binding 1. meshes
+		// of one vertex layout share an arena, so this mostly happens once
+		// per layout
+		if (drawCommand.vertexBuffer != boundVertexBuffer ||
+			drawCommand.instanceBuffer != boundInstanceBuffer) {
+			VkBuffer vertexBuffers[] = { drawCommand.vertexBuffer,
+				drawCommand.instanceBuffer };
+			VkDeviceSize offsets[] = { 0, 0 };
+			uint32_t numVertexBuffers = drawCommand.instanceBuffer !=
+				VK_NULL_HANDLE ? 2 : 1;
+			vkCmdBindVertexBuffers(commandBuffer, 0, numVertexBuffers,
+				vertexBuffers, offsets);
+			boundVertexBuffer = drawCommand.vertexBuffer;
+			boundInstanceBuffer = drawCommand.instanceBuffer;
+			statistics.numVertexBufferBinds++;
+		}
+		else {
+			statistics.numVertexBufferBindsElided++;
+		}
+
+		if (drawCommand.indexBuffer != boundIndexBuffer) {
+			vkCmdBindIndexBuffer(commandBuffer, drawCommand.indexBuffer, 0,
+				VK_INDEX_TYPE_UINT32);
+			boundIndexBuffer = drawCommand.indexBuffer;
+			statistics.numIndexBufferBinds++;
+		}
+		else {
+			statistics.numIndexBufferBindsElided++;
+		}
+
+		if (boundDescriptorCommand == nullptr ||
+			!HasSameDescriptorBinding(*boundDescriptorCommand, drawCommand)) {
+			vkCmdBindDescriptorSets(commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				drawCommand.pipelineModule->GetLayout(), 0, 1,
+				&drawCommand.descriptorSet, drawCommand.numDynamicOffsets,
+				drawCommand.dynamicOffsets);
+			boundDescriptorCommand = &drawCommand;
+			statistics.numDescriptorSetBinds++;
+		}
+		else {
+			statistics.numDescriptorSetBindsElided++;
+		}
+
+		if (drawCommand.indirectBuffer != VK_NULL_HANDLE) {
+			logicalDeviceManager->GetCmdDrawIndexedIndirectCount()(
+				commandBuffer, drawCommand.indirectBuffer,
+				drawCommand.indirectOffset, drawCommand.countBuffer,
+				drawCommand.countOffset, drawCommand.maxDrawCount,
+				GpuCullingModule::drawCommandStride);
+		}
+		else {
+			statistics.numIndicesDrawn += (size_t)drawCommand.indexCount *
+				drawCommand.instanceCount;
+			vkCmdDrawIndexed(commandBuffer, drawCommand.indexCount,
+				drawCommand.instanceCount, drawCommand.firstIndex,
+				drawCommand.vertexOffset, drawCommand.firstInstance);
+		}
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to record command buffer!");
+	}
+	return commandBuffer;
+}
+
+bool GraphicsEngine::HasSameDescriptorBinding(
+	RenderQueue::DrawCommand const& first,
+	RenderQueue::DrawCommand const& second) {
+	if (first.descriptorSet != second.descriptorSet ||
+		first.numDynamicOffsets != second.numDynamicOffsets) {
+		return false;
+	}
+	for (uint32_t i = 0; i < first.numDynamicOffsets; i++) {
+		if (first.dynamicOffsets[i] != second.dynamicOffsets[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void GraphicsEngine::RecordPrimaryCommandBuffer(uint32_t imageIndex) {
+	FrameRecordingData& frameData = frameRecordingData[imageIndex];
+	VkCommandBuffer commandBuffer =
+		frameData.primaryCommandBufferModule->GetNextCommandBuffer();
+	frameData.primaryCommandBuffer = commandBuffer;
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to begin recording command buffer!");
+	}
+
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = renderPassModule->GetRenderPass();
+	renderPassInfo.framebuffer = swapChainFramebuffers[imageIndex];
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	auto swapChainExtent = swapChainManager->GetSwapChainExtent();
+	renderPassInfo.renderArea.extent = swapChainExtent;
+
+	// order of clear values = order of attachments
+	std::array<VkClearValue, 2> clearValues = {};
+	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
+	clearValues[1].depthStencil = { 1.0f, 0 };
+
+	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+	renderPassInfo.pClearValues = clearValues.data();
+
+	// the culling pass can't run inside the render pass
+	if (gpuCullingEnabled) {
+		gpuCullingModule->RecordCulling(commandBuffer, imageIndex);
+	}
+
+	// draws all live in secondary command buffers
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo,
+		VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	if (!secondaryCommandBuffers.empty()) {
+		vkCmdExecuteCommands(commandBuffer,
+			static_cast<uint32_t>(secondaryCommandBuffers.size()),
+			secondaryCommandBuffers.data());
+	}
+	vkCmdEndRenderPass(commandBuffer);
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to record command buffer!");
+	}
 }
- 
@@ -5,9 +5,13 @@
 #include "Resources/Model.h"
 #include "GameObjects/GameObject.h"
 #include "CommonBufferModule.h"
+#include "RenderQueue.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
 #include <vector>
-#include <stack>
 #include <map>
+#include <set>
+#include <tuple>
 
 class SwapChainManager;
 class GfxDeviceManager;
@@ -17,50 +21,124 @@ class PipelineModule;
 struct GLFWwindow;
 class ImageTextureLoader;
 class ResourceLoader;
+class InstanceBufferModule;
+class GpuCullingModule;
+class UniformRingBufferModule;
+class TextureCreator;
+class ThreadPool;
 
 class GraphicsEngine {
 public:
+	// objects that share a model, pipeline and texture are drawn
+	// with one instanced draw call
+	struct InstanceGroup {
+		std::shared_ptr<PipelineModule> pipelineModule;
+		std::vector<std::shared_ptr<GameObject>> gameObjects;
+		uint32_t firstInstance;
+	};
+
+	// instanced draws in the current frame, and the per-instance data
+	// they read from
+	struct InstancingData {
+		std::vector<InstanceGroup> instanceGroups;
+		std::set<GameObject*> instancedGameObjects;
+		InstanceBufferModule* instanceBufferModule;
+	};
+
+	// counted while recording each frame. elided binds are ones that
+	// were skipped because the state was already bound
+	struct RenderStatistics {
+		// objects outside the view frustum, including parts of ones that are
+		size_t numCulledGameObjects = 0;
+		// the part of those hidden behind occluders, not counting their parts
+		size_t numOccludedGameObjects = 0;
+		// objects handed to the GPU culling pass instead. how many of them
+		// it culls isn't read back
+		size_t numGpuTestedGameObjects = 0;
+		size_t numDrawCommands = 0;
+		size_t numPipelineBinds = 0;
+		size_t numPipelineBindsElided = 0;
+		size_t numVertexBufferBinds = 0;
+		size_t numVertexBufferBindsElided = 0;
+		size_t numIndexBufferBinds = 0;
+		size_t numIndexBufferBindsElided = 0;
+		size_t numDescriptorSetBinds = 0;
+		size_t numDescriptorSetBindsElided = 0;
+		// by direct draws, so what GPU culling lets through isn't included
+		size_t numIndicesDrawn = 0;
+	};
+
 	GraphicsEngine(GfxDeviceManager* gfxDeviceManager,
 				   std::shared_ptr<LogicalDeviceManager> logicalDeviceManager,
 				   ResourceLoader *resourceLoader, VkSurfaceKHR surface,
 				   GLFWwindow* window, VkCommandPool mainCommandPool,
 					VkCommandPoolCreateInfo poolCreateInfo,
+				   ThreadPool* recordingThreadPool,
 				   std::vector<std::shared_ptr<GameObject>>& gameObjects);
 
 	~GraphicsEngine();
 
 	SwapChainManager* GetSwapChainManager() { return swapChainManager; }
 	RenderPassModule* GetRenderPassModule() { return renderPassModule; }
-	// Right now image has one command buffer
+	// valid after RecordCommandsForFrame is called for the image
 	VkCommandBuffer* GetCommandBufferData(int imageIndex) {
-		return commandBufferModules[imageIndex]->GetCommandBuffers().data(); }
+		return &frameRecordingData[imageIndex].primaryCommandBuffer; }
 
-	void ReRecordCommandsForGameObjects(GfxDeviceManager* gfxDeviceManager,
-		ResourceLoader* resourceLoader, std::vector<VkFence> const & inFlightFences,
-		std::vector<std::shared_ptr<GameObject>> const & allGameObjects);
-	
-	void RemoveGameObjectsAndRecordCommands(
-		std::vector<VkFence> const& inFlightFences,
-		std::vector<std::shared_ptr<GameObject>> const & gameObjectsToRemove,
-		std::vector<std::shared_ptr<GameObject>> const & allGameObjectsSansRemovals);
-
-	void RemoveGameObjectsAndReRecordCommandsForAddedGameObjects(
-		GfxDeviceManager* gfxDeviceManager, ResourceLoader* resourceLoader,
-		std::vector<VkFence> const& inFlightFences,
-		std::vector<std::shared_ptr<GameObject>> const & gameObjectsToRemove,
-		std::vector<std::shared_ptr<GameObject>> const & allGameObjectsSansRemovals);
-
-	void RecordCommandBuffersForCommandBufferModule(
-		std::vector<std::shared_ptr<GameObject>> const& gameObjects,
-		CommandBufferModule* commandBufferModule,
-		VkFramebuffer swapChainFramebuffer,
-		int swapChainIndex);
+	// creates pipelines, uniform buffers and descriptor sets for objects
+	// that don't have them yet
+	void AddAndInitializeNewGameObjects(GfxDeviceManager* gfxDeviceManager,
+		ResourceLoader* resourceLoader,
+		std::vector<std::shared_ptr<GameObject>> const & gameObjects);
+
+	// removed objects retire their own GPU resources; pipelines that might
+	// still be bound in frames in flight are kept alive until those finish
+	void RemoveGameObjects(
+		std::vector<std::shared_ptr<GameObject>> const & gameObjectsToRemove);
+
+	// recreates the swapchain and everything sized to it. pipelines, UBOs
+	// and descriptor sets are kept. returns false if the new swapchain
+	// doesn't fit them, in which case the engine has to be rebuilt. the
+	// device has to be idle
+	bool RecreateSwapChain(VkSurfaceKHR surface, GLFWwindow* window);
+
+	// rebuilds the draw list and records it into the image's command
+	// buffers. the GPU has to be done with the image's previous commands
+	void RecordCommandsForFrame(uint32_t imageIndex,
+		std::vector<std::shared_ptr<GameObject>> const & gameObjects,
+		glm::mat4 const& viewMatrix);
+
+	// from the last call to RecordCommandsForFrame
+	RenderStatistics const& GetRenderStatistics() const {
+		return renderStatistics;
+	}
+
+	// instanceable objects are then culled by a compute pass and drawn
+	// with indirect count draws, in batches per pipeline, texture and
+	// geometry arena. everything else is drawn without culling. ignored if
+	// the device can't do it
+	void SetGpuCullingEnabled(bool enabled);
+	bool IsGpuCullingEnabled() const {
+		return gpuCullingEnabled;
+	}
+	bool IsGpuCullingSupported() const;
 
-	void Update(std::vector<VkFence> const& inFlightFences);
+	// objects behind occluders are culled on the CPU after frustum
+	// culling. has no effect while GPU culling is on
+	void SetOcclusionCullingEnabled(bool enabled) {
+		occlusionCullingEnabled = enabled;
+	}
+	bool IsOcclusionCullingEnabled() const {
+		return occlusionCullingEnabled;
+	}
+	OcclusionCuller::Statistics const& GetOcclusionStatistics() const {
+		return occlusionCuller.GetStatistics();
+	}
 
 private:
 	// not owned by us
 	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager;
+	GfxDeviceManager* gfxDeviceManager;
+	ResourceLoader* resourceLoader;
 
 	SwapChainManager* swapChainManager;
 	RenderPassModule* renderPassModule;
@@ -68,37 +146,82 @@ private:
 		gameObjectToPipelineModule;
 
 	VkImage colorImage;
-	VkDeviceMemory colorImageMemory;
+	MemoryAllocator::Allocation colorImageAllocation;
 	VkImageView colorImageView;
 
 	VkImage depthImage;
-	VkDeviceMemory depthImageMemory;
+	MemoryAllocator::Allocation depthImageAllocation;
 	VkImageView depthImageView;
 
 	std::vector<VkFramebuffer> swapChainFramebuffers;
 
-	// so that we can parallelize command buffer recording
-	// create a vector of them
-	std::vector<CommandBufferModule*> commandBufferModules;
-	std::vector<CommandBufferModule*> commandBufferModulesPending;
-	std::stack<std::shared_ptr<GameObject>> gameObjectsPipelinesPendingRemoval;
-	bool pendingCommandModules;
+	// command buffers are re-recorded every frame. each swap chain image
+	// has its own pools, which get reset once its previous frame is done
+	struct FrameRecordingData {
+		CommandBufferModule* primaryCommandBufferModule;
+		VkCommandBuffer primaryCommandBuffer;
+		// one per worker thread, since pools can't be shared between threads
+		std::vector<CommandBufferModule*> secondaryCommandBufferModules;
+	};
+
+	// a slice of the render queue that gets recorded by one worker
+	struct RecordingJob {
+		size_t firstDrawCommand;
+		size_t numDrawCommands;
+	};
+
+	// not owned by us
+	ThreadPool* recordingThreadPool;
+	std::vector<FrameRecordingData> frameRecordingData;
+
+	// rebuilt and sorted every frame. ids that go into the sort keys are
+	// handed out in the order resources are first seen
+	FrustumCuller frustumCuller;
+	OcclusionCuller occlusionCuller;
+	bool occlusionCullingEnabled;
+	RenderQueue renderQueue;
+	std::map<void const*, uint32_t> pipelineSortIds;
+	std::map<void const*, uint32_t> materialSortIds;
+	std::map<void const*, uint32_t> meshSortIds;
+	std::vector<RecordingJob> recordingJobs;
+	// one per job so workers don't share counters
+	std::vector<RenderStatistics> jobStatistics;
+	RenderStatistics renderStatistics;
+	std::vector<VkCommandBuffer> secondaryCommandBuffers;
+	static const size_t maxDrawCommandsPerJob;
+
+	InstancingData* instancingData;
+	// instanced variants of regular pipelines. holding on to the regular
+	// pipeline keeps its address from being reused while cached
+	std::map<std::shared_ptr<PipelineModule>, std::shared_ptr<PipelineModule>>
+		instancedPipelineModules;
+	static const size_t minInstancesPerGroup;
+
+	// null until GPU culling is first turned on. batches reuse InstanceGroup,
+	// with firstInstance being the batch's first slot in the culling
+	// pass's output
+	GpuCullingModule* gpuCullingModule;
+	bool gpuCullingEnabled;
+	// objects keep the culled flag from the last CPU pass otherwise
+	bool culledFlagsNeedReset;
+	std::vector<InstanceGroup> gpuCullingBatches;
+
+	// all game object UBOs live here
+	std::shared_ptr<UniformRingBufferModule> uniformRingBuffer;
+	static const VkDeviceSize uniformRingBufferRegionSize;
 	
-	void AddAndInitializeNewGameObjects(GfxDeviceManager* gfxDeviceManager,
-										ResourceLoader* resourceLoader,
-										std::vector<std::shared_ptr<GameObject>>& gameObjects);
 	void SetGameObjectsInitalizedRecursively(std::vector<std::shared_ptr<GameObject>> const & gameObjects);
 
 	void CleanUpSwapChain();
+	void DestroyFramebuffers();
+	void DestroyAttachments();
 	void CreateSwapChain(GfxDeviceManager* gfxDeviceManager,
 		VkSurfaceKHR surface, GLFWwindow* window);
 	void CreateSwapChainImageViews();
 	void CreateRenderPassModule(GfxDeviceManager* gfxDeviceManager);
 
-	void CreateColorResources(GfxDeviceManager* gfxDeviceManager,
-		VkCommandPool commandPool);
-	void CreateDepthResources(GfxDeviceManager* gfxDeviceManager,
-		VkCommandPool commandPool);
+	void CreateColorResources(GfxDeviceManager* gfxDeviceManager);
+	void CreateDepthResources(GfxDeviceManager* gfxDeviceManager);
 	void CreateFramebuffers();
 
 	void AddGraphicsPipelinesFromGameObjects(GfxDeviceManager* gfxDeviceManager,
@@ -112,22 +235,54 @@ private:
 		ResourceLoader* resourceLoader);
 	std::shared_ptr<PipelineModule>
 		FindMatchingPipelineFromAnotherGameObject(std::shared_ptr<GameObject> const& gameObject);
-	void RemoveGraphicsPipelinesFromPendingGameObjects();
-	void RemoveGameObjectToPipelineRecursive(std::shared_ptr<GameObject> const& gameObject);
+	void RetireGameObjectRecursive(std::shared_ptr<GameObject> const& gameObject);
 
-	void CreateUniformBuffersForGameObjects(GfxDeviceManager* gfxDeviceManager,
+	void CreateUniformBuffersForGameObjects(
 		std::vector<std::shared_ptr<GameObject>> const & gameObjects);
 	void CreateDescriptorPoolAndSetsForGameObjects(
 		std::vector<std::shared_ptr<GameObject>> const & gameObjects);
-	void CreateCommandBuffersForGameObjects(
-		std::vector<std::shared_ptr<GameObject>> const & gameObjects,
-		std::vector<CommandBufferModule*> commandBufferModulesToUse);
+	void CreateFrameRecordingData(VkCommandPoolCreateInfo const& poolCreateInfo);
+	void DestroyFrameRecordingData();
+
+	void BuildInstanceGroups(std::vector<std::shared_ptr<GameObject>> const& gameObjects);
+	void CollectInstancingCandidates(
+		std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+		std::map<std::tuple<Model*, size_t, PipelineModule*, TextureCreator*>,
+			std::vector<std::shared_ptr<GameObject>>>& candidateGroups);
+	std::shared_ptr<PipelineModule> GetOrCreateInstancedPipeline(
+		std::shared_ptr<GameObject> const& gameObject,
+		std::shared_ptr<PipelineModule> const& regularPipelineModule);
+	void UpdateInstanceBuffer(uint32_t imageIndex);
+	void BuildGpuCullingBatches(
+		std::vector<std::shared_ptr<GameObject>> const& gameObjects);
+	void CollectGpuCullingCandidates(
+		std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+		std::map<std::tuple<PipelineModule*, TextureCreator*, VkBuffer, VkBuffer>,
+			std::vector<std::shared_ptr<GameObject>>>& candidateBatches);
+	size_t WriteGpuCullingObjects(uint32_t imageIndex,
+		glm::mat4 const& viewProjection);
 
-	void RecordCommandForGameObjects(VkCommandBuffer& commandBuffer,
+	static uint32_t GetSortId(std::map<void const*, uint32_t>& sortIds,
+		void const* resource);
+	uint64_t MakeSortKey(std::shared_ptr<GameObject> const& gameObject,
+		RenderQueue::DrawCommand const& drawCommand, glm::mat4 const& viewMatrix);
+	void CollectDrawCommandsForGameObjects(
 		std::vector<std::shared_ptr<GameObject>> const & gameObjects,
-		bool renderOnlyTransparent,
-		int swapChainIndex);
-	void RecordCommandForGameObject(VkCommandBuffer& commandBuffer,
-		std::shared_ptr<GameObject> const & gameObject, bool renderOnlyTransparent,
-		int swapChainIndex);
+		uint32_t imageIndex, glm::mat4 const& viewMatrix);
+	void CollectDrawCommandForGameObject(
+		std::shared_ptr<GameObject> const & gameObject, uint32_t imageIndex,
+		glm::mat4 const& viewMatrix);
+	void CollectDrawCommandsForInstanceGroups(uint32_t imageIndex,
+		glm::mat4 const& viewMatrix);
+	void CollectDrawCommandsForGpuCullingBatches(uint32_t imageIndex,
+		glm::mat4 const& viewMatrix);
+	void BuildRenderQueue(std::vector<std::shared_ptr<GameObject>> const & gameObjects,
+		uint32_t imageIndex, glm::mat4 const& viewMatrix);
+
+	VkCommandBuffer RecordDrawCommands(RecordingJob const& recordingJob,
+		uint32_t imageIndex, CommandBufferModule* commandBufferModule,
+		RenderStatistics& statistics);
+	static bool HasSameDescriptorBinding(RenderQueue::DrawCommand const& first,
+		RenderQueue::DrawCommand const& second);
+	void RecordPrimaryCommandBuffer(uint32_t imageIndex);
 };
@@ -0,0 +1,62 @@
+#include "InstanceBufferModule.h"
+#include "LogicalDeviceManager.h"
+#include "GfxDeviceManager.h"
+#include "Common.h"
+#include "Vertex.h"
+#include <stdexcept>
+
+const size_t InstanceBufferModule::minCapacity = 64;
+
+InstanceBufferModule::InstanceBufferModule(size_t numSwapChainImages,
+	LogicalDeviceManager* logicalDeviceManager,
+	GfxDeviceManager* gfxDeviceManager) :
+	logicalDeviceManager(logicalDeviceManager),
+	gfxDeviceManager(gfxDeviceManager),
+	numSwapChainImages(numSwapChainImages) {
+	instanceBuffers.resize(numSwapChainImages);
+	instanceBufferAllocations.resize(numSwapChainImages);
+	capacities.resize(numSwapChainImages, 0);
+	for (size_t i = 0; i < numSwapChainImages; i++) {
+		CreateBuffer(i, minCapacity);
+	}
+}
+
+InstanceBufferModule::~InstanceBufferModule() {
+	for (size_t i = 0; i < numSwapChainImages; i++) {
+		DestroyBuffer(i);
+	}
+}
+
+void InstanceBufferModule::ReserveInstances(size_t swapChainIndex,
+	size_t numInstances) {
+	size_t capacity = capacities[swapChainIndex];
+	if (numInstances <= capacity) {
+		return;
+	}
+
+	// double so that steady spawning doesn't resize every time
+	size_t newCapacity = capacity;
+	while (newCapacity < numInstances) {
+		newCapacity *= 2;
+	}
+	DestroyBuffer(swapChainIndex);
+	CreateBuffer(swapChainIndex, newCapacity);
+}
+
+void InstanceBufferModule::CreateBuffer(size_t swapChainIndex,
+	size_t numInstances) {
+	VkDeviceSize bufferSize = sizeof(InstanceData) * numInstances;
+
+	// host-visible allocations stay mapped
+	Common::CreateBuffer(logicalDeviceManager, gfxDeviceManager, bufferSize,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		instanceBuffers[swapChainIndex], instanceBufferAllocations[swapChainIndex]);
+	capacities[swapChainIndex] = numInstances;
+}
+
+void InstanceBufferModule::DestroyBuffer(size_t swapChainIndex) {
+	Common::DestroyBuffer(logicalDeviceManager, instanceBuffers[swapChainIndex],
+		instanceBufferAllocations[swapChainIndex]);
+	capacities[swapChainIndex] = 0;
+}
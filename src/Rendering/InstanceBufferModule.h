@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include "MemoryAllocator.h"
+#include <vector>
+
+class GfxDeviceManager;
+class LogicalDeviceManager;
+
+// Per-instance data used by instanced draws. There is one buffer per
+// swap chain image, and each one stays mapped for its whole lifetime.
+class InstanceBufferModule {
+public:
+	InstanceBufferModule(size_t numSwapChainImages,
+		LogicalDeviceManager* logicalDeviceManager,
+		GfxDeviceManager* gfxDeviceManager);
+	~InstanceBufferModule();
+
+	// grows the buffer of one swap chain image if it can't hold the number
+	// of instances requested. the old buffer is destroyed right away, so the
+	// caller has to make sure the GPU is done with that image
+	void ReserveInstances(size_t swapChainIndex, size_t numInstances);
+
+	VkBuffer GetInstanceBuffer(size_t swapChainIndex) const {
+		return instanceBuffers[swapChainIndex];
+	}
+
+	void* GetMappedData(size_t swapChainIndex) const {
+		return instanceBufferAllocations[swapChainIndex].mappedData;
+	}
+
+	size_t GetCapacity(size_t swapChainIndex) const {
+		return capacities[swapChainIndex];
+	}
+
+private:
+	// not owned by us
+	LogicalDeviceManager* logicalDeviceManager;
+	GfxDeviceManager* gfxDeviceManager;
+
+	size_t numSwapChainImages;
+	std::vector<size_t> capacities;
+	std::vector<VkBuffer> instanceBuffers;
+	std::vector<MemoryAllocator::Allocation> instanceBufferAllocations;
+
+	static const size_t minCapacity;
+
+	void CreateBuffer(size_t swapChainIndex, size_t numInstances);
+	void DestroyBuffer(size_t swapChainIndex);
+};
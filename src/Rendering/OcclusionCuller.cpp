@@ -0,0 +1,139 @@
+#include "OcclusionCuller.h"
+#include "GameObjects/GameObject.h"
+#include "Resources/Model.h"
+
+// small enough to fill quickly, big enough that pawns and bullets still
+// cover a few pixels
+const uint32_t OcclusionCuller::bufferWidth = 256;
+const uint32_t OcclusionCuller::bufferHeight = 128;
+const size_t OcclusionCuller::maxTrianglesPerOccluder = 65536;
+
+OcclusionCuller::OcclusionCuller() :
+	occlusionBuffer(bufferWidth, bufferHeight) {
+}
+
+size_t OcclusionCuller::CullGameObjects(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+	glm::mat4 const& viewProjection) {
+	statistics = Statistics();
+	occlusionBuffer.Clear();
+	RasterizeOccluders(gameObjects, viewProjection);
+	statistics.numOccluderTriangles =
+		occlusionBuffer.GetNumRasterizedTriangles();
+	// nothing can be hidden
+	if (statistics.numOccluderTriangles == 0) {
+		return 0;
+	}
+	occlusionBuffer.BuildHierarchy();
+
+	testEntries.clear();
+	for (auto const& gameObject : gameObjects) {
+		AddSubtree(gameObject.get());
+	}
+
+	size_t numEntries = testEntries.size();
+	for (size_t i = 0; i < numEntries;) {
+		TestEntry const& testEntry = testEntries[i];
+		// frustum culling already took care of these and their children
+		if (testEntry.gameObject->IsCulled()) {
+			i = testEntry.subtreeEnd;
+			continue;
+		}
+		if (testEntry.unbounded || testEntry.subtreeBounds.IsEmpty()) {
+			i++;
+			continue;
+		}
+
+		statistics.numTestedGameObjects++;
+		if (!occlusionBuffer.IsBoxVisible(testEntry.subtreeBounds.GetCenter(),
+			testEntry.subtreeBounds.GetExtents(), viewProjection)) {
+			testEntry.gameObject->SetCulled(true);
+			statistics.numOccludedGameObjects++;
+			i = testEntry.subtreeEnd;
+		}
+		else {
+			i++;
+		}
+	}
+	return statistics.numOccludedGameObjects;
+}
+
+void OcclusionCuller::RasterizeOccluders(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+	glm::mat4 const& viewProjection) {
+	for (auto const& gameObject : gameObjects) {
+		if (gameObject->IsCulled()) {
+			continue;
+		}
+		if (gameObject->IsOccluder() && !gameObject->IsInvisible() &&
+			gameObject->IsReadyToDraw()) {
+			RasterizeOccluder(gameObject.get(), viewProjection);
+		}
+		RasterizeOccluders(gameObject->GetChildren(), viewProjection);
+	}
+}
+
+void OcclusionCuller::RasterizeOccluder(GameObject* gameObject,
+	glm::mat4 const& viewProjection) {
+	std::shared_ptr<Model> model = gameObject->GetOccluderModel();
+	if (model == nullptr) {
+		return;
+	}
+	auto& vertices = model->GetVertices();
+	auto const& indices = model->GetIndices();
+	bool isTriangleStrip = model->GetTopologyType() ==
+		Model::TopologyType::TriangleStrip;
+	size_t numTriangles = isTriangleStrip ?
+		(indices.size() >= 3 ? indices.size() - 2 : 0) : indices.size() / 3;
+	if (numTriangles == 0 || numTriangles > maxTrianglesPerOccluder) {
+		return;
+	}
+
+	glm::mat4 localToClip = viewProjection * gameObject->GetLocalToWorld();
+	clipPositions.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++) {
+		clipPositions[i] = localToClip * glm::vec4(vertices[i].position, 1.0f);
+	}
+
+	if (isTriangleStrip) {
+		// winding doesn't matter, since both sides are drawn
+		stripIndices.clear();
+		for (size_t i = 0; i < numTriangles; i++) {
+			stripIndices.push_back(indices[i]);
+			stripIndices.push_back(indices[i + 1]);
+			stripIndices.push_back(indices[i + 2]);
+		}
+		occlusionBuffer.RasterizeTriangles(clipPositions.data(),
+			stripIndices.data(), stripIndices.size());
+	}
+	else {
+		occlusionBuffer.RasterizeTriangles(clipPositions.data(),
+			indices.data(), indices.size());
+	}
+	statistics.numOccluders++;
+}
+
+void OcclusionCuller::AddSubtree(GameObject* gameObject) {
+	size_t index = testEntries.size();
+	TestEntry testEntry;
+	testEntry.gameObject = gameObject;
+	testEntry.subtreeBounds = gameObject->GetWorldBounds();
+	// something that draws without bounds can't be hidden, and neither
+	// can anything above it
+	testEntry.unbounded = testEntry.subtreeBounds.IsEmpty() &&
+		!gameObject->IsInvisible();
+	testEntries.push_back(testEntry);
+
+	for (auto const& child : gameObject->GetChildren()) {
+		size_t childIndex = testEntries.size();
+		AddSubtree(child.get());
+		TestEntry const& childEntry = testEntries[childIndex];
+		if (childEntry.unbounded) {
+			testEntries[index].unbounded = true;
+		}
+		else if (!childEntry.subtreeBounds.IsEmpty()) {
+			testEntries[index].subtreeBounds.Merge(childEntry.subtreeBounds);
+		}
+	}
+	testEntries[index].subtreeEnd = testEntries.size();
+}
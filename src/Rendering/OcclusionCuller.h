@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Math/BoundingVolumes.h"
+#include "Math/OcclusionBuffer.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class GameObject;
+
+// Runs after frustum culling. Draws the models of visible occluders into a
+// CPU depth buffer, then flags objects whose bounds are entirely behind
+// them as culled. Like frustum culling, objects are tested with the bounds
+// of their whole subtree, so hidden parents take their parts with them.
+class OcclusionCuller {
+public:
+	// for the last call to CullGameObjects
+	struct Statistics {
+		size_t numOccluders = 0;
+		size_t numOccluderTriangles = 0;
+		size_t numTestedGameObjects = 0;
+		size_t numOccludedGameObjects = 0;
+	};
+
+	OcclusionCuller();
+
+	// returns the number of objects flagged as culled
+	size_t CullGameObjects(
+		std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+		glm::mat4 const& viewProjection);
+
+	Statistics const& GetStatistics() const {
+		return statistics;
+	}
+
+private:
+	// the scene graph flattened in depth-first order. subtreeEnd is one
+	// past the object's last descendant
+	struct TestEntry {
+		GameObject* gameObject;
+		AABB subtreeBounds;
+		bool unbounded;
+		size_t subtreeEnd;
+	};
+
+	OcclusionBuffer occlusionBuffer;
+	std::vector<TestEntry> testEntries;
+	std::vector<glm::vec4> clipPositions;
+	std::vector<uint32_t> stripIndices;
+	Statistics statistics;
+
+	static const uint32_t bufferWidth;
+	static const uint32_t bufferHeight;
+	// anything bigger should give a simpler occluder model
+	static const size_t maxTrianglesPerOccluder;
+
+	void RasterizeOccluders(
+		std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+		glm::mat4 const& viewProjection);
+	void RasterizeOccluder(GameObject* gameObject,
+		glm::mat4 const& viewProjection);
+	void AddSubtree(GameObject* gameObject);
+};
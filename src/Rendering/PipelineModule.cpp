@@ -7,13 +7,16 @@
 
 PipelineModule::PipelineModule(const std::string& vertShaderName,
 	const std::string& fragShaderName, VkDevice device,
-	VkExtent2D swapChainExtent, GfxDeviceManager* gfxDeviceManager,
+	GfxDeviceManager* gfxDeviceManager,
 	ResourceLoader* resourceLoader,
 	VkDescriptorSetLayout descriptorSetLayout,
 	VkRenderPass renderPass,
 	DescriptorSetFunctions::MaterialType materialType,
-	VkPrimitiveTopology primitiveTopology) : device(device),
-	materialType(materialType), primitiveTopology(primitiveTopology) {
+	VkPrimitiveTopology primitiveTopology,
+	VkPipelineCache pipelineCache,
+	bool instanced) : device(device),
+	materialType(materialType), primitiveTopology(primitiveTopology),
+	instanced(instanced) {
 #if __APPLE__
 	std::shared_ptr<ShaderLoader> vertShaderModule = resourceLoader->GetShader(
 	"../../shaders/" + vertShaderName, device);
@@ -90,34 +93,39 @@ std::shared_ptr<ShaderLoader> fragShaderModule = resourceLoader->GetShader(
 		}
 	}
 	
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.vertexAttributeDescriptionCount = (uint32_t)numAttrib;
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-	vertexInputInfo.pVertexAttributeDescriptions = attribDescriptionArray;
+	// instanced pipelines read per-instance data from a second binding
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions = {
+		bindingDescription
+	};
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions(
+		attribDescriptionArray, attribDescriptionArray + numAttrib);
+	if (instanced) {
+		bindingDescriptions.push_back(InstanceData::GetBindingDescription());
+		auto instanceAttributeDescriptions =
+			InstanceData::GetAttributeDescriptions((uint32_t)numAttrib);
+		attributeDescriptions.insert(attributeDescriptions.end(),
+			instanceAttributeDescriptions.begin(),
+			instanceAttributeDescriptions.end());
+	}
+
+	vertexInputInfo.vertexBindingDescriptionCount = (uint32_t)bindingDescriptions.size();
+	vertexInputInfo.vertexAttributeDescriptionCount = (uint32_t)attributeDescriptions.size();
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
 	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 	inputAssembly.topology = primitiveTopology;
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-	VkViewport viewport = {};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = (float)swapChainExtent.width;
-	viewport.height = (float)swapChainExtent.height;
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	VkRect2D scissor = {};
-	scissor.offset = { 0, 0 };
-	scissor.extent = swapChainExtent;
-
+	// viewport and scissor are set when recording, so pipelines don't
+	// depend on the swapchain's size and survive a resize
 	VkPipelineViewportStateCreateInfo viewportState = {};
 	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewport;
+	viewportState.pViewports = nullptr;
 	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
+	viewportState.pScissors = nullptr;
 
 	VkPipelineRasterizationStateCreateInfo rasterizer = {};
 	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -164,15 +172,15 @@ std::shared_ptr<ShaderLoader> fragShaderModule = resourceLoader->GetShader(
 	colorBlending.blendConstants[2] = 0.0f; // optional
 	colorBlending.blendConstants[3] = 0.0f; // optional
 
-	/*VkDynamicState dynamicStates[] = {
+	VkDynamicState dynamicStates[] = {
 		VK_DYNAMIC_STATE_VIEWPORT,
-		VK_DYNAMIC_STATE_LINE_WIDTH
+		VK_DYNAMIC_STATE_SCISSOR
 	};
 
 	VkPipelineDynamicStateCreateInfo dynamicState = {};
 	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
 	dynamicState.dynamicStateCount = 2;
-	dynamicState.pDynamicStates = dynamicStates;*/
+	dynamicState.pDynamicStates = dynamicStates;
 
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -200,7 +208,7 @@ std::shared_ptr<ShaderLoader> fragShaderModule = resourceLoader->GetShader(
 	pipelineInfo.pMultisampleState = &multiSampling;
 	pipelineInfo.pDepthStencilState = &depthStencil;
 	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.pDynamicState = nullptr;
+	pipelineInfo.pDynamicState = &dynamicState;
 
 	pipelineInfo.layout = pipelineLayout;
 	pipelineInfo.renderPass = renderPass;
@@ -208,7 +216,7 @@ std::shared_ptr<ShaderLoader> fragShaderModule = resourceLoader->GetShader(
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1,
+	VkResult result = vkCreateGraphicsPipelines(device, pipelineCache, 1,
 		&pipelineInfo, nullptr, &graphicsPipeline);
 	std::cout << "Pipeline result " << result << std::endl;
 	if (result != VK_SUCCESS) {
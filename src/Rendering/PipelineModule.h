@@ -11,12 +11,14 @@ class PipelineModule {
 public:
 	PipelineModule(const std::string& vertShaderName,
 		const std::string& fragShaderName, VkDevice device,
-		VkExtent2D swapChainExtent, GfxDeviceManager *gfxDeviceManager,
+		GfxDeviceManager *gfxDeviceManager,
 		ResourceLoader *resourceLoader,
 		VkDescriptorSetLayout descriptorSetLayout,
 		VkRenderPass renderPass,
 		DescriptorSetFunctions::MaterialType materialType,
-		VkPrimitiveTopology primitiveTopology);
+		VkPrimitiveTopology primitiveTopology,
+		VkPipelineCache pipelineCache,
+		bool instanced = false);
 
 	~PipelineModule();
 
@@ -34,6 +36,10 @@ public:
 			this->primitiveTopology == iPrimitiveTopology;
 	}
 
+	bool IsInstanced() const {
+		return instanced;
+	}
+
 private:
 	VkPipelineLayout pipelineLayout;
 	VkDevice device;
@@ -41,6 +47,7 @@ private:
 
 	DescriptorSetFunctions::MaterialType materialType;
 	VkPrimitiveTopology primitiveTopology;
+	bool instanced;
 
 	VkPipelineColorBlendAttachmentState SpecifyBlendStateForMaterial(
 		DescriptorSetFunctions::MaterialType materialType);
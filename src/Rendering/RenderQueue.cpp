@@ -0,0 +1,83 @@
+#include "RenderQueue.h"
+#include "Math/CommonMath.h"
+#include <algorithm>
+
+// pass takes the top two bits, and the rest add up to 62
+const uint32_t RenderQueue::pipelineIdBits = 12;
+const uint32_t RenderQueue::materialIdBits = 14;
+const uint32_t RenderQueue::meshIdBits = 12;
+const uint32_t RenderQueue::depthBits = 24;
+
+uint64_t RenderQueue::MakeSortKey(Pass pass, uint32_t pipelineId,
+	uint32_t materialId, uint32_t meshId, float viewDepth) {
+	// depth is quantized over the whole view range
+	float normalizedDepth = std::min(std::max(viewDepth /
+		CommonMath::farPlaneDistance, 0.0f), 1.0f);
+	uint64_t depthMask = (1ull << depthBits) - 1;
+	uint64_t depth = (uint64_t)(normalizedDepth * (float)depthMask);
+
+	uint64_t pipelineField = pipelineId & ((1ull << pipelineIdBits) - 1);
+	uint64_t materialField = materialId & ((1ull << materialIdBits) - 1);
+	uint64_t meshField = meshId & ((1ull << meshIdBits) - 1);
+	uint64_t stateFields = (pipelineField << (materialIdBits + meshIdBits)) |
+		(materialField << meshIdBits) | meshField;
+	uint64_t sortKey = (uint64_t)pass << 62;
+
+	if (pass == Pass::Opaque) {
+		// front to back within the same state, so early depth
+		// testing can reject more
+		sortKey |= stateFields << depthBits;
+		sortKey |= depth;
+	}
+	else {
+		// back to front comes before state
+		sortKey |= (depthMask - depth) << (62 - depthBits);
+		sortKey |= stateFields;
+	}
+	return sortKey;
+}
+
+void RenderQueue::Clear() {
+	drawCommands.clear();
+	sortEntries.clear();
+}
+
+void RenderQueue::Add(uint64_t sortKey, DrawCommand const& drawCommand) {
+	SortEntry sortEntry;
+	sortEntry.sortKey = sortKey;
+	sortEntry.drawCommandIndex = (uint32_t)drawCommands.size();
+	sortEntries.push_back(sortEntry);
+	drawCommands.push_back(drawCommand);
+}
+
+void RenderQueue::Sort() {
+	// LSD radix sort, a byte at a time. it's stable, so draws with
+	// the same key stay in the order they were added
+	size_t numEntries = sortEntries.size();
+	scratchEntries.resize(numEntries);
+	for (uint32_t shift = 0; shift < 64; shift += 8) {
+		size_t counts[256] = {};
+		for (auto const& sortEntry : sortEntries) {
+			counts[(sortEntry.sortKey >> shift) & 0xff]++;
+		}
+		// skip bytes that are the same for every key, which is most
+		// of them when there aren't many pipelines or materials
+		uint64_t firstByte = numEntries > 0 ?
+			(sortEntries[0].sortKey >> shift) & 0xff : 0;
+		if (counts[firstByte] == numEntries) {
+			continue;
+		}
+
+		size_t offsets[256];
+		size_t offset = 0;
+		for (size_t i = 0; i < 256; i++) {
+			offsets[i] = offset;
+			offset += counts[i];
+		}
+		for (auto const& sortEntry : sortEntries) {
+			scratchEntries[offsets[(sortEntry.sortKey >> shift) & 0xff]++] =
+				sortEntry;
+		}
+		sortEntries.swap(scratchEntries);
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include "GameObjects/GameObject.h"
+#include <cstdint>
+#include <vector>
+
+class PipelineModule;
+
+// Flat list of the draws in a frame. Each draw gets a 64-bit key, and
+// sorting by it puts them in the order they should be recorded in: opaque
+// before transparent, then grouped by pipeline, material and mesh so that
+// neighbors share state. Transparent draws are ordered back to front
+// first, since blending needs that more than it needs fewer binds.
+class RenderQueue {
+public:
+	enum class Pass {
+		Opaque = 0,
+		Transparent
+	};
+
+	// everything needed to record one draw, gathered up front so that
+	// worker threads don't have to touch game objects
+	struct DrawCommand {
+		PipelineModule* pipelineModule;
+		VkBuffer vertexBuffer;
+		// instanced draws bind this to binding 1
+		VkBuffer instanceBuffer;
+		VkBuffer indexBuffer;
+		// meshes share arena buffers, so these say where theirs starts
+		int32_t vertexOffset;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t instanceCount;
+		uint32_t firstInstance;
+		VkDescriptorSet descriptorSet;
+		uint32_t numDynamicOffsets;
+		uint32_t dynamicOffsets[GameObject::maxDynamicOffsets];
+		// set for GPU-culled batches, whose draws and draw count come from
+		// the culling pass. the counts above are unused then
+		VkBuffer indirectBuffer;
+		VkDeviceSize indirectOffset;
+		VkBuffer countBuffer;
+		VkDeviceSize countOffset;
+		uint32_t maxDrawCount;
+	};
+
+	// ids only need to be unique within a frame. ones that don't fit in
+	// their field wrap around, which costs binds but not correctness
+	static uint64_t MakeSortKey(Pass pass, uint32_t pipelineId,
+		uint32_t materialId, uint32_t meshId, float viewDepth);
+
+	void Clear();
+	void Add(uint64_t sortKey, DrawCommand const& drawCommand);
+	void Sort();
+
+	size_t GetNumDrawCommands() const {
+		return sortEntries.size();
+	}
+
+	// in sorted order once Sort has been called
+	DrawCommand const& GetDrawCommand(size_t index) const {
+		return drawCommands[sortEntries[index].drawCommandIndex];
+	}
+
+private:
+	// sorting these instead of the draw commands keeps the moves small
+	struct SortEntry {
+		uint64_t sortKey;
+		uint32_t drawCommandIndex;
+	};
+
+	std::vector<DrawCommand> drawCommands;
+	std::vector<SortEntry> sortEntries;
+	std::vector<SortEntry> scratchEntries;
+
+	static const uint32_t pipelineIdBits;
+	static const uint32_t materialIdBits;
+	static const uint32_t meshIdBits;
+	static const uint32_t depthBits;
+};
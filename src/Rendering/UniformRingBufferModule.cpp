@@ -0,0 +1,78 @@
+#include "UniformRingBufferModule.h"
+#include "LogicalDeviceManager.h"
+#include "GfxDeviceManager.h"
+#include "Common.h"
+#include <iostream>
+#include <stdexcept>
+
+UniformRingBufferModule::UniformRingBufferModule(size_t numSwapChainImages,
+	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
+	GfxDeviceManager* gfxDeviceManager,
+	VkDeviceSize regionSize) :
+	logicalDeviceManager(logicalDeviceManager),
+	gfxDeviceManager(gfxDeviceManager), numSwapChainImages(numSwapChainImages), nextFreeOffset(0) {
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(gfxDeviceManager->GetPhysicalDevice(),
+		&deviceProperties);
+	alignment = deviceProperties.limits.minUniformBufferOffsetAlignment;
+	if (alignment == 0) {
+		alignment = 1;
+	}
+	// each region has to start at an aligned offset too
+	this->regionSize = AlignSize(regionSize);
+	AddBuffer();
+}
+
+UniformRingBufferModule::~UniformRingBufferModule() {
+	for (size_t bufferIndex = 0; bufferIndex < uniformBuffers.size();
+		bufferIndex++) {
+		Common::DestroyBuffer(logicalDeviceManager.get(),
+			uniformBuffers[bufferIndex], uniformBufferAllocations[bufferIndex]);
+	}
+}
+
+void UniformRingBufferModule::AddBuffer() {
+	VkBuffer uniformBuffer;
+	MemoryAllocator::Allocation uniformBufferAllocation;
+	Common::CreateBuffer(logicalDeviceManager.get(), gfxDeviceManager,
+		regionSize * numSwapChainImages, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		uniformBuffer, uniformBufferAllocation);
+	uniformBuffers.push_back(uniformBuffer);
+	uniformBufferAllocations.push_back(uniformBufferAllocation);
+	// the allocator keeps host-visible memory mapped
+	mappedData.push_back((char*)uniformBufferAllocation.mappedData);
+}
+
+VkDeviceSize UniformRingBufferModule::AllocateSlice(VkDeviceSize sliceSize) {
+	VkDeviceSize alignedSize = AlignSize(sliceSize);
+	auto freeSlicesIt = freeSlices.find(alignedSize);
+	if (freeSlicesIt != freeSlices.end() && !freeSlicesIt->second.empty()) {
+		VkDeviceSize sliceOffset = freeSlicesIt->second.back();
+		freeSlicesIt->second.pop_back();
+		return sliceOffset;
+	}
+
+	if (alignedSize > regionSize) {
+		throw std::runtime_error("Failed to allocate uniform ring buffer slice!");
+	}
+	// slices can't straddle two buffers, so the rest of this one is skipped
+	VkDeviceSize offsetInBuffer = nextFreeOffset % regionSize;
+	if (offsetInBuffer + alignedSize > regionSize) {
+		nextFreeOffset += regionSize - offsetInBuffer;
+	}
+	if (nextFreeOffset / regionSize >= uniformBuffers.size()) {
+		AddBuffer();
+		std::cout << "Uniform ring buffer is full, added buffer "
+			<< uniformBuffers.size() << " of " << regionSize / 1024
+			<< " KB per image.\n";
+	}
+	VkDeviceSize sliceOffset = nextFreeOffset;
+	nextFreeOffset += alignedSize;
+	return sliceOffset;
+}
+
+void UniformRingBufferModule::FreeSlice(VkDeviceSize sliceOffset,
+	VkDeviceSize sliceSize) {
+	freeSlices[AlignSize(sliceSize)].push_back(sliceOffset);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include "MemoryAllocator.h"
+#include <map>
+#include <memory>
+#include <vector>
+
+class GfxDeviceManager;
+class LogicalDeviceManager;
+
+// One big uniform buffer that all game objects write their UBOs to.
+// It is split into a region per swap chain image, and each object gets a
+// slice at the same offset in every region. The buffer is mapped once, and
+// slices are bound with dynamic offsets. When it fills up, another buffer
+// of the same size is added; slices never move, so descriptors pointing at
+// the earlier buffers stay valid. Slice offsets count across all buffers,
+// as if the regions of each buffer followed those of the one before.
+class UniformRingBufferModule {
+public:
+	UniformRingBufferModule(size_t numSwapChainImages,
+		std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
+		GfxDeviceManager* gfxDeviceManager,
+		VkDeviceSize regionSize);
+	~UniformRingBufferModule();
+
+	// returns offset of slice within a region
+	VkDeviceSize AllocateSlice(VkDeviceSize sliceSize);
+	void FreeSlice(VkDeviceSize sliceOffset, VkDeviceSize sliceSize);
+
+	void* GetSliceData(size_t swapChainIndex, VkDeviceSize sliceOffset) const {
+		return mappedData[sliceOffset / regionSize] +
+			swapChainIndex * regionSize + sliceOffset % regionSize;
+	}
+
+	// within the slice's buffer
+	uint32_t GetDynamicOffset(size_t swapChainIndex,
+		VkDeviceSize sliceOffset) const {
+		return static_cast<uint32_t>(swapChainIndex * regionSize +
+			sliceOffset % regionSize);
+	}
+
+	// buffer the slice lives in
+	VkBuffer GetUniformBuffer(VkDeviceSize sliceOffset) const {
+		return uniformBuffers[sliceOffset / regionSize];
+	}
+
+	VkDeviceSize GetRegionSize() const {
+		return regionSize;
+	}
+
+	size_t GetNumBuffers() const {
+		return uniformBuffers.size();
+	}
+
+private:
+	// ring buffer can outlive the graphics engine, since game objects
+	// hold on to it
+	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager;
+	GfxDeviceManager* gfxDeviceManager;
+
+	std::vector<VkBuffer> uniformBuffers;
+	std::vector<MemoryAllocator::Allocation> uniformBufferAllocations;
+	std::vector<char*> mappedData;
+
+	size_t numSwapChainImages;
+	VkDeviceSize regionSize;
+	VkDeviceSize alignment;
+	VkDeviceSize nextFreeOffset;
+	// freed slices, keyed by aligned size. objects tend to use the same
+	// few sizes, so these get reused quickly
+	std::map<VkDeviceSize, std::vector<VkDeviceSize>> freeSlices;
+
+	void AddBuffer();
+
+	VkDeviceSize AlignSize(VkDeviceSize size) const {
+		return (size + alignment - 1) & ~(alignment - 1);
+	}
+};
@@ -6,12 +6,28 @@
 #include <iostream>
 #include <vector>
 #include <set>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
 #include "Math/NoiseGenerator.h"
 #include "Math/PerlinNoise.h"
 #include "Math/CommonMath.h"
+#include "Math/MeshSimplifier.h"
+#include "ThreadPool.h"
+#include <atomic>
 
 // TODO: http://www.songho.ca/opengl/gl_cylinder.html
 
+const uint32_t Model::maxLodLevels = 4;
+// a quarter of the screen is about where a sphere with a quarter of the
+// triangles stops looking faceted
+const float Model::firstLodScreenSize = 0.25f;
+// anything smaller is cheap enough to draw as it is
+const size_t Model::minTrianglesToSimplify = 256;
+const uint32_t Model::minPlaneLodDivisions = 8;
+// small enough that a 1000x1000 plane keeps every worker busy
+const uint32_t Model::planeTilePoints = 16384;
+
 Model::Model(const std::string& modelPath) {
 	tinyobj::attrib_t attrib;
 	std::vector<tinyobj::shape_t> shapes;
@@ -65,17 +81,102 @@ Model::Model(const std::string& modelPath) {
 	}
 
 	modelTopology = TopologyType::TriangleList;
+	RecomputeBounds();
+	AddSimplifiedLods();
 }
 
 Model::Model(const std::vector<ModelVert>& vertices,
 	  const std::vector<uint32_t>& indices,
 		TopologyType modelTopology) : vertices(vertices),
 	indices(indices), modelTopology(modelTopology) {
+	RecomputeBounds();
+}
+
+void Model::RecomputeBounds() {
+	boundingBox = AABB();
+	for (auto const& vertex : vertices) {
+		boundingBox.AddPoint(vertex.position);
+	}
+
+	// centered on the box, so it's not the tightest sphere possible, but
+	// it only takes one more pass
+	if (boundingBox.IsEmpty()) {
+		boundingSphere = BoundingSphere();
+		return;
+	}
+	glm::vec3 center = boundingBox.GetCenter();
+	float maxDistanceSquared = 0.0f;
+	for (auto const& vertex : vertices) {
+		glm::vec3 offset = vertex.position - center;
+		maxDistanceSquared = std::max(maxDistanceSquared,
+			glm::dot(offset, offset));
+	}
+	boundingSphere = BoundingSphere(center, sqrtf(maxDistanceSquared));
 }
 
 Model::~Model() {
 }
 
+void Model::AddLod(std::shared_ptr<Model> const& lodModel,
+	float maxScreenSize) {
+	if (lodModel->modelTopology != modelTopology) {
+		throw std::runtime_error("Failed to add level of detail: topology "
+			"doesn't match the model's!");
+	}
+	lods.push_back({ lodModel, maxScreenSize });
+}
+
+float Model::GetLodScreenSize(uint32_t lodLevel) {
+	return firstLodScreenSize / (float)(1u << (lodLevel - 1));
+}
+
+void Model::AddSimplifiedLods() {
+	size_t numTriangles = indices.size() / 3;
+	if (numTriangles < minTrianglesToSimplify) {
+		return;
+	}
+
+	std::vector<glm::vec3> positions;
+	positions.reserve(vertices.size());
+	for (auto const& vertex : vertices) {
+		positions.push_back(vertex.position);
+	}
+
+	// each level carries on collapsing from the one before
+	MeshSimplifier meshSimplifier(positions, indices);
+	for (uint32_t lodLevel = 1; lodLevel < maxLodLevels; lodLevel++) {
+		size_t numTrianglesBefore = meshSimplifier.GetNumTriangles();
+		std::vector<uint32_t> lodIndices = meshSimplifier.Simplify(
+			numTriangles >> (2 * lodLevel));
+		// stuck; a level that isn't much cheaper isn't worth switching to
+		if (meshSimplifier.GetNumTriangles() * 4 > numTrianglesBefore * 3) {
+			break;
+		}
+		AddLod(CreateFromTriangles(lodIndices), GetLodScreenSize(lodLevel));
+		if (meshSimplifier.GetNumTriangles() < minTrianglesToSimplify) {
+			break;
+		}
+	}
+}
+
+std::shared_ptr<Model> Model::CreateFromTriangles(
+	std::vector<uint32_t> const& triangleIndices) const {
+	// only keep vertices that are still used
+	std::vector<uint32_t> newIndices(vertices.size(), UINT32_MAX);
+	std::vector<ModelVert> lodVertices;
+	std::vector<uint32_t> lodIndices;
+	lodIndices.reserve(triangleIndices.size());
+	for (uint32_t index : triangleIndices) {
+		if (newIndices[index] == UINT32_MAX) {
+			newIndices[index] = (uint32_t)lodVertices.size();
+			lodVertices.push_back(vertices[index]);
+		}
+		lodIndices.push_back(newIndices[index]);
+	}
+	return std::make_shared<Model>(lodVertices, lodIndices,
+		TopologyType::TriangleList);
+}
+
 std::shared_ptr<Model> Model::CreateQuad(
 	glm::vec3 const& quadOrigin,
 	glm::vec3 const& side1Vec, glm::vec3 const& side2Vec,
@@ -202,11 +303,8 @@ std::shared_ptr<Model> Model::CreatePlane(const glm::vec3& lowerLeft,
 	const glm::vec3& side1Vec, const glm::vec3& side2Vec,
 	uint32_t numSide1Points, uint32_t numSide2Points,
 	NoiseGeneratorType noiseGeneratorType,
-	uint32_t numNoiseLayers)
+	uint32_t numNoiseLayers, ThreadPool* threadPool)
 {
-	std::vector<ModelVert> vertices;
-	std::vector<uint32_t> indices;
-
 	// make sure side1 and side2 are perpendicular
 	if (fabs(glm::dot(side1Vec, side2Vec)) > 0.0f)
 	{
@@ -215,48 +313,139 @@ std::shared_ptr<Model> Model::CreatePlane(const glm::vec3& lowerLeft,
 		return nullptr;
 	}
 
-	glm::vec3 quadPoint;
 	// if there are n points, there are (n-1) divisions
 	glm::vec3 side1Div = side1Vec / (float)(numSide1Points - 1);
 	glm::vec3 side2Div = side2Vec / (float)(numSide2Points - 1);
-
-	// generate noise, if applicable
-	float* noiseValues;
-	glm::vec3* normValues;
-	GeneratePlaneNoiseAndDerivatives(&noiseValues, &normValues,
-								lowerLeft, side1Vec, side2Vec,
-								numSide1Points, numSide2Points,
-								noiseGeneratorType, numNoiseLayers);
-
-	// for each piece in side 1 (row)
-	glm::vec2 texCoord(0.0f, 0.0f);
 	float uDiv = 1.0f / (float)(numSide1Points - 1);
 	float vDiv = 1.0f / (float)(numSide2Points - 1);
-	for (uint32_t side1Index = 0, oneDimIndex = 0; side1Index < numSide1Points;
-		side1Index++)
-	{
-		quadPoint = (float)side1Index * side1Div + lowerLeft;
-		texCoord = glm::vec2((float)side1Index * uDiv, 0.0f);
-		// for each piece in side 2 (column)
-		for (uint32_t side2Index = 0; side2Index < numSide2Points;
-			side2Index++, oneDimIndex++)
+
+	// everything is written in place by the tiles, which are bands of
+	// side 1 rows
+	size_t numTotalPoints = (size_t)numSide1Points * numSide2Points;
+	std::vector<ModelVert> vertices(numTotalPoints);
+	std::vector<uint32_t> indices((size_t)(numSide1Points - 1) *
+		numSide2Points * 2);
+	std::vector<float> noiseValues(numTotalPoints);
+	std::vector<glm::vec3> normals(numTotalPoints);
+
+	uint32_t numTileRows = std::max(1u, planeTilePoints / numSide2Points);
+	uint32_t numTiles = (numSide1Points + numTileRows - 1) / numTileRows;
+	std::vector<float> tileMaxValues(numTiles, 0.0f);
+
+	NoiseGenerator* noiseGenerator = NoiseGenerator::Create(
+		noiseGeneratorType);
+	RunPlaneTiles(numTiles, threadPool, [&](uint32_t tileIndex) {
+		uint32_t firstSide1Index = tileIndex * numTileRows;
+		uint32_t endSide1Index = std::min(firstSide1Index + numTileRows,
+			numSide1Points);
+		tileMaxValues[tileIndex] = GeneratePlaneNoiseAndNormals(
+			noiseGenerator, lowerLeft, side1Div, side2Div, firstSide1Index,
+			endSide1Index, numSide2Points, numNoiseLayers,
+			noiseValues.data(), normals.data());
+	});
+	delete noiseGenerator;
+
+	float maxVal = 0.0f;
+	for (float tileMaxValue : tileMaxValues) {
+		maxVal = std::max(maxVal, tileMaxValue);
+	}
+	float noiseScale = maxVal > 0.0f ? 1.0f / maxVal : 0.0f;
+
+	RunPlaneTiles(numTiles, threadPool, [&](uint32_t tileIndex) {
+		uint32_t firstSide1Index = tileIndex * numTileRows;
+		uint32_t endSide1Index = std::min(firstSide1Index + numTileRows,
+			numSide1Points);
+		for (uint32_t side1Index = firstSide1Index; side1Index < endSide1Index;
+			side1Index++)
 		{
-			quadPoint += side2Div;
-			auto displacedPnt = quadPoint;
-			auto noiseValue = noiseValues[oneDimIndex];
-			//displacedPnt.y += noiseValue;
-			texCoord.y = 1.0f - (float)side2Index * vDiv;
-			vertices.push_back(Model::ModelVert(displacedPnt,
-												normValues[oneDimIndex],
-												glm::vec3(1.0f, 1.0f, 1.0f),
-												texCoord));
+			size_t oneDimIndex = (size_t)side1Index * numSide2Points;
+			glm::vec3 rowStart = (float)side1Index * side1Div + lowerLeft;
+			glm::vec2 texCoord((float)side1Index * uDiv, 0.0f);
+			for (uint32_t side2Index = 0; side2Index < numSide2Points;
+				side2Index++, oneDimIndex++)
+			{
+				auto displacedPnt = rowStart + (float)side2Index * side2Div;
+				noiseValues[oneDimIndex] *= noiseScale;
+				//displacedPnt.y += noiseValues[oneDimIndex];
+				texCoord.y = 1.0f - (float)side2Index * vDiv;
+				vertices[oneDimIndex] = Model::ModelVert(displacedPnt,
+					normals[oneDimIndex], glm::vec3(1.0f, 1.0f, 1.0f),
+					texCoord);
+			}
+		}
+		// the last row has no strip of its own
+		WritePlaneStripIndices(indices.data(), firstSide1Index,
+			std::min(endSide1Index, numSide1Points - 1), numSide2Points);
+	});
+
+	std::shared_ptr<Model> planeModel = std::make_shared<Model>(vertices,
+		indices, TopologyType::TriangleStrip);
+
+	// points are picked from the full grid, so the levels keep its noise
+	uint32_t step = 2;
+	for (uint32_t lodLevel = 1; lodLevel < maxLodLevels; lodLevel++) {
+		if ((numSide1Points - 1) / step < minPlaneLodDivisions ||
+			(numSide2Points - 1) / step < minPlaneLodDivisions) {
+			break;
 		}
+		planeModel->AddLod(CreateDecimatedPlane(vertices, numSide1Points,
+			numSide2Points, step), GetLodScreenSize(lodLevel));
+		step *= 2;
 	}
+	return planeModel;
+}
 
+std::shared_ptr<Model> Model::CreateDecimatedPlane(
+	std::vector<ModelVert> const& planeVertices,
+	uint32_t numSide1Points, uint32_t numSide2Points, uint32_t step) {
+	// every step-th row and column, plus the last ones so that the edges
+	// stay where they are
+	std::vector<uint32_t> side1Indices, side2Indices;
 	for (uint32_t side1Index = 0; side1Index < numSide1Points - 1;
+		side1Index += step) {
+		side1Indices.push_back(side1Index);
+	}
+	side1Indices.push_back(numSide1Points - 1);
+	for (uint32_t side2Index = 0; side2Index < numSide2Points - 1;
+		side2Index += step) {
+		side2Indices.push_back(side2Index);
+	}
+	side2Indices.push_back(numSide2Points - 1);
+
+	std::vector<ModelVert> vertices;
+	vertices.reserve(side1Indices.size() * side2Indices.size());
+	for (uint32_t side1Index : side1Indices) {
+		for (uint32_t side2Index : side2Indices) {
+			vertices.push_back(planeVertices[side1Index * numSide2Points +
+				side2Index]);
+		}
+	}
+
+	std::vector<uint32_t> indices;
+	AddPlaneStripIndices(indices, (uint32_t)side1Indices.size(),
+		(uint32_t)side2Indices.size());
+	return std::make_shared<Model>(vertices, indices,
+		TopologyType::TriangleStrip);
+}
+
+void Model::AddPlaneStripIndices(std::vector<uint32_t>& indices,
+	uint32_t numSide1Points, uint32_t numSide2Points) {
+	size_t firstIndex = indices.size();
+	indices.resize(firstIndex + (size_t)(numSide1Points - 1) *
+		numSide2Points * 2);
+	WritePlaneStripIndices(indices.data() + firstIndex, 0,
+		numSide1Points - 1, numSide2Points);
+}
+
+void Model::WritePlaneStripIndices(uint32_t* indices,
+	uint32_t firstSide1Index, uint32_t endSide1Index,
+	uint32_t numSide2Points) {
+	for (uint32_t side1Index = firstSide1Index; side1Index < endSide1Index;
 		side1Index++)
 	{
 		uint32_t nextSide1Index = side1Index + 1;
+		uint32_t* stripIndices = indices + (size_t)side1Index *
+			numSide2Points * 2;
 		for (uint32_t side2Index = 0; side2Index < numSide2Points;
 			side2Index++)
 		{
@@ -265,94 +454,148 @@ std::shared_ptr<Model> Model::CreatePlane(const glm::vec3& lowerLeft,
 				+ side2Index;
 			uint32_t oneDimIndexTop = nextSide1Index * numSide2Points
 				+ side2Index;
-			indices.push_back(oneDimIndexTop);
-			indices.push_back(oneDimIndexBottom);
+			*stripIndices++ = oneDimIndexTop;
+			*stripIndices++ = oneDimIndexBottom;
 		}
 	}
+}
 
-	delete[] noiseValues;
-	delete[] normValues;
-	return std::make_shared<Model>(vertices, indices,
-		TopologyType::TriangleStrip);
+void Model::RunPlaneTiles(uint32_t numTiles, ThreadPool* threadPool,
+	std::function<void(uint32_t tileIndex)> const& tileJob) {
+	if (threadPool == nullptr || numTiles == 1) {
+		for (uint32_t tileIndex = 0; tileIndex < numTiles; tileIndex++) {
+			tileJob(tileIndex);
+		}
+		return;
+	}
+	// one job per worker, each pulling tiles as it goes, so uneven tiles
+	// don't leave workers waiting
+	std::atomic<uint32_t> nextTile(0);
+	size_t numJobs = std::min((size_t)numTiles, threadPool->GetNumWorkers());
+	for (size_t jobIndex = 0; jobIndex < numJobs; jobIndex++) {
+		threadPool->Enqueue([&nextTile, numTiles, &tileJob](
+			size_t workerIndex) {
+			for (uint32_t tileIndex = nextTile++; tileIndex < numTiles;
+				tileIndex = nextTile++) {
+				tileJob(tileIndex);
+			}
+		});
+	}
+	threadPool->WaitIdle();
 }
 
-void Model::GeneratePlaneNoiseAndDerivatives(float** noiseValues,
-								 glm::vec3** normals,
-								 const glm::vec3& lowerLeft,
-								 const glm::vec3& side1Vec,
-								 const glm::vec3& side2Vec,
-								 uint32_t numSide1Points,
-								 uint32_t numSide2Points,
-								 NoiseGeneratorType noiseGeneratorType,
-								 uint32_t numNoiseLayers) {
-	uint32_t numTotalPoints = numSide1Points * numSide1Points;
-	*noiseValues = new float[numTotalPoints];
-	*normals = new glm::vec3[numTotalPoints];
-	glm::vec3* derivValues = new glm::vec3[numTotalPoints];
-	
-	auto noiseValuesPtr = *noiseValues;
-	auto normalsPtr = *normals;
-	for (uint32_t i = 0; i < numTotalPoints; i++) {
-		noiseValuesPtr[i] = 0.0f;
-		derivValues[i] = glm::vec3(0.0f, 0.0f, 0.0f);
-		derivValues[i] = glm::vec3(0.0f, 1.0f, 0.0f);
-	}
-	if (noiseGeneratorType != NoiseGeneratorType::None) {
-		NoiseGenerator* noiseGenerator = new PerlinNoise();
-		
-		glm::vec3 quadPoint;
-		// if there are n points, there are (n-1) divisions
-		glm::vec3 side1Div = side1Vec / (float)(numSide1Points - 1);
-		glm::vec3 side2Div = side2Vec / (float)(numSide2Points - 1);
-		// https://www.scratchapixel.com/lessons/procedural-generation-virtual-worlds/perlin-noise-part-2/perlin-noise-terrain-mesh
-		// https://www.scratchapixel.com/lessons/procedural-generation-virtual-worlds/perlin-noise-part-2/perlin-noise-computing-derivatives
-		float maxVal = 0;
-		for (uint32_t side1Index = 0, oneDimIndex = 0; side1Index < numSide1Points;
-			side1Index++)
+float Model::GeneratePlaneNoiseAndNormals(NoiseGenerator const* noiseGenerator,
+	const glm::vec3& lowerLeft, const glm::vec3& side1Div,
+	const glm::vec3& side2Div, uint32_t firstSide1Index,
+	uint32_t endSide1Index, uint32_t numSide2Points,
+	uint32_t numNoiseLayers, float* noiseValues, glm::vec3* normals) {
+	size_t firstPoint = (size_t)firstSide1Index * numSide2Points;
+	size_t endPoint = (size_t)endSide1Index * numSide2Points;
+	if (noiseGenerator == nullptr) {
+		for (size_t oneDimIndex = firstPoint; oneDimIndex < endPoint;
+			oneDimIndex++) {
+			noiseValues[oneDimIndex] = 0.0f;
+			normals[oneDimIndex] = glm::vec3(0.0f, 1.0f, 0.0f);
+		}
+		return 0.0f;
+	}
+
+	// https://www.scratchapixel.com/lessons/procedural-generation-virtual-worlds/perlin-noise-part-2/perlin-noise-terrain-mesh
+	// https://www.scratchapixel.com/lessons/procedural-generation-virtual-worlds/perlin-noise-part-2/perlin-noise-computing-derivatives
+	// a row at a time, each layer in one batch
+	std::vector<float> rowX(numSide2Points), rowY(numSide2Points),
+		rowZ(numSide2Points), rowValues(numSide2Points),
+		rowDerivX(numSide2Points), rowDerivY(numSide2Points),
+		rowDerivZ(numSide2Points), rowFractals(numSide2Points);
+	NoiseBatch rowBatch = { rowX.data(), rowY.data(), rowZ.data(),
+		rowValues.data(), rowDerivX.data(), rowDerivY.data(),
+		rowDerivZ.data(), numSide2Points };
+	float maxVal = 0.0f;
+	for (uint32_t side1Index = firstSide1Index; side1Index < endSide1Index;
+		side1Index++)
+	{
+		glm::vec3 rowStart = (float)side1Index * side1Div + lowerLeft;
+		for (uint32_t side2Index = 0; side2Index < numSide2Points;
+			side2Index++)
 		{
-			quadPoint = (float)side1Index * side1Div + lowerLeft;
+			glm::vec3 quadPoint = rowStart + (float)side2Index * side2Div;
+			rowX[side2Index] = quadPoint.x;
+			rowY[side2Index] = quadPoint.y;
+			rowZ[side2Index] = quadPoint.z;
+			rowFractals[side2Index] = 0.0f;
+			rowDerivX[side2Index] = 0.0f;
+			rowDerivY[side2Index] = 1.0f;
+			rowDerivZ[side2Index] = 0.0f;
+		}
+
+		float amplitude = 1.0f;
+		for (uint32_t layerIndex = 0; layerIndex < numNoiseLayers; layerIndex++) {
+			noiseGenerator->EvalBatch(rowBatch);
 			for (uint32_t side2Index = 0; side2Index < numSide2Points;
-				side2Index++, oneDimIndex++)
+				side2Index++)
 			{
-				quadPoint += side2Div;
-				float fractal = 0.0f;
-				float amplitude = 1.0f;
-				for (uint32_t layerIndex = 0; layerIndex < numNoiseLayers; layerIndex++) {
-					glm::vec3 deriv;
-					// TODO: this perlin code is crap. replace because it has bugs
-					fractal += (1.0f + noiseGenerator->Eval(quadPoint, deriv)) * 0.5f * amplitude;
-					quadPoint *= 2.0f;
-					amplitude *= 0.5f;
-					derivValues[oneDimIndex] = deriv;
-				}
-
-				if (fractal > maxVal) {
-					maxVal = fractal;
-				}
-				noiseValuesPtr[oneDimIndex] = fractal;
-				//std::cout << "fractal " << fractal << std::endl;
-				derivValues[oneDimIndex] = glm::normalize(derivValues[oneDimIndex]);
-				
-				auto derivativeVal = derivValues[oneDimIndex];
-				glm::vec3 tangent(1.0f, derivativeVal[0], 0.0f);
-				glm::vec3 bitangent(0.0f, derivativeVal[2], 1.0f);
-				normalsPtr[oneDimIndex] = glm::normalize(glm::vec3(-derivativeVal[0],
-														 1.0f,
-														 -derivativeVal[2]));
+				rowFractals[side2Index] += (1.0f + rowValues[side2Index]) *
+					0.5f * amplitude;
+				rowX[side2Index] *= 2.0f;
+				rowY[side2Index] *= 2.0f;
+				rowZ[side2Index] *= 2.0f;
 			}
+			amplitude *= 0.5f;
 		}
-		for (uint32_t i = 0; i < numTotalPoints; i++) {
-			noiseValuesPtr[i] /= maxVal;
+
+		size_t oneDimIndex = (size_t)side1Index * numSide2Points;
+		for (uint32_t side2Index = 0; side2Index < numSide2Points;
+			side2Index++, oneDimIndex++)
+		{
+			float fractal = rowFractals[side2Index];
+			if (fractal > maxVal) {
+				maxVal = fractal;
+			}
+			noiseValues[oneDimIndex] = fractal;
+			// normals come from the last layer's derivatives
+			glm::vec3 derivativeVal = glm::normalize(glm::vec3(
+				rowDerivX[side2Index], rowDerivY[side2Index],
+				rowDerivZ[side2Index]));
+			normals[oneDimIndex] = glm::normalize(glm::vec3(-derivativeVal[0],
+				1.0f, -derivativeVal[2]));
 		}
-		
-		delete noiseGenerator;
-		delete [] derivValues;
 	}
+	return maxVal;
 }
 
-// based mostly on http://www.songho.ca/opengl/gl_sphere.html
 std::shared_ptr<Model> Model::CreateIcosahedron(float radius,
 												uint32_t numSubdivisions) {
+	std::vector<ModelVert> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> seamVertices;
+	CreateIcosahedronBase(radius, vertices, indices, seamVertices);
+
+	// a subdivision only appends vertices, so every level is built from
+	// the one before it. the coarser levels are kept as levels of detail;
+	// each has a quarter of the triangles of the one after it
+	uint32_t numLevels = std::min(numSubdivisions + 1, maxLodLevels);
+	std::vector<std::shared_ptr<Model>> levels(numLevels);
+	for (uint32_t subDiv = 0; subDiv <= numSubdivisions; subDiv++) {
+		if (subDiv > 0) {
+			SubdivideIcosahedron(vertices, indices, radius, seamVertices);
+		}
+		uint32_t lodLevel = numSubdivisions - subDiv;
+		if (lodLevel < numLevels) {
+			CalculateNormalVectors(vertices, indices, seamVertices);
+			levels[lodLevel] = std::make_shared<Model>(vertices, indices,
+				TopologyType::TriangleList);
+		}
+	}
+
+	for (uint32_t lodLevel = 1; lodLevel < numLevels; lodLevel++) {
+		levels[0]->AddLod(levels[lodLevel], GetLodScreenSize(lodLevel));
+	}
+	return levels[0];
+}
+
+void Model::CreateIcosahedronBase(float radius,
+	std::vector<ModelVert>& vertices, std::vector<uint32_t>& indices,
+	std::vector<uint32_t>& seamVertices) {
 	// 360 degrees divided by 5 is 72.0 degrees
 	const float circumDivAngle = 72.0f * (float)M_PI / 180.0f;
 	// elevation angle, assuming vertex of icosahedron is
@@ -363,8 +606,8 @@ std::shared_ptr<Model> Model::CreateIcosahedron(float radius,
 	// 22 vertices to start with. five at each pole,
 	// six across at verticalAngle, and then another
 	// six across at 90 degrees + verticalAngle
-	std::vector<ModelVert> vertices(22);
-	std::vector<uint32_t> indices;
+	vertices.assign(22, ModelVert());
+	indices.clear();
 	// start at -126 at 1st row, -90 on second row
 	float hAngle1 = -(float)M_PI * 0.5f - circumDivAngle * 0.5f;
 	float hAngle2 = -(float)M_PI * 0.5f;
@@ -375,8 +618,6 @@ std::shared_ptr<Model> Model::CreateIcosahedron(float radius,
 	float vDiv = 1.0f / 3.0f;
 	glm::vec3 minColor = glm::vec3(0.1f, 0.1f, 0.1f),
 		maxColor = glm::vec3(1.0f, 1.0f, 1.0f);
-	
-	std::unordered_map<uint32_t, std::set<TriangleEdgeSet>> vertexNeighbors;
 
 	// top-most pole has several verts, each with its own
 	// texture coordinate
@@ -416,6 +657,13 @@ std::shared_ptr<Model> Model::CreateIcosahedron(float radius,
 		hAngle1 += circumDivAngle;
 		hAngle2 += circumDivAngle;
 	}
+	// the last vertex of each row is the first one again, on the other
+	// side of the texture seam. a full turn of sines and cosines doesn't
+	// land exactly where it started, which would leave a crack
+	vertices[10].position = vertices[5].position;
+	vertices[16].position = vertices[11].position;
+	// both poles, and both ends of each row
+	seamVertices = { 0, 1, 2, 3, 4, 5, 10, 11, 16, 17, 18, 19, 20, 21 };
 	
 	for (uint32_t i = 17; i < 22; i++) {
 		vertices[i].position = glm::vec3(0.0f,-radius, 0.0f);
@@ -428,7 +676,7 @@ std::shared_ptr<Model> Model::CreateIcosahedron(float radius,
 	uint32_t row1StartIndex = 5;
 	for (uint32_t i = 0; i < 5; i++) {
 		AddIcosahedronIndices(indices, i,
-			row1StartIndex + i, row1StartIndex + i + 1, vertexNeighbors);
+			row1StartIndex + i, row1StartIndex + i + 1);
 	}
 	
 	uint32_t row2StartIndex = 11;
@@ -439,104 +687,103 @@ std::shared_ptr<Model> Model::CreateIcosahedron(float radius,
 		uint32_t firstRow2Index = row2StartIndex + i;
 		uint32_t secondRow2Index = firstRow2Index + 1;
 		AddIcosahedronIndices(indices, firstRow2Index,
-			secondRow1Index, firstRow1Index, vertexNeighbors);
+			secondRow1Index, firstRow1Index);
 		AddIcosahedronIndices(indices, secondRow1Index,
-			firstRow2Index, secondRow2Index, vertexNeighbors);
+			firstRow2Index, secondRow2Index);
 	}
 	
 	// bottom pole
 	uint32_t poleStartIndex = 17;
 	for (uint32_t i = 0; i < 5; i++) {
 		AddIcosahedronIndices(indices, poleStartIndex + i,
-			row2StartIndex + i + 1, row2StartIndex + i,
-			vertexNeighbors);
+			row2StartIndex + i + 1, row2StartIndex + i);
 	}
-	
-	SubdivideIcosahedron(vertices, indices, numSubdivisions, radius,
-		vertexNeighbors);
-
-	CalculateNormalVectors(vertices, vertexNeighbors);
-	
-	return std::make_shared<Model>(vertices, indices,
-								   TopologyType::TriangleList);
 }
 
 void Model::AddIcosahedronIndices(std::vector<uint32_t>& indices,
 									uint32_t index1, uint32_t index2,
-									uint32_t index3,
-									std::unordered_map<uint32_t,std::set<TriangleEdgeSet>>
-									& vertexNeighbors) {
+									uint32_t index3) {
 	indices.push_back(index1);
 	indices.push_back(index2);
 	indices.push_back(index3);
-	
-	vertexNeighbors[index1].insert(TriangleEdgeSet(index2, index3));
-	vertexNeighbors[index2].insert(TriangleEdgeSet(index3, index1));
-	vertexNeighbors[index3].insert(TriangleEdgeSet(index1, index2));
 }
 
 void Model::SubdivideIcosahedron(std::vector<ModelVert>& vertices,
 								 std::vector<uint32_t>& indices,
-								 uint32_t numSubdivisions,
 								 float radius,
-								 std::unordered_map<uint32_t, std::set<TriangleEdgeSet>>
-								 & vertexNeighbors) {
-	ModelVert newV1, newV2, newV3;
-	std::vector<uint32_t> tmpIndices;
-	std::vector<ModelVert> tmpVerts;
-
-	vertexNeighbors.clear();
-
-	for (uint32_t subDiv = 0; subDiv < numSubdivisions; subDiv++) {
-		// build new indices by storing old indices into temp array
-		tmpIndices = indices;
-		tmpVerts = vertices;
-		size_t numCurrentIndices = tmpIndices.size();
-		indices.clear();
-		vertexNeighbors.clear();
-		vertices.clear();
-		for (size_t index = 0; index <= numCurrentIndices-3; index += 3) {
-			size_t oldIndex1 = tmpIndices[index],
-				oldIndex2 = tmpIndices[index + 1],
-				oldIndex3 = tmpIndices[index + 2];
-			ModelVert const & v1 = tmpVerts[oldIndex1];
-			ModelVert const & v2 = tmpVerts[oldIndex2];
-			ModelVert const & v3 = tmpVerts[oldIndex3];
-
-			// split each half edge
-			ComputeHalfVertex(v1, v2, newV1, radius);
-			ComputeHalfVertex(v2, v3, newV2, radius);
-			ComputeHalfVertex(v1, v3, newV3, radius);
-
-			uint32_t newV1Index = (uint32_t)vertices.size();
-			vertices.push_back(newV1);
-			uint32_t newV2Index = (uint32_t)vertices.size();
-			vertices.push_back(newV2);
-			uint32_t newV3Index = (uint32_t)vertices.size();
-			vertices.push_back(newV3);
-			oldIndex1 = vertices.size();
-			vertices.push_back(v1);
-			oldIndex2 = vertices.size();
-			vertices.push_back(v2);
-			oldIndex3 = vertices.size();
-			vertices.push_back(v3);
-
-			// topmost triangle in new subdiv
-			AddIcosahedronIndices(indices, (uint32_t)oldIndex1,
-				newV1Index, newV3Index, vertexNeighbors);
-			// center triangle
-			AddIcosahedronIndices(indices, newV2Index,
-				newV3Index, newV1Index, vertexNeighbors);
-			// bottom left triangle
-			AddIcosahedronIndices(indices, newV1Index,
-				(uint32_t)oldIndex2, newV2Index, vertexNeighbors);
-			// bottom right triangle
-			AddIcosahedronIndices(indices, newV3Index,
-				newV2Index, (uint32_t)oldIndex3, vertexNeighbors);
+								 std::vector<uint32_t>& seamVertices) {
+	size_t numTriangles = indices.size() / 3;
+	// every edge is shared by two triangles, except along the texture
+	// seam where the two sides use different vertices
+	size_t maxNumEdges = numTriangles * 3;
+	std::unordered_map<uint64_t, uint32_t> edgeMidpoints;
+	edgeMidpoints.reserve(maxNumEdges);
+	vertices.reserve(vertices.size() + maxNumEdges);
+	// how many triangles use each new midpoint's edge
+	uint32_t firstMidpoint = (uint32_t)vertices.size();
+	std::vector<uint8_t> numEdgeTriangles(maxNumEdges, 0);
+
+	std::vector<uint32_t> newIndices(indices.size() * 4);
+	for (size_t triangle = 0; triangle < numTriangles; triangle++) {
+		uint32_t index1 = indices[triangle * 3],
+			index2 = indices[triangle * 3 + 1],
+			index3 = indices[triangle * 3 + 2];
+
+		// split each half edge, once for both triangles on it
+		uint32_t newV1Index = GetHalfVertex(vertices, edgeMidpoints,
+			index1, index2, radius);
+		uint32_t newV2Index = GetHalfVertex(vertices, edgeMidpoints,
+			index2, index3, radius);
+		uint32_t newV3Index = GetHalfVertex(vertices, edgeMidpoints,
+			index1, index3, radius);
+		numEdgeTriangles[newV1Index - firstMidpoint]++;
+		numEdgeTriangles[newV2Index - firstMidpoint]++;
+		numEdgeTriangles[newV3Index - firstMidpoint]++;
+
+		uint32_t* newTriangles = &newIndices[triangle * 12];
+		// topmost triangle in new subdiv
+		newTriangles[0] = index1;
+		newTriangles[1] = newV1Index;
+		newTriangles[2] = newV3Index;
+		// center triangle
+		newTriangles[3] = newV2Index;
+		newTriangles[4] = newV3Index;
+		newTriangles[5] = newV1Index;
+		// bottom left triangle
+		newTriangles[6] = newV1Index;
+		newTriangles[7] = index2;
+		newTriangles[8] = newV2Index;
+		// bottom right triangle
+		newTriangles[9] = newV3Index;
+		newTriangles[10] = newV2Index;
+		newTriangles[11] = index3;
+	}
+	indices.swap(newIndices);
+
+	for (uint32_t index = firstMidpoint; index < vertices.size(); index++) {
+		if (numEdgeTriangles[index - firstMidpoint] == 1) {
+			seamVertices.push_back(index);
 		}
 	}
 }
 
+uint32_t Model::GetHalfVertex(std::vector<ModelVert>& vertices,
+	std::unordered_map<uint64_t, uint32_t>& edgeMidpoints,
+	uint32_t index1, uint32_t index2, float radius) {
+	uint64_t edgeKey = index1 < index2 ?
+		((uint64_t)index1 << 32) | index2 :
+		((uint64_t)index2 << 32) | index1;
+	auto insertResult = edgeMidpoints.emplace(edgeKey,
+		(uint32_t)vertices.size());
+	if (insertResult.second) {
+		ModelVert halfVertex;
+		ComputeHalfVertex(vertices[index1], vertices[index2], halfVertex,
+			radius);
+		vertices.push_back(halfVertex);
+	}
+	return insertResult.first->second;
+}
+
 void Model::ComputeHalfVertex(ModelVert const& v1, ModelVert const& v2,
 	ModelVert& halfVertex, float radius)
 {
@@ -552,37 +799,61 @@ void Model::ComputeHalfVertex(ModelVert const& v1, ModelVert const& v2,
 }
 
 void Model::CalculateNormalVectors(std::vector<ModelVert>& vertices,
-	std::unordered_map<uint32_t, std::set<TriangleEdgeSet>>& vertexNeighbors) {
-	size_t numVertices = vertices.size();
-	for (size_t vertIndex = 0; vertIndex < numVertices; vertIndex++) {
-		ComputeNormal((uint32_t)vertIndex, vertices, vertexNeighbors);
+	std::vector<uint32_t> const& indices,
+	std::vector<uint32_t> const& seamVertices) {
+	for (ModelVert& vertex : vertices) {
+		vertex.normal = glm::vec3(0.0f, 0.0f, 0.0f);
 	}
-}
-
-glm::vec3 Model::ComputeNormal(uint32_t vertexIndex,
-							   std::vector<ModelVert>& vertices,
-							   std::unordered_map<uint32_t,std::set<TriangleEdgeSet>> & vertexNeighbors) {
-	std::set<TriangleEdgeSet> const & neighbors = vertexNeighbors[vertexIndex];
-	glm::vec3 normalVec(0.0f, 0.0f, 0.0f);
-	
-	glm::vec3 const & ourVertex = vertices[vertexIndex].position;
-	size_t numNeighbors = neighbors.size();
-	
-	for(TriangleEdgeSet const & triangleEdgeSet : neighbors) {
-		auto index1 = triangleEdgeSet.pointIndex1;
-		auto index2 = triangleEdgeSet.pointIndex2;
-		ModelVert const & point1 = vertices[index1];
-		ModelVert const& point2 = vertices[index2];
 
-		glm::vec3 vectorToPoint1 = (point1.position - ourVertex);
-		glm::normalize(vectorToPoint1);
-		glm::vec3 vectorToPoint2 = (point2.position - ourVertex);
-		glm::normalize(vectorToPoint2);
+	// the cross product is as long as twice the triangle's area, so
+	// bigger triangles count for more at each of their corners
+	size_t numIndices = indices.size();
+	for (size_t index = 0; index + 2 < numIndices; index += 3) {
+		ModelVert& v1 = vertices[indices[index]];
+		ModelVert& v2 = vertices[indices[index + 1]];
+		ModelVert& v3 = vertices[indices[index + 2]];
+		glm::vec3 faceNormal = glm::cross(v2.position - v1.position,
+			v3.position - v1.position);
+		v1.normal += faceNormal;
+		v2.normal += faceNormal;
+		v3.normal += faceNormal;
+	}
 
-		normalVec += glm::cross(vectorToPoint2, vectorToPoint1);
+	// the poles and the texture seam have a vertex for each side, and
+	// each only sees the triangles on its own. summing them over the ones
+	// at the same position keeps the shading from creasing there
+	std::vector<uint32_t> byPosition(seamVertices);
+	std::sort(byPosition.begin(), byPosition.end(),
+		[&vertices](uint32_t index1, uint32_t index2) {
+			glm::vec3 const& position1 = vertices[index1].position;
+			glm::vec3 const& position2 = vertices[index2].position;
+			if (position1.x != position2.x) {
+				return position1.x < position2.x;
+			}
+			if (position1.y != position2.y) {
+				return position1.y < position2.y;
+			}
+			return position1.z < position2.z;
+		});
+	for (size_t first = 0; first < byPosition.size();) {
+		glm::vec3 const& position = vertices[byPosition[first]].position;
+		glm::vec3 normal(0.0f, 0.0f, 0.0f);
+		size_t last = first;
+		while (last < byPosition.size() &&
+			vertices[byPosition[last]].position == position) {
+			normal += vertices[byPosition[last]].normal;
+			last++;
+		}
+		for (size_t i = first; i < last; i++) {
+			vertices[byPosition[i]].normal = normal;
+		}
+		first = last;
 	}
 
-	normalVec /= (float)numNeighbors;
-	glm::normalize(normalVec);
-	return normalVec;
+	for (ModelVert& vertex : vertices) {
+		float normalLength = glm::length(vertex.normal);
+		if (normalLength > 0.0f) {
+			vertex.normal /= normalLength;
+		}
+	}
 }
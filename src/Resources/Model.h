@@ -6,12 +6,17 @@
 
 #include <vector>
 #include <array>
+#include <memory>
 #include <set>
 #include <unordered_map>
+#include <functional>
 #include <glm/glm.hpp>
 #include "vulkan/vulkan.h"
 #include "Vertex.h"
 #include "Math/NoiseGenerator.h"
+#include "Math/BoundingVolumes.h"
+
+class ThreadPool;
 
 class Model {
 public:
@@ -54,21 +59,6 @@ public:
 		glm::vec2 texCoord;
 	};
 
-	struct TriangleEdgeSet {
-		// first edge goes to point 1, second to point 2
-		uint32_t pointIndex1;
-		uint32_t pointIndex2;
-
-		TriangleEdgeSet(uint32_t index1, uint32_t index2) 
-			: pointIndex1(index1), pointIndex2(index2) {
-		}
-
-		bool operator<(TriangleEdgeSet const& b) const {
-			bool comp1 = pointIndex1 < b.pointIndex1;
-			return comp1 || (comp1 && pointIndex2 < b.pointIndex2);
-		}
-	};
-	
 	Model() : modelTopology(TopologyType::TriangleList) {}
 	Model(const std::string& modelPath);
 	Model(const std::vector<ModelVert>& vertices,
@@ -87,12 +77,17 @@ public:
 		std::vector<ModelVert>& destinationVerts, std::vector<uint32_t>& indices,
 		uint32_t indexOffset);
 
+	// comes with levels of detail that skip every second, fourth, ... row
+	// and column of points. bands of rows are generated on the thread
+	// pool's workers if one is given
 	static std::shared_ptr<Model> CreatePlane(const glm::vec3& lowerLeft,
 		const glm::vec3& side1Vec, const glm::vec3& side2Vec,
 		uint32_t numSide1Points, uint32_t numSide2Points,
 		NoiseGeneratorType noiseGeneratorType,
-		uint32_t numNoiseLayers = 0);
+		uint32_t numNoiseLayers = 0, ThreadPool* threadPool = nullptr);
 	
+	// comes with a level of detail for each subdivision level below
+	// numSubdivisions
 	static std::shared_ptr<Model> CreateIcosahedron(float radius,
 													uint32_t numSubdivisions);
 	
@@ -176,46 +171,118 @@ public:
 		for (size_t i = 0; i < newIndices.size(); i++) {
 			indices.push_back(newIndices[i] + offsetFromCurrentVerts);
 		}
+		RecomputeBounds();
+	}
+
+	// local space, computed when the model is created. positions changed
+	// through GetVertices need a call to RecomputeBounds
+	AABB const& GetBoundingBox() const {
+		return boundingBox;
 	}
 
+	BoundingSphere const& GetBoundingSphere() const {
+		return boundingSphere;
+	}
+
+	void RecomputeBounds();
+
 	TopologyType GetTopologyType() const {
 		return modelTopology;
 	}
 
+	struct Lod {
+		std::shared_ptr<Model> model;
+		// drawn once the model's bounding sphere covers less than this
+		// fraction of the screen's height
+		float maxScreenSize;
+	};
+
+	// coarser versions of the model, from finest to coarsest. they have to
+	// use the same topology and stay inside the model's bounds, since
+	// those are used for all of them
+	void AddLod(std::shared_ptr<Model> const& lodModel, float maxScreenSize);
+
+	std::vector<Lod> const& GetLods() const {
+		return lods;
+	}
+
+	// each level has about a quarter of the triangles of the one before,
+	// and takes over at half the size on screen
+	static float GetLodScreenSize(uint32_t lodLevel);
+
+	static const uint32_t maxLodLevels;
+
 private:
 	std::vector<ModelVert> vertices;
 	std::vector<uint32_t> indices;
 	TopologyType modelTopology;
+	AABB boundingBox;
+	BoundingSphere boundingSphere;
+	std::vector<Lod> lods;
+
+	static const float firstLodScreenSize;
+	static const size_t minTrianglesToSimplify;
+	static const uint32_t minPlaneLodDivisions;
+	static const uint32_t planeTilePoints;
+
+	// quadric error simplification of loaded meshes
+	void AddSimplifiedLods();
+	std::shared_ptr<Model> CreateFromTriangles(
+		std::vector<uint32_t> const& triangleIndices) const;
+
+	// the 20 faces before any subdivision. seamVertices gets the vertices
+	// that are split in two or more at the poles and the texture seam
+	static void CreateIcosahedronBase(float radius,
+		std::vector<ModelVert>& vertices, std::vector<uint32_t>& indices,
+		std::vector<uint32_t>& seamVertices);
+	static std::shared_ptr<Model> CreateDecimatedPlane(
+		std::vector<ModelVert> const& planeVertices,
+		uint32_t numSide1Points, uint32_t numSide2Points, uint32_t step);
+	static void AddPlaneStripIndices(std::vector<uint32_t>& indices,
+		uint32_t numSide1Points, uint32_t numSide2Points);
 	
-	static void GeneratePlaneNoiseAndDerivatives(float** noiseValues,
-											glm::vec3** normals,
-											const glm::vec3& lowerLeft,
-											const glm::vec3& side1Vec,
-											const glm::vec3& side2Vec,
-											uint32_t numSide1Points,
-											uint32_t numSide2Points,
-											NoiseGeneratorType noiseGeneratorType,
-											uint32_t numNoiseLayers);
+	static void WritePlaneStripIndices(uint32_t* indices,
+		uint32_t firstSide1Index, uint32_t endSide1Index,
+		uint32_t numSide2Points);
+	// runs inline without a thread pool. blocks until all tiles are done
+	static void RunPlaneTiles(uint32_t numTiles, ThreadPool* threadPool,
+		std::function<void(uint32_t tileIndex)> const& tileJob);
+	// fills in rows [firstSide1Index, endSide1Index) and returns the
+	// largest noise value among them, before normalization
+	static float GeneratePlaneNoiseAndNormals(
+		NoiseGenerator const* noiseGenerator, const glm::vec3& lowerLeft,
+		const glm::vec3& side1Div, const glm::vec3& side2Div,
+		uint32_t firstSide1Index, uint32_t endSide1Index,
+		uint32_t numSide2Points, uint32_t numNoiseLayers,
+		float* noiseValues, glm::vec3* normals);
 	
 	static void AddIcosahedronIndices(std::vector<uint32_t>& indices,
 									  uint32_t index1, uint32_t index2,
-									  uint32_t index3,
-									  std::unordered_map<uint32_t,std::set<TriangleEdgeSet>> & vertexNeighbors);
+									  uint32_t index3);
 	
+	// splits every triangle into four. midpoints are appended after the
+	// existing vertices, and shared by the triangles on both sides of an
+	// edge. edges with a triangle on one side only are split vertices'
+	// edges, and their midpoints are added to seamVertices
 	static void SubdivideIcosahedron(std::vector<ModelVert>& vertices,
 									 std::vector<uint32_t>& indices,
-									 uint32_t numSubdivisions, float radius,
-									 std::unordered_map<uint32_t, std::set<TriangleEdgeSet>>
-									& vertexNeighbors);
+									 float radius,
+									 std::vector<uint32_t>& seamVertices);
+	// index of the midpoint of the edge between the two vertices, added
+	// the first time the edge is seen
+	static uint32_t GetHalfVertex(std::vector<ModelVert>& vertices,
+		std::unordered_map<uint64_t, uint32_t>& edgeMidpoints,
+		uint32_t index1, uint32_t index2, float radius);
 
 	static void ComputeHalfVertex(ModelVert const& v1, ModelVert const& v2,
 		ModelVert& halfVertex, float radius);
 	
+	// area weighted average of the normals of the triangles around each
+	// vertex, in one pass over the triangles. the seam vertices that share
+	// a position get the same normal
 	static void CalculateNormalVectors(std::vector<ModelVert>& vertices,
-		std::unordered_map<uint32_t, std::set<TriangleEdgeSet>>& vertexNeighbors);
-
-	static glm::vec3 ComputeNormal(uint32_t vertexIndex, std::vector<ModelVert>& vertices,
-							std::unordered_map<uint32_t,std::set<TriangleEdgeSet>> & vertexNeighbors);
+		std::vector<uint32_t> const& indices,
+		std::vector<uint32_t> const& seamVertices);
 };
 
 namespace std {
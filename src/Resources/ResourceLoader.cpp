@@ -5,12 +5,15 @@
 #include "GfxDeviceManager.h"
 #include "LogicalDeviceManager.h"
 #include "Resources/Model.h"
+#include "Resources/Material.h"
 
-ResourceLoader::ResourceLoader() {
+ResourceLoader::ResourceLoader() : numProceduralModelHits(0),
+	numProceduralModelMisses(0), numMaterialHits(0), numMaterialMisses(0) {
 
 }
 
 ResourceLoader::~ResourceLoader() {
+	materialsLoaded.clear();
 	shadersLoaded.clear();
 	texturesLoaded.clear();
 }
@@ -28,15 +31,14 @@ std::shared_ptr<ShaderLoader> ResourceLoader::GetShader(std::string path, VkDevi
 
 std::shared_ptr<TextureCreator> ResourceLoader::GetTexture(const std::string& path,
 	GfxDeviceManager* gfxDeviceManager,
-	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager,
-	VkCommandPool commandPool) {
+	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager) {
 	auto foundTexturItr = texturesLoaded.find(path);
 	if (foundTexturItr != texturesLoaded.cend()) {
 		return foundTexturItr->second;
 	}
 
 	auto newTexture = std::make_shared<TextureCreator>(path, gfxDeviceManager,
-		logicalDeviceManager, commandPool);
+		logicalDeviceManager);
 	texturesLoaded[path] = newTexture;
 	return newTexture;
 }
@@ -44,8 +46,7 @@ std::shared_ptr<TextureCreator> ResourceLoader::GetTexture(const std::string& pa
 std::shared_ptr<TextureCreator> ResourceLoader::BuildRawTexture(std::string textureName,
 	unsigned char* pixels, int texWidth, int texHeight, int bytesPerPixel,
 	GfxDeviceManager* gfxDeviceManager,
-	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager,
-	VkCommandPool commandPool) {
+	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager) {
 	auto foundTexturItr = texturesLoaded.find(textureName);
 	if (foundTexturItr != texturesLoaded.cend()) {
 		return foundTexturItr->second;
@@ -53,7 +54,7 @@ std::shared_ptr<TextureCreator> ResourceLoader::BuildRawTexture(std::string text
 
 	auto newTexture = std::make_shared<TextureCreator>(pixels, texWidth,
 		texHeight, bytesPerPixel, gfxDeviceManager,
-		logicalDeviceManager, commandPool);
+		logicalDeviceManager);
 	texturesLoaded[textureName] = newTexture;
 	return newTexture;
 }
@@ -77,3 +78,110 @@ std::shared_ptr<Model> ResourceLoader::GetModel(const std::string& path) {
 	modelsLoaded[path] = newModel;
 	return newModel;
 }
+
+std::shared_ptr<Model> ResourceLoader::GetQuad(glm::vec3 const& quadOrigin,
+	glm::vec3 const& side1Vec, glm::vec3 const& side2Vec,
+	bool isTriangleStrip) {
+	ProceduralModelKey key(ProceduralModelType::Quad, {
+		quadOrigin.x, quadOrigin.y, quadOrigin.z,
+		side1Vec.x, side1Vec.y, side1Vec.z,
+		side2Vec.x, side2Vec.y, side2Vec.z,
+		isTriangleStrip ? 1.0f : 0.0f });
+	return GetProceduralModel(key, [&]() {
+		return Model::CreateQuad(quadOrigin, side1Vec, side2Vec,
+			isTriangleStrip);
+	});
+}
+
+std::shared_ptr<Model> ResourceLoader::GetBox(glm::vec3 const& boxCenter,
+	glm::vec3 const& right, glm::vec3 const& up,
+	glm::vec3 const& forward) {
+	ProceduralModelKey key(ProceduralModelType::Box, {
+		boxCenter.x, boxCenter.y, boxCenter.z,
+		right.x, right.y, right.z,
+		up.x, up.y, up.z,
+		forward.x, forward.y, forward.z });
+	return GetProceduralModel(key, [&]() {
+		return Model::CreateBox(boxCenter, right, up, forward);
+	});
+}
+
+std::shared_ptr<Model> ResourceLoader::GetPlane(glm::vec3 const& lowerLeft,
+	glm::vec3 const& side1Vec, glm::vec3 const& side2Vec,
+	uint32_t numSide1Points, uint32_t numSide2Points,
+	NoiseGeneratorType noiseGeneratorType, uint32_t numNoiseLayers,
+	ThreadPool* threadPool) {
+	// the thread pool only changes how fast the plane is made, not what
+	// it looks like
+	ProceduralModelKey key(ProceduralModelType::Plane, {
+		lowerLeft.x, lowerLeft.y, lowerLeft.z,
+		side1Vec.x, side1Vec.y, side1Vec.z,
+		side2Vec.x, side2Vec.y, side2Vec.z,
+		(float)numSide1Points, (float)numSide2Points,
+		(float)(int)noiseGeneratorType, (float)numNoiseLayers });
+	return GetProceduralModel(key, [&]() {
+		return Model::CreatePlane(lowerLeft, side1Vec, side2Vec,
+			numSide1Points, numSide2Points, noiseGeneratorType,
+			numNoiseLayers, threadPool);
+	});
+}
+
+std::shared_ptr<Model> ResourceLoader::GetIcosahedron(float radius,
+	uint32_t numSubdivisions) {
+	ProceduralModelKey key(ProceduralModelType::Icosahedron, {
+		radius, (float)numSubdivisions });
+	return GetProceduralModel(key, [&]() {
+		return Model::CreateIcosahedron(radius, numSubdivisions);
+	});
+}
+
+std::shared_ptr<Material> ResourceLoader::GetMaterial(
+	DescriptorSetFunctions::MaterialType materialType,
+	std::shared_ptr<TextureCreator> const& texture,
+	nlohmann::json const& materialNode) {
+	// textures are cached too, so the same texture is the same pointer
+	MaterialKey key(materialType, texture.get(), materialNode.dump());
+	auto foundMaterialItr = materialsLoaded.find(key);
+	if (foundMaterialItr != materialsLoaded.cend()) {
+		numMaterialHits++;
+		return foundMaterialItr->second;
+	}
+
+	numMaterialMisses++;
+	auto newMaterial = std::make_shared<Material>(texture, materialType,
+		materialNode);
+	materialsLoaded[key] = newMaterial;
+	return newMaterial;
+}
+
+ResourceLoader::CacheStatistics
+	ResourceLoader::GetProceduralModelStatistics() const {
+	CacheStatistics statistics;
+	statistics.numEntries = proceduralModelsLoaded.size();
+	statistics.numHits = numProceduralModelHits;
+	statistics.numMisses = numProceduralModelMisses;
+	return statistics;
+}
+
+ResourceLoader::CacheStatistics ResourceLoader::GetMaterialStatistics() const {
+	CacheStatistics statistics;
+	statistics.numEntries = materialsLoaded.size();
+	statistics.numHits = numMaterialHits;
+	statistics.numMisses = numMaterialMisses;
+	return statistics;
+}
+
+std::shared_ptr<Model> ResourceLoader::GetProceduralModel(
+	ProceduralModelKey const& key,
+	std::function<std::shared_ptr<Model>()> const& createModel) {
+	auto foundModelItr = proceduralModelsLoaded.find(key);
+	if (foundModelItr != proceduralModelsLoaded.cend()) {
+		numProceduralModelHits++;
+		return foundModelItr->second;
+	}
+
+	numProceduralModelMisses++;
+	auto newModel = createModel();
+	proceduralModelsLoaded[key] = newModel;
+	return newModel;
+}
@@ -3,41 +3,100 @@
 #include <map>
 #include <string>
 #include <memory>
+#include <tuple>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <glm/glm.hpp>
 #include "vulkan/vulkan.h"
+#include "Rendering/DescriptorSetFunctions.h"
+#include "Math/NoiseGenerator.h"
+#include "nlohmann/json.hpp"
 
 class ShaderLoader;
 class TextureCreator;
 class GfxDeviceManager;
 class LogicalDeviceManager;
 class Model;
+class Material;
+class ThreadPool;
 
 // Responsible for loading and caching any
 // resources used, like textures, shaders,
 // sounds, et cetera.
 class ResourceLoader {
 public:
+	struct CacheStatistics {
+		size_t numEntries = 0;
+		uint64_t numHits = 0;
+		uint64_t numMisses = 0;
+	};
+
 	ResourceLoader();
 	~ResourceLoader();
 
 	std::shared_ptr<ShaderLoader> GetShader(std::string path, VkDevice device);
 	std::shared_ptr<TextureCreator> GetTexture(const std::string& path,
 		GfxDeviceManager* gfxDeviceManager,
-		std::shared_ptr<LogicalDeviceManager> logicalDeviceManager,
-		VkCommandPool commandPool);
+		std::shared_ptr<LogicalDeviceManager> logicalDeviceManager);
 	
 
 	std::shared_ptr<TextureCreator> BuildRawTexture(std::string textureName,
 		unsigned char* pixels,
 		int texWidth, int texHeight, int bytesPerPixel,
 		GfxDeviceManager* gfxDeviceManager,
-		std::shared_ptr<LogicalDeviceManager> logicalDeviceManager,
-		VkCommandPool commandPool);
+		std::shared_ptr<LogicalDeviceManager> logicalDeviceManager);
 	std::shared_ptr<TextureCreator> GetRawTexture(std::string textureName);
 
 	std::shared_ptr<Model> GetModel(const std::string& path);
 
+	// procedural models are made once per set of parameters and then
+	// shared by everyone who asks for them, so they must not be modified
+	std::shared_ptr<Model> GetQuad(glm::vec3 const& quadOrigin,
+		glm::vec3 const& side1Vec, glm::vec3 const& side2Vec,
+		bool isTriangleStrip);
+	std::shared_ptr<Model> GetBox(glm::vec3 const& boxCenter,
+		glm::vec3 const& right, glm::vec3 const& up,
+		glm::vec3 const& forward);
+	std::shared_ptr<Model> GetPlane(glm::vec3 const& lowerLeft,
+		glm::vec3 const& side1Vec, glm::vec3 const& side2Vec,
+		uint32_t numSide1Points, uint32_t numSide2Points,
+		NoiseGeneratorType noiseGeneratorType, uint32_t numNoiseLayers = 0,
+		ThreadPool* threadPool = nullptr);
+	std::shared_ptr<Model> GetIcosahedron(float radius,
+		uint32_t numSubdivisions);
+
+	// same for materials, keyed by type, texture and parameters
+	std::shared_ptr<Material> GetMaterial(
+		DescriptorSetFunctions::MaterialType materialType,
+		std::shared_ptr<TextureCreator> const& texture,
+		nlohmann::json const& materialNode);
+
+	CacheStatistics GetProceduralModelStatistics() const;
+	CacheStatistics GetMaterialStatistics() const;
+
 private:
+	enum class ProceduralModelType : char { Quad = 0, Box, Plane,
+		Icosahedron };
+	// every parameter in order, integers included
+	typedef std::pair<ProceduralModelType, std::vector<float>>
+		ProceduralModelKey;
+	// the material's json is keyed by its text
+	typedef std::tuple<DescriptorSetFunctions::MaterialType,
+		TextureCreator const*, std::string> MaterialKey;
+
 	std::map<std::string, std::shared_ptr<ShaderLoader>> shadersLoaded;
 	std::map<std::string, std::shared_ptr<TextureCreator>> texturesLoaded;
 	std::map<std::string, std::shared_ptr<Model>> modelsLoaded;
+	std::map<ProceduralModelKey, std::shared_ptr<Model>>
+		proceduralModelsLoaded;
+	std::map<MaterialKey, std::shared_ptr<Material>> materialsLoaded;
+
+	uint64_t numProceduralModelHits;
+	uint64_t numProceduralModelMisses;
+	uint64_t numMaterialHits;
+	uint64_t numMaterialMisses;
+
+	std::shared_ptr<Model> GetProceduralModel(ProceduralModelKey const& key,
+		std::function<std::shared_ptr<Model>()> const& createModel);
 };
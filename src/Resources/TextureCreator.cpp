@@ -9,16 +9,18 @@
 #include "Common.h"
 #include "GfxDeviceManager.h"
 #include "LogicalDeviceManager.h"
+#include "UploadContext.h"
+#include "DeferredDestructionQueue.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 TextureCreator::TextureCreator(const std::string& path,
 	GfxDeviceManager* gfxDeviceManager,
-	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager,
-	VkCommandPool commandPool) {
+	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager)
+	: uploadTicket(0), resident(false) {
 	this->logicalDeviceManager = logicalDeviceManager;
-	CreateTextureImageFromFile(path, gfxDeviceManager, commandPool);
+	CreateTextureImageFromFile(path, gfxDeviceManager);
 	CreateTextureImageView(4);
 	CreateTextureSampler();
 }
@@ -26,25 +28,47 @@ TextureCreator::TextureCreator(const std::string& path,
 TextureCreator::TextureCreator(unsigned char* pixels,
 	int texWidth, int texHeight, int bytesPerPixel,
 	GfxDeviceManager* gfxDeviceManager,
-	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager,
-	VkCommandPool commandPool) {
+	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager)
+	: uploadTicket(0), resident(false) {
 	this->logicalDeviceManager = logicalDeviceManager;
 	CreateTextureImage(pixels, texWidth, texHeight, bytesPerPixel,
-		gfxDeviceManager, commandPool);
+		gfxDeviceManager);
 	CreateTextureImageView(bytesPerPixel);
 	CreateTextureSampler();
 }
 
 TextureCreator::~TextureCreator() {
-	vkDestroySampler(logicalDeviceManager->GetDevice(), textureSampler, nullptr);
-	vkDestroyImageView(logicalDeviceManager->GetDevice(), textureImageView, nullptr);
+	// materials using this might still be bound in frames in flight
+	LogicalDeviceManager* logicalDeviceManager = this->logicalDeviceManager.get();
+	VkSampler retiredSampler = textureSampler;
+	VkImageView retiredImageView = textureImageView;
+	VkImage retiredImage = textureImage;
+	MemoryAllocator::Allocation retiredAllocation = textureImageAllocation;
+	auto retireTexture = [logicalDeviceManager, retiredSampler,
+		retiredImageView, retiredImage, retiredAllocation]() {
+		logicalDeviceManager->GetDeferredDestructionQueue()->Enqueue(
+			[logicalDeviceManager, retiredSampler, retiredImageView,
+			retiredImage, retiredAllocation]() mutable {
+				VkDevice device = logicalDeviceManager->GetDevice();
+				vkDestroySampler(device, retiredSampler, nullptr);
+				vkDestroyImageView(device, retiredImageView, nullptr);
+				Common::DestroyImage(logicalDeviceManager, retiredImage,
+					retiredAllocation);
+			});
+	};
 
-	vkDestroyImage(logicalDeviceManager->GetDevice(), textureImage, nullptr);
-	vkFreeMemory(logicalDeviceManager->GetDevice(), textureImageMemory, nullptr);
+	if (uploadTicket != 0) {
+		// the upload finishes first, then the image can be retired
+		logicalDeviceManager->GetUploadContext()->CancelUpload(uploadTicket,
+			retireTexture);
+	}
+	else {
+		retireTexture();
+	}
 }
 
 void TextureCreator::CreateTextureImageFromFile(const std::string& path,
-	GfxDeviceManager* gfxDeviceManager, VkCommandPool commandPool) {
+	GfxDeviceManager* gfxDeviceManager) {
 	int texWidth, texHeight, texChannels;
 	unsigned char* pixels = stbi_load(path.c_str(),
 		&texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
@@ -54,63 +78,28 @@ void TextureCreator::CreateTextureImageFromFile(const std::string& path,
 	}
 	
 	CreateTextureImage(pixels, texWidth, texHeight, 4,
-		gfxDeviceManager, commandPool);
+		gfxDeviceManager);
 }
 
 void TextureCreator::CreateTextureImage(unsigned char *pixels,
 	int texWidth, int texHeight, int bytesPerPixel,
-	GfxDeviceManager* gfxDeviceManager, VkCommandPool commandPool) {
+	GfxDeviceManager* gfxDeviceManager) {
 	VkDeviceSize imageSize = (VkDeviceSize)texWidth *
 		(VkDeviceSize)texHeight * bytesPerPixel;
 	mipLevels = static_cast<uint32_t>(std::floor(
 		std::log2(std::max(texWidth, texHeight)))) + 1;
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-
-	Common::CreateBuffer(logicalDeviceManager.get(), gfxDeviceManager, imageSize,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer,
-		stagingBufferMemory);
-
-	void* data;
-	vkMapMemory(logicalDeviceManager->GetDevice(), stagingBufferMemory, 0, imageSize,
-		0, &data);
-	memcpy(data, pixels, static_cast<size_t>(imageSize));
-	vkUnmapMemory(logicalDeviceManager->GetDevice(), stagingBufferMemory);
-
 	VkFormat imageFormat = bytesPerPixel == 4 ? VK_FORMAT_R8G8B8A8_UNORM :
 		VK_FORMAT_R8_UNORM;
 
 	Common::CreateImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT,
 		imageFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
 		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageAllocation,
 		logicalDeviceManager.get(), gfxDeviceManager);
 
-	Common::TransitionImageLayout(textureImage, imageFormat,
-		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		mipLevels, commandPool, logicalDeviceManager.get());
-	// transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-	// while generating mipmaps
-
-	CopyBufferToImage(commandPool, stagingBuffer, textureImage,
-		static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-
-	/*transitionImageLayout(textureImage, imageFormat,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-		mipLevels);*/
-
-	vkDestroyBuffer(logicalDeviceManager->GetDevice(), stagingBuffer, nullptr);
-	vkFreeMemory(logicalDeviceManager->GetDevice(), stagingBufferMemory, nullptr);
-	GenerateMipmaps(gfxDeviceManager, commandPool, textureImage,
-		imageFormat, texWidth, texHeight, mipLevels);
-}
-
-void TextureCreator::GenerateMipmaps(GfxDeviceManager* gfxDeviceManager,
-	VkCommandPool commandPool, VkImage image, VkFormat imageFormat,
-	uint32_t texWidth, uint32_t texHeight, uint32_t mipLevels) {
-	// check if image format supports linear blitting
+	// check if image format supports linear blitting. done up front since
+	// mipmaps get generated later, once the upload lands
 	VkFormatProperties formatProperties;
 	vkGetPhysicalDeviceFormatProperties(gfxDeviceManager->GetPhysicalDevice(),
 		imageFormat, &formatProperties);
@@ -120,7 +109,24 @@ void TextureCreator::GenerateMipmaps(GfxDeviceManager* gfxDeviceManager,
 		throw std::runtime_error("Texture image format does not support linear filtering!");
 	}
 
-	VkCommandBuffer commandBuffer = Common::BeginSingleTimeCommands(commandPool,
+	// pixels get copied to staging memory right away. the image is in
+	// VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL when the callback runs, and gets
+	// transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while
+	// generating mipmaps
+	uint32_t width = static_cast<uint32_t>(texWidth);
+	uint32_t height = static_cast<uint32_t>(texHeight);
+	uploadTicket = logicalDeviceManager->GetUploadContext()->UploadToImageAsync(
+		pixels, imageSize, textureImage, width, height, mipLevels,
+		[this, imageFormat, width, height]() {
+			uploadTicket = 0;
+			GenerateMipmaps(textureImage, imageFormat, width, height, mipLevels);
+			resident = true;
+		});
+}
+
+void TextureCreator::GenerateMipmaps(VkImage image, VkFormat imageFormat,
+	uint32_t texWidth, uint32_t texHeight, uint32_t mipLevels) {
+	VkCommandBuffer commandBuffer = Common::BeginSingleTimeCommands(
 		logicalDeviceManager.get());
 
 	VkImageMemoryBarrier barrier = {};
@@ -190,41 +196,7 @@ void TextureCreator::GenerateMipmaps(GfxDeviceManager* gfxDeviceManager,
 		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
 		0, nullptr, 0, nullptr, 1, &barrier);
 
-	Common::EndSingleTimeCommands(commandBuffer, commandPool, logicalDeviceManager.get());
-}
-
-void TextureCreator::CopyBufferToImage(VkCommandPool commandPool,
-	VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-	VkCommandBuffer commandBuffer = Common::BeginSingleTimeCommands(commandPool,
-		logicalDeviceManager.get());
-
-	VkBufferImageCopy region = {};
-	region.bufferOffset = 0;
-	region.bufferRowLength = 0;
-	region.bufferImageHeight = 0;
-
-	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel = 0;
-	region.imageSubresource.baseArrayLayer = 0;
-	region.imageSubresource.layerCount = 1;
-
-	region.imageOffset = { 0, 0, 0 };
-	region.imageExtent = {
-		width,
-		height,
-		1
-	};
-
-	vkCmdCopyBufferToImage(
-		commandBuffer,
-		buffer,
-		image,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		1,
-		&region
-	);
-
-	Common::EndSingleTimeCommands(commandBuffer, commandPool, logicalDeviceManager.get());
+	Common::EndSingleTimeCommands(logicalDeviceManager.get());
 }
 
 void TextureCreator::CreateTextureImageView(int bytesPerPixel) {
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "vulkan/vulkan.h"
+#include "MemoryAllocator.h"
+#include "UploadContext.h"
 #include <string>
 #include <memory>
 
@@ -11,17 +13,15 @@ class TextureCreator {
 public:
 	TextureCreator(const std::string& path,
 		GfxDeviceManager* gfxDeviceManager,
-		std::shared_ptr<LogicalDeviceManager> logicalDeviceManager,
-		VkCommandPool commandPool);
+		std::shared_ptr<LogicalDeviceManager> logicalDeviceManager);
 	TextureCreator(unsigned char* pixels,
 		int texWidth, int texHeight, int bytesPerPixel,
 		GfxDeviceManager* gfxDeviceManager,
-		std::shared_ptr<LogicalDeviceManager> logicalDeviceManager,
-		VkCommandPool commandPool);
+		std::shared_ptr<LogicalDeviceManager> logicalDeviceManager);
 	~TextureCreator();
 
-	VkDeviceMemory GetTextureImageMemory() {
-		return textureImageMemory;
+	MemoryAllocator::Allocation const& GetTextureImageAllocation() const {
+		return textureImageAllocation;
 	}
 
 	VkImageView GetTextureImageView() {
@@ -32,19 +32,20 @@ public:
 		return textureSampler;
 	}
 
+	// false until the upload lands and mipmaps are recorded; the texture
+	// can't be sampled before then
+	bool IsResident() const {
+		return resident;
+	}
+
 private:
 	void CreateTextureImageFromFile(const std::string& path,
-		GfxDeviceManager* gfxDeviceManager,
-		VkCommandPool commandPool);
+		GfxDeviceManager* gfxDeviceManager);
 	void CreateTextureImage(unsigned char* pixels,
 		int texWidth, int texHeight, int bytesPerPixel,
-		GfxDeviceManager* gfxDeviceManager,
-		VkCommandPool commandPool);
-	void GenerateMipmaps(GfxDeviceManager* gfxDeviceManager,
-		VkCommandPool commandPool, VkImage image, VkFormat imageFormat,
+		GfxDeviceManager* gfxDeviceManager);
+	void GenerateMipmaps(VkImage image, VkFormat imageFormat,
 		uint32_t texWidth, uint32_t texHeight, uint32_t mipLevel);
-	void CopyBufferToImage(VkCommandPool commandPool, VkBuffer buffer,
-		VkImage image, uint32_t width, uint32_t height);
 
 	void CreateTextureImageView(int bytesPerPixel);
 	void CreateTextureSampler();
@@ -53,7 +54,10 @@ private:
 	uint32_t mipLevels;
 	VkImage textureImage;
 
-	VkDeviceMemory textureImageMemory;
+	MemoryAllocator::Allocation textureImageAllocation;
 	VkImageView textureImageView;
 	VkSampler textureSampler;
+
+	UploadContext::UploadTicket uploadTicket;
+	bool resident;
 };
@@ -0,0 +1,72 @@
+#include "SceneManagement/CollisionSystem.h"
+#include "GameObjects/GameObject.h"
+#include "GameObjects/Mothership/PawnBehavior.h"
+#include "GameObjects/Mothership/MothershipBehavior.h"
+
+const float CollisionSystem::pawnCellSize = 4.0f;
+
+CollisionSystem::CollisionSystem() : pawnGrid(pawnCellSize) {
+}
+
+void CollisionSystem::Rebuild(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects) {
+	pawnGrid.Clear();
+	pawns.clear();
+	motherships.clear();
+	AddGameObjects(gameObjects);
+	pawnGrid.Build();
+}
+
+PawnBehavior* CollisionSystem::FindPawn(glm::vec3 const& position,
+	float radius) const {
+	uint32_t pawnIndex;
+	// pawns destroyed earlier in the frame are still in the grid
+	if (!pawnGrid.FindNearest(position, radius,
+		[this](uint32_t item) { return !pawns[item]->IsDestroyed(); },
+		pawnIndex)) {
+		return nullptr;
+	}
+	return pawns[pawnIndex];
+}
+
+MothershipBehavior* CollisionSystem::FindMothership(
+	glm::vec3 const& position) const {
+	for (MothershipSphere const& mothership : motherships) {
+		glm::vec3 offset = position - mothership.center;
+		if (glm::dot(offset, offset) <=
+			mothership.radius * mothership.radius) {
+			return mothership.behavior;
+		}
+	}
+	return nullptr;
+}
+
+void CollisionSystem::AddGameObjects(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects) {
+	for (std::shared_ptr<GameObject> const& gameObject : gameObjects) {
+		// pooled objects that aren't spawned can't be hit
+		if (!gameObject->IsActive()) {
+			continue;
+		}
+
+		GameObjectBehavior* behavior = gameObject->GetGameObjectBehavior();
+		PawnBehavior* pawnBehavior = dynamic_cast<PawnBehavior*>(behavior);
+		if (pawnBehavior != nullptr && !pawnBehavior->IsDestroyed()) {
+			pawnGrid.Insert(gameObject->GetWorldPosition(),
+				(uint32_t)pawns.size());
+			pawns.push_back(pawnBehavior);
+		}
+
+		MothershipBehavior* mothershipBehavior =
+			dynamic_cast<MothershipBehavior*>(behavior);
+		if (mothershipBehavior != nullptr) {
+			MothershipSphere mothership;
+			mothership.behavior = mothershipBehavior;
+			mothership.center = gameObject->GetWorldPosition();
+			mothership.radius = mothershipBehavior->GetRadius();
+			motherships.push_back(mothership);
+		}
+
+		AddGameObjects(gameObject->GetChildren());
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Math/SpatialHashGrid.h"
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+class GameObject;
+class PawnBehavior;
+class MothershipBehavior;
+
+// What bullets can hit, gathered from the scene once per frame instead of
+// walking every object for every bullet. Pawns are points in a spatial
+// hash grid; motherships are few and big, so they are kept as spheres and
+// tested one by one. Positions are the ones from when it was rebuilt.
+class CollisionSystem {
+public:
+	CollisionSystem();
+
+	void Rebuild(std::vector<std::shared_ptr<GameObject>> const& gameObjects);
+
+	// nearest pawn within radius that hasn't been destroyed yet, or null
+	PawnBehavior* FindPawn(glm::vec3 const& position, float radius) const;
+	// a mothership whose sphere contains the position, or null
+	MothershipBehavior* FindMothership(glm::vec3 const& position) const;
+
+	size_t GetNumPawns() const {
+		return pawns.size();
+	}
+
+private:
+	struct MothershipSphere {
+		MothershipBehavior* behavior;
+		glm::vec3 center;
+		float radius;
+	};
+
+	SpatialHashGrid pawnGrid;
+	// grid items index into this
+	std::vector<PawnBehavior*> pawns;
+	std::vector<MothershipSphere> motherships;
+
+	// about twice the distance bullets hit pawns from
+	static const float pawnCellSize;
+
+	void AddGameObjects(
+		std::vector<std::shared_ptr<GameObject>> const& gameObjects);
+};
@@ -1,4 +1,7 @@
 #include "SceneManagement/Scene.h"
+#include "SceneManagement/Terrain.h"
+#include "SceneManagement/CollisionSystem.h"
+#include "SceneManagement/SceneQuery.h"
 #include "ResourceLoader.h"
 #include "GfxDeviceManager.h"
 #include "LogicalDeviceManager.h"
@@ -19,10 +22,16 @@ Scene::Scene(ResourceLoader* resourceLoader,
 	std::shared_ptr<LogicalDeviceManager> const & logicalDeviceManager,
 	VkCommandPool commandPool) :
 		resourceLoader(resourceLoader), gfxDeviceManager(gfxDeviceManager),
-		logicalDeviceManager(logicalDeviceManager), commandPool(commandPool) {
+		logicalDeviceManager(logicalDeviceManager), commandPool(commandPool),
+		terrain(nullptr), terrainActive(true),
+		collisionSystem(new CollisionSystem()),
+		sceneQuery(new SceneQuery()), numPoolHits(0), numPoolMisses(0) {
 }
 
 Scene::~Scene() {
+	delete terrain;
+	delete collisionSystem;
+	delete sceneQuery;
 }
 
 void Scene::AddGameObject(std::shared_ptr<GameObject>
@@ -35,6 +44,11 @@ void Scene::AddGameObject(std::shared_ptr<GameObject>
 	gameObjects.push_back(newGameObject);
 }
 
+void Scene::ClearGameObjects() {
+	gameObjects.clear();
+	sceneQuery->Clear();
+}
+
 GameObject* Scene::GetGameObject(unsigned int index) {
 	if (index >= gameObjects.size()) {
 		return nullptr;
@@ -47,6 +61,8 @@ void Scene::RemoveGameObject(GameObject* gameObjectToRemove) {
 	for (int i = 0; i < gameObjects.size(); i++) {
 		if (gameObjects[i].get() == gameObjectToRemove) {
 			removalIndex = i;
+			// it may not live until the next refit
+			sceneQuery->RemoveGameObject(gameObjectToRemove);
 			gameObjects[i]->SetInitializedInEngine(false);
 			gameObjects[i]->SetMarkedForDeletionInScene(false);
 			break;
@@ -63,6 +79,7 @@ void Scene::RemoveGameObject(std::shared_ptr<GameObject> const & gameObjectToRem
 	for (int i = 0; i < gameObjects.size(); i++) {
 		if (gameObjects[i] == gameObjectToRemove) {
 			removalIndex = i;
+			sceneQuery->RemoveGameObject(gameObjectToRemove.get());
 			gameObjects[i]->SetInitializedInEngine(false);
 			gameObjects[i]->SetMarkedForDeletionInScene(false);
 			break;
@@ -88,6 +105,21 @@ void Scene::RemoveGameObjects(
 	}
 }
 
+void Scene::MarkGameObjectsForDeletion() {
+	for (auto& gameObject : gameObjects) {
+		gameObject->SetMarkedForDeletionInScene(true);
+	}
+	for (auto& pool : gameObjectPools) {
+		pool.freeGameObjects.clear();
+		for (auto& gameObject : pool.gameObjects) {
+			gameObject->SetMarkedForDeletionInScene(false);
+			gameObject->SetActive(false);
+			pool.freeGameObjects.push_back(gameObject);
+		}
+	}
+	spawnedGameObjects.clear();
+}
+
 std::shared_ptr<GameObject> Scene::GetPlayerGameObject() {
 	std::shared_ptr<GameObject> foundPlayer = nullptr;
 
@@ -107,71 +139,174 @@ std::shared_ptr<GameObject> Scene::GetPlayerGameObject() {
 void Scene::SpawnGameObject(SpawnType spawnType,
 	glm::vec3 const & spawnPosition,
 	glm::vec3 const& forwardDir) {
+	GameObjectPool& pool = gameObjectPools[(size_t)spawnType];
+	std::shared_ptr<GameObject> gameObject;
+	if (pool.freeGameObjects.size() > 0) {
+		gameObject = pool.freeGameObjects.back();
+		pool.freeGameObjects.pop_back();
+		numPoolHits++;
+	}
+	else {
+		// the pool grows, and the new object is set up by the engine
+		// like any other new object
+		gameObject = CreatePooledGameObject(spawnType);
+		numPoolMisses++;
+	}
+
+	switch (spawnType) {
+		case SpawnType::Pawn:
+			static_cast<PawnBehavior*>(gameObject->GetGameObjectBehavior())
+				->Reset(forwardDir);
+			break;
+		case SpawnType::Bullet:
+			static_cast<BulletBehavior*>(gameObject->GetGameObjectBehavior())
+				->Reset(forwardDir);
+			break;
+	}
+	gameObject->SetLocalTransform(glm::translate(glm::mat4(1.0f),
+		spawnPosition));
+	spawnedGameObjects.push_back(gameObject);
+}
+
+void Scene::PrewarmGameObjectPool(SpawnType spawnType,
+	size_t numGameObjects) {
+	GameObjectPool& pool = gameObjectPools[(size_t)spawnType];
+	for (size_t i = 0; i < numGameObjects; i++) {
+		pool.freeGameObjects.push_back(CreatePooledGameObject(spawnType));
+	}
+}
+
+Scene::PoolStatistics Scene::GetPoolStatistics() const {
+	PoolStatistics statistics;
+	for (auto const& pool : gameObjectPools) {
+		statistics.numPooledGameObjects += pool.gameObjects.size();
+		statistics.numFreeGameObjects += pool.freeGameObjects.size();
+		for (auto const& gameObject : pool.gameObjects) {
+			if (gameObject->IsActive()) {
+				statistics.numActiveGameObjects++;
+			}
+		}
+	}
+	statistics.numHits = numPoolHits;
+	statistics.numMisses = numPoolMisses;
+	return statistics;
+}
+
+std::shared_ptr<GameObject> Scene::CreatePooledGameObject(
+	SpawnType spawnType) {
+	std::shared_ptr<GameObject> gameObject;
 	switch (spawnType) {
 		case SpawnType::Pawn:
-			SpawnPawnGameObject(spawnPosition, forwardDir);
+			gameObject = CreatePawnGameObject();
 			break;
 		case SpawnType::Bullet:
-			SpawnBulletGameObject(spawnPosition, forwardDir);
+			gameObject = CreateBulletGameObject();
 			break;
 	}
+	gameObject->SetActive(false);
+	gameObjectPools[(size_t)spawnType].gameObjects.push_back(gameObject);
+	upcomingGameObjects.push_back(gameObject);
+	return gameObject;
 }
 
-void Scene::SpawnPawnGameObject(glm::vec3 const& spawnPosition,
-								glm::vec3 const& forwardDirection) {
+std::shared_ptr<GameObject> Scene::CreatePawnGameObject() {
+	// every pawn looks the same, so they share their material and model
 	nlohmann::json dummyNode;
-	std::shared_ptr<Material> gameObjectMaterial = GameObjectCreator::CreateMaterial(
+	std::shared_ptr<Material> gameObjectMaterial =
+		GameObjectCreator::GetSharedMaterial(
 		DescriptorSetFunctions::MaterialType::UnlitTintedTextured,
 		"texture.jpg", dummyNode, false, resourceLoader, gfxDeviceManager,
-		logicalDeviceManager, commandPool);
+		logicalDeviceManager);
 	std::shared_ptr<Model> gameObjectModel =
-		Model::CreateIcosahedron(1.0f, 2);
-	glm::mat4 localToWorldTransform = glm::translate(glm::mat4(1.0f),
-		spawnPosition);
+		resourceLoader->GetIcosahedron(1.0f, 2);
 
-	std::shared_ptr<GameObject> newGameObject =
-		GameObjectCreator::CreateMeshGameObject(gameObjectMaterial,
-			gameObjectModel, std::make_unique<PawnBehavior>(this, forwardDirection),
-			localToWorldTransform, resourceLoader, gfxDeviceManager,
-			logicalDeviceManager, commandPool);
-	upcomingGameObjects.push_back(newGameObject);
+	// placed and pointed somewhere when it's spawned
+	return GameObjectCreator::CreateMeshGameObject(gameObjectMaterial,
+		gameObjectModel, std::make_unique<PawnBehavior>(this,
+			glm::vec3(1.0f, 0.0f, 0.0f)),
+		glm::mat4(1.0f), resourceLoader, gfxDeviceManager,
+		logicalDeviceManager, commandPool);
 }
 
-void Scene::SpawnBulletGameObject(glm::vec3 const& spawnPosition,
-	glm::vec3 const& forwardDir) {
+std::shared_ptr<GameObject> Scene::CreateBulletGameObject() {
 	nlohmann::json dummyNode;
-	std::shared_ptr gameObjectMaterial = GameObjectCreator::CreateMaterial(
+	std::shared_ptr gameObjectMaterial = GameObjectCreator::GetSharedMaterial(
 		DescriptorSetFunctions::MaterialType::UnlitTintedTextured,
 		"texture.jpg", dummyNode, false, resourceLoader, gfxDeviceManager,
-		logicalDeviceManager, commandPool);
+		logicalDeviceManager);
 	std::shared_ptr gameObjectModel = GameObjectCreator::LoadModelFromName(
 		"cube.obj", resourceLoader);
-	glm::mat4 localToWorldTransform = glm::translate(glm::mat4(1.0f),
-		spawnPosition);
 
-	std::shared_ptr<GameObject> newGameObject =
-		std::static_pointer_cast<GameObject>(
-			GameObjectCreator::CreateMeshGameObject(gameObjectMaterial,
-			gameObjectModel, std::make_unique<BulletBehavior>(this,
-				forwardDir),
-			localToWorldTransform, resourceLoader, gfxDeviceManager,
-			logicalDeviceManager, commandPool));
-	upcomingGameObjects.push_back(newGameObject);
+	return std::static_pointer_cast<GameObject>(
+		GameObjectCreator::CreateMeshGameObject(gameObjectMaterial,
+		gameObjectModel, std::make_unique<BulletBehavior>(this,
+			glm::vec3(0.0f, 0.0f, -1.0f)),
+		glm::mat4(1.0f), resourceLoader, gfxDeviceManager,
+		logicalDeviceManager, commandPool));
+}
+
+void Scene::RecyclePooledGameObjects() {
+	for (auto& pool : gameObjectPools) {
+		for (auto& gameObject : pool.gameObjects) {
+			if (!gameObject->GetMarkedForDeletion()) {
+				continue;
+			}
+			// destroyed this frame. one that's already free stays in the
+			// free list once
+			gameObject->SetMarkedForDeletionInScene(false);
+			if (gameObject->IsActive()) {
+				gameObject->SetActive(false);
+				pool.freeGameObjects.push_back(gameObject);
+			}
+		}
+	}
+}
+
+void Scene::SetTerrain(Terrain* newTerrain) {
+	if (terrain != nullptr) {
+		terrain->Clear();
+		delete terrain;
+	}
+	terrain = newTerrain;
+}
+
+void Scene::SetTerrainActive(bool value) {
+	if (terrainActive && !value && terrain != nullptr) {
+		terrain->Clear();
+	}
+	terrainActive = value;
 }
 
 void Scene::Update(float time, float deltaTime, uint32_t imageIndex,
 	glm::mat4 const & viewMatrix, VkExtent2D swapChainExtent) {
+	// new chunks go in with this frame's spawns
+	if (terrain != nullptr && terrainActive) {
+		glm::vec3 cameraPosition = glm::vec3(glm::inverse(viewMatrix)[3]);
+		terrain->Update(cameraPosition, upcomingGameObjects);
+	}
+
 	for (auto& gameObject : upcomingGameObjects) {
 		gameObjects.push_back(gameObject);
 	}
 	upcomingGameObjects.clear();
+	for (auto& gameObject : spawnedGameObjects) {
+		gameObject->SetActive(true);
+	}
+	spawnedGameObjects.clear();
+
+	// bullets test against where everything was at the start of the frame
+	collisionSystem->Rebuild(gameObjects);
+	sceneQuery->Refit(gameObjects);
 
 	for (std::shared_ptr<GameObject>& gameObject : gameObjects) {
-		if (!gameObject->GetInitializedInEngine()) {
+		if (!gameObject->GetInitializedInEngine() || !gameObject->IsActive()) {
 			continue;
 		}
 		gameObject->UpdateState(time, deltaTime);
 		gameObject->UpdateVisualState(imageIndex,
 			viewMatrix, time, deltaTime, swapChainExtent);
 	}
+
+	// before the engine removes whatever was destroyed this frame
+	RecyclePooledGameObjects();
 }
@@ -6,6 +6,7 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -14,12 +15,24 @@ class ResourceLoader;
 class GfxDeviceManager;
 class LogicalDeviceManager;
 class GraphicsEngine;
+class Terrain;
+class CollisionSystem;
+class SceneQuery;
 
 class Scene
 {
 public:
 	enum class SpawnType : char { Pawn = 0, Bullet };
 
+	struct PoolStatistics {
+		size_t numPooledGameObjects = 0;
+		size_t numFreeGameObjects = 0;
+		size_t numActiveGameObjects = 0;
+		// spawns that reused a free object vs. ones that had to make one
+		uint64_t numHits = 0;
+		uint64_t numMisses = 0;
+	};
+
 	Scene(ResourceLoader* resourceLoader,
 		GfxDeviceManager* gfxDeviceManager,
 		std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
@@ -30,9 +43,7 @@ public:
 	
 	GameObject* GetGameObject(unsigned int index);
 	
-	void ClearGameObjects() {
-		gameObjects.clear();
-	}
+	void ClearGameObjects();
 	
 	std::vector<std::shared_ptr<GameObject>>& GetGameObjects() {
 		return gameObjects;
@@ -47,14 +58,50 @@ public:
 	void RemoveGameObjects(std::vector<std::shared_ptr<GameObject>> const &
 		gameObjectsToRemove);
 
+	// marks everything for removal except pooled objects, which stay in
+	// the scene and go back to their pools. that includes objects spawned
+	// this frame, which haven't been activated yet and may not even be in
+	// the scene yet
+	void MarkGameObjectsForDeletion();
+
 	std::shared_ptr<GameObject> GetPlayerGameObject();
 
+	// spawned objects come from a pool per spawn type. destroyed ones go
+	// back to it instead of being removed from the scene, so they keep
+	// their buffers, descriptor sets and pipelines for the next spawn
 	void SpawnGameObject(SpawnType spawnType,
 		glm::vec3 const & spawnPosition,
 		glm::vec3 const& forwardDir);
 
+	// adds inactive objects to a pool ahead of time. they are initialized
+	// in the engine with the rest of the scene, so spawns don't have to
+	void PrewarmGameObjectPool(SpawnType spawnType, size_t numGameObjects);
+
+	PoolStatistics GetPoolStatistics() const;
+
 	void Update(float time, float deltaTime, uint32_t imageIndex,
 		glm::mat4 const& viewMatrix, VkExtent2D swapChainExtent);
+
+	// takes ownership
+	void SetTerrain(Terrain* newTerrain);
+
+	Terrain* GetTerrain() {
+		return terrain;
+	}
+
+	// an inactive terrain drops its chunks and stops streaming them in
+	void SetTerrainActive(bool value);
+
+	// rebuilt at the start of every update
+	CollisionSystem const* GetCollisionSystem() const {
+		return collisionSystem;
+	}
+
+	// raycasts, sphere overlaps and nearest object searches for picking
+	// and targeting. refit at the start of every update
+	SceneQuery const* GetSceneQuery() const {
+		return sceneQuery;
+	}
 	
 private:
 	std::vector<std::shared_ptr<GameObject>> gameObjects;
@@ -67,9 +114,30 @@ private:
 	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager;
 	VkCommandPool commandPool;
 
-	void SpawnPawnGameObject(glm::vec3 const & spawnPosition,
-							 glm::vec3 const& forwardDirection);
-	void SpawnBulletGameObject(glm::vec3 const& spawnPosition,
-							   glm::vec3 const& forwardDir);
+	Terrain* terrain;
+	bool terrainActive;
+	CollisionSystem* collisionSystem;
+	SceneQuery* sceneQuery;
+
+	struct GameObjectPool {
+		// every object of the pool, spawned or not
+		std::vector<std::shared_ptr<GameObject>> gameObjects;
+		std::vector<std::shared_ptr<GameObject>> freeGameObjects;
+	};
+
+	// indexed by spawn type
+	GameObjectPool gameObjectPools[2];
+	// pooled objects spawned this frame, activated with the next update
+	// like any other new object
+	std::vector<std::shared_ptr<GameObject>> spawnedGameObjects;
+	uint64_t numPoolHits;
+	uint64_t numPoolMisses;
+
+	// new objects are inactive and go into the scene with the next update
+	std::shared_ptr<GameObject> CreatePooledGameObject(SpawnType spawnType);
+	std::shared_ptr<GameObject> CreatePawnGameObject();
+	std::shared_ptr<GameObject> CreateBulletGameObject();
+	// puts destroyed pooled objects back into their pools
+	void RecyclePooledGameObjects();
 };
 
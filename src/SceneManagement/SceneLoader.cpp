@@ -19,6 +19,7 @@
 #include "Resources/TextureCreator.h"
 #include "Resources/Model.h"
 #include "Scene.h"
+#include "Terrain.h"
 #include "nlohmann/json.hpp"
 #include "Math/PerlinNoise.h"
 #include "Common.h"
@@ -40,7 +41,8 @@ static void SetUpGameObject(const nlohmann::json& jsonObj,
 	ResourceLoader* resourceLoader,
 	GfxDeviceManager *gfxDeviceManager,
 	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
-	VkCommandPool commandPool);
+	VkCommandPool commandPool,
+	ThreadPool* threadPool);
 
 static void SetupMaterial(const nlohmann::json& materialNode,
 						  std::shared_ptr<Material>& material,
@@ -52,11 +54,25 @@ static void SetupMaterial(const nlohmann::json& materialNode,
 static void SetupTransformation(const nlohmann::json& transformNode,
 								glm::mat4& localToWorld);
 
+static std::shared_ptr<Model> CreatePlaneOccluderModel(
+	std::shared_ptr<Model> const& planeModel, uint32_t numSide1Points,
+	uint32_t numSide2Points);
+
+static void SetUpTerrain(const nlohmann::json& terrainNode,
+	Scene* const scene,
+	ResourceLoader* resourceLoader,
+	GfxDeviceManager *gfxDeviceManager,
+	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
+	VkCommandPool commandPool);
+
+static NoiseGeneratorType GetNoiseGeneratorType(std::string const& noiseType);
+
 void SceneLoader::DeserializeJSONFileIntoScene(
 	ResourceLoader* resourceLoader,
 	GfxDeviceManager *gfxDeviceManager,
 	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
 	VkCommandPool commandPool,
+	ThreadPool* threadPool,
 	Scene * const scene,
 	SceneSettings& sceneSettings,
 	const std::string& jsonFilePath) {
@@ -74,9 +90,14 @@ void SceneLoader::DeserializeJSONFileIntoScene(
 			std::shared_ptr<GameObject> constructedGameObject;
 			SetUpGameObject(element.value(), constructedGameObject,
 							scene, resourceLoader, gfxDeviceManager,
-							logicalDeviceManager, commandPool);
+							logicalDeviceManager, commandPool, threadPool);
 			scene->AddGameObject(constructedGameObject);
 		}
+
+		if (Common::ContainsToken(jsonObject, "terrain")) {
+			SetUpTerrain(jsonObject["terrain"], scene, resourceLoader,
+				gfxDeviceManager, logicalDeviceManager, commandPool);
+		}
 	}
 	catch (const std::exception& e) {
 		std::stringstream exceptionMsg;
@@ -110,7 +131,8 @@ static void SetUpGameObject(const nlohmann::json& jsonObj,
 	ResourceLoader* resourceLoader,
 	GfxDeviceManager *gfxDeviceManager,
 	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
-	VkCommandPool commandPool) {
+	VkCommandPool commandPool,
+	ThreadPool* threadPool) {
 	std::string modelType = Common::SafeGetToken(jsonObj, "model");
 	auto materialNode = Common::SafeGetToken(jsonObj, "material");
 	
@@ -119,6 +141,10 @@ static void SetUpGameObject(const nlohmann::json& jsonObj,
 				  gfxDeviceManager, logicalDeviceManager,
 				  commandPool);
 
+	bool isOccluder = Common::ContainsToken(jsonObj, "occluder") &&
+		(bool)Common::SafeGetToken(jsonObj, "occluder");
+	std::shared_ptr<Model> occluderModel;
+
 	std::shared_ptr<Model> gameObjectModel;
 	if (modelType.find("Procedural") != std::string::npos)
 	{
@@ -157,7 +183,8 @@ static void SetUpGameObject(const nlohmann::json& jsonObj,
 			unsigned int numSide2Pnts = Common::SafeGetToken(metaDataNode, "num_side_2_points");
 			
 			std::string noiseType = Common::SafeGetToken(metaDataNode, "noise_type");
-			if (noiseType == "perlin" || noiseType == "none") {
+			if (noiseType == "perlin" || noiseType == "simplex" ||
+				noiseType == "none") {
 				uint32_t numNoiseLayers = Common::ContainsToken(metaDataNode, "num_noise_layers") ?
 					Common::SafeGetToken(metaDataNode, "num_noise_layers") : 0;
 				gameObjectModel = Model::CreatePlane(
@@ -165,8 +192,13 @@ static void SetUpGameObject(const nlohmann::json& jsonObj,
 					glm::vec3((float)side1Vec[0], (float)side1Vec[1], (float)side1Vec[2]),
 					glm::vec3((float)side2Vec[0], (float)side2Vec[1], (float)side2Vec[2]),
 					numSide1Pnts, numSide2Pnts,
-					noiseType == "perlin" ? NoiseGeneratorType::Perlin : NoiseGeneratorType::None,
-					numNoiseLayers);
+					GetNoiseGeneratorType(noiseType),
+					numNoiseLayers, threadPool);
+				// a million triangles is too many to rasterize every frame
+				if (isOccluder) {
+					occluderModel = CreatePlaneOccluderModel(gameObjectModel,
+						numSide1Pnts, numSide2Pnts);
+				}
 			}
 			else {
 				std::stringstream exceptionMsg;
@@ -196,8 +228,12 @@ static void SetUpGameObject(const nlohmann::json& jsonObj,
 
 	std::string gameObjectType = jsonObj["type"];
 	if (gameObjectType == "BasicTurret") {
+		auto turretBehavior = std::make_shared<BasicTurretBehavior>(scene);
+		// optional; turrets look around at random unless asked
+		turretBehavior->SetTargetsNearestPawn(
+			jsonObj.value("targets_nearest_pawn", false));
 		constructedGameObject = std::make_shared<BasicTurret>
-			(scene, std::make_shared<BasicTurretBehavior>(scene), gfxDeviceManager,
+			(scene, turretBehavior, gfxDeviceManager,
 			logicalDeviceManager, resourceLoader, commandPool, localToWorldTransform);
 	}
 	else if (gameObjectType == "Mothership") {
@@ -226,6 +262,91 @@ static void SetUpGameObject(const nlohmann::json& jsonObj,
 			<< std::endl;
 			throw exceptionMsg;
 	}
+
+	if (isOccluder) {
+		constructedGameObject->SetOccluder(true, occluderModel);
+	}
+}
+
+// the plane's corners as two triangles. only covers the same area as the
+// plane while its points aren't displaced
+static std::shared_ptr<Model> CreatePlaneOccluderModel(
+	std::shared_ptr<Model> const& planeModel, uint32_t numSide1Points,
+	uint32_t numSide2Points) {
+	auto const& planeVertices = planeModel->GetVertices();
+	size_t lastRowStart = (size_t)(numSide1Points - 1) * numSide2Points;
+	std::vector<Model::ModelVert> vertices = {
+		Model::ModelVert(planeVertices[0].position),
+		Model::ModelVert(planeVertices[numSide2Points - 1].position),
+		Model::ModelVert(planeVertices[lastRowStart].position),
+		Model::ModelVert(planeVertices[lastRowStart + numSide2Points - 1].position)
+	};
+	std::vector<uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+	return std::make_shared<Model>(vertices, indices,
+		Model::TopologyType::TriangleList);
+}
+
+static void SetUpTerrain(const nlohmann::json& terrainNode,
+	Scene* const scene,
+	ResourceLoader* resourceLoader,
+	GfxDeviceManager *gfxDeviceManager,
+	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
+	VkCommandPool commandPool) {
+	auto materialNode = Common::SafeGetToken(terrainNode, "material");
+	std::shared_ptr<Material> terrainMaterial;
+	SetupMaterial(materialNode, terrainMaterial, resourceLoader,
+		gfxDeviceManager, logicalDeviceManager, commandPool);
+
+	auto lowerLeftPos = Common::SafeGetToken(terrainNode, "lower_left");
+	auto terrainSize = Common::SafeGetToken(terrainNode, "size");
+
+	Terrain::Settings terrainSettings;
+	terrainSettings.lowerLeft = glm::vec3((float)lowerLeftPos[0],
+		(float)lowerLeftPos[1], (float)lowerLeftPos[2]);
+	terrainSettings.size = glm::vec2((float)terrainSize[0],
+		(float)terrainSize[1]);
+	terrainSettings.chunkPoints = Common::SafeGetToken(terrainNode,
+		"chunk_points");
+	terrainSettings.leafChunkSize = Common::SafeGetToken(terrainNode,
+		"leaf_chunk_size");
+	terrainSettings.viewDistance = Common::SafeGetToken(terrainNode,
+		"view_distance");
+	terrainSettings.lodDistanceFactor =
+		Common::ContainsToken(terrainNode, "lod_distance_factor") ?
+		(float)Common::SafeGetToken(terrainNode, "lod_distance_factor") : 2.0f;
+	terrainSettings.heightScale =
+		Common::ContainsToken(terrainNode, "height_scale") ?
+		(float)Common::SafeGetToken(terrainNode, "height_scale") : 0.0f;
+	terrainSettings.noiseFrequency =
+		Common::ContainsToken(terrainNode, "noise_frequency") ?
+		(float)Common::SafeGetToken(terrainNode, "noise_frequency") : 0.01f;
+	terrainSettings.noiseType = GetNoiseGeneratorType(
+		Common::ContainsToken(terrainNode, "noise_type") ?
+		(std::string)Common::SafeGetToken(terrainNode, "noise_type") :
+		std::string("perlin"));
+	terrainSettings.numNoiseLayers =
+		Common::ContainsToken(terrainNode, "num_noise_layers") ?
+		(uint32_t)Common::SafeGetToken(terrainNode, "num_noise_layers") : 0;
+	terrainSettings.occluder = Common::ContainsToken(terrainNode, "occluder") &&
+		(bool)Common::SafeGetToken(terrainNode, "occluder");
+
+	scene->SetTerrain(new Terrain(terrainSettings, terrainMaterial,
+		resourceLoader, gfxDeviceManager, logicalDeviceManager, commandPool));
+}
+
+static NoiseGeneratorType GetNoiseGeneratorType(std::string const& noiseType) {
+	if (noiseType == "perlin") {
+		return NoiseGeneratorType::Perlin;
+	}
+	if (noiseType == "simplex") {
+		return NoiseGeneratorType::Simplex;
+	}
+	if (noiseType == "none") {
+		return NoiseGeneratorType::None;
+	}
+	std::stringstream exceptionMsg;
+	exceptionMsg << "Don't understand noise type: " << noiseType;
+	throw exceptionMsg;
 }
 
 static void SetupMaterial(const nlohmann::json& materialNode,
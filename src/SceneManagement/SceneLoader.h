@@ -8,6 +8,7 @@
 class ResourceLoader;
 class GfxDeviceManager;
 class LogicalDeviceManager;
+class ThreadPool;
 
 class SceneLoader {
 public:
@@ -24,6 +25,8 @@ public:
 		GfxDeviceManager *gfxDeviceManager,
 		std::shared_ptr<LogicalDeviceManager>const& logicalDeviceManager,
 		VkCommandPool commandPool,
+		// speeds up procedural models; can be null
+		ThreadPool* threadPool,
 		class Scene * const scene,
 		SceneSettings& sceneSettings,
 		const std::string& jsonFilePath);
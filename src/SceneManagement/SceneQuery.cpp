@@ -0,0 +1,245 @@
+#include "SceneManagement/SceneQuery.h"
+#include "GameObjects/GameObject.h"
+#include "GameObjects/Mothership/PawnBehavior.h"
+#include "GameObjects/Mothership/MothershipBehavior.h"
+#include "GameObjects/Player/BulletBehavior.h"
+#include "GameObjects/Player/PlayerGameObjectBehavior.h"
+#include "GameObjects/Turrets/BasicTurretBehavior.h"
+#include "Math/CommonMath.h"
+#include <cmath>
+
+const float SceneQuery::fatMargin = 1.0f;
+
+SceneQuery::SceneQuery() : tree(fatMargin), refitCount(0),
+	numReinsertedObjects(0) {
+}
+
+void SceneQuery::Refit(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects) {
+	refitCount++;
+	numReinsertedObjects = 0;
+	RefitGameObjects(gameObjects, StaticCategory);
+
+	// whatever wasn't reached is gone from the scene or inactive
+	for (uint32_t entryIndex = 0; entryIndex < entries.size(); entryIndex++) {
+		Entry const& entry = entries[entryIndex];
+		if (entry.gameObject != nullptr && entry.lastRefit != refitCount) {
+			RemoveEntry(entryIndex);
+		}
+	}
+}
+
+void SceneQuery::RemoveGameObject(GameObject* gameObject) {
+	auto foundEntry = entryIndices.find(gameObject);
+	if (foundEntry != entryIndices.end()) {
+		RemoveEntry(foundEntry->second);
+	}
+	for (auto const& child : gameObject->GetChildren()) {
+		RemoveGameObject(child.get());
+	}
+}
+
+void SceneQuery::Clear() {
+	tree.Clear();
+	entries.clear();
+	freeEntries.clear();
+	entryIndices.clear();
+	numReinsertedObjects = 0;
+}
+
+bool SceneQuery::Raycast(glm::vec3 const& origin,
+	glm::vec3 const& direction, float maxDistance, uint32_t categoryMask,
+	RaycastHit& hit) const {
+	glm::vec3 unitDirection = glm::normalize(direction);
+	bool found = false;
+	tree.Raycast(origin, unitDirection, maxDistance, categoryMask,
+		[&](uint32_t entryIndex) {
+			Entry const& entry = entries[entryIndex];
+			if (!IsQueryable(entry)) {
+				return -1.0f;
+			}
+			float distance = RaycastEntry(entry, origin, unitDirection,
+				maxDistance);
+			// the tree only passes on boxes the ray reaches within the
+			// nearest hit so far, but the exact test can land past it
+			if (distance < 0.0f || distance > maxDistance ||
+				(found && distance >= hit.distance)) {
+				return -1.0f;
+			}
+			hit.gameObject = entry.gameObject;
+			hit.distance = distance;
+			found = true;
+			return distance;
+		});
+
+	if (found) {
+		hit.position = origin + unitDirection * hit.distance;
+	}
+	return found;
+}
+
+void SceneQuery::OverlapSphere(glm::vec3 const& center, float radius,
+	uint32_t categoryMask, std::vector<GameObject*>& gameObjects) const {
+	tree.QuerySphere(center, radius, categoryMask,
+		[&](uint32_t entryIndex) {
+			Entry const& entry = entries[entryIndex];
+			if (IsQueryable(entry) && OverlapsEntry(entry, center, radius)) {
+				gameObjects.push_back(entry.gameObject);
+			}
+			return true;
+		});
+}
+
+GameObject* SceneQuery::FindNearest(glm::vec3 const& point,
+	float maxDistance, uint32_t categoryMask) const {
+	uint32_t nearestEntry;
+	float nearestDistance;
+	if (!tree.FindNearest(point, maxDistance, categoryMask,
+		[&](uint32_t entryIndex) {
+			Entry const& entry = entries[entryIndex];
+			if (!IsQueryable(entry)) {
+				return -1.0f;
+			}
+			return GetDistanceToEntry(entry, point);
+		}, nearestEntry, nearestDistance)) {
+		return nullptr;
+	}
+	return entries[nearestEntry].gameObject;
+}
+
+SceneQuery::Statistics SceneQuery::GetStatistics() const {
+	Statistics statistics;
+	statistics.numObjects = tree.GetNumProxies();
+	statistics.treeHeight = tree.GetHeight();
+	statistics.numReinsertedObjects = numReinsertedObjects;
+	return statistics;
+}
+
+void SceneQuery::RefitGameObjects(
+	std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+	uint32_t parentCategory) {
+	for (std::shared_ptr<GameObject> const& gameObject : gameObjects) {
+		if (!gameObject->IsActive()) {
+			continue;
+		}
+
+		float sphereRadius;
+		uint32_t category = GetCategory(gameObject.get(), parentCategory,
+			sphereRadius);
+		AABB bounds = gameObject->GetWorldBounds();
+		// objects that don't draw anything can still have children that do
+		if (!bounds.IsEmpty()) {
+			if (sphereRadius > 0.0f) {
+				// the mesh can sit a little inside its sphere
+				glm::vec3 center = gameObject->GetWorldPosition();
+				bounds.Merge(AABB(center - glm::vec3(sphereRadius),
+					center + glm::vec3(sphereRadius)));
+			}
+			auto foundEntry = entryIndices.find(gameObject.get());
+			if (foundEntry == entryIndices.end()) {
+				uint32_t entryIndex;
+				if (freeEntries.size() > 0) {
+					entryIndex = freeEntries.back();
+					freeEntries.pop_back();
+				}
+				else {
+					entryIndex = (uint32_t)entries.size();
+					entries.push_back(Entry());
+				}
+				Entry& entry = entries[entryIndex];
+				entry.gameObject = gameObject.get();
+				entry.proxy = tree.CreateProxy(bounds, entryIndex, category);
+				entry.sphereRadius = sphereRadius;
+				entry.lastRefit = refitCount;
+				entryIndices[gameObject.get()] = entryIndex;
+				numReinsertedObjects++;
+			}
+			else {
+				Entry& entry = entries[foundEntry->second];
+				if (tree.MoveProxy(entry.proxy, bounds)) {
+					numReinsertedObjects++;
+				}
+				// pooled objects come back as something else, sometimes
+				tree.SetCategoryBits(entry.proxy, category);
+				entry.sphereRadius = sphereRadius;
+				entry.lastRefit = refitCount;
+			}
+		}
+
+		RefitGameObjects(gameObject->GetChildren(), category);
+	}
+}
+
+void SceneQuery::RemoveEntry(uint32_t entryIndex) {
+	Entry& entry = entries[entryIndex];
+	tree.DestroyProxy(entry.proxy);
+	entryIndices.erase(entry.gameObject);
+	entry.gameObject = nullptr;
+	freeEntries.push_back(entryIndex);
+}
+
+bool SceneQuery::IsQueryable(Entry const& entry) const {
+	return entry.gameObject->IsActive() &&
+		!entry.gameObject->GetMarkedForDeletion();
+}
+
+float SceneQuery::RaycastEntry(Entry const& entry, glm::vec3 const& origin,
+	glm::vec3 const& direction, float maxDistance) const {
+	if (entry.sphereRadius > 0.0f) {
+		float tVal;
+		if (!CommonMath::RaySphereIntersection(direction, origin,
+			entry.sphereRadius, entry.gameObject->GetWorldPosition(), tVal)) {
+			return -1.0f;
+		}
+		return tVal;
+	}
+	return entry.gameObject->GetWorldBounds().IntersectRay(origin,
+		1.0f / direction, maxDistance);
+}
+
+float SceneQuery::GetDistanceToEntry(Entry const& entry,
+	glm::vec3 const& point) const {
+	if (entry.sphereRadius > 0.0f) {
+		float distance = glm::length(point -
+			entry.gameObject->GetWorldPosition()) - entry.sphereRadius;
+		return distance > 0.0f ? distance : 0.0f;
+	}
+	return std::sqrt(entry.gameObject->GetWorldBounds()
+		.GetDistanceSquared(point));
+}
+
+bool SceneQuery::OverlapsEntry(Entry const& entry, glm::vec3 const& center,
+	float radius) const {
+	if (entry.sphereRadius > 0.0f) {
+		glm::vec3 offset = center - entry.gameObject->GetWorldPosition();
+		float radiusSum = radius + entry.sphereRadius;
+		return glm::dot(offset, offset) <= radiusSum * radiusSum;
+	}
+	return entry.gameObject->GetWorldBounds().GetDistanceSquared(center) <=
+		radius * radius;
+}
+
+uint32_t SceneQuery::GetCategory(GameObject* gameObject,
+	uint32_t parentCategory, float& sphereRadius) {
+	sphereRadius = 0.0f;
+	GameObjectBehavior* behavior = gameObject->GetGameObjectBehavior();
+	if (dynamic_cast<PawnBehavior*>(behavior) != nullptr) {
+		return PawnCategory;
+	}
+	MothershipBehavior* mothershipBehavior =
+		dynamic_cast<MothershipBehavior*>(behavior);
+	if (mothershipBehavior != nullptr) {
+		sphereRadius = mothershipBehavior->GetRadius();
+		return MothershipCategory;
+	}
+	if (dynamic_cast<BulletBehavior*>(behavior) != nullptr) {
+		return BulletCategory;
+	}
+	if (dynamic_cast<BasicTurretBehavior*>(behavior) != nullptr) {
+		return TurretCategory;
+	}
+	if (dynamic_cast<PlayerGameObjectBehavior*>(behavior) != nullptr) {
+		return PlayerCategory;
+	}
+	return parentCategory;
+}
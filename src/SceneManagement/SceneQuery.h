@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Math/DynamicAabbTree.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class GameObject;
+
+// Picking and targeting queries over every active object in the scene,
+// backed by a dynamic AABB tree of their world bounds. Refit once per
+// frame: objects that only moved a little keep their place in the tree,
+// so the cost of a refit goes to the ones that moved out of their fattened
+// boxes. Motherships are tested as the spheres they are, everything else
+// by its world bounds. Children are in it too, and belong to the category
+// of the object they hang off unless their own behavior says otherwise.
+// The tree has the bounds from the last refit, which is why it's fattened;
+// exact tests use where objects are at the time of the query.
+class SceneQuery {
+public:
+	// bits of the category masks queries take
+	enum Category : uint32_t {
+		PawnCategory = 1u << 0,
+		MothershipCategory = 1u << 1,
+		BulletCategory = 1u << 2,
+		TurretCategory = 1u << 3,
+		PlayerCategory = 1u << 4,
+		// terrain chunks, menu items and anything else
+		StaticCategory = 1u << 5,
+		AllCategories = 0xffffffffu
+	};
+
+	struct RaycastHit {
+		GameObject* gameObject = nullptr;
+		float distance = 0.0f;
+		glm::vec3 position;
+	};
+
+	struct Statistics {
+		size_t numObjects = 0;
+		int32_t treeHeight = 0;
+		// objects that moved out of their fattened boxes in the last refit
+		size_t numReinsertedObjects = 0;
+	};
+
+	SceneQuery();
+
+	// adds new objects, moves the ones whose bounds changed and drops the
+	// ones that left the scene or went inactive
+	void Refit(std::vector<std::shared_ptr<GameObject>> const& gameObjects);
+	// for objects that are taken out of the scene between refits. its
+	// children go too
+	void RemoveGameObject(GameObject* gameObject);
+	void Clear();
+
+	// nearest object the ray hits within maxDistance. direction doesn't
+	// have to be normalized
+	bool Raycast(glm::vec3 const& origin, glm::vec3 const& direction,
+		float maxDistance, uint32_t categoryMask, RaycastHit& hit) const;
+	// appends every object that touches the sphere
+	void OverlapSphere(glm::vec3 const& center, float radius,
+		uint32_t categoryMask, std::vector<GameObject*>& gameObjects) const;
+	// object nearest to the point within maxDistance, or null. distance is
+	// to the object's surface, and zero for points inside it
+	GameObject* FindNearest(glm::vec3 const& point, float maxDistance,
+		uint32_t categoryMask) const;
+
+	Statistics GetStatistics() const;
+
+private:
+	struct Entry {
+		GameObject* gameObject;
+		int32_t proxy;
+		// zero for objects tested by their bounds
+		float sphereRadius;
+		uint32_t lastRefit;
+	};
+
+	DynamicAabbTree tree;
+	// tree items index into this
+	std::vector<Entry> entries;
+	std::vector<uint32_t> freeEntries;
+	std::unordered_map<GameObject*, uint32_t> entryIndices;
+	uint32_t refitCount;
+	size_t numReinsertedObjects;
+
+	// how far objects can move before they are reinserted
+	static const float fatMargin;
+
+	void RefitGameObjects(
+		std::vector<std::shared_ptr<GameObject>> const& gameObjects,
+		uint32_t parentCategory);
+	void RemoveEntry(uint32_t entryIndex);
+
+	// objects that were recycled or destroyed since the last refit are
+	// still in the tree, and have to be skipped
+	bool IsQueryable(Entry const& entry) const;
+	float RaycastEntry(Entry const& entry, glm::vec3 const& origin,
+		glm::vec3 const& direction, float maxDistance) const;
+	float GetDistanceToEntry(Entry const& entry,
+		glm::vec3 const& point) const;
+	bool OverlapsEntry(Entry const& entry, glm::vec3 const& center,
+		float radius) const;
+
+	static uint32_t GetCategory(GameObject* gameObject,
+		uint32_t parentCategory, float& sphereRadius);
+};
@@ -0,0 +1,377 @@
+#include "SceneManagement/Terrain.h"
+#include "GameObjects/GameObject.h"
+#include "GameObjects/MeshGameObject.h"
+#include "GameObjects/GameObjectCreationUtilFuncs.h"
+#include "GameObjects/Msc/StationaryGameObjectBehavior.h"
+#include "Resources/Model.h"
+#include "Math/NoiseGenerator.h"
+#include "ThreadPool.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+
+// generation is bursty and shouldn't compete with command recording
+const size_t Terrain::numGenerationWorkers = 2;
+// enough to keep the workers busy; the rest waits for the next update, by
+// when the camera might not need it anymore
+const size_t Terrain::maxGeneratingChunks = 8;
+
+bool Terrain::ChunkKey::Overlaps(ChunkKey const& other) const {
+	// one of them has to contain the other
+	if (depth <= other.depth) {
+		uint32_t shift = other.depth - depth;
+		return (other.x >> shift) == x && (other.z >> shift) == z;
+	}
+	uint32_t shift = depth - other.depth;
+	return (x >> shift) == other.x && (z >> shift) == other.z;
+}
+
+Terrain::Terrain(Settings const& settings,
+	std::shared_ptr<Material> const& material,
+	ResourceLoader* resourceLoader,
+	GfxDeviceManager* gfxDeviceManager,
+	std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
+	VkCommandPool commandPool) : settings(settings), maxDepth(0),
+	material(material), resourceLoader(resourceLoader),
+	gfxDeviceManager(gfxDeviceManager),
+	logicalDeviceManager(logicalDeviceManager), commandPool(commandPool),
+	generation(0) {
+	if (settings.chunkPoints < 2 || settings.leafChunkSize <= 0.0f) {
+		throw std::runtime_error("Failed to create terrain: chunks need at "
+			"least two points per side and a positive size!");
+	}
+	float largestSide = std::max(settings.size.x, settings.size.y);
+	while (largestSide / (float)(1u << maxDepth) > settings.leafChunkSize &&
+		maxDepth < 16) {
+		maxDepth++;
+	}
+	generationThreadPool = new ThreadPool(numGenerationWorkers);
+}
+
+Terrain::~Terrain() {
+	// waits for the jobs that are still running
+	delete generationThreadPool;
+}
+
+void Terrain::Update(glm::vec3 const& cameraPosition,
+	std::vector<std::shared_ptr<GameObject>>& newGameObjects) {
+	AddFinishedChunks(newGameObjects);
+
+	std::vector<std::pair<float, ChunkKey>> selectedChunks;
+	SelectChunks({ 0, 0, 0 }, cameraPosition, selectedChunks);
+	std::sort(selectedChunks.begin(), selectedChunks.end(),
+		[](std::pair<float, ChunkKey> const& first,
+			std::pair<float, ChunkKey> const& second) {
+			return first.first < second.first;
+		});
+	wantedChunks.clear();
+	for (auto const& selectedChunk : selectedChunks) {
+		wantedChunks.push_back(selectedChunk.second);
+	}
+
+	StartGeneratingChunks();
+	RetireChunks();
+}
+
+void Terrain::Clear() {
+	for (auto& loadedChunk : loadedChunks) {
+		loadedChunk.second.gameObject->SetMarkedForDeletionInScene(true);
+	}
+	loadedChunks.clear();
+	generatingChunks.clear();
+	wantedChunks.clear();
+	generation++;
+}
+
+Terrain::Statistics Terrain::GetStatistics() const {
+	Statistics statistics;
+	statistics.numLoadedChunks = loadedChunks.size();
+	statistics.numGeneratingChunks = generatingChunks.size();
+	for (auto const& loadedChunk : loadedChunks) {
+		statistics.numLoadedVertices += loadedChunk.second.numVertices;
+	}
+	return statistics;
+}
+
+void Terrain::AddFinishedChunks(
+	std::vector<std::shared_ptr<GameObject>>& newGameObjects) {
+	std::vector<FinishedChunk> chunksToAdd;
+	{
+		std::lock_guard<std::mutex> lock(finishedChunkMutex);
+		chunksToAdd.swap(finishedChunks);
+	}
+
+	for (auto const& finishedChunk : chunksToAdd) {
+		if (finishedChunk.generation != generation) {
+			continue;
+		}
+		generatingChunks.erase(finishedChunk.key);
+		// retired right away if the camera moved on in the meantime
+		Chunk chunk;
+		chunk.gameObject = CreateChunkGameObject(finishedChunk.model);
+		chunk.numVertices = finishedChunk.model->GetVertices().size();
+		loadedChunks[finishedChunk.key] = chunk;
+		newGameObjects.push_back(chunk.gameObject);
+	}
+}
+
+void Terrain::SelectChunks(ChunkKey const& key, glm::vec3 const& cameraPosition,
+	std::vector<std::pair<float, ChunkKey>>& selectedChunks) const {
+	AABB bounds = GetChunkBounds(key);
+	glm::vec3 closestPoint = glm::clamp(cameraPosition, bounds.min,
+		bounds.max);
+	float distance = glm::length(closestPoint - cameraPosition);
+	if (distance > settings.viewDistance) {
+		return;
+	}
+
+	glm::vec3 chunkSize = bounds.max - bounds.min;
+	float largestSide = std::max(chunkSize.x, chunkSize.z);
+	if (key.depth < maxDepth &&
+		distance < largestSide * settings.lodDistanceFactor) {
+		uint32_t childDepth = key.depth + 1;
+		for (uint32_t childIndex = 0; childIndex < 4; childIndex++) {
+			ChunkKey childKey = { childDepth, key.x * 2 + (childIndex & 1),
+				key.z * 2 + (childIndex >> 1) };
+			SelectChunks(childKey, cameraPosition, selectedChunks);
+		}
+		return;
+	}
+	selectedChunks.push_back(std::make_pair(distance, key));
+}
+
+void Terrain::StartGeneratingChunks() {
+	for (auto const& key : wantedChunks) {
+		if (generatingChunks.size() >= maxGeneratingChunks) {
+			break;
+		}
+		if (loadedChunks.find(key) != loadedChunks.end() ||
+			generatingChunks.find(key) != generatingChunks.end()) {
+			continue;
+		}
+
+		generatingChunks.insert(key);
+		Settings jobSettings = settings;
+		uint32_t jobGeneration = generation;
+		generationThreadPool->Enqueue([this, jobSettings, key,
+			jobGeneration](size_t workerIndex) {
+			FinishedChunk finishedChunk;
+			finishedChunk.key = key;
+			finishedChunk.model = GenerateChunkModel(jobSettings, key);
+			finishedChunk.generation = jobGeneration;
+			std::lock_guard<std::mutex> lock(finishedChunkMutex);
+			finishedChunks.push_back(finishedChunk);
+		});
+	}
+}
+
+void Terrain::RetireChunks() {
+	for (auto loadedIt = loadedChunks.begin(); loadedIt !=
+		loadedChunks.end();) {
+		ChunkKey const& key = loadedIt->first;
+		bool isWanted = false;
+		// stays up as a stand-in for wanted chunks on its ground until
+		// they've all been generated, so no holes open up
+		bool isStandIn = false;
+		for (auto const& wantedKey : wantedChunks) {
+			if (wantedKey == key) {
+				isWanted = true;
+				break;
+			}
+			if (wantedKey.Overlaps(key) &&
+				loadedChunks.find(wantedKey) == loadedChunks.end()) {
+				isStandIn = true;
+			}
+		}
+
+		if (isWanted || isStandIn) {
+			++loadedIt;
+			continue;
+		}
+		loadedIt->second.gameObject->SetMarkedForDeletionInScene(true);
+		loadedIt = loadedChunks.erase(loadedIt);
+	}
+}
+
+std::shared_ptr<GameObject> Terrain::CreateChunkGameObject(
+	std::shared_ptr<Model> const& model) const {
+	// vertices are in world space already
+	std::shared_ptr<GameObject> chunkGameObject =
+		GameObjectCreator::CreateMeshGameObject(material, model,
+			std::make_shared<StationaryGameObjectBehavior>(), glm::mat4(1.0f),
+			resourceLoader, gfxDeviceManager, logicalDeviceManager,
+			commandPool);
+	// a flat chunk hides things as well as its corners do
+	if (settings.occluder && settings.heightScale == 0.0f) {
+		auto const& vertices = model->GetVertices();
+		uint32_t numPoints = settings.chunkPoints;
+		size_t lastRowStart = (size_t)(numPoints - 1) * numPoints;
+		std::vector<Model::ModelVert> occluderVertices = {
+			Model::ModelVert(vertices[0].position),
+			Model::ModelVert(vertices[numPoints - 1].position),
+			Model::ModelVert(vertices[lastRowStart].position),
+			Model::ModelVert(vertices[lastRowStart + numPoints - 1].position)
+		};
+		std::vector<uint32_t> occluderIndices = { 0, 1, 2, 2, 1, 3 };
+		chunkGameObject->SetOccluder(true, std::make_shared<Model>(
+			occluderVertices, occluderIndices,
+			Model::TopologyType::TriangleList));
+	}
+	return chunkGameObject;
+}
+
+AABB Terrain::GetChunkBounds(ChunkKey const& key) const {
+	float numChunksPerSide = (float)(1u << key.depth);
+	glm::vec3 chunkSize(settings.size.x / numChunksPerSide, 0.0f,
+		settings.size.y / numChunksPerSide);
+	glm::vec3 chunkMin = settings.lowerLeft + glm::vec3(
+		(float)key.x * chunkSize.x, 0.0f, (float)key.z * chunkSize.z);
+	glm::vec3 chunkMax = chunkMin + chunkSize;
+	chunkMax.y += settings.heightScale;
+	return AABB(chunkMin, chunkMax);
+}
+
+std::shared_ptr<Model> Terrain::GenerateChunkModel(Settings const& settings,
+	ChunkKey const& key) {
+	NoiseGenerator* noise = settings.heightScale != 0.0f ?
+		NoiseGenerator::Create(settings.noiseType) : nullptr;
+	uint32_t numPoints = settings.chunkPoints;
+	float numChunksPerSide = (float)(1u << key.depth);
+	float chunkSizeX = settings.size.x / numChunksPerSide;
+	float chunkSizeZ = settings.size.y / numChunksPerSide;
+	float originX = settings.lowerLeft.x + (float)key.x * chunkSizeX;
+	float originZ = settings.lowerLeft.z + (float)key.z * chunkSizeZ;
+	float spacingX = chunkSizeX / (float)(numPoints - 1);
+	float spacingZ = chunkSizeZ / (float)(numPoints - 1);
+
+	// one extra point around the edges, so normals line up with the
+	// neighbouring chunks
+	uint32_t numHeightPoints = numPoints + 2;
+	std::vector<float> heights((size_t)numHeightPoints * numHeightPoints);
+	std::vector<float> heightZ(numHeightPoints);
+	for (uint32_t j = 0; j < numHeightPoints; j++) {
+		heightZ[j] = originZ + ((float)j - 1.0f) * spacingZ;
+	}
+	for (uint32_t i = 0; i < numHeightPoints; i++) {
+		float x = originX + ((float)i - 1.0f) * spacingX;
+		SampleHeightRow(settings, noise, x, heightZ.data(), numHeightPoints,
+			&heights[(size_t)i * numHeightPoints]);
+	}
+	delete noise;
+
+	std::vector<Model::ModelVert> vertices;
+	vertices.reserve((size_t)numPoints * numPoints);
+	for (uint32_t i = 0; i < numPoints; i++) {
+		float x = originX + (float)i * spacingX;
+		for (uint32_t j = 0; j < numPoints; j++) {
+			float z = originZ + (float)j * spacingZ;
+			size_t heightIndex = (size_t)(i + 1) * numHeightPoints + (j + 1);
+			float height = heights[heightIndex];
+			float slopeX = (heights[heightIndex + numHeightPoints] -
+				heights[heightIndex - numHeightPoints]) / (2.0f * spacingX);
+			float slopeZ = (heights[heightIndex + 1] -
+				heights[heightIndex - 1]) / (2.0f * spacingZ);
+			// texture coordinates span the whole terrain, like the plane's
+			glm::vec2 texCoord((x - settings.lowerLeft.x) / settings.size.x,
+				1.0f - (z - settings.lowerLeft.z) / settings.size.y);
+			vertices.push_back(Model::ModelVert(
+				glm::vec3(x, settings.lowerLeft.y + height, z),
+				glm::normalize(glm::vec3(-slopeX, 1.0f, -slopeZ)),
+				glm::vec3(1.0f, 1.0f, 1.0f), texCoord));
+		}
+	}
+
+	// same winding as the plane's triangle strips
+	std::vector<uint32_t> indices;
+	indices.reserve((size_t)(numPoints - 1) * (numPoints - 1) * 6);
+	for (uint32_t i = 0; i < numPoints - 1; i++) {
+		for (uint32_t j = 0; j < numPoints - 1; j++) {
+			uint32_t bottom = i * numPoints + j;
+			uint32_t top = bottom + numPoints;
+			indices.push_back(top);
+			indices.push_back(bottom);
+			indices.push_back(top + 1);
+			indices.push_back(bottom);
+			indices.push_back(bottom + 1);
+			indices.push_back(top + 1);
+		}
+	}
+
+	// neighbours at other depths don't share all of their edge points, so
+	// hang a skirt off each edge to cover the cracks. drawn from both sides
+	if (settings.heightScale > 0.0f) {
+		uint32_t lastPoint = numPoints - 1;
+		std::vector<uint32_t> edgePoints;
+		for (uint32_t j = 0; j < lastPoint; j++) {
+			edgePoints.push_back(j);
+		}
+		for (uint32_t i = 0; i < lastPoint; i++) {
+			edgePoints.push_back(i * numPoints + lastPoint);
+		}
+		for (uint32_t j = lastPoint; j > 0; j--) {
+			edgePoints.push_back(lastPoint * numPoints + j);
+		}
+		for (uint32_t i = lastPoint; i > 0; i--) {
+			edgePoints.push_back(i * numPoints);
+		}
+
+		uint32_t firstSkirtVertex = (uint32_t)vertices.size();
+		for (uint32_t edgePoint : edgePoints) {
+			Model::ModelVert skirtVertex = vertices[edgePoint];
+			skirtVertex.position.y -= settings.heightScale;
+			vertices.push_back(skirtVertex);
+		}
+		uint32_t numEdgePoints = (uint32_t)edgePoints.size();
+		for (uint32_t e = 0; e < numEdgePoints; e++) {
+			uint32_t next = (e + 1) % numEdgePoints;
+			uint32_t top0 = edgePoints[e], top1 = edgePoints[next];
+			uint32_t bottom0 = firstSkirtVertex + e;
+			uint32_t bottom1 = firstSkirtVertex + next;
+			uint32_t skirtIndices[] = { top0, bottom0, top1, top1, bottom0,
+				bottom1, top0, top1, bottom0, top1, bottom1, bottom0 };
+			indices.insert(indices.end(), skirtIndices, skirtIndices + 12);
+		}
+	}
+
+	return std::make_shared<Model>(vertices, indices,
+		Model::TopologyType::TriangleList);
+}
+
+void Terrain::SampleHeightRow(Settings const& settings,
+	NoiseGenerator const* noise, float x, float const* z,
+	uint32_t numRowPoints, float* heights) {
+	if (noise == nullptr || settings.numNoiseLayers == 0) {
+		std::fill(heights, heights + numRowPoints, 0.0f);
+		return;
+	}
+	// fixed normalization, unlike the plane's, so that chunks agree on
+	// heights along their shared edges
+	std::vector<float> rowX(numRowPoints), rowY(numRowPoints, 0.0f),
+		rowZ(numRowPoints), rowValues(numRowPoints), rowDerivX(numRowPoints),
+		rowDerivY(numRowPoints), rowDerivZ(numRowPoints);
+	for (uint32_t j = 0; j < numRowPoints; j++) {
+		rowX[j] = x * settings.noiseFrequency;
+		rowZ[j] = z[j] * settings.noiseFrequency;
+		heights[j] = 0.0f;
+	}
+	NoiseBatch rowBatch = { rowX.data(), rowY.data(), rowZ.data(),
+		rowValues.data(), rowDerivX.data(), rowDerivY.data(),
+		rowDerivZ.data(), numRowPoints };
+
+	float amplitude = 1.0f;
+	float totalAmplitude = 0.0f;
+	for (uint32_t layerIndex = 0; layerIndex < settings.numNoiseLayers;
+		layerIndex++) {
+		noise->EvalBatch(rowBatch);
+		for (uint32_t j = 0; j < numRowPoints; j++) {
+			heights[j] += (1.0f + rowValues[j]) * 0.5f * amplitude;
+			rowX[j] *= 2.0f;
+			rowZ[j] *= 2.0f;
+		}
+		totalAmplitude += amplitude;
+		amplitude *= 0.5f;
+	}
+	for (uint32_t j = 0; j < numRowPoints; j++) {
+		heights[j] = settings.heightScale * heights[j] / totalAmplitude;
+	}
+}
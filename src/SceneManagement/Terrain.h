@@ -0,0 +1,158 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include "Math/BoundingVolumes.h"
+#include "Math/NoiseGenerator.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+class GameObject;
+class Material;
+class Model;
+class ResourceLoader;
+class GfxDeviceManager;
+class LogicalDeviceManager;
+class ThreadPool;
+
+// Ground that is split into chunks on a quadtree and streamed in around
+// the camera, instead of being one big plane. Chunks close to the camera
+// are small and detailed; farther ones cover more ground with the same
+// number of points, and nothing past the view distance is kept at all.
+// Chunk geometry and noise are generated on worker threads; finished
+// chunks become game objects of the scene.
+class Terrain {
+public:
+	struct Settings {
+		// the terrain lies in the xz plane
+		glm::vec3 lowerLeft;
+		glm::vec2 size;
+		// points along each side of a chunk, at any depth
+		uint32_t chunkPoints;
+		// the quadtree stops splitting once chunks are this small
+		float leafChunkSize;
+		float viewDistance;
+		// chunks split when the camera is closer than this many times
+		// their size
+		float lodDistanceFactor;
+		// noise heights go from 0 to heightScale. zero keeps the terrain
+		// flat
+		float heightScale;
+		NoiseGeneratorType noiseType;
+		float noiseFrequency;
+		uint32_t numNoiseLayers;
+		bool occluder;
+	};
+
+	struct Statistics {
+		size_t numLoadedChunks = 0;
+		size_t numGeneratingChunks = 0;
+		size_t numLoadedVertices = 0;
+	};
+
+	Terrain(Settings const& settings,
+		std::shared_ptr<Material> const& material,
+		ResourceLoader* resourceLoader,
+		GfxDeviceManager* gfxDeviceManager,
+		std::shared_ptr<LogicalDeviceManager> const& logicalDeviceManager,
+		VkCommandPool commandPool);
+	~Terrain();
+
+	// picks the chunks the camera needs, starts generating missing ones
+	// and hands out the ones that finished. chunks that are no longer
+	// needed are marked for deletion in the scene
+	void Update(glm::vec3 const& cameraPosition,
+		std::vector<std::shared_ptr<GameObject>>& newGameObjects);
+
+	// drops every chunk, for when the scene's objects are taken away.
+	// chunks that are still generating are thrown out once they finish
+	void Clear();
+
+	Statistics GetStatistics() const;
+
+private:
+	struct ChunkKey {
+		uint32_t depth;
+		uint32_t x;
+		uint32_t z;
+
+		bool operator<(ChunkKey const& other) const {
+			if (depth != other.depth) {
+				return depth < other.depth;
+			}
+			if (x != other.x) {
+				return x < other.x;
+			}
+			return z < other.z;
+		}
+
+		bool operator==(ChunkKey const& other) const {
+			return depth == other.depth && x == other.x && z == other.z;
+		}
+
+		// true if this chunk covers some of the other's ground
+		bool Overlaps(ChunkKey const& other) const;
+	};
+
+	struct FinishedChunk {
+		ChunkKey key;
+		std::shared_ptr<Model> model;
+		uint32_t generation;
+	};
+
+	struct Chunk {
+		std::shared_ptr<GameObject> gameObject;
+		size_t numVertices;
+	};
+
+	Settings settings;
+	uint32_t maxDepth;
+	std::shared_ptr<Material> material;
+
+	ResourceLoader* resourceLoader;
+	GfxDeviceManager* gfxDeviceManager;
+	std::shared_ptr<LogicalDeviceManager> logicalDeviceManager;
+	VkCommandPool commandPool;
+
+	std::map<ChunkKey, Chunk> loadedChunks;
+	std::set<ChunkKey> generatingChunks;
+	// nearest first
+	std::vector<ChunkKey> wantedChunks;
+
+	// written by workers
+	std::vector<FinishedChunk> finishedChunks;
+	std::mutex finishedChunkMutex;
+	// bumped by Clear, so results of older jobs can be told apart
+	uint32_t generation;
+
+	// owned, and deleted before anything its jobs touch
+	ThreadPool* generationThreadPool;
+
+	static const size_t numGenerationWorkers;
+	static const size_t maxGeneratingChunks;
+
+	void AddFinishedChunks(
+		std::vector<std::shared_ptr<GameObject>>& newGameObjects);
+	void SelectChunks(ChunkKey const& key, glm::vec3 const& cameraPosition,
+		std::vector<std::pair<float, ChunkKey>>& selectedChunks) const;
+	void StartGeneratingChunks();
+	void RetireChunks();
+	std::shared_ptr<GameObject> CreateChunkGameObject(
+		std::shared_ptr<Model> const& model) const;
+
+	AABB GetChunkBounds(ChunkKey const& key) const;
+
+	// these run on worker threads, and only read settings
+	static std::shared_ptr<Model> GenerateChunkModel(Settings const& settings,
+		ChunkKey const& key);
+	// heights at a fixed x for each of the z values, with the noise
+	// evaluated in batches
+	static void SampleHeightRow(Settings const& settings,
+		NoiseGenerator const* noise, float x, float const* z,
+		uint32_t numRowPoints, float* heights);
+};
@@ -0,0 +1,128 @@
+#include "SustainedFireBenchmark.h"
+#include "GameEngine.h"
+#include "Camera.h"
+#include "MemoryAllocator.h"
+#include "SceneManagement/Scene.h"
+#include <iostream>
+
+SustainedFireBenchmark::SustainedFireBenchmark(GameEngine* gameEngine,
+	MemoryAllocator* memoryAllocator) : gameEngine(gameEngine),
+	memoryAllocator(memoryAllocator), phase(Phase::Off), phaseStartTime(0.0f),
+	numFrames(0), startSpawns(0), startPoolMisses(0), startMemoryRequests(0),
+	startDeviceMemoryAllocations(0) {
+}
+
+void SustainedFireBenchmark::Start(float time) {
+	if (phase != Phase::Off) {
+		return;
+	}
+	std::cout << "Sustained fire: warming up for " << warmUpSeconds
+		<< " s.\n";
+	phase = Phase::WarmUp;
+	phaseStartTime = time;
+}
+
+void SustainedFireBenchmark::Update(float time) {
+	if (phase == Phase::Off) {
+		return;
+	}
+	// escape ends it early
+	if (gameEngine->GetGameMode() != GameEngine::GameMode::Game &&
+		phase != Phase::Menu) {
+		phase = Phase::Off;
+		return;
+	}
+
+	Scene* scene = gameEngine->GetMainGameScene();
+	float phaseTime = time - phaseStartTime;
+	glm::vec3 cameraPosition = gameEngine->GetMainCamera()->GetWorldPosition();
+	glm::vec3 cameraForward =
+		gameEngine->GetMainCamera()->GetForwardDirection();
+	switch (phase) {
+		case Phase::WarmUp:
+		{
+			gameEngine->SpawnGameObject(Scene::SpawnType::Bullet,
+				cameraPosition, cameraForward);
+			if (phaseTime < warmUpSeconds) {
+				break;
+			}
+			auto poolStatistics = scene->GetPoolStatistics();
+			auto memoryStatistics = memoryAllocator->GetStatistics();
+			startSpawns = poolStatistics.numHits + poolStatistics.numMisses;
+			startPoolMisses = poolStatistics.numMisses;
+			startMemoryRequests = memoryStatistics.numRequests;
+			startDeviceMemoryAllocations =
+				memoryStatistics.numDeviceMemoryAllocations;
+			numFrames = 0;
+			phase = Phase::Measure;
+			phaseStartTime = time;
+			break;
+		}
+		case Phase::Measure:
+		{
+			gameEngine->SpawnGameObject(Scene::SpawnType::Bullet,
+				cameraPosition, cameraForward);
+			numFrames++;
+			if (phaseTime < measureSeconds) {
+				break;
+			}
+			auto poolStatistics = scene->GetPoolStatistics();
+			auto memoryStatistics = memoryAllocator->GetStatistics();
+			uint64_t numPoolMisses = poolStatistics.numMisses -
+				startPoolMisses;
+			uint64_t numMemoryRequests = memoryStatistics.numRequests -
+				startMemoryRequests;
+			uint64_t numDeviceMemoryAllocations =
+				memoryStatistics.numDeviceMemoryAllocations -
+				startDeviceMemoryAllocations;
+			std::cout << "Sustained fire: "
+				<< poolStatistics.numHits + poolStatistics.numMisses -
+				startSpawns << " spawns over " << numFrames << " frames, "
+				<< numPoolMisses << " new pooled objects, "
+				<< numMemoryRequests << " buffer and image allocations, "
+				<< numDeviceMemoryAllocations
+				<< " vkAllocateMemory calls.\n";
+			if (numPoolMisses > 0 || numMemoryRequests > 0 ||
+				numDeviceMemoryAllocations > 0) {
+				std::cout << "Sustained fire: FAILED, spawning still "
+					<< "creates Vulkan objects after warming up.\n";
+			}
+
+			// more of each than the pools have free, so some are new
+			// objects that aren't even in the scene yet
+			size_t numSpawns = poolStatistics.numFreeGameObjects + 1;
+			for (size_t i = 0; i < numSpawns; i++) {
+				gameEngine->SpawnGameObject(Scene::SpawnType::Bullet,
+					cameraPosition, cameraForward);
+				gameEngine->SpawnGameObject(Scene::SpawnType::Pawn,
+					cameraPosition + cameraForward * 20.0f, cameraForward);
+			}
+			gameEngine->UpdateGameMode(GameEngine::GameMode::Menu);
+			phase = Phase::Menu;
+			break;
+		}
+		case Phase::Menu:
+		{
+			// a frame later, after the scene had a chance to activate
+			// what was spawned
+			auto poolStatistics = scene->GetPoolStatistics();
+			std::cout << "Sustained fire: back in the menu, "
+				<< poolStatistics.numActiveGameObjects << " of "
+				<< poolStatistics.numPooledGameObjects
+				<< " pooled objects active, "
+				<< poolStatistics.numFreeGameObjects << " free.\n";
+			if (poolStatistics.numActiveGameObjects > 0 ||
+				poolStatistics.numFreeGameObjects !=
+				poolStatistics.numPooledGameObjects) {
+				std::cout << "Sustained fire: FAILED, pooled objects "
+					<< "didn't go back to their pools.\n";
+			}
+			// and into a new game, the way the play button does
+			gameEngine->UpdateGameMode(GameEngine::GameMode::Game);
+			phase = Phase::Off;
+			break;
+		}
+		default:
+			break;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+class GameEngine;
+class MemoryAllocator;
+
+// Fires a bullet every frame, to check that spawning stops touching Vulkan
+// once the pools have grown to fit. Then goes to the menu in the same frame
+// as a burst of spawns, and checks that every pooled object went back.
+// Only created with --sustained-fire on the command line; B starts it in
+// game.
+class SustainedFireBenchmark {
+public:
+	// the allocator is owned by the logical device manager
+	SustainedFireBenchmark(GameEngine* gameEngine,
+		MemoryAllocator* memoryAllocator);
+
+	void Start(float time);
+	// call at the start of every frame
+	void Update(float time);
+
+private:
+	enum class Phase : char { Off = 0, WarmUp, Measure, Menu };
+
+	GameEngine* gameEngine;
+	MemoryAllocator* memoryAllocator;
+
+	Phase phase;
+	float phaseStartTime;
+	uint64_t numFrames;
+	// counters when measuring started
+	uint64_t startSpawns;
+	uint64_t startPoolMisses;
+	uint64_t startMemoryRequests;
+	uint64_t startDeviceMemoryAllocations;
+
+	// longer than a bullet lives
+	static constexpr float warmUpSeconds = 5.0f;
+	static constexpr float measureSeconds = 10.0f;
+};
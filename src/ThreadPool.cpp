@@ -0,0 +1,81 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t numWorkers) : numUnfinishedJobs(0),
+	shuttingDown(false) {
+	if (numWorkers == 0) {
+		unsigned int numHardwareThreads = std::thread::hardware_concurrency();
+		numWorkers = numHardwareThreads > 1 ? numHardwareThreads - 1 : 1;
+	}
+	for (size_t i = 0; i < numWorkers; i++) {
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		shuttingDown = true;
+	}
+	jobAvailable.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::Enqueue(Job job) {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		jobs.push_back(std::move(job));
+		numUnfinishedJobs++;
+	}
+	jobAvailable.notify_one();
+}
+
+void ThreadPool::WaitIdle() {
+	std::unique_lock<std::mutex> lock(jobMutex);
+	jobsFinished.wait(lock, [this]() { return numUnfinishedJobs == 0; });
+	if (firstException) {
+		std::exception_ptr exception = firstException;
+		firstException = nullptr;
+		std::rethrow_exception(exception);
+	}
+}
+
+void ThreadPool::WorkerLoop(size_t workerIndex) {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobAvailable.wait(lock, [this]() {
+				return shuttingDown || !jobs.empty();
+			});
+			// finish what's queued before quitting
+			if (jobs.empty()) {
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		std::exception_ptr exception;
+		try {
+			job(workerIndex);
+		}
+		catch (...) {
+			exception = std::current_exception();
+		}
+
+		bool finishedAll;
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			if (exception && !firstException) {
+				firstException = exception;
+			}
+			numUnfinishedJobs--;
+			finishedAll = numUnfinishedJobs == 0;
+		}
+		if (finishedAll) {
+			jobsFinished.notify_all();
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that stay alive for the life of the pool, so
+// per-frame work doesn't pay for thread creation. Jobs get the index of the
+// worker running them, which can be used to pick per-thread resources like
+// command pools.
+class ThreadPool {
+public:
+	typedef std::function<void(size_t workerIndex)> Job;
+
+	// zero picks one worker per hardware thread, minus one for the caller
+	explicit ThreadPool(size_t numWorkers = 0);
+	~ThreadPool();
+
+	size_t GetNumWorkers() const {
+		return workers.size();
+	}
+
+	void Enqueue(Job job);
+	// blocks until every job enqueued so far has finished. rethrows the
+	// first exception a job threw, if any
+	void WaitIdle();
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<Job> jobs;
+	std::mutex jobMutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobsFinished;
+	// queued plus running
+	size_t numUnfinishedJobs;
+	bool shuttingDown;
+	std::exception_ptr firstException;
+
+	void WorkerLoop(size_t workerIndex);
+};
@@ -0,0 +1,541 @@
+#include "UploadContext.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+const size_t UploadContext::maxBatchesInFlight = 3;
+const VkDeviceSize UploadContext::stagingRingSize = 32 * 1024 * 1024;
+// with a transfer queue around, the graphics ring only sees small updates
+const VkDeviceSize UploadContext::graphicsStagingRingSize = 8 * 1024 * 1024;
+
+UploadContext::UploadContext(VkDevice device, VkQueue graphicsQueue,
+	uint32_t graphicsQueueFamilyIndex, VkQueue transferQueue,
+	uint32_t transferQueueFamilyIndex, MemoryAllocator* memoryAllocator) :
+	device(device), memoryAllocator(memoryAllocator), nextTicket(1),
+	numCompletedUploads(0) {
+	dedicatedTransferQueue = transferQueueFamilyIndex != graphicsQueueFamilyIndex;
+	CreateLane(graphicsLane, graphicsQueue, graphicsQueueFamilyIndex,
+		dedicatedTransferQueue ? graphicsStagingRingSize : stagingRingSize);
+	if (dedicatedTransferQueue) {
+		CreateLane(transferLane, transferQueue, transferQueueFamilyIndex,
+			stagingRingSize);
+	}
+}
+
+UploadContext::~UploadContext() {
+	WaitIdle();
+	// regular callbacks might refer to objects that are already gone by
+	// now, but canceled ones still have resources to release
+	std::vector<UploadCallback> retireCallbacks;
+	for (auto& upload : completedUploads) {
+		if (upload.canceled && upload.onComplete) {
+			retireCallbacks.push_back(upload.onComplete);
+		}
+	}
+	completedUploads.clear();
+	for (auto& callback : retireCallbacks) {
+		callback();
+	}
+
+	DestroyLane(graphicsLane);
+	if (dedicatedTransferQueue) {
+		DestroyLane(transferLane);
+	}
+}
+
+void UploadContext::CreateLane(UploadLane& lane, VkQueue queue,
+	uint32_t queueFamilyIndex, VkDeviceSize ringSize) {
+	lane.queue = queue;
+	lane.queueFamilyIndex = queueFamilyIndex;
+	lane.currentBatchIndex = 0;
+	lane.stagingRingSize = ringSize;
+	lane.ringHead = 0;
+	lane.ringTail = 0;
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = queueFamilyIndex;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+		VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	if (vkCreateCommandPool(device, &poolInfo, nullptr, &lane.commandPool)
+		!= VK_SUCCESS) {
+		throw std::runtime_error("Failed to create upload command pool!");
+	}
+
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = lane.commandPool;
+	allocInfo.commandBufferCount = 1;
+
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+	lane.batches.resize(maxBatchesInFlight);
+	for (auto& batch : lane.batches) {
+		if (vkAllocateCommandBuffers(device, &allocInfo, &batch.commandBuffer)
+			!= VK_SUCCESS) {
+			throw std::runtime_error("Failed to allocate upload command buffer!");
+		}
+		if (vkCreateFence(device, &fenceInfo, nullptr, &batch.fence)
+			!= VK_SUCCESS) {
+			throw std::runtime_error("Failed to create upload fence!");
+		}
+		batch.recording = false;
+		batch.submitted = false;
+		batch.ringHead = 0;
+	}
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = ringSize;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateBuffer(device, &bufferInfo, nullptr, &lane.stagingRingBuffer)
+		!= VK_SUCCESS) {
+		throw std::runtime_error("Failed to create staging ring buffer!");
+	}
+	lane.stagingRingAllocation = memoryAllocator->AllocateForBuffer(
+		lane.stagingRingBuffer,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+void UploadContext::DestroyLane(UploadLane& lane) {
+	vkDestroyBuffer(device, lane.stagingRingBuffer, nullptr);
+	memoryAllocator->Free(lane.stagingRingAllocation);
+	for (auto& batch : lane.batches) {
+		vkDestroyFence(device, batch.fence, nullptr);
+	}
+	// frees the command buffers too
+	vkDestroyCommandPool(device, lane.commandPool, nullptr);
+}
+
+void UploadContext::UploadToBuffer(void const* data, VkDeviceSize size,
+	VkBuffer dstBuffer, VkDeviceSize dstOffset) {
+	std::lock_guard<std::mutex> lock(uploadMutex);
+	RecordBufferCopy(graphicsLane, data, size, dstBuffer, dstOffset);
+}
+
+UploadContext::UploadTicket UploadContext::UploadToBufferAsync(
+	void const* data, VkDeviceSize size, VkBuffer dstBuffer,
+	UploadCallback onComplete) {
+	std::lock_guard<std::mutex> lock(uploadMutex);
+	UploadLane& lane = GetAsyncLane();
+	RecordBufferCopy(lane, data, size, dstBuffer, 0);
+
+	PendingUpload upload = {};
+	upload.ticket = nextTicket++;
+	upload.buffer = dstBuffer;
+	upload.image = VK_NULL_HANDLE;
+	upload.mipLevels = 0;
+	upload.onComplete = onComplete;
+	if (dedicatedTransferQueue) {
+		UploadBatch& batch = GetRecordingBatch(lane);
+		RecordOwnershipTransfer(batch.commandBuffer, upload, true);
+		batch.pendingUploads.push_back(upload);
+	}
+	else {
+		// graphics batch gets submitted before anything that could use it
+		completedUploads.push_back(upload);
+	}
+	return upload.ticket;
+}
+
+UploadContext::UploadTicket UploadContext::UploadToImageAsync(
+	void const* data, VkDeviceSize size, VkImage dstImage, uint32_t width,
+	uint32_t height, uint32_t mipLevels, UploadCallback onComplete) {
+	std::lock_guard<std::mutex> lock(uploadMutex);
+	UploadLane& lane = GetAsyncLane();
+	// staging goes first, since running out of ring space can flush the
+	// batch; the transition has to end up in the same batch as the copy
+	VkDeviceSize stagingOffset;
+	VkBuffer stagingBuffer = StageData(lane, data, size, 16, stagingOffset);
+	UploadBatch& batch = GetRecordingBatch(lane);
+
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = dstImage;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset = stagingOffset;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { width, height, 1 };
+
+	vkCmdCopyBufferToImage(batch.commandBuffer, stagingBuffer, dstImage,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	PendingUpload upload = {};
+	upload.ticket = nextTicket++;
+	upload.buffer = VK_NULL_HANDLE;
+	upload.image = dstImage;
+	upload.mipLevels = mipLevels;
+	upload.onComplete = onComplete;
+	if (dedicatedTransferQueue) {
+		RecordOwnershipTransfer(batch.commandBuffer, upload, true);
+		batch.pendingUploads.push_back(upload);
+	}
+	else {
+		completedUploads.push_back(upload);
+	}
+	return upload.ticket;
+}
+
+void UploadContext::CancelUpload(UploadTicket ticket,
+	UploadCallback onRetired) {
+	if (ticket == 0) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		// the upload stays where it is, so the copy still finishes and
+		// retires like any other. only its callback changes
+		PendingUpload* upload = FindUpload(ticket);
+		if (upload != nullptr) {
+			upload->canceled = true;
+			upload->onComplete = onRetired;
+			return;
+		}
+	}
+	// already handed over, so nothing is writing to the resource anymore
+	if (onRetired) {
+		onRetired();
+	}
+}
+
+UploadContext::PendingUpload* UploadContext::FindUpload(UploadTicket ticket) {
+	auto matchesTicket = [ticket](PendingUpload const& upload) {
+		return upload.ticket == ticket;
+	};
+	auto completedIt = std::find_if(completedUploads.begin(),
+		completedUploads.end(), matchesTicket);
+	if (completedIt != completedUploads.end()) {
+		return &(*completedIt);
+	}
+	if (dedicatedTransferQueue) {
+		for (auto& batch : transferLane.batches) {
+			auto pendingIt = std::find_if(batch.pendingUploads.begin(),
+				batch.pendingUploads.end(), matchesTicket);
+			if (pendingIt != batch.pendingUploads.end()) {
+				return &(*pendingIt);
+			}
+		}
+	}
+	return nullptr;
+}
+
+VkCommandBuffer UploadContext::BeginRecording() {
+	uploadMutex.lock();
+	return GetRecordingBatch(graphicsLane).commandBuffer;
+}
+
+void UploadContext::EndRecording() {
+	uploadMutex.unlock();
+}
+
+void UploadContext::Flush() {
+	std::vector<UploadCallback> callbacks;
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		if (dedicatedTransferQueue) {
+			FlushCurrentBatch(transferLane);
+			RetireCompletedBatches(transferLane);
+		}
+		for (auto& upload : completedUploads) {
+			// canceled resources are about to be destroyed, so they don't
+			// need to be handed over
+			if (dedicatedTransferQueue && !upload.canceled) {
+				RecordOwnershipTransfer(
+					GetRecordingBatch(graphicsLane).commandBuffer, upload, false);
+			}
+			callbacks.push_back(upload.onComplete);
+		}
+		completedUploads.clear();
+	}
+
+	// these tend to record follow-up work like generating mipmaps, which
+	// needs the lock
+	for (auto& callback : callbacks) {
+		if (callback) {
+			callback();
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(uploadMutex);
+	numCompletedUploads += callbacks.size();
+	RetireCompletedBatches(graphicsLane);
+	FlushCurrentBatch(graphicsLane);
+}
+
+void UploadContext::WaitIdle() {
+	std::lock_guard<std::mutex> lock(uploadMutex);
+	if (dedicatedTransferQueue) {
+		FlushCurrentBatch(transferLane);
+		WaitForLane(transferLane);
+	}
+	FlushCurrentBatch(graphicsLane);
+	WaitForLane(graphicsLane);
+}
+
+UploadContext::UploadBatch& UploadContext::GetRecordingBatch(UploadLane& lane) {
+	UploadBatch& batch = lane.batches[lane.currentBatchIndex];
+	if (batch.recording) {
+		return batch;
+	}
+	// only blocks if every batch is still in flight
+	RetireBatch(lane, batch, true);
+
+	vkResetCommandBuffer(batch.commandBuffer, 0);
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+
+	// frames submitted earlier might still read from resources we are about
+	// to overwrite
+	vkCmdPipelineBarrier(batch.commandBuffer,
+		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 0, nullptr);
+	batch.recording = true;
+	return batch;
+}
+
+void UploadContext::FlushCurrentBatch(UploadLane& lane) {
+	UploadBatch& batch = lane.batches[lane.currentBatchIndex];
+	if (!batch.recording) {
+		return;
+	}
+
+	// make copies visible to whatever gets submitted after us. transfer
+	// queues can't name graphics stages, and the ownership transfer takes
+	// care of visibility there anyway
+	if (&lane == &graphicsLane) {
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+			VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+			VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+	vkEndCommandBuffer(batch.commandBuffer);
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &batch.commandBuffer;
+	if (vkQueueSubmit(lane.queue, 1, &submitInfo, batch.fence) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to submit upload command buffer!");
+	}
+
+	batch.recording = false;
+	batch.submitted = true;
+	batch.ringHead = lane.ringHead;
+	lane.currentBatchIndex = (lane.currentBatchIndex + 1) % maxBatchesInFlight;
+}
+
+void UploadContext::RetireBatch(UploadLane& lane, UploadBatch& batch,
+	bool waitForCompletion) {
+	if (!batch.submitted) {
+		return;
+	}
+	if (waitForCompletion) {
+		vkWaitForFences(device, 1, &batch.fence, VK_TRUE,
+			std::numeric_limits<uint64_t>::max());
+	}
+	else if (vkGetFenceStatus(device, batch.fence) != VK_SUCCESS) {
+		return;
+	}
+	vkResetFences(device, 1, &batch.fence);
+
+	for (size_t i = 0; i < batch.dedicatedStagingBuffers.size(); i++) {
+		vkDestroyBuffer(device, batch.dedicatedStagingBuffers[i], nullptr);
+		memoryAllocator->Free(batch.dedicatedStagingAllocations[i]);
+	}
+	batch.dedicatedStagingBuffers.clear();
+	batch.dedicatedStagingAllocations.clear();
+
+	// handed over to the graphics queue on the next flush
+	completedUploads.insert(completedUploads.end(),
+		batch.pendingUploads.begin(), batch.pendingUploads.end());
+	batch.pendingUploads.clear();
+
+	// batches complete in order, so everything staged before this is free
+	lane.ringTail = std::max(lane.ringTail, batch.ringHead);
+	batch.submitted = false;
+}
+
+void UploadContext::RetireCompletedBatches(UploadLane& lane) {
+	// oldest first, so uploads complete in the order they were made
+	for (size_t i = 0; i < maxBatchesInFlight; i++) {
+		RetireBatch(lane, lane.batches[(lane.currentBatchIndex + i) %
+			maxBatchesInFlight], false);
+	}
+}
+
+void UploadContext::WaitForOldestBatch(UploadLane& lane) {
+	// the slot after the most recently submitted one was used longest ago
+	for (size_t i = 0; i < maxBatchesInFlight; i++) {
+		UploadBatch& batch = lane.batches[(lane.currentBatchIndex + i) %
+			maxBatchesInFlight];
+		if (batch.submitted) {
+			RetireBatch(lane, batch, true);
+			return;
+		}
+	}
+}
+
+void UploadContext::WaitForLane(UploadLane& lane) {
+	for (size_t i = 0; i < maxBatchesInFlight; i++) {
+		RetireBatch(lane, lane.batches[(lane.currentBatchIndex + i) %
+			maxBatchesInFlight], true);
+	}
+}
+
+VkBuffer UploadContext::StageData(UploadLane& lane, void const* data,
+	VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& stagingOffset) {
+	VkDeviceSize ringSize = lane.stagingRingSize;
+	if (size > ringSize / 4) {
+		// too big for the ring; give it a buffer that goes away with the batch
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		VkBuffer stagingBuffer;
+		if (vkCreateBuffer(device, &bufferInfo, nullptr, &stagingBuffer)
+			!= VK_SUCCESS) {
+			throw std::runtime_error("Failed to create staging buffer!");
+		}
+		auto stagingAllocation = memoryAllocator->AllocateForBuffer(stagingBuffer,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			MemoryAllocator::AllocationLifetime::Transient);
+		memcpy(stagingAllocation.mappedData, data, (size_t)size);
+
+		UploadBatch& batch = GetRecordingBatch(lane);
+		batch.dedicatedStagingBuffers.push_back(stagingBuffer);
+		batch.dedicatedStagingAllocations.push_back(stagingAllocation);
+		stagingOffset = 0;
+		return stagingBuffer;
+	}
+
+	while (true) {
+		VkDeviceSize offset = (lane.ringHead + alignment - 1) / alignment *
+			alignment;
+		// don't let data wrap around the end of the ring
+		if (offset % ringSize + size > ringSize) {
+			offset = (offset / ringSize + 1) * ringSize;
+		}
+		if (offset + size - lane.ringTail <= ringSize) {
+			lane.ringHead = offset + size;
+			stagingOffset = offset % ringSize;
+			memcpy((char*)lane.stagingRingAllocation.mappedData + stagingOffset,
+				data, (size_t)size);
+			return lane.stagingRingBuffer;
+		}
+
+		RetireCompletedBatches(lane);
+		bool anySubmitted = false;
+		for (auto& batch : lane.batches) {
+			anySubmitted = anySubmitted || batch.submitted;
+		}
+		if (!anySubmitted) {
+			// only the batch being recorded holds on to the ring
+			FlushCurrentBatch(lane);
+		}
+		WaitForOldestBatch(lane);
+	}
+}
+
+void UploadContext::RecordBufferCopy(UploadLane& lane, void const* data,
+	VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset) {
+	VkDeviceSize stagingOffset;
+	VkBuffer stagingBuffer = StageData(lane, data, size, 4, stagingOffset);
+	UploadBatch& batch = GetRecordingBatch(lane);
+
+	VkBufferCopy copyRegion = {};
+	copyRegion.srcOffset = stagingOffset;
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size = size;
+	vkCmdCopyBuffer(batch.commandBuffer, stagingBuffer, dstBuffer, 1, &copyRegion);
+}
+
+void UploadContext::RecordOwnershipTransfer(VkCommandBuffer commandBuffer,
+	PendingUpload const& upload, bool release) {
+	// the release makes the copy available, the acquire makes it visible
+	// to whatever the graphics queue does with the resource next
+	VkAccessFlags srcAccessMask = release ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+	VkPipelineStageFlags srcStage = release ? VK_PIPELINE_STAGE_TRANSFER_BIT :
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	VkAccessFlags dstAccessMask = 0;
+	VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+	if (upload.buffer != VK_NULL_HANDLE) {
+		if (!release) {
+			// buffers can get updated in place once they are ours
+			dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+				VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+			dstStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+				VK_PIPELINE_STAGE_TRANSFER_BIT;
+		}
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.srcQueueFamilyIndex = transferLane.queueFamilyIndex;
+		barrier.dstQueueFamilyIndex = graphicsLane.queueFamilyIndex;
+		barrier.buffer = upload.buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr,
+			1, &barrier, 0, nullptr);
+	}
+	else {
+		if (!release) {
+			// images get their mip chain built right after
+			dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT |
+				VK_ACCESS_TRANSFER_WRITE_BIT;
+			dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		}
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = transferLane.queueFamilyIndex;
+		barrier.dstQueueFamilyIndex = graphicsLane.queueFamilyIndex;
+		barrier.image = upload.image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = upload.mipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr,
+			0, nullptr, 1, &barrier);
+	}
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include "MemoryAllocator.h"
+#include <functional>
+#include <vector>
+#include <mutex>
+
+// Batches buffer/image uploads and one-off commands like layout transitions
+// into a single command buffer, which gets submitted once per frame instead of
+// stalling the queue for every copy. Data goes through a persistently mapped
+// staging ring; space in it is reclaimed as the batches that read from it
+// complete.
+// Async uploads go to a dedicated transfer queue if the device has one, and
+// are handed over to the graphics queue family once they land. Without one,
+// they are recorded with the rest of the graphics batch.
+class UploadContext {
+public:
+	// zero means no upload
+	typedef uint64_t UploadTicket;
+	typedef std::function<void()> UploadCallback;
+
+	UploadContext(VkDevice device, VkQueue graphicsQueue,
+		uint32_t graphicsQueueFamilyIndex, VkQueue transferQueue,
+		uint32_t transferQueueFamilyIndex, MemoryAllocator* memoryAllocator);
+	~UploadContext();
+
+	// data is copied to staging memory right away, so the caller can
+	// release it. the GPU copy happens when the batch is flushed
+	void UploadToBuffer(void const* data, VkDeviceSize size, VkBuffer dstBuffer,
+		VkDeviceSize dstOffset = 0);
+
+	// resource can't be used until onComplete runs from Flush. by then it
+	// belongs to the graphics queue family, and anything onComplete records
+	// goes into the graphics batch
+	UploadTicket UploadToBufferAsync(void const* data, VkDeviceSize size,
+		VkBuffer dstBuffer, UploadCallback onComplete);
+	// image is transitioned from undefined to
+	// VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL for all mip levels, and stays that
+	// way until onComplete
+	UploadTicket UploadToImageAsync(void const* data, VkDeviceSize size,
+		VkImage dstImage, uint32_t width, uint32_t height, uint32_t mipLevels,
+		UploadCallback onComplete);
+	// drops the callback and doesn't wait. onRetired runs instead, from
+	// Flush, once the GPU is done writing to the resource; that's where it
+	// can be handed off for destruction
+	void CancelUpload(UploadTicket ticket, UploadCallback onRetired);
+
+	// for recording other commands into the current batch. has to be paired
+	// with EndRecording, and nothing else can be uploaded in between
+	VkCommandBuffer BeginRecording();
+	void EndRecording();
+
+	// submits everything recorded so far without waiting on it. also hands
+	// over finished async uploads and runs their callbacks
+	void Flush();
+	// flushes and waits for all batches to complete
+	void WaitIdle();
+
+	bool HasDedicatedTransferQueue() const {
+		return dedicatedTransferQueue;
+	}
+
+	// number of async upload callbacks that have run so far
+	uint64_t GetNumCompletedUploads() const {
+		return numCompletedUploads;
+	}
+
+private:
+	struct PendingUpload {
+		UploadTicket ticket;
+		// only one of these is set
+		VkBuffer buffer;
+		VkImage image;
+		uint32_t mipLevels;
+		UploadCallback onComplete;
+		// onComplete is the onRetired callback passed to CancelUpload
+		bool canceled;
+	};
+
+	struct UploadBatch {
+		VkCommandBuffer commandBuffer;
+		VkFence fence;
+		bool recording;
+		bool submitted;
+		// ring position once this batch's staging data was written
+		VkDeviceSize ringHead;
+		// staging buffers that were too big for the ring
+		std::vector<VkBuffer> dedicatedStagingBuffers;
+		std::vector<MemoryAllocator::Allocation> dedicatedStagingAllocations;
+		// async uploads that complete with this batch
+		std::vector<PendingUpload> pendingUploads;
+	};
+
+	// a queue with its own batches and staging ring
+	struct UploadLane {
+		VkQueue queue;
+		uint32_t queueFamilyIndex;
+		VkCommandPool commandPool;
+
+		std::vector<UploadBatch> batches;
+		size_t currentBatchIndex;
+
+		VkBuffer stagingRingBuffer;
+		MemoryAllocator::Allocation stagingRingAllocation;
+		VkDeviceSize stagingRingSize;
+		// these only grow; ring offsets are taken modulo the ring size
+		VkDeviceSize ringHead;
+		VkDeviceSize ringTail;
+	};
+
+	VkDevice device;
+	MemoryAllocator* memoryAllocator;
+	std::mutex uploadMutex;
+
+	UploadLane graphicsLane;
+	UploadLane transferLane;
+	bool dedicatedTransferQueue;
+
+	// async uploads whose data has landed, waiting to be handed over
+	std::vector<PendingUpload> completedUploads;
+	UploadTicket nextTicket;
+	uint64_t numCompletedUploads;
+
+	static const size_t maxBatchesInFlight;
+	static const VkDeviceSize stagingRingSize;
+	static const VkDeviceSize graphicsStagingRingSize;
+
+	void CreateLane(UploadLane& lane, VkQueue queue, uint32_t queueFamilyIndex,
+		VkDeviceSize ringSize);
+	void DestroyLane(UploadLane& lane);
+	UploadLane& GetAsyncLane() {
+		return dedicatedTransferQueue ? transferLane : graphicsLane;
+	}
+
+	UploadBatch& GetRecordingBatch(UploadLane& lane);
+	void FlushCurrentBatch(UploadLane& lane);
+	void RetireBatch(UploadLane& lane, UploadBatch& batch,
+		bool waitForCompletion);
+	void RetireCompletedBatches(UploadLane& lane);
+	void WaitForOldestBatch(UploadLane& lane);
+	void WaitForLane(UploadLane& lane);
+	// null if the upload isn't in flight or waiting to be handed over
+	PendingUpload* FindUpload(UploadTicket ticket);
+
+	// returns staging buffer and offset into it that data was written to
+	VkBuffer StageData(UploadLane& lane, void const* data, VkDeviceSize size,
+		VkDeviceSize alignment, VkDeviceSize& stagingOffset);
+	void RecordBufferCopy(UploadLane& lane, void const* data, VkDeviceSize size,
+		VkBuffer dstBuffer, VkDeviceSize dstOffset);
+	// release on the transfer queue, acquire on the graphics queue
+	void RecordOwnershipTransfer(VkCommandBuffer commandBuffer,
+		PendingUpload const& upload, bool release);
+};
@@ -276,6 +276,42 @@ struct VertexPosNormalColorTexCoord {
 	}
 };
 
+// per-instance data for instanced draws. it lives in its own vertex
+// binding and advances once per instance instead of once per vertex
+struct InstanceData {
+	glm::mat4 model;
+	glm::vec4 tint;
+
+	static VkVertexInputBindingDescription GetBindingDescription() {
+		VkVertexInputBindingDescription bindingDescription = {};
+		bindingDescription.binding = 1;
+		bindingDescription.stride = sizeof(InstanceData);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+		return bindingDescription;
+	}
+
+	// instance attributes come after the mesh's attributes, so the
+	// first location depends on the vertex type. the model matrix
+	// takes up four locations, one per column
+	static std::array<VkVertexInputAttributeDescription, 5> GetAttributeDescriptions(
+		uint32_t firstLocation) {
+		std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions = {};
+		for (uint32_t column = 0; column < 4; column++) {
+			attributeDescriptions[column].binding = 1;
+			attributeDescriptions[column].location = firstLocation + column;
+			attributeDescriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[column].offset = (uint32_t)(offsetof(InstanceData, model)
+				+ sizeof(glm::vec4) * column);
+		}
+
+		attributeDescriptions[4].binding = 1;
+		attributeDescriptions[4].location = firstLocation + 4;
+		attributeDescriptions[4].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+		attributeDescriptions[4].offset = offsetof(InstanceData, tint);
+		return attributeDescriptions;
+	}
+};
+
 namespace std {
 	template<> struct hash<VertexPos> {
 		size_t operator()(VertexPos const& vertex) const {
@@ -2,13 +2,23 @@
 #include <iostream>
 #include <cstdlib>
 #include <ctime>
+#include <cstring>
 #include "GameApplicationLogic.h"
 
-int main() {
+int main(int argc, char** argv) {
 	// in case we use rand anywhere, set up seed here
 	srand((unsigned int)time(NULL));
 
 	GameApplicationLogic app;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--sustained-fire") == 0) {
+			app.EnableSustainedFireBenchmark();
+		}
+		else {
+			std::cerr << "Unknown option " << argv[i] << ".\n";
+			return EXIT_FAILURE;
+		}
+	}
 
 	try {
 		app.Run();